@@ -23,10 +23,13 @@ namespace riscv {
 		abi_syscall_exit = 93,
 		abi_syscall_exit_group = 94,
 		abi_syscall_set_tid_address = 96,
+		abi_syscall_futex = 98,
 		abi_syscall_uname = 160,
 		abi_syscall_gettimeofday = 169,
+		abi_syscall_gettid = 178,
 		abi_syscall_brk = 214,
 		abi_syscall_munmap = 215,
+		abi_syscall_clone = 220,
 		abi_syscall_mmap = 222,
 		abi_syscall_open = 1024,
 		abi_syscall_unlink = 1026,
@@ -39,6 +42,11 @@ namespace riscv {
 		typename P::long_t tv_usec;
 	};
 
+	template <typename P> struct abi_timespec {
+		typename P::long_t tv_sec;
+		typename P::long_t tv_nsec;
+	};
+
 	template <typename P> struct abi_timezone {
 		typename P::int_t tz_minuteswest;
 		typename P::int_t tz_dsttime;
@@ -117,6 +125,24 @@ namespace riscv {
 		abi_errno_EINVAL = 22
 	};
 
+	enum {
+		abi_clone_VM = 0x00000100,
+		abi_clone_THREAD = 0x00010000,
+		abi_clone_SETTLS = 0x00080000,
+		abi_clone_PARENT_SETTID = 0x00100000,
+		abi_clone_CHILD_CLEARTID = 0x00200000,
+		abi_clone_CHILD_SETTID = 0x01000000
+	};
+
+	enum {
+		abi_futex_WAIT = 0,
+		abi_futex_WAKE = 1,
+		abi_futex_WAIT_BITSET = 9,
+		abi_futex_WAKE_BITSET = 10,
+		abi_futex_PRIVATE_FLAG = 128,
+		abi_futex_CLOCK_REALTIME = 256
+	};
+
 	struct abi_winsize {
 		unsigned short ws_row;
 		unsigned short ws_col;
@@ -172,8 +198,18 @@ namespace riscv {
 		proc.ireg[rv_ireg_a0] = ret >= 0 ? ret : -errno;
 	}
 
+	/*
+	 * the host kernel returns EFAULT rather than faulting when a syscall
+	 * writes to a write protected page, so code pages are unprotected first
+	 */
+	template <typename P> void abi_guest_write(P &proc, addr_t addr, size_t len)
+	{
+		if (proc.guest_write && len > 0) proc.guest_write(addr, len);
+	}
+
 	template <typename P> void abi_sys_read(P &proc)
 	{
+		abi_guest_write(proc, addr_t(proc.ireg[rv_ireg_a1]), size_t(proc.ireg[rv_ireg_a2]));
 		int ret = read(proc.ireg[rv_ireg_a0],
 			(void*)(addr_t)proc.ireg[rv_ireg_a1], proc.ireg[rv_ireg_a2]);
 		proc.ireg[rv_ireg_a0] = ret >= 0 ? ret : -errno;
@@ -195,6 +231,7 @@ namespace riscv {
 		for (int i = 0; i < iovcnt; i++) {
 			host_iov[i].iov_base = (void*)(addr_t)abi_iov[i].iov_base;
 			host_iov[i].iov_len = (size_t)abi_iov[i].iov_len;
+			abi_guest_write(proc, addr_t(host_iov[i].iov_base), host_iov[i].iov_len);
 		}
 		int ret = readv(fd, host_iov, iovcnt);
 		proc.ireg[rv_ireg_a0] = ret >= 0 ? ret : -errno;
@@ -216,6 +253,7 @@ namespace riscv {
 
 	template <typename P> void abi_sys_pread(P &proc)
 	{
+		abi_guest_write(proc, addr_t(proc.ireg[rv_ireg_a1]), size_t(proc.ireg[rv_ireg_a2]));
 		int ret = pread(proc.ireg[rv_ireg_a0],
 			(void*)(addr_t)proc.ireg[rv_ireg_a1], proc.ireg[rv_ireg_a2],
 			proc.ireg[rv_ireg_a3]);
@@ -287,10 +325,110 @@ namespace riscv {
 		exit(proc.ireg[rv_ireg_a0]);
 	}
 
+	template <typename P> void abi_sys_exit_thread(P &proc)
+	{
+		if (proc.main_thread()) {
+			abi_sys_exit(proc);
+		}
+
+		/* clear the thread id for pthread_join and stop the thread run loop */
+		if (proc.clear_child_tid) {
+			__atomic_store_n((s32*)proc.clear_child_tid, 0, __ATOMIC_SEQ_CST);
+			proc.threads->futex_wake(proc.clear_child_tid, 1);
+		}
+		proc.raise(P::internal_cause_poweroff, proc.pc);
+	}
+
 	template <typename P> void abi_sys_set_tid_address(P &proc)
 	{
-		proc.clear_child_tid = *(int*)(uintptr_t)proc.ireg[rv_ireg_a0].r.xu.val;
-		proc.ireg[rv_ireg_a0].r.xu.val = 1; /* tid is 1 for now */
+		proc.clear_child_tid = addr_t(proc.ireg[rv_ireg_a0].r.xu.val);
+		proc.ireg[rv_ireg_a0] = proc.tid;
+	}
+
+	template <typename P> void abi_sys_gettid(P &proc)
+	{
+		proc.ireg[rv_ireg_a0] = proc.tid;
+	}
+
+	template <typename P, typename C>
+	void abi_sys_futex_wait(P &proc, addr_t uaddr, s32 val, addr_t utime, bool absolute)
+	{
+		typename C::time_point deadline;
+		if (utime) {
+			abi_timespec<P> *guest_ts = (abi_timespec<P>*)utime;
+			auto timeout = std::chrono::seconds(guest_ts->tv_sec) +
+				std::chrono::nanoseconds(guest_ts->tv_nsec);
+			deadline = absolute ? typename C::time_point(timeout) : C::now() + timeout;
+		}
+		proc.ireg[rv_ireg_a0] = proc.threads->template futex_wait<C>(uaddr, val,
+			utime ? &deadline : nullptr);
+	}
+
+	template <typename P> void abi_sys_futex(P &proc)
+	{
+		addr_t uaddr = addr_t(proc.ireg[rv_ireg_a0].r.xu.val);
+		int op = int(proc.ireg[rv_ireg_a1].r.xu.val);
+		s32 val = s32(proc.ireg[rv_ireg_a2].r.xu.val);
+		addr_t utime = addr_t(proc.ireg[rv_ireg_a3].r.xu.val);
+		bool realtime = op & abi_futex_CLOCK_REALTIME;
+
+		/* the bitset is ignored so bitset waiters are woken by any wake */
+		switch (op & ~(abi_futex_PRIVATE_FLAG | abi_futex_CLOCK_REALTIME)) {
+			case abi_futex_WAIT:
+				abi_sys_futex_wait<P,std::chrono::steady_clock>(proc, uaddr, val, utime, false);
+				break;
+			case abi_futex_WAIT_BITSET:
+				if (realtime) {
+					abi_sys_futex_wait<P,std::chrono::system_clock>(proc, uaddr, val, utime, true);
+				} else {
+					abi_sys_futex_wait<P,std::chrono::steady_clock>(proc, uaddr, val, utime, true);
+				}
+				break;
+			case abi_futex_WAKE:
+			case abi_futex_WAKE_BITSET:
+				proc.ireg[rv_ireg_a0] = proc.threads->futex_wake(uaddr, val);
+				break;
+			default:
+				proc.ireg[rv_ireg_a0] = -ENOSYS;
+				break;
+		}
+	}
+
+	template <typename P> void abi_sys_clone(P &proc)
+	{
+		typename P::ux flags = proc.ireg[rv_ireg_a0].r.xu.val;
+		typename P::ux stack = proc.ireg[rv_ireg_a1].r.xu.val;
+		addr_t ptid = addr_t(proc.ireg[rv_ireg_a2].r.xu.val);
+		typename P::ux tls = proc.ireg[rv_ireg_a3].r.xu.val;
+		addr_t ctid = addr_t(proc.ireg[rv_ireg_a4].r.xu.val);
+
+		/* only threads sharing the address space are supported */
+		if (!(flags & abi_clone_VM) || !(flags & abi_clone_THREAD) || !proc.threads->create) {
+			proc.ireg[rv_ireg_a0] = -ENOSYS;
+			return;
+		}
+
+		/* the child starts after the ecall with a0 = 0 on the new stack */
+		auto child = proc.threads->create();
+		child->threads = proc.threads;
+		child->tid = proc.threads->next_tid++;
+		child->log = proc.log;
+		child->threaded = proc.threaded;
+		child->symlookup = proc.symlookup;
+		child->mmu.mem = proc.mmu.mem;
+		child->pc = proc.pc + 4;
+		child->fcsr = proc.fcsr;
+		for (size_t i = 0; i < P::ireg_count; i++) child->ireg[i] = proc.ireg[i];
+		for (size_t i = 0; i < P::freg_count; i++) child->freg[i] = proc.freg[i];
+		child->ireg[rv_ireg_a0] = 0;
+		if (stack) child->ireg[rv_ireg_sp] = stack;
+		if (flags & abi_clone_SETTLS) child->ireg[rv_ireg_tp] = tls;
+		if (flags & abi_clone_CHILD_CLEARTID) child->clear_child_tid = ctid;
+		if (flags & abi_clone_PARENT_SETTID) *(s32*)ptid = child->tid;
+		if (flags & abi_clone_CHILD_SETTID) *(s32*)ctid = child->tid;
+
+		proc.ireg[rv_ireg_a0] = child->tid;
+		proc.threads->start(child);
 	}
 
 	template <typename P> void abi_sys_uname(P &proc)
@@ -396,9 +534,12 @@ namespace riscv {
 			case abi_syscall_pread:           abi_sys_pread(proc); break;
 			case abi_syscall_pwrite:          abi_sys_pwrite(proc); break;
 			case abi_syscall_fstat:           abi_sys_fstat(proc); break;
-			case abi_syscall_exit:            abi_sys_exit(proc); break;
+			case abi_syscall_exit:            abi_sys_exit_thread(proc); break;
 			case abi_syscall_exit_group:      abi_sys_exit(proc); break;
 			case abi_syscall_set_tid_address: abi_sys_set_tid_address(proc); break;
+			case abi_syscall_futex:           abi_sys_futex(proc); break;
+			case abi_syscall_gettid:          abi_sys_gettid(proc); break;
+			case abi_syscall_clone:           abi_sys_clone(proc); break;
 			case abi_syscall_uname:           abi_sys_uname(proc); break;
 			case abi_syscall_gettimeofday:    abi_sys_gettimeofday(proc);break;
 			case abi_syscall_brk:             abi_sys_brk(proc); break;
@@ -26,7 +26,12 @@
 #include <random>
 #include <deque>
 #include <map>
+#include <set>
+#include <list>
 #include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
 #include <atomic>
 #include <type_traits>
 
@@ -73,6 +78,8 @@
 #include "processor-histogram.h"
 #include "processor-proxy.h"
 #include "debug-cli.h"
+#include "processor-block.h"
+#include "queue.h"
 
 #include "asmjit.h"
 
@@ -131,8 +138,11 @@ struct rv_jit
 	int proc_logs = 0;
 	int trace_iters = 100;
 	int trace_length = 0;
+	size_t trace_cache_mb = 0;
 	bool help_or_error = false;
 	std::string elf_filename;
+	std::string trace_cache_dir;
+	bool trace_thread = false;
 
 	std::vector<std::string> host_cmdline;
 	std::vector<std::string> host_env;
@@ -318,6 +328,9 @@ struct rv_jit
 			{ "-T", "--log-jit-trace", cmdline_arg_type_none,
 				"Log JIT trace",
 				[&](std::string s) { return (proc_logs |= proc_log_jit_trace); } },
+			{ "-E", "--log-exit", cmdline_arg_type_none,
+				"Log Registers and JIT statistics at exit",
+				[&](std::string s) { return (proc_logs |= proc_log_exit_stats); } },
 			{ "-P", "--pc-usage-histogram", cmdline_arg_type_none,
 				"Record program counter usage",
 				[&](std::string s) { return (proc_logs |= proc_log_hist_pc); } },
@@ -345,6 +358,15 @@ struct rv_jit
 			{ "-L", "--trace-length", cmdline_arg_type_string,
 				"Trace length",
 				[&](std::string s) { trace_length = strtoull(s.c_str(), nullptr, 10); return true; } },
+			{ "-C", "--jit-cache-mb", cmdline_arg_type_string,
+				"JIT code cache budget in MiB (default unlimited)",
+				[&](std::string s) { trace_cache_mb = strtoull(s.c_str(), nullptr, 10); return true; } },
+			{ "-B", "--background-jit", cmdline_arg_type_none,
+				"Generate trace code on a background thread",
+				[&](std::string s) { return (trace_thread = true); } },
+			{ "-D", "--trace-cache-dir", cmdline_arg_type_string,
+				"Directory for traces saved and reused across runs",
+				[&](std::string s) { trace_cache_dir = s; return true; } },
 			{ "-h", "--help", cmdline_arg_type_none,
 				"Show help",
 				[&](std::string s) { return (help_or_error = true); } },
@@ -383,6 +405,38 @@ struct rv_jit
 		elf.load(elf_filename, true);
 	}
 
+	/* Name the trace cache after the ELF load segments, the trace cache version and the emitter version */
+	template <typename P>
+	std::string trace_cache_path()
+	{
+		int fd = open(elf_filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			panic("trace_cache_path: error: open: %s: %s", elf_filename.c_str(), strerror(errno));
+		}
+		sha512_ctx_t sha512;
+		u8 digest[SHA512_OUTPUT_BYTES];
+		sha512_init(&sha512);
+		u64 version[2] = { P::trace_cache_version, P::jit_emitter::emitter_version };
+		sha512_update(&sha512, (const unsigned char*)version, sizeof(version));
+		for (auto &phdr : elf.phdrs) {
+			if (phdr.p_type != PT_LOAD) continue;
+			std::vector<u8> buf(phdr.p_filesz);
+			if (pread(fd, buf.data(), buf.size(), phdr.p_offset) != ssize_t(buf.size())) {
+				panic("trace_cache_path: error: read: %s: %s", elf_filename.c_str(), strerror(errno));
+			}
+			u64 vaddr = phdr.p_vaddr;
+			sha512_update(&sha512, (const unsigned char*)&vaddr, sizeof(vaddr));
+			sha512_update(&sha512, buf.data(), buf.size());
+		}
+		close(fd);
+		sha512_final(&sha512, digest);
+		std::string name;
+		for (size_t i = 0; i < SHA512_OUTPUT_BYTES; i++) {
+			name += format_string("%02x", digest[i]);
+		}
+		return trace_cache_dir + "/" + name + ".traces";
+	}
+
 	/* Start the execuatable with the given proxy processor template */
 	template <typename P>
 	void start_jit()
@@ -409,6 +463,11 @@ struct rv_jit
 		proc.mmu.mem->log = (proc.log & proc_log_memory);
 		proc.trace_iters = trace_iters;
 		proc.trace_length = trace_length;
+		proc.trace_cache_limit = trace_cache_mb << 20;
+		proc.trace_thread_enable = trace_thread;
+		if (trace_cache_dir.size() > 0 && mode == jit_mode_trace) {
+			proc.trace_cache_file = trace_cache_path<P>();
+		}
 
 		/* Find the ELF executable PT_LOAD segments and mmap them into user memory */
 		for (size_t i = 0; i < elf.phdrs.size(); i++) {
@@ -25,7 +25,11 @@
 #include <random>
 #include <deque>
 #include <map>
+#include <list>
 #include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
 #include <atomic>
 #include <type_traits>
 
@@ -72,6 +76,7 @@
 #include "processor-histogram.h"
 #include "processor-proxy.h"
 #include "debug-cli.h"
+#include "processor-block.h"
 #include "processor-runloop.h"
 
 #if defined (ENABLE_GPERFTOOL)
@@ -135,6 +140,7 @@ struct rv_emulator
 	int proc_logs = 0;
 	bool help_or_error = false;
 	bool symbolicate = false;
+	bool threaded = false;
 	uint64_t initial_seed = 0;
 	int ext = rv_set_imafdc;
 
@@ -372,6 +378,9 @@ struct rv_emulator
 			{ "-d", "--debug", cmdline_arg_type_none,
 				"Start up in debugger CLI",
 				[&](std::string s) { return (proc_logs |= proc_log_ebreak_cli); } },
+			{ "-D", "--direct-threaded", cmdline_arg_type_none,
+				"Execute pre-decoded blocks with the direct threaded interpreter",
+				[&](std::string s) { return (threaded = true); } },
 			{ "-x", "--no-pseudo", cmdline_arg_type_none,
 				"Disable Pseudoinstruction decoding",
 				[&](std::string s) { return (proc_logs |= proc_log_no_pseudo); } },
@@ -425,6 +434,7 @@ struct rv_emulator
 		/* instantiate processor, set log options and program counter to entry address */
 		P proc;
 		proc.log = proc_logs;
+		proc.threaded = threaded;
 		proc.pc = elf.ehdr.e_entry;
 		proc.mmu.mem->log = (proc.log & proc_log_memory);
 		if (symbolicate) proc.symlookup = [&](addr_t va) { return this->symlookup(va); };
@@ -445,7 +455,8 @@ struct rv_emulator
 		map_proxy_stack(proc, P::mmu_type::memory_top, stack_size);
 		setup_proxy_stack(proc, P::mmu_type::memory_top, stack_size);
 
-		/* Initialize interpreter */
+		/* Initialize interpreter, guest threads run in their own copy of the run loop */
+		proc.template enable_threads<P>();
 		proc.init();
 
 #if defined (ENABLE_GPERFTOOL)
@@ -17,6 +17,7 @@
 #include <climits>
 #include <cfloat>
 #include <cfenv>
+#include <cstddef>
 #include <limits>
 #include <array>
 #include <string>
@@ -26,6 +27,7 @@
 #include <random>
 #include <deque>
 #include <map>
+#include <set>
 #include <thread>
 #include <mutex>
 #include <chrono>
@@ -92,10 +94,19 @@
 #include "processor-histogram.h"
 #include "processor-priv-1.9.h"
 #include "debug-cli.h"
+#include "processor-block.h"
 #include "processor-runloop.h"
+#include "node.h"
 #include "cache.h"
 #include "mmu-soft-cache.h"
 
+#include "asmjit.h"
+
+#include "jit-decode.h"
+#include "jit-emitter-rv64.h"
+#include "jit-fusion.h"
+#include "jit-runloop.h"
+
 #if defined (ENABLE_GPERFTOOL)
 #include "gperftools/profiler.h"
 #endif
@@ -109,6 +120,12 @@ using priv_emulator_rv64imafdc = processor_runloop<processor_privileged<processo
 using priv_cache_emulator_rv32imafdc = processor_runloop<processor_privileged<processor_rv32imafdc_model<decode,processor_priv_rv32imafd,mmu_soft_cache_rv32>>>;
 using priv_cache_emulator_rv64imafdc = processor_runloop<processor_privileged<processor_rv64imafdc_model<decode,processor_priv_rv64imafd,mmu_soft_cache_rv64>>>;
 
+/* Parameterized privileged soft-mmu JIT processor model */
+
+using priv_jit_model_rv64imafdc = processor_rv64imafdc_model<jit_decode,processor_priv_rv64imafd,mmu_soft_rv64>;
+using priv_jit_emulator_rv64imafdc = jit_runloop<processor_privileged<priv_jit_model_rv64imafdc>,
+	jit_fusion<jit_emitter_rv64<priv_jit_model_rv64imafdc>>>;
+
 /* environment variables */
 
 static const char* allowed_env_vars[] = {
@@ -155,6 +172,18 @@ struct rv_emulator
 	s64 ram_boot = 0;
 	uint64_t initial_seed = 0;
         bool use_cache = false;
+	std::string cache_stats_json;
+	bool cache_stats_mmio = false;
+	std::string l1i_cache;
+	std::string l1d_cache;
+	std::string l2_cache;
+	std::string cache_sample;
+	bool use_jit = false;
+	bool threaded = false;
+	size_t num_harts = 1;
+	uint64_t inst_per_tick = 0;
+	int trace_iters = 100;
+	size_t trace_cache_mb = 0;
 
 	std::vector<std::string> host_cmdline;
 	std::vector<std::string> host_env;
@@ -179,6 +208,66 @@ struct rv_emulator
 		return prot;
 	}
 
+	/* Cache statistics pages for L1D, L1I and L2 are optionally mapped read-only from here */
+	static const uintmax_t cache_stats_mpa = 0x40020000ULL;
+
+	cache_geometry parse_cache_geometry(std::string option, std::string spec, cache_geometry geometry)
+	{
+		if (spec.size() > 0 && !geometry.parse(spec)) {
+			const char *problem = geometry.check();
+			panic("error: invalid %s %s%s%s", option.c_str(), spec.c_str(),
+				problem ? ": " : "", problem ? problem : "");
+		}
+		return geometry;
+	}
+
+	template <typename P>
+	auto configure_cache(P &proc, int) -> decltype(proc.mmu.icache, void())
+	{
+		typedef typename P::mmu_type::l1_cache_type l1_cache_type;
+		typedef typename P::mmu_type::l2_cache_type l2_cache_type;
+		proc.mmu.configure_caches(
+			parse_cache_geometry("--l1i-cache", l1i_cache, proc.mmu.icache->geometry),
+			parse_cache_geometry("--l1d-cache", l1d_cache, proc.mmu.dcache->geometry),
+			parse_cache_geometry("--l2-cache", l2_cache, proc.mmu.l2cache->geometry));
+		proc.mmu.cache_stats_json = cache_stats_json;
+		if (cache_sample.size() > 0) {
+			cache_sampler sampler;
+			if (!sampler.parse(cache_sample)) {
+				panic("error: invalid --cache-sample %s", cache_sample.c_str());
+			}
+			proc.mmu.configure_sampling(sampler);
+		}
+		if (cache_stats_mmio) {
+			proc.mmu.mem->add_segment(std::make_shared<cache_stats_mmio_device<l1_cache_type>>
+				(proc.mmu.dcache, cache_stats_mpa));
+			proc.mmu.mem->add_segment(std::make_shared<cache_stats_mmio_device<l1_cache_type>>
+				(proc.mmu.icache, cache_stats_mpa + page_size));
+			proc.mmu.mem->add_segment(std::make_shared<cache_stats_mmio_device<l2_cache_type>>
+				(proc.mmu.l2cache, cache_stats_mpa + page_size * 2));
+		}
+	}
+
+	template <typename P>
+	void configure_cache(P &proc, long) {}
+
+	/* Run the boot hart in this thread and secondary harts in their own threads */
+	template <typename P>
+	auto run_harts(P &proc, exit_cause ex, int) -> decltype(static_cast<processor_singleton*>(&proc), void())
+	{
+		node<P> smp(proc);
+		smp.create_harts(num_harts);
+		smp.start();
+		proc.run(ex);
+		smp.shutdown();
+	}
+
+	template <typename P>
+	void run_harts(P &proc, exit_cause ex, long)
+	{
+		proc.run(ex);
+	}
+
 	/* Map ELF load segments into privileged MMU address space */
 	template <typename P>
 	void map_load_segment_priv(P &proc, const char* filename, Elf64_Phdr &phdr, addr_t map_addr)
@@ -217,6 +306,24 @@ struct rv_emulator
                         { "-a", "--cache-sim", cmdline_arg_type_none,
                                 "Simulate cache",
                                 [&](std::string s) { use_cache = true; return (proc_logs |= proc_log_cache_stats);}},
+			{ "-A", "--cache-stats-json", cmdline_arg_type_string,
+				"Write cache statistics as JSON at exit (implies --cache-sim)",
+				[&](std::string s) { use_cache = true; cache_stats_json = s; return (proc_logs |= proc_log_cache_stats); } },
+			{ "-w", "--cache-stats-mmio", cmdline_arg_type_none,
+				"Map L1D, L1I and L2 statistics read-only from 0x40020000 (implies --cache-sim)",
+				[&](std::string s) { use_cache = cache_stats_mmio = true; return (proc_logs |= proc_log_cache_stats); } },
+			{ "-i", "--l1i-cache", cmdline_arg_type_string,
+				"L1 instruction cache SIZE[:WAYS[:LINE]][:lru|plru|random|srrip][:wb|wt]",
+				[&](std::string s) { use_cache = true; l1i_cache = s; return (proc_logs |= proc_log_cache_stats); } },
+			{ "-k", "--l1d-cache", cmdline_arg_type_string,
+				"L1 data cache SIZE[:WAYS[:LINE]][:lru|plru|random|srrip][:wb|wt]",
+				[&](std::string s) { use_cache = true; l1d_cache = s; return (proc_logs |= proc_log_cache_stats); } },
+			{ "-L", "--l2-cache", cmdline_arg_type_string,
+				"L2 cache SIZE[:WAYS[:LINE]][:lru|plru|random|srrip][:wb|wt] (size 0 disables)",
+				[&](std::string s) { use_cache = true; l2_cache = s; return (proc_logs |= proc_log_cache_stats); } },
+			{ "-y", "--cache-sample", cmdline_arg_type_string,
+				"Sample the cache model every PERIOD:WARMUP:MEASURE instructions (implies --cache-sim)",
+				[&](std::string s) { use_cache = true; cache_sample = s; return (proc_logs |= proc_log_cache_stats); } },
 			{ "-l", "--log-instructions", cmdline_arg_type_none,
 				"Log Instructions",
 				[&](std::string s) { return (proc_logs |= (proc_log_inst | proc_log_trap)); } },
@@ -265,6 +372,24 @@ struct rv_emulator
 			{ "-T", "--debug-trap", cmdline_arg_type_none,
 				"Start up in debugger and enter debugger on trap",
 				[&](std::string s) { return (proc_logs |= (proc_log_ebreak_cli | proc_log_trap_cli)); } },
+			{ "-j", "--jit", cmdline_arg_type_none,
+				"Translate hot traces with the x86-64 JIT (rv64 only)",
+				[&](std::string s) { return (use_jit = true); } },
+			{ "-J", "--trace-iters", cmdline_arg_type_string,
+				"JIT trace iterations (default 100)",
+				[&](std::string s) { trace_iters = strtoull(s.c_str(), nullptr, 10); return true; } },
+			{ "-C", "--jit-cache-mb", cmdline_arg_type_string,
+				"JIT code cache budget in MiB (default unlimited)",
+				[&](std::string s) { trace_cache_mb = strtoull(s.c_str(), nullptr, 10); return true; } },
+			{ "-D", "--direct-threaded", cmdline_arg_type_none,
+				"Execute pre-decoded blocks with the direct threaded interpreter",
+				[&](std::string s) { return (threaded = true); } },
+			{ "-H", "--harts", cmdline_arg_type_string,
+				"Number of harts, each running in its own host thread (default 1)",
+				[&](std::string s) { num_harts = strtoull(s.c_str(), nullptr, 10); return true; } },
+			{ "-V", "--virtual-time", cmdline_arg_type_string,
+				"Derive time from retired instructions per timer tick and skip idle WFI time",
+				[&](std::string s) { inst_per_tick = strtoull(s.c_str(), nullptr, 10); return inst_per_tick > 0; } },
 			{ "-x", "--no-pseudo", cmdline_arg_type_none,
 				"Disable Pseudoinstruction decoding",
 				[&](std::string s) { return (proc_logs |= proc_log_no_pseudo); } },
@@ -327,6 +452,9 @@ struct rv_emulator
 		P proc;
 		proc.log = proc_logs;
 		proc.mmu.mem->log = (proc.log & proc_log_memory);
+		proc.trace_iters = trace_iters;
+		proc.trace_cache_limit = trace_cache_mb << 20;
+		proc.threaded = threaded;
 
 		/* randomise integer register state with 512 bits of entropy */
 		proc.seed_registers(cpu, initial_seed, 512);
@@ -386,15 +514,18 @@ struct rv_emulator
 
                 }
 		/* Initialize interpreter */
+		proc.num_harts = num_harts;
+		proc.inst_per_tick = inst_per_tick;
 		proc.init();
 		proc.reset(); /* Reset code calls mapped ROM image */
-		proc.device_config->num_harts = 1;
-		proc.device_config->time_base = 1000000000;
+		proc.device_config->num_harts = num_harts;
+		proc.device_config->time_base = inst_per_tick ? inst_per_tick : 1000000000;
 		proc.device_config->rom_base = rom_base;
 		proc.device_config->rom_size = rom_size;
 		proc.device_config->rom_entry = rom_entry;
 		proc.device_config->ram_base = default_ram_base;
 		proc.device_config->ram_size = default_ram_size;
+		configure_cache(proc, 0);
 
 #if defined (ENABLE_GPERFTOOL)
 		ProfilerStart("test-emulate.out");
@@ -404,8 +535,8 @@ struct rv_emulator
 		 *
 		 * when --debug flag is present we start in the debugger
 		 */
-		proc.run(proc.log & proc_log_ebreak_cli
-			? exit_cause_cli : exit_cause_continue);
+		run_harts(proc, proc.log & proc_log_ebreak_cli
+			? exit_cause_cli : exit_cause_continue, 0);
 #if defined (ENABLE_GPERFTOOL)
 		ProfilerStop();
 #endif
@@ -421,8 +552,31 @@ struct rv_emulator
 		}
 		#endif
 		
+		/* secondary harts share memory and devices but not caches or traces */
+		if (num_harts > 1 && (use_jit || use_cache)) {
+			panic("error: --harts can not be combined with --jit or --cache-sim");
+		}
+
+		/* JIT traces are triggered from the program counter histogram */
+		if (use_jit) {
+			if (use_cache) {
+				panic("error: --jit can not be combined with --cache-sim");
+			}
+			if (inst_per_tick) {
+				panic("error: --jit can not be combined with --virtual-time");
+			}
+			proc_logs |= proc_log_hist_pc | proc_log_jit_trap;
+		}
+
                 /* execute */
-		if (ram_boot == 0) {
+		if (use_jit) {
+			if (ram_boot == 64 || (ram_boot == 0 && elf.ei_class == ELFCLASS64)) {
+				start_priv<priv_jit_emulator_rv64imafdc>();
+			} else {
+				panic("error: --jit is only supported for rv64");
+			}
+		}
+		else if (ram_boot == 0) {
 		    if(use_cache) {
                         switch(elf.ei_class){
                             case ELFCLASS32:
@@ -440,10 +594,12 @@ struct rv_emulator
                     }
 		}
 		else if (ram_boot == 32) {
-			start_priv<priv_emulator_rv32imafdc>();
+			if (use_cache) start_priv<priv_cache_emulator_rv32imafdc>();
+			else start_priv<priv_emulator_rv32imafdc>();
 		}
 		else if (ram_boot == 64) {
-			start_priv<priv_emulator_rv64imafdc>();
+			if (use_cache) start_priv<priv_cache_emulator_rv64imafdc>();
+			else start_priv<priv_emulator_rv64imafdc>();
 		} else {
 			panic("--boot option must be 32 or 64");
 		}
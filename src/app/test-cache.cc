@@ -26,6 +26,7 @@
 #include <random>
 #include <deque>
 #include <map>
+#include <set>
 #include <thread>
 #include <atomic>
 #include <type_traits>
@@ -75,10 +76,43 @@
 #include "queue.h"
 #include "console.h"
 #include "cache.h"
+#include "mmu-soft-cache.h"
 #include "pma.h"
 
 using namespace riscv;
 
+/* machine mode processor state needed to drive the MMUs directly */
+struct bench_proc
+{
+    typedef u64 ux;
+    u64 mode = rv_mode_M, pdid = 0, sptbr = 0;
+    u32 log = 0;
+    struct { struct { u64 mprv, mpp, vm, mxr, pum; } r; } mstatus = {};
+
+    void raise(int cause, u64 addr) { panic("bench: cause %d addr 0x%llx", cause, addr); }
+};
+
+/* time a load and store to every double word of a working set, returning ns per access */
+template <typename MMU>
+double bench_mmu(MMU &mmu, u64 base, size_t working_set, size_t iters)
+{
+    bench_proc proc;
+    auto &cpu = host_cpu::get_instance();
+    u64 t = cpu.get_time_ns();
+    for (size_t i = 0; i < iters; i++) {
+        for (u64 offset = 0; offset < working_set; offset += 8) {
+            u64 val;
+            mmu.load(proc, base + offset, val);
+            mmu.store(proc, base + offset, val + 1);
+        }
+    }
+    t = cpu.get_time_ns() - t;
+    u64 val;
+    mmu.load(proc, base, val);
+    assert(val == iters);
+    return double(t) / double(iters * (working_set >> 3) * 2);
+}
+
 int main(int argc, char *argv[])
 {       
 
@@ -99,7 +133,7 @@ int main(int argc, char *argv[])
     
     printf("Running tests for direct mapped, write through cache...\n");
 
-    tagged_cache<param_rv64,4096,1,1024> cache_dm(mem,cache_write_through);
+    tagged_cache<param_rv64> cache_dm(mem, cache_geometry(4096, 1, 1024, cache_write_through));
     //Store a value into an empty line in the cache, load to see if we got a hit.
     temp = 23;
     cache_dm.access_cache(0x4ABCDE, 'S', temp); 
@@ -118,16 +152,16 @@ int main(int argc, char *argv[])
     //Check we get 75 back
     assert(z2 == 75);
     assert(z2 != 23);
-    //Check the ppn was changed
-    assert(cache_dm.cache_key[cache_dm.lookup_cache_line(0x4ACCDA)].ppn != 0x4ab);
+    //Check the tag was changed
+    assert(cache_dm.cache_key[cache_dm.lookup_cache_line(0x4ACCDA)].tag != 0x4ab);
     //Load the previous tag back in, check that it still retains its old value from main memory
     cache_dm.access_cache(0x4abcde, 'L',z3);
     assert(cache_dm.last_access == cache_line_must_evict);
     mem->load(0x4abcde, memVal);
     assert(z3 == 23);
     assert(z3 == y2);
-    //Lookup the 0x2accda mpa, check that the ppn there is for 0x2ab since we loaded it in.
-    assert(cache_dm.cache_key[cache_dm.lookup_cache_line(0x4accda)].ppn == 0x4ab);
+    //Lookup the 0x2accda mpa, check that the tag there is for 0x2ab since we loaded it in.
+    assert(cache_dm.cache_key[cache_dm.lookup_cache_line(0x4accda)].tag == 0x4ab);
   
     ////////////////////////
     //Direct mapped, write back tests
@@ -137,7 +171,7 @@ int main(int argc, char *argv[])
 
     mem->clear_segments();
     mem->add_ram(0x1000, 0x40000000 - 0x1000);
-    tagged_cache<param_rv64, 4096, 1, 16> cache_dm_wb(mem);
+    tagged_cache<param_rv64> cache_dm_wb(mem, cache_geometry(4096, 1, 16));
     //Store some values into memory
     temp = 23; temp2 = 14; temp3 = 35;
     cache_dm_wb.access_cache(0x11ccf, 'S', temp);
@@ -187,7 +221,7 @@ int main(int argc, char *argv[])
     printf("Running tests for set associative, write through cache...\n");
     mem->clear_segments();
     mem->add_ram(0x30000, 0x40000000LL - 0x30000);
-    tagged_cache<param_rv64,8192, 2, 256> cache_sa_wt(mem, cache_write_through);
+    tagged_cache<param_rv64> cache_sa_wt(mem, cache_geometry(8192, 2, 256, cache_write_through));
     //Store some values into a set
     temp = 110; temp2 = 33;
     cache_sa_wt.access_cache(0x41a22, 'S', temp);
@@ -243,7 +277,7 @@ int main(int argc, char *argv[])
     //Clear main memory, refill it with new RAM
     mem->clear_segments();
     mem->add_ram(0x20000, 0x40000000LL - 0x20000);
-    tagged_cache<param_rv64,16384,4,256> cache_sa(mem);
+    tagged_cache<param_rv64> cache_sa(mem, cache_geometry(16384, 4, 256));
     //Fill a set with data
     temp = 76; temp2 = 55; temp3 = 23;
     cache_sa.access_cache(0x20000,'S',temp);
@@ -379,7 +413,7 @@ int main(int argc, char *argv[])
     printf("Running tests for values larger than one byte...\n");
     mem->clear_segments();
     mem->add_ram(0x20000, 0x40000000LL - 0x20000);
-    tagged_cache<param_rv64,32768,8,64> cache_t(mem,cache_write_through);
+    tagged_cache<param_rv64> cache_t(mem, cache_geometry(32768, 8, 64, cache_write_through));
     cache_t.default_ram_base = 0x20000;
     cache_t.default_ram_size = 0x40000000LL - 0x20000;
     temp_16 = 0x2311;
@@ -408,7 +442,159 @@ int main(int argc, char *argv[])
     temp_64_3 = 0;
     mem->load(0x6421aa,temp_64_3);
     assert(temp_64_3 == temp_64_3);
+
+    //////////////////////////////////////
+    //Tests for cache statistics
+    /////////////////////////////////////
+    printf("Running tests for cache statistics...\n");
+    typedef tagged_cache<param_rv64> stats_cache_t;
+    std::shared_ptr<stats_cache_t> cache_st = std::make_shared<stats_cache_t>(mem, cache_geometry(4096, 1, 16));
+    cache_st->default_ram_base = 0x20000;
+    cache_st->default_ram_size = 0x40000000LL - 0x20000;
+    //Miss into an empty line, hit it, then evict the dirty line from the same set
+    cache_st->store(0x40100, temp_64);
+    cache_st->load(0x40108, temp_64_2);
+    cache_st->load(0x50100, temp_64_2);
+    assert(cache_st->stats.loads == 2 && cache_st->stats.stores == 1);
+    assert(cache_st->stats.hits == 1 && cache_st->stats.misses == 2);
+    assert(cache_st->stats.evictions == 1 && cache_st->stats.writebacks == 1);
+    assert(cache_st->set_conflicts[0x10] == 1 && cache_st->set_conflicts[0] == 0);
+    //The MMIO window exposes the same counters followed by the geometry
+    cache_stats_mmio_device<stats_cache_t> cache_st_mmio(cache_st, 0x40020000);
+    cache_st_mmio.load(8 * 2, temp_64_2);
+    assert(temp_64_2 == 1);
+    cache_st_mmio.load(8 * 6, temp_64_2);
+    assert(temp_64_2 == 256);
+    cache_st_mmio.load(8 * 7, temp_64_2);
+    assert(temp_64_2 == 1);
+    cache_st_mmio.load(8 * (8 + 0x10), temp_64_2);
+    assert(temp_64_2 == 1);
+
+    //////////////////////////////////////
+    //Tests for replacement policies and geometry
+    /////////////////////////////////////
+    printf("Running tests for replacement policies...\n");
+    //Tree PLRU: after touching ways 0..3 in order, victims follow the tree away from recent ways
+    cache_replacement_plru plru(1, 4);
+    for (size_t way = 0; way < 4; way++) plru.fill(0, way);
+    assert(plru.victim(0) == 0);
+    plru.hit(0, 0);
+    assert(plru.victim(0) == 2);
+    plru.hit(0, 2);
+    assert(plru.victim(0) == 1);
+    //SRRIP: hit lines are kept over filled lines, and a full set ages until a victim is found
+    cache_replacement_srrip srrip(1, 4);
+    for (size_t way = 0; way < 4; way++) srrip.fill(0, way);
+    srrip.hit(0, 0); srrip.hit(0, 1); srrip.hit(0, 3);
+    assert(srrip.victim(0) == 2);
+    srrip.fill(0, 2);
+    assert(srrip.victim(0) == 2);
+    //Random stays within the set
+    cache_replacement_random rnd(1, 8);
+    for (size_t i = 0; i < 64; i++) assert(rnd.victim(0) < 8);
+    //Geometry strings
+    cache_geometry geom;
+    assert(geom.parse("16K:4:32:plru:wt"));
+    assert(geom.size == 16384 && geom.ways == 4 && geom.line_size == 32);
+    assert(geom.replacement == "plru" && geom.write_policy == cache_write_through);
+    assert(geom.parse("1M") && geom.size == 1048576 && geom.ways == 4);
+    assert(!geom.parse("24K:4:32"));
+    assert(!cache_geometry().parse("16K:4:32:fifo"));
+    assert(!cache_geometry().parse("16K:128:64"));
+
+    //////////////////////////////////////
+    //Tests for a two level hierarchy
+    /////////////////////////////////////
+    printf("Running tests for a two level hierarchy...\n");
+    typedef tagged_cache<param_rv64> l2_t;
+    typedef tagged_cache<param_rv64,l2_t> l1_t;
+    std::shared_ptr<l2_t> l2 = std::make_shared<l2_t>(mem, cache_geometry(65536, 8, 128, cache_write_back, "plru"));
+    l1_t l1(l2, cache_geometry(4096, 2, 64, cache_write_back, "srrip"));
+    l2->default_ram_base = l1.default_ram_base = 0x20000;
+    l2->default_ram_size = l1.default_ram_size = 0x40000000LL - 0x20000;
+    //An L1 miss fills one line from the L2, which fills its larger line from memory
+    mem->store(0x100040, u64(0x1122334455667788));
+    l1.load(0x100040, temp_64_2);
+    assert(temp_64_2 == 0x1122334455667788);
+    assert(l1.stats.misses == 1 && l2->stats.loads == 1 && l2->stats.misses == 1);
+    //The other half of the L2 line hits in the L2
+    l1.load(0x100000, temp_64_2);
+    assert(l1.stats.misses == 2 && l2->stats.hits == 1);
+    //Dirty L1 lines only reach memory through the L2 once both are flushed
+    l1.store(0x100040, u64(0xdeadbeef));
+    mem->load(0x100040, temp_64_2);
+    assert(temp_64_2 == 0x1122334455667788);
+    assert(l1.flush() == 0);
+    assert(l2->stats.stores == 1 && l1.stats.writebacks == 1);
+    mem->load(0x100040, temp_64_2);
+    assert(temp_64_2 == 0x1122334455667788);
+    assert(l2->flush() == 0);
+    mem->load(0x100040, temp_64_2);
+    assert(temp_64_2 == 0xdeadbeef);
+    //Accesses that cross a line are split
+    l1.store(0x10007c, u64(0x0102030405060708));
+    l1.load(0x10007c, temp_64_2);
+    assert(temp_64_2 == 0x0102030405060708);
+    //A disabled level passes accesses through
+    l2_t l2_off(mem, cache_geometry(0));
+    l2_off.load(0x100040, temp_64_2);
+    assert(temp_64_2 == 0xdeadbeef && l2_off.stats.loads == 0);
+    //fence.i makes dirty write back data lines visible to instruction fetch and memory
+    std::unique_ptr<mmu_soft_cache_rv64> mmu_wb(new mmu_soft_cache_rv64());
+    mmu_wb->mem->add_ram(0x80000000, 0x100000);
+    cache_geometry wb_geom(32768, 8, 64, cache_write_back);
+    mmu_wb->configure_caches(wb_geom, wb_geom, cache_geometry(262144, 8, 64, cache_write_back));
+    u32 inst_word;
+    mmu_wb->fetch_mem(0x80001000, inst_word);
+    assert(inst_word == 0);
+    mmu_wb->store_mem(0x80001000, u32(0x00000013));
+    mmu_wb->sync_icache();
+    mmu_wb->fetch_mem(0x80001000, inst_word);
+    assert(inst_word == 0x00000013);
+    mmu_wb->mem->load(0x80001000, inst_word);
+    assert(inst_word == 0x00000013);
+
+    //////////////////////////////////////
+    //Tests for sampled simulation
+    /////////////////////////////////////
+    printf("Running tests for sampled simulation...\n");
+    cache_sample_stat sample_stat;
+    for (double x : { 2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0 }) sample_stat.add(x);
+    assert(sample_stat.n == 8 && sample_stat.mean == 5.0);
+    assert(fabs(sample_stat.ci95() - 1.96 * sqrt(32.0 / 7.0 / 8.0)) < 1e-12);
+    cache_sampler sampler;
+    assert(sampler.parse("10M:100K:50K"));
+    assert(sampler.period == 10000000 && sampler.warmup == 100000 && sampler.measure == 50000);
+    assert(sampler.phase_end == 10000000 - 150000);
+    assert(!cache_sampler().parse("1K:1K:1K"));
+    assert(!cache_sampler().parse("1M:0:0"));
+    //Windows are measured with the caches and the rest of each period bypasses them
+    std::unique_ptr<mmu_soft_cache_rv64> mmu_sampled(new mmu_soft_cache_rv64());
+    mmu_sampled->configure_sampling(sampler);
+    assert(!mmu_sampled->detailed);
+    assert(mmu_sampled->sample(0, 100000000) == 10000000 - 150000);
+    assert(mmu_sampled->sample(10000000 - 150000, 100000000) == 100000 && mmu_sampled->detailed);
+    assert(mmu_sampled->sample(10000000 - 50000, 100000000) == 50000 && mmu_sampled->detailed);
+    assert(mmu_sampled->sample(10000000, 100000000) == 10000000 - 150000 && !mmu_sampled->detailed);
+    assert(mmu_sampled->sampler.mpki[0].n == 1);
     printf("All tests passed!\n");
+
+    //////////////////////////////////////
+    //Benchmark the cache model against the soft MMU
+    /////////////////////////////////////
+    static const size_t bench_sizes[] = { 16 << 10, 1 << 20 };
+    for (size_t working_set : bench_sizes) {
+        size_t iters = (8 << 20) / working_set;
+        mmu_soft_rv64 mmu;
+        mmu.mem->add_ram(0x80000000, 0x1000000);
+        std::unique_ptr<mmu_soft_cache_rv64> mmu_cache(new mmu_soft_cache_rv64());
+        mmu_cache->mem->add_ram(0x80000000, 0x1000000);
+        double soft_ns = bench_mmu(mmu, 0x80000000, working_set, iters);
+        double cache_ns = bench_mmu(*mmu_cache, 0x80000000, working_set, iters);
+        printf("Benchmark %5zu KiB working set: mmu_soft %6.2f ns/access, "
+            "mmu_soft_cache %6.2f ns/access, slowdown %5.1fx\n",
+            working_set >> 10, soft_ns, cache_ns, cache_ns / soft_ns);
+    }
 }       
 
 
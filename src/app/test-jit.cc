@@ -26,7 +26,12 @@
 #include <random>
 #include <deque>
 #include <map>
+#include <set>
+#include <list>
 #include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
 #include <atomic>
 #include <type_traits>
 
@@ -70,6 +75,8 @@
 #include "processor-histogram.h"
 #include "processor-proxy.h"
 #include "debug-cli.h"
+#include "processor-block.h"
+#include "queue.h"
 
 #include "asmjit.h"
 
@@ -104,20 +111,25 @@ struct rv_test_jit
 
 	rv_test_jit() : total_tests(0), tests_passed(0) {}
 
-	void run_test(const char* test_name, P &proc, addr_t pc, size_t step)
+	void run_test(const char* test_name, P &proc, addr_t pc, size_t step, bool reload = false)
 	{
 		printf("\n=========================================================\n");
 		printf("TEST: %s\n", test_name);
 		typename P::ireg_t save_regs[P::ireg_count];
+		typename P::freg_t save_fregs[P::freg_count];
 		size_t regfile_size = sizeof(typename P::ireg_t) * P::ireg_count;
+		size_t fregfile_size = sizeof(typename P::freg_t) * P::freg_count;
+		u32 interp_fflags = 0, jit_fflags = 0;
 
 		/* create 256MB RAM at 256MB */
 		proc.mmu.mem->brk = proc.mmu.mem->heap_begin = proc.mmu.mem->heap_end = 0x10000000;
 		proc.ireg[rv_ireg_a0] = 0x20000000;
 		abi_sys_brk(proc);
 
-		/* clear registers */
+		/* clear registers and accrued exceptions */
 		memset(&proc.ireg[0], 0, regfile_size);
+		memset(&proc.freg[0], 0, fregfile_size);
+		feclearexcept(FE_ALL_EXCEPT);
 
 		/* step the interpreter */
 		printf("\n--[ interp ]---------------\n");
@@ -125,9 +137,13 @@ struct rv_test_jit
 		proc.pc = pc;
 		proc.step(step);
 
-		/* save and reset registers */
+		/* save and reset registers and accrued exceptions */
+		fenv_getflags(interp_fflags);
+		feclearexcept(FE_ALL_EXCEPT);
 		memcpy(&save_regs[0], &proc.ireg[0], regfile_size);
+		memcpy(&save_fregs[0], &proc.freg[0], fregfile_size);
 		memset(&proc.ireg[0], 0, regfile_size);
+		memset(&proc.freg[0], 0, fregfile_size);
 
 		/* compile the program buffer trace */
 		printf("\n--[ jit ]------------------\n");
@@ -135,11 +151,23 @@ struct rv_test_jit
 		proc.pc = pc;
 		proc.jit_trace();
 
-		/* reset registers */
+		/* save the trace and install it again from the saved trace cache */
+		if (reload) {
+			proc.trace_cache_file = format_string("/tmp/test-jit-%d.traces", getpid());
+			proc.save_trace_cache();
+			proc.clear_trace_cache();
+			proc.load_trace_cache();
+			unlink(proc.trace_cache_file.c_str());
+		}
+
+		/* reset registers and accrued exceptions */
 		memset(&proc.ireg[0], 0, regfile_size);
+		memset(&proc.freg[0], 0, fregfile_size);
+		feclearexcept(FE_ALL_EXCEPT);
 
 		/* run compiled trace */
 		proc.jit_exec(proc, pc);
+		fenv_getflags(jit_fflags);
 
 		/* print result */
 		printf("\n--[ result ]---------------\n");
@@ -152,6 +180,23 @@ struct rv_test_jit
 					rv_ireg_name_sym[i], proc.ireg[i].r.xu.val);
 			}
 		}
+		for (size_t i = 0; i < P::freg_count; i++) {
+			if (save_fregs[i].r.xu.val != proc.freg[i].r.xu.val) {
+				pass = false;
+				printf("ERROR interp-%s=0x%016llx jit-%s=0x%016llx\n",
+					rv_freg_name_sym[i], save_fregs[i].r.xu.val,
+					rv_freg_name_sym[i], proc.freg[i].r.xu.val);
+			}
+		}
+		if (interp_fflags != jit_fflags) {
+			pass = false;
+			printf("ERROR interp-fflags=0x%02x jit-fflags=0x%02x\n",
+				interp_fflags, jit_fflags);
+		}
+		if (reload && proc.trace_loads != 1) {
+			pass = false;
+			printf("ERROR traces-loaded=%llu\n", proc.trace_loads);
+		}
 		printf("%s\n", pass ? "PASS" : "FAIL");
 		if (pass) tests_passed++;
 		total_tests++;
@@ -1539,6 +1584,21 @@ struct rv_test_jit
 		run_test(__func__, proc, (addr_t)as.get_section(".text")->buf.data(), 5);
 	}
 
+	void test_trace_cache_1()
+	{
+		P proc;
+		assembler as;
+
+		as.load_imm(rv_ireg_a0, 0x10000000);
+		as.load_imm(rv_ireg_s1, 0x12345678);
+		asm_sd(as, rv_ireg_a0, rv_ireg_s1, 0);
+		asm_ld(as, rv_ireg_s2, rv_ireg_a0, 0);
+		asm_ebreak(as);
+		as.link();
+
+		run_test(__func__, proc, (addr_t)as.get_section(".text")->buf.data(), 5, true);
+	}
+
 	void test_sw_lw_1()
 	{
 		P proc;
@@ -1899,6 +1959,241 @@ struct rv_test_jit
 		run_test(__func__, proc, (addr_t)as.get_section(".text")->buf.data(), 5);
 	}
 
+	/* floating point ops are cross-checked against the interpreter (registers and fflags) */
+
+	void load_fimm_d(assembler &as, int frd, f64 val)
+	{
+		f64_bits b = { .f = val };
+		as.load_imm(rv_ireg_t0, b.u);
+		asm_fmv_d_x(as, frd, rv_ireg_t0);
+	}
+
+	void load_fimm_s(assembler &as, int frd, f32 val)
+	{
+		f32_bits b = { .f = val };
+		as.load_imm(rv_ireg_t0, s32(b.u));
+		asm_fmv_s_x(as, frd, rv_ireg_t0);
+	}
+
+	void run_fp_test(const char* test_name, assembler &as)
+	{
+		P proc;
+		asm_ebreak(as);
+		as.link();
+		auto &buf = as.get_section(".text")->buf;
+		run_test(test_name, proc, (addr_t)buf.data(), buf.size() / 4 - 1);
+	}
+
+	void test_fadd_d_1()
+	{
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, 1.5);
+		load_fimm_d(as, rv_freg_fa1, 2.25);
+		asm_fadd_d(as, rv_freg_fa2, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fsub_d(as, rv_freg_fa3, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fmul_d(as, rv_freg_fa4, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fdiv_d(as, rv_freg_fa5, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fdiv_d_inexact()
+	{
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, 1.0);
+		load_fimm_d(as, rv_freg_fa1, 3.0);
+		asm_fdiv_d(as, rv_freg_fa2, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fdiv_d_zero()
+	{
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, 1.0);
+		asm_fdiv_d(as, rv_freg_fa2, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fsqrt_d_1()
+	{
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, 2.0);
+		load_fimm_d(as, rv_freg_fa1, -1.0);
+		asm_fsqrt_d(as, rv_freg_fa2, rv_freg_fa0, rv_rm_dyn);
+		asm_fsqrt_d(as, rv_freg_fa3, rv_freg_fa1, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fadd_s_1()
+	{
+		assembler as;
+		load_fimm_s(as, rv_freg_fa0, 1.5f);
+		load_fimm_s(as, rv_freg_fa1, 0.1f);
+		asm_fadd_s(as, rv_freg_fa2, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fsub_s(as, rv_freg_fa3, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fmul_s(as, rv_freg_fa4, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fdiv_s(as, rv_freg_fa5, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fsqrt_s(as, rv_freg_fa6, rv_freg_fa0, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fmadd_d_1()
+	{
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, 1.5);
+		load_fimm_d(as, rv_freg_fa1, 4.0);
+		load_fimm_d(as, rv_freg_fa2, 0.25);
+		asm_fmadd_d(as, rv_freg_fs0, rv_freg_fa0, rv_freg_fa1, rv_freg_fa2, rv_rm_dyn);
+		asm_fmsub_d(as, rv_freg_fs1, rv_freg_fa0, rv_freg_fa1, rv_freg_fa2, rv_rm_dyn);
+		asm_fnmsub_d(as, rv_freg_fs2, rv_freg_fa0, rv_freg_fa1, rv_freg_fa2, rv_rm_dyn);
+		asm_fnmadd_d(as, rv_freg_fs3, rv_freg_fa0, rv_freg_fa1, rv_freg_fa2, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fmadd_s_1()
+	{
+		assembler as;
+		load_fimm_s(as, rv_freg_fa0, 1.5f);
+		load_fimm_s(as, rv_freg_fa1, 4.0f);
+		load_fimm_s(as, rv_freg_fa2, 0.25f);
+		asm_fmadd_s(as, rv_freg_fs0, rv_freg_fa0, rv_freg_fa1, rv_freg_fa2, rv_rm_dyn);
+		asm_fmsub_s(as, rv_freg_fs1, rv_freg_fa0, rv_freg_fa1, rv_freg_fa2, rv_rm_dyn);
+		asm_fnmsub_s(as, rv_freg_fs2, rv_freg_fa0, rv_freg_fa1, rv_freg_fa2, rv_rm_dyn);
+		asm_fnmadd_s(as, rv_freg_fs3, rv_freg_fa0, rv_freg_fa1, rv_freg_fa2, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fmadd_d_inexact()
+	{
+		/* 0.1 * 0.1 - 0.01 differs between a fused and an unfused multiply add */
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, 0.1);
+		load_fimm_d(as, rv_freg_fa1, 0.01);
+		asm_fmadd_d(as, rv_freg_fs0, rv_freg_fa0, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fmsub_d(as, rv_freg_fs1, rv_freg_fa0, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fnmsub_d(as, rv_freg_fs2, rv_freg_fa0, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fnmadd_d(as, rv_freg_fs3, rv_freg_fa0, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fmadd_s_inexact()
+	{
+		assembler as;
+		load_fimm_s(as, rv_freg_fa0, 0.1f);
+		load_fimm_s(as, rv_freg_fa1, 0.01f);
+		asm_fmadd_s(as, rv_freg_fs0, rv_freg_fa0, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fmsub_s(as, rv_freg_fs1, rv_freg_fa0, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fnmsub_s(as, rv_freg_fs2, rv_freg_fa0, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		asm_fnmadd_s(as, rv_freg_fs3, rv_freg_fa0, rv_freg_fa0, rv_freg_fa1, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fsgnj_d_1()
+	{
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, 1.5);
+		load_fimm_d(as, rv_freg_fa1, -2.0);
+		asm_fsgnj_d(as, rv_freg_fa2, rv_freg_fa0, rv_freg_fa1);
+		asm_fsgnjn_d(as, rv_freg_fa3, rv_freg_fa0, rv_freg_fa1);
+		asm_fsgnjx_d(as, rv_freg_fa4, rv_freg_fa1, rv_freg_fa1);
+		asm_fsgnj_s(as, rv_freg_fa5, rv_freg_fa0, rv_freg_fa1);
+		asm_fsgnjn_s(as, rv_freg_fa6, rv_freg_fa0, rv_freg_fa1);
+		asm_fsgnjx_s(as, rv_freg_fa7, rv_freg_fa1, rv_freg_fa1);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fmin_fmax_d_1()
+	{
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, 1.5);
+		load_fimm_d(as, rv_freg_fa1, -2.0);
+		load_fimm_d(as, rv_freg_fa2, std::numeric_limits<f64>::quiet_NaN());
+		asm_fmin_d(as, rv_freg_fs0, rv_freg_fa0, rv_freg_fa1);
+		asm_fmax_d(as, rv_freg_fs1, rv_freg_fa0, rv_freg_fa1);
+		asm_fmin_d(as, rv_freg_fs2, rv_freg_fa0, rv_freg_fa2);
+		asm_fmax_d(as, rv_freg_fs3, rv_freg_fa2, rv_freg_fa0);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fmin_fmax_s_1()
+	{
+		assembler as;
+		load_fimm_s(as, rv_freg_fa0, 1.5f);
+		load_fimm_s(as, rv_freg_fa1, -2.0f);
+		load_fimm_s(as, rv_freg_fa2, std::numeric_limits<f32>::quiet_NaN());
+		asm_fmin_s(as, rv_freg_fs0, rv_freg_fa0, rv_freg_fa1);
+		asm_fmax_s(as, rv_freg_fs1, rv_freg_fa0, rv_freg_fa1);
+		asm_fmin_s(as, rv_freg_fs2, rv_freg_fa0, rv_freg_fa2);
+		asm_fmax_s(as, rv_freg_fs3, rv_freg_fa2, rv_freg_fa0);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fcmp_d_1()
+	{
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, 1.5);
+		load_fimm_d(as, rv_freg_fa1, -2.0);
+		load_fimm_d(as, rv_freg_fa2, std::numeric_limits<f64>::quiet_NaN());
+		asm_feq_d(as, rv_ireg_a0, rv_freg_fa0, rv_freg_fa0);
+		asm_flt_d(as, rv_ireg_a1, rv_freg_fa1, rv_freg_fa0);
+		asm_fle_d(as, rv_ireg_a2, rv_freg_fa0, rv_freg_fa1);
+		asm_feq_d(as, rv_ireg_a3, rv_freg_fa2, rv_freg_fa0);
+		asm_flt_d(as, rv_ireg_s0, rv_freg_fa2, rv_freg_fa0);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fcmp_s_1()
+	{
+		assembler as;
+		load_fimm_s(as, rv_freg_fa0, 1.5f);
+		load_fimm_s(as, rv_freg_fa1, -2.0f);
+		asm_feq_s(as, rv_ireg_a0, rv_freg_fa0, rv_freg_fa0);
+		asm_flt_s(as, rv_ireg_a1, rv_freg_fa1, rv_freg_fa0);
+		asm_fle_s(as, rv_ireg_s1, rv_freg_fa0, rv_freg_fa1);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fcvt_1()
+	{
+		assembler as;
+		as.load_imm(rv_ireg_a0, -7);
+		as.load_imm(rv_ireg_s0, 0x123456789ULL);
+		asm_fcvt_d_w(as, rv_freg_fa0, rv_ireg_a0, rv_rm_dyn);
+		asm_fcvt_d_wu(as, rv_freg_fa1, rv_ireg_a0, rv_rm_dyn);
+		asm_fcvt_d_l(as, rv_freg_fa2, rv_ireg_s0, rv_rm_dyn);
+		asm_fcvt_s_w(as, rv_freg_fa3, rv_ireg_a0, rv_rm_dyn);
+		asm_fcvt_s_wu(as, rv_freg_fa4, rv_ireg_a0, rv_rm_dyn);
+		asm_fcvt_s_l(as, rv_freg_fa5, rv_ireg_s0, rv_rm_dyn);
+		asm_fcvt_s_d(as, rv_freg_fa6, rv_freg_fa2, rv_rm_dyn);
+		asm_fcvt_d_s(as, rv_freg_fa7, rv_freg_fa6, rv_rm_dyn);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fmv_x_1()
+	{
+		assembler as;
+		load_fimm_d(as, rv_freg_fa0, -1.5);
+		load_fimm_d(as, rv_freg_fa1, std::numeric_limits<f64>::quiet_NaN());
+		load_fimm_s(as, rv_freg_fa2, -1.5f);
+		asm_fmv_x_d(as, rv_ireg_a0, rv_freg_fa0);
+		asm_fmv_x_d(as, rv_ireg_s1, rv_freg_fa1);
+		asm_fmv_x_s(as, rv_ireg_a2, rv_freg_fa2);
+		run_fp_test(__func__, as);
+	}
+
+	void test_fsd_fld_1()
+	{
+		assembler as;
+		as.load_imm(rv_ireg_a0, 0x10000000);
+		load_fimm_d(as, rv_freg_fa0, 3.25);
+		load_fimm_s(as, rv_freg_fa1, -0.5f);
+		asm_fsd(as, rv_ireg_a0, rv_freg_fa0, 0);
+		asm_fsw(as, rv_ireg_a0, rv_freg_fa1, 8);
+		asm_fld(as, rv_freg_fs0, rv_ireg_a0, 0);
+		asm_flw(as, rv_freg_fs1, rv_ireg_a0, 8);
+		asm_ld(as, rv_ireg_a1, rv_ireg_a0, 0);
+		run_fp_test(__func__, as);
+	}
+
 	void print_summary()
 	{
 		printf("\n%d/%d tests successful\n", tests_passed, total_tests);
@@ -1998,6 +2293,7 @@ int main(int argc, char *argv[])
 	test.test_sd_ld_2();
 	test.test_sd_ld_3();
 	test.test_sd_ld_4();
+	test.test_trace_cache_1();
 	test.test_sw_lw_1();
 	test.test_sw_lw_2();
 	test.test_sw_lw_3();
@@ -2022,5 +2318,22 @@ int main(int argc, char *argv[])
 	test.test_sb_lbu_2();
 	test.test_sb_lbu_3();
 	test.test_sb_lbu_4();
+	test.test_fadd_d_1();
+	test.test_fdiv_d_inexact();
+	test.test_fdiv_d_zero();
+	test.test_fsqrt_d_1();
+	test.test_fadd_s_1();
+	test.test_fmadd_d_1();
+	test.test_fmadd_s_1();
+	test.test_fmadd_d_inexact();
+	test.test_fmadd_s_inexact();
+	test.test_fsgnj_d_1();
+	test.test_fmin_fmax_d_1();
+	test.test_fmin_fmax_s_1();
+	test.test_fcmp_d_1();
+	test.test_fcmp_s_1();
+	test.test_fcvt_1();
+	test.test_fmv_x_1();
+	test.test_fsd_fld_1();
 	test.print_summary();
 }
@@ -17,6 +17,7 @@
 #include <vector>
 #include <limits>
 #include <map>
+#include <set>
 
 #include <sys/mman.h>
 
@@ -40,6 +41,13 @@
 
 using namespace riscv;
 
+/* supervisor mode processor state needed to drive the MMU directly */
+struct walk_proc : processor_rv64imafd
+{
+	u64 mode = rv_mode_S, pdid = 0, sptbr = 0;
+	struct { struct { u64 mprv, mpp, vm, mxr, pum; } r; } mstatus = {};
+};
+
 int main(int argc, char *argv[])
 {
 	assert(page_shift == 12);
@@ -67,7 +75,7 @@ int main(int argc, char *argv[])
 	mmu_type mmu;
 
 	// insert entry for VA 0x10000 into the TLB (PDID=0, ASID=0, VA=0x10000, PPN=1, PTE.bits=DAGURWXV)
-	mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000, /* PTE level */ 2, /* PTE.bits */ 0xff, /* PPN */ 0x1);
+	mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000, /* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x1);
 
 	// test that PPN 1 is returned for (PDID=0, ASID=0, VA=0x10000) -> PPN=1, PTE.bits=DAGURWXV)
 	tlb_type::tlb_entry_t *tlb_ent = mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000);
@@ -87,6 +95,57 @@ int main(int argc, char *argv[])
 	// test that invalid_ppn is returned for (VA=0x10000, ASID=0)
 	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000) == nullptr);
 
+	// fill one set past its associativity, the least recently used entry moves to the victim buffer
+	for (size_t i = 0; i <= tlb_type::ways; i++) {
+		mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ (0x10 + i * tlb_type::sets) << page_shift,
+			/* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x100 + i);
+	}
+	tlb_ent = mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10 << page_shift);
+	assert(tlb_ent != nullptr);
+	assert(tlb_ent->ppn == 0x100);
+	assert(tlb_ent == mmu.l1_dtlb.tlb + (0x10 & tlb_type::mask) * tlb_type::ways);
+	assert(mmu.l1_dtlb.victim_hits == 1);
+
+	// a 2MiB superpage maps every page in its range with a single entry
+	mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x200000, /* PTE level */ 1, /* PTE.bits */ 0xff, /* PPN */ 0x400);
+	tlb_ent = mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x3ff000);
+	assert(tlb_ent != nullptr);
+	assert(tlb_ent->ppn == 0x400);
+	assert(tlb_ent->ptel == 1);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x400000) == nullptr);
+	mmu.l1_dtlb.flush(0);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x200000) == nullptr);
+
+	// an ASID flush only invalidates entries of that ASID, ASID 0 flushes all entries
+	mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 1, /* VA */ 0x10000, /* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x1);
+	mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 2, /* VA */ 0x20000, /* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x2);
+	mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 2, /* VA */ 0x200000, /* PTE level */ 1, /* PTE.bits */ 0xff, /* PPN */ 0x400);
+	mmu.l1_dtlb.flush(/* PDID */ 0, /* ASID */ 1);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 1, /* VA */ 0x10000) == nullptr);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 2, /* VA */ 0x20000) != nullptr);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 2, /* VA */ 0x201000) != nullptr);
+	mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 1, /* VA */ 0x10000, /* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x1);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 1, /* VA */ 0x10000) != nullptr);
+	mmu.l1_dtlb.flush(/* PDID */ 0, /* ASID */ 0);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 1, /* VA */ 0x10000) == nullptr);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 2, /* VA */ 0x20000) == nullptr);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 2, /* VA */ 0x201000) == nullptr);
+
+	// walks start below the deepest cached non-leaf PTE for the same root and VA prefix
+	typename tlb_type::UX table = 0;
+	assert(mmu.pwc.walk_start<sv39>(/* root */ 0x80, /* VA */ 0x40201000, table) == 2);
+	mmu.pwc.insert<sv39>(/* root */ 0x80, /* VA */ 0x40201000, /* level */ 2, /* table */ 0x2000);
+	assert(mmu.pwc.walk_start<sv39>(/* root */ 0x80, /* VA */ 0x40201000, table) == 1);
+	assert(table == 0x2000);
+	mmu.pwc.insert<sv39>(/* root */ 0x80, /* VA */ 0x40201000, /* level */ 1, /* table */ 0x3000);
+	assert(mmu.pwc.walk_start<sv39>(/* root */ 0x80, /* VA */ 0x40201000, table) == 0);
+	assert(table == 0x3000);
+	assert(mmu.pwc.walk_start<sv48>(/* root */ 0x80, /* VA */ 0x40201000, table) == 3);
+	assert(mmu.pwc.walk_start<sv39>(/* root */ 0x81, /* VA */ 0x40201000, table) == 2);
+	assert(mmu.pwc.saved == 3);
+	mmu.pwc.flush();
+	assert(mmu.pwc.walk_start<sv39>(/* root */ 0x80, /* VA */ 0x40201000, table) == 2);
+
 	// add RAM to the MMU emulation (exclude zero page)
 	mmu.mem->add_ram(0x1000, /*1GB*/0x40000000LL - 0x1000);
 
@@ -95,4 +154,119 @@ int main(int argc, char *argv[])
 	addr_t uva = mmu.mem->mpa_to_uva(segment, 0x1000);
 	assert(segment);
 	assert(uva == mmu.mem->segments.front()->uva + 0x0LL); 
+
+	// test that the zero page has no host mapping and RAM pages do
+	assert(mmu.mem->mpa_to_host_page(0x0, pma_type_main) == 0);
+	assert(mmu.mem->mpa_to_host_page(0x1000, pma_type_main | pma_prot_write) == uva);
+
+	// record the host address for a load from VA 0x10234 (MPA 0x1234)
+	tlb_ent = mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000, /* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x1);
+	mmu.tlb_set_host<mmu_type::op_load>(tlb_ent, 0x10234, 0x1234);
+	assert(tlb_ent->ltag == 0x10000);
+	assert(tlb_ent->stag == tlb_type::tlb_entry_t::invalid_tag);
+	assert(tlb_ent->addend + 0x10238 == uintptr_t(uva) + 0x238);
+
+	// flush the host tags
+	mmu.l1_dtlb.flush_host();
+	assert(tlb_ent->ltag == tlb_type::tlb_entry_t::invalid_tag);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000) == tlb_ent);
+
+	// flushing the TLB drops host tags so inline translation can not use flushed entries
+	mmu.tlb_set_host<mmu_type::op_load>(tlb_ent, 0x10234, 0x1234);
+	assert(tlb_ent->ltag == 0x10000);
+	mmu.l1_dtlb.flush(/* PDID */ 0, /* ASID */ 1);
+	assert(tlb_ent->ltag == tlb_type::tlb_entry_t::invalid_tag);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000) == tlb_ent);
+
+	// host flushes only clear the sets tagged since the last host flush
+	assert(mmu.l1_dtlb.host_set_count == 0);
+	mmu.tlb_set_host<mmu_type::op_load>(tlb_ent, 0x10234, 0x1234);
+	mmu.tlb_set_host<mmu_type::op_store>(tlb_ent, 0x10234, 0x1234);
+	assert(mmu.l1_dtlb.host_set_count == 1);
+	assert(mmu.l1_dtlb.host_sets[0] == 0x10);
+	auto other_ent = mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x11000, /* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x2);
+	mmu.tlb_set_host<mmu_type::op_load>(other_ent, 0x11000, 0x2000);
+	assert(mmu.l1_dtlb.host_set_count == 2);
+	assert(mmu.l1_dtlb.host_sets[1] == 0x11);
+	auto moved_ent = mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x50000, /* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x5);
+	assert(moved_ent == tlb_ent);
+	assert(tlb_ent[1].ltag == 0x10000);
+	mmu.l1_dtlb.flush_host();
+	assert(mmu.l1_dtlb.host_set_count == 0);
+	assert(tlb_ent[1].ltag == tlb_type::tlb_entry_t::invalid_tag);
+	assert(tlb_ent[1].stag == tlb_type::tlb_entry_t::invalid_tag);
+	assert(other_ent->ltag == tlb_type::tlb_entry_t::invalid_tag);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000) == tlb_ent);
+
+	// tagging more sets than can be recorded clears the whole TLB on the next host flush
+	for (size_t i = 0; i <= tlb_type::sets; i++) {
+		auto ent = mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x100000 + (i << page_shift), /* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x1);
+		mmu.tlb_set_host<mmu_type::op_load>(ent, 0x100000 + (i << page_shift), 0x1000);
+	}
+	assert(mmu.l1_dtlb.host_set_count > tlb_type::sets);
+	mmu.l1_dtlb.flush_host();
+	for (size_t i = 0; i < tlb_type::size; i++) {
+		assert(mmu.l1_dtlb.tlb[i].ltag == tlb_type::tlb_entry_t::invalid_tag);
+	}
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000) != nullptr);
+	tlb_ent = mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000);
+
+	// stores to code pages are flagged and never get a host store tag
+	mmu.tlb_set_host<mmu_type::op_store>(tlb_ent, 0x10234, 0x1234);
+	assert(tlb_ent->stag == 0x10000);
+	mmu.set_code_page(0x1234);
+	assert(tlb_ent->stag == tlb_type::tlb_entry_t::invalid_tag);
+	assert(!mmu.code_store(0x2000));
+	assert(!mmu.code_dirty);
+	assert(mmu.code_store(0x1ff8));
+	assert(mmu.code_dirty);
+	mmu.clear_code_pages();
+	assert(!mmu.code_store(0x1ff8));
+	assert(!mmu.code_dirty);
+
+	// superpages are tagged through a page sized alias in way 0 of the set for the VA
+	auto super_ent = mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x200000, /* PTE level */ 1, /* PTE.bits */ 0xff, /* PPN */ 0x400);
+	mmu.tlb_set_host<mmu_type::op_load>(super_ent, 0x203234, 0x403234);
+	assert(super_ent->ltag == tlb_type::tlb_entry_t::invalid_tag);
+	auto alias_ent = mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x203000);
+	assert(alias_ent == mmu.l1_dtlb.tlb + (0x203 & tlb_type::mask) * tlb_type::ways);
+	assert(alias_ent->ptel == 0);
+	assert(alias_ent->ppn == 0x403);
+	assert(alias_ent->ltag == 0x203000);
+	assert(alias_ent->addend + 0x203238 == uintptr_t(uva) + 0x402238);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x204000) == super_ent);
+	mmu.l1_dtlb.flush(/* PDID */ 0, /* ASID */ 0);
+	assert(alias_ent->ltag == tlb_type::tlb_entry_t::invalid_tag);
+	assert(mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x203000) == nullptr);
+
+	// main memory words have a host address unless they straddle a page or are outside RAM
+	s64 *word = mmu.mem->host_word<s64>(0x2000);
+	assert(word == (s64*)(uva + 0x1000));
+	assert(mmu.mem->host_word<s64>(0x2ffc) == nullptr);
+	assert(mmu.mem->host_word<s32>(0x2ffc) != nullptr);
+	assert(mmu.mem->host_word<s64>(0x0) == nullptr);
+
+	// host atomics return the previous value
+	*word = 5;
+	assert(amo_host<s64>(amoadd, word, 3) == 5 && *word == 8);
+	assert(amo_host<s64>(amomin, word, -1) == 8 && *word == -1);
+	assert(amo_host<s64>(amomaxu, word, 2) == -1 && *word == -1);
+	assert(amo_host<s64>(amoswap, word, 7) == -1 && *word == 7);
+
+	// store conditional fails if the word no longer holds the reserved value
+	assert(sc_host<s64>(word, 7, 9) && *word == 9);
+	assert(!sc_host<s64>(word, 7, 11) && *word == 9);
+
+	// with exceptions disabled a page fault records the cause of the faulting access
+	walk_proc proc;
+	proc.exceptions = false;
+	proc.mstatus.r.vm = rv_vm_sv39;
+	proc.sptbr = 0x100; /* empty root page table at MPA 0x100000 */
+	u64 val = 0;
+	mmu.load(proc, 0x5000, val);
+	assert(proc.cause == rv_cause_fault_load);
+	assert(proc.badaddr == 0x5000);
+	mmu.store(proc, 0x6000, val);
+	assert(proc.cause == rv_cause_fault_store);
+	assert(proc.badaddr == 0x6000);
 }
@@ -0,0 +1,318 @@
+//
+//  test-proxy.cc
+//
+
+#undef NDEBUG
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <cinttypes>
+#include <csignal>
+#include <csetjmp>
+#include <cerrno>
+#include <cmath>
+#include <cctype>
+#include <cwchar>
+#include <climits>
+#include <cfloat>
+#include <cfenv>
+#include <limits>
+#include <array>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <deque>
+#include <map>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>
+
+#include "dense_hash_map"
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/ioctl.h>
+#include <sys/utsname.h>
+
+#include "host-endian.h"
+#include "types.h"
+#include "fmt.h"
+#include "bits.h"
+#include "sha512.h"
+#include "format.h"
+#include "meta.h"
+#include "util.h"
+#include "host.h"
+#include "cmdline.h"
+#include "codec.h"
+#include "elf.h"
+#include "elf-file.h"
+#include "elf-format.h"
+#include "strings.h"
+#include "disasm.h"
+#include "alu.h"
+#include "fpu.h"
+#include "pma.h"
+#include "amo.h"
+#include "processor-logging.h"
+#include "processor-base.h"
+#include "processor-impl.h"
+#include "interp.h"
+#include "processor-model.h"
+#include "mmu-proxy.h"
+#include "unknown-abi.h"
+#include "processor-histogram.h"
+#include "processor-proxy.h"
+#include "debug-cli.h"
+#include "processor-block.h"
+#include "processor-runloop.h"
+
+using namespace riscv;
+
+using proxy_emulator_rv64imafdc = processor_runloop<processor_proxy<processor_rv64imafdc_model<decode,processor_rv64imafd,mmu_proxy_rv64>>>;
+
+typedef processor_proxy<processor_rv64imafdc_model<decode,processor_rv64imafd,mmu_proxy_rv64>> proxy_rv64imafdc;
+typedef proxy_rv64imafdc::threads_type threads_type;
+
+static size_t futex_waiters(threads_type &threads)
+{
+	std::lock_guard<std::mutex> guard(threads.futex_lock);
+	return threads.futex_waiters.size();
+}
+
+/* spin until n waiters are queued */
+static void futex_await_waiters(threads_type &threads, size_t n)
+{
+	while (futex_waiters(threads) != n) std::this_thread::yield();
+}
+
+static void test_futex_wait()
+{
+	typedef std::chrono::steady_clock clock;
+	threads_type threads;
+	s32 word = 1;
+
+	// a wait on a word that no longer holds the expected value fails at once
+	assert(threads.futex_wait<clock>(addr_t(&word), 0, nullptr) == -EAGAIN);
+	assert(futex_waiters(threads) == 0);
+
+	// a timed out wait returns ETIMEDOUT and leaves no waiter queued
+	auto deadline = clock::now() + std::chrono::milliseconds(10);
+	assert(threads.futex_wait<clock>(addr_t(&word), 1, &deadline) == -ETIMEDOUT);
+	assert(clock::now() >= deadline);
+	assert(futex_waiters(threads) == 0);
+
+	// a wake with no waiters wakes nothing
+	assert(threads.futex_wake(addr_t(&word), 1) == 0);
+
+	printf("futex wait: PASS\n");
+}
+
+static void test_futex_wake()
+{
+	typedef std::chrono::steady_clock clock;
+	threads_type threads;
+	s32 word = 1, other = 1;
+	std::atomic<int> woken(0);
+	std::vector<std::thread> waiters;
+
+	for (int i = 0; i < 3; i++) {
+		waiters.push_back(std::thread([&] {
+			assert(threads.futex_wait<clock>(addr_t(&word), 1, nullptr) == 0);
+			woken++;
+		}));
+	}
+	futex_await_waiters(threads, 3);
+
+	// waiters on other words are not woken
+	assert(threads.futex_wake(addr_t(&other), 3) == 0);
+	assert(futex_waiters(threads) == 3);
+
+	// a wake returns the number of waiters woken, at most count
+	assert(threads.futex_wake(addr_t(&word), 2) == 2);
+	assert(futex_waiters(threads) == 1);
+	while (woken != 2) std::this_thread::yield();
+	assert(threads.futex_wake(addr_t(&word), std::numeric_limits<int>::max()) == 1);
+	assert(futex_waiters(threads) == 0);
+	for (auto &t : waiters) t.join();
+	assert(woken == 3);
+
+	printf("futex wake: PASS\n");
+}
+
+static void test_futex_syscall()
+{
+	proxy_emulator_rv64imafdc proc;
+	proc.init();
+	s32 word = 1;
+	abi_timespec<proxy_emulator_rv64imafdc> ts = { 0, 1000000 };
+
+	// futex(FUTEX_WAIT_PRIVATE) with a stale value returns -EAGAIN in a0
+	proc.ireg[rv_ireg_a0] = addr_t(&word);
+	proc.ireg[rv_ireg_a1] = abi_futex_WAIT | abi_futex_PRIVATE_FLAG;
+	proc.ireg[rv_ireg_a2] = 0;
+	proc.ireg[rv_ireg_a3] = 0;
+	abi_sys_futex(proc);
+	assert(proc.ireg[rv_ireg_a0].r.x.val == -EAGAIN);
+
+	// futex(FUTEX_WAIT) with a relative timeout returns -ETIMEDOUT in a0
+	proc.ireg[rv_ireg_a0] = addr_t(&word);
+	proc.ireg[rv_ireg_a1] = abi_futex_WAIT;
+	proc.ireg[rv_ireg_a2] = 1;
+	proc.ireg[rv_ireg_a3] = addr_t(&ts);
+	abi_sys_futex(proc);
+	assert(proc.ireg[rv_ireg_a0].r.x.val == -ETIMEDOUT);
+	assert(futex_waiters(*proc.threads) == 0);
+
+	// futex(FUTEX_WAKE) with no waiters wakes nothing
+	proc.ireg[rv_ireg_a0] = addr_t(&word);
+	proc.ireg[rv_ireg_a1] = abi_futex_WAKE;
+	proc.ireg[rv_ireg_a2] = 1;
+	abi_sys_futex(proc);
+	assert(proc.ireg[rv_ireg_a0].r.x.val == 0);
+
+	printf("futex syscall: PASS\n");
+}
+
+static void test_clone_cleartid()
+{
+	typedef std::chrono::steady_clock clock;
+	const u64 thread_flags = abi_clone_VM | abi_clone_THREAD;
+	proxy_emulator_rv64imafdc proc;
+	proc.init();
+	s32 ptid = 0, ctid = -1;
+	std::thread child_thread;
+
+	// clone fails without a run loop to start threads in or without a shared address space
+	proc.ireg[rv_ireg_a0] = thread_flags;
+	abi_sys_clone(proc);
+	assert(proc.ireg[rv_ireg_a0].r.x.val == -ENOSYS);
+
+	/* the child exits once the parent is waiting for it, like pthread_join */
+	proc.threads->create = [] {
+		return std::shared_ptr<proxy_rv64imafdc>(std::make_shared<proxy_emulator_rv64imafdc>());
+	};
+	proc.threads->start = [&] (std::shared_ptr<proxy_rv64imafdc> child) {
+		child_thread = std::thread([&proc, child] {
+			futex_await_waiters(*proc.threads, 1);
+			if (setjmp(child->env) == 0) {
+				abi_sys_exit_thread(*child);
+			}
+		});
+	};
+	proc.ireg[rv_ireg_a0] = abi_clone_VM;
+	abi_sys_clone(proc);
+	assert(proc.ireg[rv_ireg_a0].r.x.val == -ENOSYS);
+
+	// clone returns the child tid and stores it in the parent and child tid words
+	proc.ireg[rv_ireg_a0] = thread_flags | abi_clone_PARENT_SETTID |
+		abi_clone_CHILD_SETTID | abi_clone_CHILD_CLEARTID;
+	proc.ireg[rv_ireg_a1] = 0;
+	proc.ireg[rv_ireg_a2] = addr_t(&ptid);
+	proc.ireg[rv_ireg_a4] = addr_t(&ctid);
+	abi_sys_clone(proc);
+	s32 tid = s32(proc.ireg[rv_ireg_a0].r.x.val);
+	assert(tid == 2);
+	assert(ptid == tid);
+
+	// thread exit clears the child tid word and wakes the joining thread
+	s32 val;
+	while ((val = __atomic_load_n(&ctid, __ATOMIC_SEQ_CST)) != 0) {
+		int ret = proc.threads->futex_wait<clock>(addr_t(&ctid), val, nullptr);
+		assert(ret == 0 || ret == -EAGAIN);
+	}
+	child_thread.join();
+	assert(ctid == 0);
+	assert(futex_waiters(*proc.threads) == 0);
+
+	printf("clone cleartid: PASS\n");
+}
+
+static void test_guest_write()
+{
+	proxy_emulator_rv64imafdc proc;
+	proc.init();
+	std::vector<std::pair<addr_t,size_t>> writes;
+	int fds[2];
+	assert(pipe(fds) == 0);
+
+	/* a write protected page standing in for a page of traced code */
+	char *page = (char*)mmap(nullptr, page_size, PROT_READ | PROT_WRITE,
+		MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	assert(page != MAP_FAILED);
+	assert(mprotect(page, page_size, PROT_READ) == 0);
+
+	// without the hook the host kernel fails the read into the protected page
+	assert(write(fds[1], "abcd", 4) == 4);
+	proc.ireg[rv_ireg_a0] = fds[0];
+	proc.ireg[rv_ireg_a1] = addr_t(page);
+	proc.ireg[rv_ireg_a2] = 4;
+	abi_sys_read(proc);
+	assert(proc.ireg[rv_ireg_a0].r.x.val == -EFAULT);
+
+	// the hook is given the destination range before the host kernel writes it
+	proc.guest_write = [&] (addr_t addr, size_t len) {
+		writes.push_back(std::pair<addr_t,size_t>(addr, len));
+		assert(mprotect((void*)(addr & ~addr_t(page_size - 1)), page_size, PROT_READ | PROT_WRITE) == 0);
+	};
+	proc.ireg[rv_ireg_a0] = fds[0];
+	proc.ireg[rv_ireg_a1] = addr_t(page + 8);
+	proc.ireg[rv_ireg_a2] = 4;
+	abi_sys_read(proc);
+	assert(proc.ireg[rv_ireg_a0].r.x.val == 4);
+	assert(memcmp(page + 8, "abcd", 4) == 0);
+	assert(writes.size() == 1);
+	assert(writes[0].first == addr_t(page + 8) && writes[0].second == 4);
+
+	// readv reports each buffer and pread the destination range
+	abi_iovec<proxy_emulator_rv64imafdc> iov[2] = {
+		{ addr_t(page + 16), 2 }, { addr_t(page + 32), 2 }
+	};
+	assert(write(fds[1], "efgh", 4) == 4);
+	proc.ireg[rv_ireg_a0] = fds[0];
+	proc.ireg[rv_ireg_a1] = addr_t(iov);
+	proc.ireg[rv_ireg_a2] = 2;
+	abi_sys_readv(proc);
+	assert(proc.ireg[rv_ireg_a0].r.x.val == 4);
+	assert(writes.size() == 3);
+	assert(writes[1].first == addr_t(page + 16) && writes[1].second == 2);
+	assert(writes[2].first == addr_t(page + 32) && writes[2].second == 2);
+	proc.ireg[rv_ireg_a0] = fds[0];
+	proc.ireg[rv_ireg_a1] = addr_t(page + 64);
+	proc.ireg[rv_ireg_a2] = 16;
+	proc.ireg[rv_ireg_a3] = 0;
+	abi_sys_pread(proc);
+	assert(proc.ireg[rv_ireg_a0].r.x.val == -ESPIPE);
+	assert(writes.size() == 4);
+	assert(writes[3].first == addr_t(page + 64) && writes[3].second == 16);
+
+	munmap(page, page_size);
+	close(fds[0]);
+	close(fds[1]);
+
+	printf("guest write: PASS\n");
+}
+
+int main(int argc, char *argv[])
+{
+	test_futex_wait();
+	test_futex_wake();
+	test_futex_syscall();
+	test_clone_cleartid();
+	test_guest_write();
+	return 0;
+}
@@ -0,0 +1,301 @@
+//
+//  test-sys.cc
+//
+
+#undef NDEBUG
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cinttypes>
+#include <cstdarg>
+#include <cerrno>
+#include <cassert>
+#include <csignal>
+#include <csetjmp>
+#include <string>
+#include <memory>
+#include <vector>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <atomic>
+#include <cmath>
+#include <cfenv>
+#include <array>
+#include <random>
+#include <deque>
+#include <set>
+#include <type_traits>
+#include "dense_hash_map"
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "host-endian.h"
+#include "types.h"
+#include "fmt.h"
+#include "bits.h"
+#include "sha512.h"
+#include "format.h"
+#include "meta.h"
+#include "util.h"
+#include "color.h"
+#include "host.h"
+#include "cmdline.h"
+#include "codec.h"
+#include "elf.h"
+#include "elf-file.h"
+#include "elf-format.h"
+#include "strings.h"
+#include "disasm.h"
+#include "alu.h"
+#include "fpu.h"
+#include "pte.h"
+#include "pma.h"
+#include "amo.h"
+#include "processor-logging.h"
+#include "processor-base.h"
+#include "processor-impl.h"
+#include "mmu-memory.h"
+#include "tlb-soft.h"
+#include "mmu-soft.h"
+#include "interp.h"
+#include "processor-model.h"
+#include "queue.h"
+#include "console.h"
+#include "device-rom-boot.h"
+#include "device-rom-sbi.h"
+#include "device-rom-string.h"
+#include "device-config.h"
+#include "device-rtc.h"
+#include "device-timer.h"
+#include "device-plic.h"
+#include "device-uart.h"
+#include "device-mipi.h"
+#include "device-gpio.h"
+#include "device-rand.h"
+#include "device-htif.h"
+#include "processor-histogram.h"
+#include "processor-priv-1.9.h"
+#include "debug-cli.h"
+#include "processor-block.h"
+#include "processor-runloop.h"
+
+using namespace riscv;
+
+/* just enough of a processor for the timer device, recording posted interrupt events */
+struct timer_proc
+{
+	typedef u64 ux;
+
+	const u64 RTC_DIV = 100;
+
+	u32 log = 0;
+	u64 inst_per_tick = 1; /* virtual time, so the timer thread exits at once */
+	size_t num_harts = 3;
+	u64 time = 0;
+	std::vector<size_t> posted;
+
+	u64 get_time() { return time; }
+	void post_interrupt(size_t hart_id) { posted.push_back(hart_id); }
+};
+
+static void test_timer_deadlines()
+{
+	typedef timer_mmio_device<timer_proc> timer_type;
+	const u64 none = std::numeric_limits<u64>::max();
+
+	timer_proc proc;
+	timer_type timer(proc, 0x40000000);
+
+	// no timer is armed until its compare register is written
+	assert(timer.deadline() == none);
+	assert(timer.hart_deadline(0) == none);
+	assert(!timer.timer_pending(0, none - 1));
+
+	// the earliest armed compare value is the deadline, and arming posts an event to the hart
+	timer.store_64(0 << 3, 100);
+	timer.store_64(1 << 3, 50);
+	assert(timer.deadline() == 50);
+	assert(timer.hart_deadline(0) == 100);
+	assert(timer.hart_deadline(1) == 50);
+	assert(proc.posted == std::vector<size_t>({ 0, 1 }));
+
+	// a timer is pending once the time reaches its compare value and is then claimed
+	assert(!timer.timer_pending(1, 49));
+	assert(timer.timer_pending(1, 50));
+	assert(!timer.timer_pending(1, 51));
+	assert(timer.hart_deadline(1) == none);
+	assert(timer.deadline() == 100);
+
+	// only the claimed hart is pending, the deadline check rejects the others early
+	assert(!timer.timer_pending(0, 99));
+	assert(!timer.timer_pending(2, 1000));
+
+	// rewriting a compare register leaves a stale entry that is dropped when it reaches the top
+	timer.store_64(0 << 3, 200);
+	assert(timer.deadline() == 200);
+	assert(!timer.timer_pending(0, 150));
+	assert(timer.timer_pending(0, 200));
+	assert(timer.deadline() == none);
+
+	// a partial store rearms the timer with the merged value
+	timer.store_64(2 << 3, 0x100000000ULL);
+	timer.store_32(2 << 3, 0x10);
+	assert(timer.hart_deadline(2) == 0x100000010ULL);
+	assert(timer.deadline() == 0x100000010ULL);
+	u32 lo = 0;
+	timer.load_32(2 << 3, lo);
+	assert(lo == 0x10);
+
+	// repeated stores rebuild the heap instead of growing it without bound
+	for (u64 i = 0; i < 100; i++) {
+		timer.store_64(1 << 3, 1000 - i);
+	}
+	assert(timer.deadlines.size() <= timer_type::num_harts * 4);
+	assert(timer.deadline() == 901);
+	assert(timer.hart_deadline(1) == 901);
+	assert(timer.hart_deadline(2) == 0x100000010ULL);
+
+	// compare registers beyond the configured harts are storage only
+	timer.store_64(3 << 3, 1);
+	assert(timer.deadline() == 901);
+	assert(timer.hart_deadline(3) == 1);
+	assert(!timer.timer_pending(3, 1));
+
+	printf("timer deadlines: PASS\n");
+}
+
+using priv_rv64imafdc = processor_privileged<processor_rv64imafdc_model<decode,processor_priv_rv64imafd,mmu_soft_rv64>>;
+using priv_emulator_rv64imafdc = processor_runloop<priv_rv64imafdc>;
+
+static void test_virtual_time()
+{
+	const u64 ram_base = 0x80000000, none = std::numeric_limits<u64>::max();
+
+	/* one hart spinning on "1: j 1b" in machine mode with only the timer attached */
+	priv_emulator_rv64imafdc emulator;
+	priv_rv64imafdc &proc = emulator;
+	proc.inst_per_tick = 10;
+	proc.device_timer = std::make_shared<timer_mmio_device<priv_rv64imafdc>>(proc, 0x40004000);
+	proc.harts.assign(1, &proc);
+	proc.mmu.mem->add_ram(ram_base, 0x10000);
+	memory_segment<u64> *segment = nullptr;
+	u32 *text = (u32*)proc.mmu.mem->mpa_to_uva(segment, ram_base);
+	text[0] = 0x0000006f;
+	proc.pc = ram_base;
+	proc.running = true;
+	proc.intr_pending = false;
+
+	// with no timer armed steps and WFI are not bounded by a deadline
+	assert(proc.deadline_instret() == none);
+	assert(proc.step_count(1000) == 1000);
+
+	// steps stop exactly at the instruction count of timecmp
+	proc.device_timer->store_64(0, 5);
+	proc.intr_pending = false;
+	assert(proc.deadline_instret() == 50);
+	emulator.step(proc.step_count(20));
+	assert(proc.instret == 20);
+	assert(proc.step_count(1000) == 30);
+	assert(proc.step_count(10) == 10);
+	emulator.step(proc.step_count(1000));
+	assert(proc.instret == 50);
+	assert(proc.get_time() == 5);
+
+	// past the deadline the timer no longer bounds the step
+	assert(proc.step_count(1000) == 1000);
+
+	// WFI with work pending does not skip time
+	proc.device_timer->store_64(0, 12);
+	assert(proc.intr_pending);
+	proc.wait_for_interrupt();
+	assert(proc.idle_instret == 0);
+
+	// WFI with no pending work credits the idle instructions up to the deadline
+	proc.intr_pending = false;
+	proc.intr_active = false;
+	proc.wait_for_interrupt();
+	assert(proc.instret == 50);
+	assert(proc.idle_instret == 70);
+	assert(proc.get_time() == 12);
+	assert(proc.intr_pending);
+	assert(proc.device_timer->timer_pending(0, proc.get_time()));
+
+	// WFI at the deadline credits nothing more
+	proc.device_timer->store_64(0, 12);
+	proc.intr_pending = false;
+	proc.wait_for_interrupt();
+	assert(proc.idle_instret == 70);
+	assert(proc.intr_pending);
+
+	printf("virtual time: PASS\n");
+}
+
+static void test_remote_fence()
+{
+	typedef mipi_mmio_device<priv_rv64imafdc> mipi_type;
+
+	/* two harts sharing the MIPI device of the boot hart */
+	priv_emulator_rv64imafdc emulator, secondary;
+	priv_rv64imafdc &proc = emulator;
+	proc.device_mipi = std::make_shared<mipi_type>(proc, 0x40001000);
+	proc.harts = { &proc, &secondary };
+	secondary.hart_id = 1;
+	proc.intr_pending = false;
+	secondary.intr_pending = false;
+
+	// a store to a fence word requests the fences and posts an event to the hart
+	u32 val = 0;
+	proc.device_mipi->store_32(mipi_type::ipi_size + 4, mipi_type::fence_vm);
+	proc.device_mipi->store_32(mipi_type::ipi_size + 4, mipi_type::fence_i);
+	assert(secondary.intr_pending);
+	assert(!proc.intr_pending);
+	proc.device_mipi->load_32(mipi_type::ipi_size + 4, val);
+	assert(val == (mipi_type::fence_i | mipi_type::fence_vm));
+	proc.device_mipi->load_32(mipi_type::ipi_size, val);
+	assert(val == 0);
+	assert(!proc.device_mipi->ipi_pending(1));
+
+	// the hart claims the fences, which reads back as completed
+	auto ent = secondary.mmu.l1_dtlb.insert(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000, /* PTE level */ 0, /* PTE.bits */ 0xff, /* PPN */ 0x1);
+	assert(ent != nullptr);
+	secondary.remote_fence(proc.device_mipi->claim_fences(1));
+	proc.device_mipi->load_32(mipi_type::ipi_size + 4, val);
+	assert(val == 0);
+	assert(proc.device_mipi->claim_fences(1) == 0);
+
+	// sfence.vm flushes the hart's translations and both fences drop its decoded blocks
+	assert(secondary.mmu.l1_dtlb.lookup(/* PDID */ 0, /* ASID */ 0, /* VA */ 0x10000) == nullptr);
+	assert(priv_emulator_rv64imafdc::remote_fenced(secondary, 0));
+	assert(!priv_emulator_rv64imafdc::remote_fenced(secondary, 0));
+	secondary.remote_fence(0);
+	assert(!priv_emulator_rv64imafdc::remote_fenced(secondary, 0));
+
+	// fences requested of harts that are not running post no event
+	secondary.intr_pending = false;
+	proc.device_mipi->store_32(mipi_type::ipi_size + 3 * 4, mipi_type::fence_i);
+	assert(!proc.intr_pending && !secondary.intr_pending);
+	assert(proc.device_mipi->claim_fences(3) == mipi_type::fence_i);
+	assert(proc.device_mipi->claim_fences(mipi_type::num_harts) == 0);
+
+	printf("remote fence: PASS\n");
+}
+
+int main(int argc, char *argv[])
+{
+	test_timer_deadlines();
+	test_virtual_time();
+	test_remote_fence();
+	return 0;
+}
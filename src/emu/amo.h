@@ -61,6 +61,37 @@ namespace riscv {
 		}
 		return 0;
 	}
+
+	/*
+	 * AMO on host memory that other harts access concurrently. swap, add,
+	 * xor, or and and map to xchg, lock xadd or a lock cmpxchg loop, and
+	 * min and max to a compare and swap loop. Returns the previous value.
+	 */
+	template <typename T> T amo_host(amo_op op, T *ptr, T y) {
+		switch (op) {
+			case amoswap: return __atomic_exchange_n(ptr, y, __ATOMIC_SEQ_CST);
+			case amoadd:  return __atomic_fetch_add(ptr, y, __ATOMIC_SEQ_CST);
+			case amoxor:  return __atomic_fetch_xor(ptr, y, __ATOMIC_SEQ_CST);
+			case amoor:   return __atomic_fetch_or(ptr, y, __ATOMIC_SEQ_CST);
+			case amoand:  return __atomic_fetch_and(ptr, y, __ATOMIC_SEQ_CST);
+			default: break;
+		}
+		T x = __atomic_load_n(ptr, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(ptr, &x, T(amo_fn<T>(op, x, y)),
+			true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+		return x;
+	}
+
+	/*
+	 * Store conditional on host memory. The store is a compare and swap
+	 * against the value loaded by the load reserved, so it fails if
+	 * another hart has changed the word since, and stores do not need
+	 * to check a reservation table.
+	 */
+	template <typename T> bool sc_host(T *ptr, T reserved, T val) {
+		return __atomic_compare_exchange_n(ptr, &reserved, val,
+			false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+	}
 }
 
 #endif
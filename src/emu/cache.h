@@ -36,485 +36,713 @@ namespace riscv {
         
 
 	/*
-	 * tagged_cache_entry
+	 * cache_stats
 	 *
-	 * protection domain, address space and physically tagged virtually indexed cache entry with page attributes
+	 * host side cache statistics, also exposed to the guest read-only
+	 * through cache_stats_mmio_device as consecutive 64-bit words
+	 */
+	struct cache_stats
+	{
+		u64 loads;           /* loads from the cache */
+		u64 stores;          /* stores to the cache */
+		u64 hits;            /* accesses that hit a line */
+		u64 misses;          /* accesses that filled a line */
+		u64 evictions;       /* lines replaced by a fill */
+		u64 writebacks;      /* dirty lines written back to memory */
+
+		cache_stats() : loads(0), stores(0), hits(0), misses(0), evictions(0), writebacks(0) {}
+	};
+
+
+	/*
+	 * cache_replacement
 	 *
-	 * cache[PDID:ASID:VA] = STATE:PPN:DATA
+	 * replacement policy of a set associative cache. The policy is told about
+	 * hits and fills and chooses the victim way when a set has no empty way,
+	 * so hits and fills cost O(1) whatever the associativity.
 	 */
+	struct cache_replacement
+	{
+		size_t ways;
 
-	template <typename PARAM, const size_t cache_line_size>
-	struct tagged_cache_entry
+		cache_replacement(size_t ways) : ways(ways) {}
+		virtual ~cache_replacement() {}
+
+		virtual const char* name() = 0;
+		virtual void hit(size_t set, size_t way) = 0;
+		virtual void fill(size_t set, size_t way) = 0;
+		virtual size_t victim(size_t set) = 0;
+	};
+
+	/* least recently used, ordered by a per line access stamp */
+	struct cache_replacement_lru : cache_replacement
 	{
+		std::vector<u64> stamp;
+		u64 clock;
 
-		typedef typename PARAM::UX UX;
+		cache_replacement_lru(size_t sets, size_t ways) :
+			cache_replacement(ways), stamp(sets * ways), clock(0) {}
 
-		enum : UX {
-			cache_line_shift =    ctz_pow2(cache_line_size),
-			mpa_bits =            (sizeof(UX) << 3) - cache_line_shift,
-			state_bits =          cache_line_shift,
-			asid_bits =           PARAM::asid_bits,
-			ppn_bits =            PARAM::ppn_bits,
-			pcln_limit =          (1ULL<<mpa_bits)-1,
-			ppn_limit =           (1ULL<<ppn_bits)-1,
-			asid_limit =          (1ULL<<asid_bits)-1
-		};
+		const char* name() { return "lru"; }
+		void hit(size_t set, size_t way) { stamp[set * ways + way] = ++clock; }
+		void fill(size_t set, size_t way) { stamp[set * ways + way] = ++clock; }
+
+		size_t victim(size_t set)
+		{
+			u64 *s = stamp.data() + set * ways;
+			size_t way = 0;
+			for (size_t i = 1; i < ways; i++) {
+				if (s[i] < s[way]) way = i;
+			}
+			return way;
+		}
+	};
+
+	/* tree pseudo LRU, each node of a per set binary tree points at its colder half */
+	struct cache_replacement_plru : cache_replacement
+	{
+		std::vector<u64> tree;
+		size_t levels;
 
-		static_assert(asid_bits + ppn_bits == 32 || asid_bits + ppn_bits == 64 ||
-			asid_bits + ppn_bits == 128, "asid_bits + ppn_bits == (32, 64, 128)");
+		cache_replacement_plru(size_t sets, size_t ways) :
+			cache_replacement(ways), tree(sets), levels(ctz(u64(ways))) {}
 
-		/* Cache entry attributes */
+		const char* name() { return "plru"; }
+		void hit(size_t set, size_t way) { touch(set, way); }
+		void fill(size_t set, size_t way) { touch(set, way); }
 
-		UX      pcln  : mpa_bits;      /* Physical Cache Line Number */
-		UX      state : state_bits;    /* Cache State */
-		UX      ppn   : ppn_bits;      /* Physical Page Number */
-		UX      asid  : asid_bits;     /* Address Space Identifier */
-		pdid_t  pdid;                  /* Protection Domain Identifer */
-		u8*     data;                  /* Cache Data */
-                UX      status: 2;             /* Status of the entry (i.e. line is a hit, empty, or must be evicted)*/
-                UX      LRU_count;             /* Counter for Least Recently used policy */
+		void touch(size_t set, size_t way)
+		{
+			u64 bits = tree[set];
+			for (size_t node = 1, level = levels; level-- > 0; ) {
+				size_t right = (way >> level) & 1;
+				bits = right ? bits & ~(1ULL << node) : bits | (1ULL << node);
+				node = (node << 1) | right;
+			}
+			tree[set] = bits;
+		}
+
+		size_t victim(size_t set)
+		{
+			size_t node = 1;
+			for (size_t level = 0; level < levels; level++) {
+				node = (node << 1) | ((tree[set] >> node) & 1);
+			}
+			return node - ways;
+		}
+	};
+
+	/* random, from a fixed seed so that runs are repeatable */
+	struct cache_replacement_random : cache_replacement
+	{
+		u64 state;
+
+		cache_replacement_random(size_t sets, size_t ways) :
+			cache_replacement(ways), state(0x9e3779b97f4a7c15ULL) {}
+
+		const char* name() { return "random"; }
+		void hit(size_t set, size_t way) {}
+		void fill(size_t set, size_t way) {}
+
+		size_t victim(size_t set)
+		{
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			return state & (ways - 1);
+		}
+	};
+
+	/* static re-reference interval prediction with 2-bit predictions,
+	   hits predict near re-reference and fills predict long re-reference */
+	struct cache_replacement_srrip : cache_replacement
+	{
+		enum : u8 { rrpv_max = 3 };
+
+		std::vector<u8> rrpv;
+
+		cache_replacement_srrip(size_t sets, size_t ways) :
+			cache_replacement(ways), rrpv(sets * ways, rrpv_max) {}
+
+		const char* name() { return "srrip"; }
+		void hit(size_t set, size_t way) { rrpv[set * ways + way] = 0; }
+		void fill(size_t set, size_t way) { rrpv[set * ways + way] = rrpv_max - 1; }
+
+		size_t victim(size_t set)
+		{
+			u8 *r = rrpv.data() + set * ways;
+			size_t way = 0;
+			for (size_t i = 1; i < ways; i++) {
+				if (r[i] > r[way]) way = i;
+			}
+			/* age the set so the first distant line becomes the victim */
+			u8 age = rrpv_max - r[way];
+			if (age) {
+				for (size_t i = 0; i < ways; i++) r[i] += age;
+			}
+			return way;
+		}
+	};
+
+	inline bool cache_replacement_valid(std::string name)
+	{
+		return name == "lru" || name == "plru" || name == "random" || name == "srrip";
+	}
+
+	inline std::unique_ptr<cache_replacement> cache_replacement_create(std::string name,
+		size_t sets, size_t ways)
+	{
+		if (name == "plru") return std::unique_ptr<cache_replacement>(new cache_replacement_plru(sets, ways));
+		if (name == "random") return std::unique_ptr<cache_replacement>(new cache_replacement_random(sets, ways));
+		if (name == "srrip") return std::unique_ptr<cache_replacement>(new cache_replacement_srrip(sets, ways));
+		return std::unique_ptr<cache_replacement>(new cache_replacement_lru(sets, ways));
+	}
+
+	/* parse a count with an optional K or M suffix, multiplying by unit or unit squared */
+	inline bool cache_parse_count(std::string str, u64 &val, u64 unit)
+	{
+		if (str.size() == 0 || !isdigit(str[0])) return false;
+		char *end;
+		val = strtoull(str.c_str(), &end, 10);
+		if (*end == 'K' || *end == 'k') { val *= unit; end++; }
+		else if (*end == 'M' || *end == 'm') { val *= unit * unit; end++; }
+		return *end == '\0';
+	}
+
+	/*
+	 * cache_geometry
+	 *
+	 * size, associativity, line size, write policy and replacement policy of a
+	 * cache. A size of zero disables the cache so accesses go to the next level.
+	 *
+	 * parse accepts SIZE[:WAYS[:LINE]] followed by any of lru, plru, random,
+	 * srrip, wb or wt, where SIZE may have a K or M suffix, e.g. 32K:8:64:plru
+	 */
+	struct cache_geometry
+	{
+		size_t size;
+		size_t ways;
+		size_t line_size;
+		cache_write_policy write_policy;
+		std::string replacement;
+
+		cache_geometry(size_t size = 0, size_t ways = 1, size_t line_size = 64,
+			cache_write_policy write_policy = cache_write_back, std::string replacement = "lru") :
+			size(size), ways(ways), line_size(line_size),
+			write_policy(write_policy), replacement(replacement) {}
+
+		/* returns nullptr if the geometry is valid otherwise the problem */
+		const char* check() const
+		{
+			if (size == 0) return nullptr;
+			if (!ispow2(size) || !ispow2(ways) || !ispow2(line_size)) {
+				return "size, ways and line size must be powers of two";
+			}
+			if (line_size < 8 || line_size > page_size) return "line size must be from 8 to page size";
+			if (ways > 64) return "ways must be at most 64";
+			if (size < ways * line_size) return "size must hold a line in each way";
+			if (!cache_replacement_valid(replacement)) return "unknown replacement policy";
+			return nullptr;
+		}
+
+		bool parse(std::string spec)
+		{
+			size_t num = 0;
+			for (auto &comp : split(spec, ":")) {
+				if (comp == "wb") write_policy = cache_write_back;
+				else if (comp == "wt") write_policy = cache_write_through;
+				else if (cache_replacement_valid(comp)) replacement = comp;
+				else if (num < 3 && comp.size() > 0 && isdigit(comp[0])) {
+					u64 val;
+					if (!cache_parse_count(comp, val, 1024)) return false;
+					switch (num++) {
+						case 0: size = val; break;
+						case 1: ways = val; break;
+						case 2: line_size = val; break;
+					}
+				}
+				else return false;
+			}
+			return check() == nullptr;
+		}
+	};
+
+	/*
+	 * tagged_cache_entry
+	 *
+	 * physically tagged cache entry, the data lives in the cache_data array at the
+	 * same index. the tag is the machine physical address above the set index
+	 */
+
+	template <typename PARAM>
+	struct tagged_cache_entry
+	{
+		typedef typename PARAM::UX UX;
+
+		UX      tag;                   /* Physical Tag */
+		u8      state;                 /* Cache State (modified or shared) */
+		u8      status;                /* cache_line_empty or cache_line_filled */
 
 		tagged_cache_entry() :
-			 pcln(pcln_limit),
-			 state(cache_state_invalid),
-			 ppn(ppn_limit),
-			 asid(asid_limit),
-			 pdid(-1),
-			 data(nullptr) {}
-
-		tagged_cache_entry(UX pcln, UX asid, UX ppn) :
-			pcln(pcln),
-			state(cache_state_invalid),
-			ppn(ppn),
-			asid(asid),
-			pdid(0),
-			data(nullptr) {}
+			tag(0),
+			state(cache_state_shared),
+			status(cache_line_empty) {}
 	};
 
 
 	/*
 	 * tagged_cache
 	 *
-	 * protection domain, address space and physically tagged, virtually indexed set associative cache
+	 * physically indexed and tagged set associative cache with the geometry
+	 * chosen at construction. Misses fill from the next level, which is either
+	 * memory or another tagged_cache, so levels compose into a hierarchy, e.g.
+	 *
+	 * tagged_cache<PARAM,tagged_cache<PARAM>> is an L1 backed by an L2
 	 *
-	 * cache[PDID:ASID:VA] = STATE:PPN:DATA
+	 * Accesses outside of RAM are passed to the next level uncached.
 	 */
 
-	template <typename PARAM, const size_t cache_size, const size_t cache_ways, const size_t cache_line_size,
-		typename MEMORY = user_memory<typename PARAM::UX>> 
-	struct tagged_cache : MEMORY
+	template <typename PARAM, typename MEMORY = user_memory<typename PARAM::UX>>
+	struct tagged_cache : memory_bus<typename PARAM::UX>
 	{
-		static_assert(ispow2(cache_size), "cache_size must be a power of 2");
-		static_assert(ispow2(cache_ways), "cache_ways must be a power of 2");
-		static_assert(ispow2(cache_line_size), "cache_line_size must be a power of 2");
-
 		typedef typename PARAM::UX UX;
 		typedef MEMORY memory_type;
-		typedef tagged_cache_entry<PARAM,cache_line_size> cache_entry_t;
-                		
-                enum : UX {
-			size =                cache_size,
-			line_size =           cache_line_size,
-			num_ways =            cache_ways,
-			num_entries =         size / (num_ways * line_size),
-			key_size =            sizeof(cache_entry_t),
-			total_size =          cache_size + sizeof(cache_entry_t) * num_entries * num_ways,
-
-			num_entries_shift =   ctz_pow2(num_entries),
-			cache_line_shift =    ctz_pow2(cache_line_size),
-			num_ways_shift =      ctz_pow2(num_ways),
-
-			cache_line_mask =   ~((UX(1) << cache_line_shift) - 1),
-			num_entries_mask =    (UX(1) << num_entries_shift) - 1,
-                        vpn_mask        =    ~((UX(1) << (num_entries_shift + cache_line_shift))-1),
-                        data_index_mask =    ((UX(1) << (cache_line_shift + num_entries_shift))-1),
-                        cache_line_offset_mask = ((UX(1) << cache_line_shift)-1),
-
-			asid_bits =           PARAM::asid_bits,
-			ppn_bits =            PARAM::ppn_bits,
+		typedef tagged_cache_entry<PARAM> cache_entry_t;
+
+		std::shared_ptr<memory_type> mem;  /* next level */
+		cache_geometry geometry;
+		UX write_policy;
+		UX last_access;                    /* outcome of the last lookup */
+
+		size_t size;
+		size_t line_size;
+		size_t num_ways;
+		size_t num_entries;                /* number of sets */
+		size_t cache_line_shift;
+		size_t num_ways_shift;
+		size_t num_entries_shift;
+		UX cache_line_offset_mask;
+		UX num_entries_mask;
+
+		std::vector<cache_entry_t> cache_key;
+		std::vector<u8> cache_data;
+		std::unique_ptr<cache_replacement> replacement;
+
+		/* Statistics, with the number of evictions in each set */
+		cache_stats stats;
+		std::vector<u64> set_conflicts;
+
+		/* RAM size and base */
+		uintmax_t default_ram_base = 0x80000000ULL;
+		uintmax_t default_ram_size = 0x40000028ULL;
+
+		tagged_cache(std::shared_ptr<memory_type> mem, cache_geometry geometry) :
+			mem(mem),
+			geometry(geometry),
+			write_policy(geometry.write_policy),
+			last_access(cache_line_empty),
+			size(geometry.size),
+			line_size(geometry.line_size),
+			num_ways(size ? geometry.ways : 0),
+			num_entries(size ? size / (geometry.ways * line_size) : 0),
+			cache_line_shift(ctz(u64(line_size))),
+			num_ways_shift(size ? ctz(u64(num_ways)) : 0),
+			num_entries_shift(size ? ctz(u64(num_entries)) : 0),
+			cache_line_offset_mask(line_size - 1),
+			num_entries_mask(num_entries - 1),
+			cache_key(num_entries * num_ways),
+			cache_data(size),
+			set_conflicts(num_entries)
+		{
+			const char *problem = geometry.check();
+			if (problem) {
+				panic("cache: invalid geometry: %s", problem);
+			}
+			if (size) {
+				replacement = cache_replacement_create(geometry.replacement, num_entries, num_ways);
+			}
+		}
 
-		};
-                
-                //Variables for holding memory, write policy, etc.
-                std::shared_ptr<memory_type> mem;
-                UX write_policy;
-		UX last_access;
-                
-                //Arrays to hold cache entries and data
-		cache_entry_t cache_key[num_entries * num_ways];
-		u8 cache_data[cache_size];
-                
-                //RAM size and base
-                uintmax_t default_ram_base = 0x80000000ULL;
-                uintmax_t default_ram_size = 0x40000028ULL;
-
-
-                tagged_cache(std::shared_ptr<memory_type> _mem, UX _write_policy = cache_write_back) : mem(_mem), write_policy(_write_policy) {
-                    static_assert(page_shift == (cache_line_shift + num_entries_shift), "Page shift == cache_line_shift + num_entries_shift");
-                    for (size_t i = 0; i < num_entries * num_ways; i++) {
-                        cache_key[i].status = cache_line_empty;
-                        cache_key[i].LRU_count = 0;
-                        cache_key[i].state = cache_state_shared; //Using shared state to represent non-dirty data.  
-                    }
-                }
-                tagged_cache(UX _write_policy = cache_write_back) : write_policy(_write_policy){
-                    mem = std::make_shared<MEMORY>();
-                    static_assert(page_shift == (cache_line_shift + num_entries_shift), "Page shift == cache_line_shift + num_entries_shift");
-                    for(size_t i = 0; i < num_entries * num_ways; i++) {
-                        cache_key[i].status = cache_line_empty;
-                        cache_key[i].LRU_count = 0;
-                        cache_key[i].state = cache_state_shared;
-                    }
-                }
-
-                /*
-                *Updates all cache entries' LRU counters in the set, except for the most recently accessed item
-                *The caller must set the most recently accessed LRU_counter to 0.
-                *
-                *@param index_for_set is the index of the set for the cache_key (unshifted to account for associativity)
-                *@param entry_to_skip is a pointer to the entry that was recently accessed, and does not need to have its LRU counter updated.
-                *
-                */
-                void update_LRU_counters(UX index_for_set, cache_entry_t *entry_to_skip){
-                    index_for_set <<= num_ways_shift;
-                    for(size_t i = 0; i < num_ways; i++)
-                        if(&cache_key[index_for_set + i] != entry_to_skip)
-                            cache_key[index_for_set + i].LRU_count++;
-                }
-                
-                /* 
-                *Updates the cache statistic at the given machine physical address.
-                *Current stats recorded are:
-                *load_count at 0xC0000000
-                *store_count at 0xC0000008
-                *hit_count at 0xC0000010
-                *miss_count at 0xC0000018
-                *num_evicted_lines at 0xC0000020
-                *
-                *@param mpa is the machine physical address for the stat that will be updated.
-                */
-                void update_stats(u64 mpa){
-                    u64 tempVal;
-                    mem->load(mpa,tempVal);
-                    tempVal += 1;
-                    mem->store(mpa, tempVal);
-                }
-
-                /*
-                *Go through the entire cache line and load/store every corresponding memory address into/from memory.
-                *
-                *@param UX mpa is the machine physical address for the line
-                *@param signifies the operation. This must be 'S' (store) or 'L' (load).
-                *@param index_for_entry is the index of the block within the cache_key array. 
-                *index_for_entry is left shifted cache_line_shift times in this function to load/store each mem address's values from/to the cache_data array.
-                */
-                buserror_t allocate(UX mpa, u8 op, UX index_for_entry){
-                    UX mpa_masked = mpa & cache_line_mask;
-                    UX index_for_data, offset;
-                    //Traverse the cache line forward. Load/Store the data corresponding to each address into memory.
-                    for(index_for_data = index_for_entry << cache_line_shift, offset = 0  
-                        ; offset <= cache_line_offset_mask
-                        ; index_for_data++, offset++, mpa_masked++){
-                        if(op == 'S'){ 
-                            if(mem->store(mpa_masked,cache_data[index_for_data])) return -1;  
-                        }
-                        else{
-                            u8 loaded_val;
-                            if(mem->load(mpa_masked,loaded_val)) return -1;
-                            cache_data[index_for_data] = loaded_val;
-                        }
-                    }
-                    return 0;
-                }
-                /*
-                *Function used by the mmu to load from the cache.
-                *
-                *@param mpa is the machine physical address being loaded from
-                *@param val is the value that will be loaded to the mpa
-                *
-                */
-                template<typename T> 
-                buserror_t load(UX mpa, T & val){
-                    if((mpa < default_ram_base) || (mpa > (default_ram_base + default_ram_size))){
-                        return mem->load(mpa, val);
-                    }
-                    else {
-                        update_stats(0xC0000000);
-                        if(access_cache(mpa, 'L', val)) return -1;
-                        return 0;
-                    }
-                }
-                /*
-                *Function used by the mmu to store to the cache.
-                *
-                *@param mpa is the machine physical address being stored to in memory.
-                *@param val is the value that will be stored at the mpa
-                *
-                */
-                template<typename T>
-                buserror_t store(UX mpa, T val){
-                    if(mpa < default_ram_base || (mpa > (default_ram_base + default_ram_size))){
-                        return mem->store(mpa,val);
-                    }
-                    else {
-                        update_stats(0xC0000008);
-                        if(access_cache(mpa, 'S', val)) return -1;
-                        return 0;
-                    }
-                }
-                
-                /*
-                *Loads a value from the cache_data array. Possible value types are u8, u16, u32, and u64.
-                *
-                *@param index_for_data is the index for the first byte in the cache_data array.
-                *@param val will be updated with the value loaded from the cache_data array.
-                *
-                */
-                template<typename T>
-                buserror_t load_val(UX mpa, UX index_for_data, T & val){
-                    if(((index_for_data + (sizeof(val) - 1)) >> cache_line_shift) != (index_for_data >> cache_line_shift)){ 
-                        UX index_for_entry = (index_for_data >> cache_line_shift) + 1;
-                        UX amount_to_add = (cache_line_offset_mask - (mpa & cache_line_offset_mask)) + 1;
-                        UX mpa_to_fill_bits = mpa + amount_to_add;
-                        cache_entry_t * ent = &cache_key[index_for_entry];
-                        if(ent->status != cache_line_empty) {
-                            //If the line is dirty, write its contents to mem
-                            if(write_policy == cache_write_back && ent->state == cache_state_modified){
-                                if(allocate(ent->pcln << cache_line_shift, 'S', index_for_entry)) return -1;
-                                ent->state = cache_state_shared; 
-                            }
-                            //Set the LRU counter for the current line to be 0, and update all the other lines in the set.
-                            ent->LRU_count = 0;
-                            update_LRU_counters(ent->pcln & num_entries_mask, ent);
-                        }
-                        //Load the block from memory into the cache.
-                        if(allocate(mpa_to_fill_bits, 'L', index_for_entry)) return -1; 
-                        ent->pcln = mpa_to_fill_bits >> cache_line_shift;
-                        ent->ppn = ent->pcln >> num_entries_shift;
-                        ent->status = cache_line_filled;
-                        last_access = cache_line_must_evict;
-                        update_stats(0xC0000020);
-                    }
-                    size_t shift_amt = 0;
-                    u16 cast_val_16 = *reinterpret_cast<u16*>(&val);
-                    u32 cast_val_32 = *reinterpret_cast<u32*>(&val);
-                    u64 cast_val_64 = *reinterpret_cast<u64*>(&val);
-                    cast_val_16 = 0; cast_val_32 = 0; cast_val_64 = 0;
-                    //Take each byte in the cache_data array and shift it over byte(s) amount
-                    //so that the full value is created.
-                    if(sizeof(val) == 1){
-                        val = cache_data[index_for_data];
-                    }
-                    else if(sizeof(val) == 2) {
-                        val = cast_val_16;
-                        for(size_t i = 0; i < sizeof(val); i++){
-                            cast_val_16 += ((u16)cache_data[index_for_data + i] << shift_amt);
-                            shift_amt += 8;
-                        }
-                        val = cast_val_16;
-                    }
-                    else if(sizeof(val) == 4){
-                        for(size_t i = 0; i < sizeof(val); i++){
-                            cast_val_32 += ((u32)cache_data[index_for_data + i] << shift_amt);
-                            shift_amt += 8;
-                        }
-                        val = cast_val_32;
-                    }
-                    else{
-                        for(size_t i = 0; i < sizeof(val); i++){
-                            cast_val_64 += ((u64)cache_data[index_for_data + i] << shift_amt);
-                            shift_amt += 8;
-                        }
-                        val = cast_val_64;
-                    }
-                    return 0;
-                }
-                
-                /*
-                *Stores a value into the cache_data array. Possible value types are u8, u16, u32, and u64.
-                *
-                *@param mpa is the machine physical address. This is needed in the event write-through policy is used.
-                *@param index_for_data is the index for the first byte in the cache_data array.
-                *@param val is the value that will be stored into the cache_data array. One byte at a time.
-                *
-                */
-                template<typename T>
-                buserror_t store_val(UX mpa, UX index_for_data, T val){
-                    u8 cast_val_8 = *reinterpret_cast<u8*>(&val);
-                    u16 cast_val_16 = *reinterpret_cast<u16*>(&val);
-                    u32 cast_val_32 = *reinterpret_cast<u32*>(&val);
-                    u64 cast_val_64 = *reinterpret_cast<u64*>(&val);
-                    //Assign current_byte to val so that only a byte is retrieved,
-                    //store that, then right shift val a byte amount to get the next byte. 
-                    if(sizeof(val) == 1){
-                            cache_data[index_for_data] = cast_val_8;
-                            if(write_policy == cache_write_through){
-                                if(mem->store(mpa,cast_val_8)) return -1;
-                            }
-                    }
-                    else if(sizeof(val) == 2)
-                        for(size_t i = 0; i < sizeof(val); i++){
-                            u8 current_byte = cast_val_16;
-                            cache_data[index_for_data + i] = current_byte;
-                            if(write_policy == cache_write_through){
-                                if(mem->store(mpa++,current_byte)) return -1;
-                            }
-                            cast_val_16 >>= 8;
-                        }
-                    else if(sizeof(val) == 4)
-                        for(size_t i = 0; i < sizeof(val); i++){
-                            u8 current_byte = cast_val_32;
-                            cache_data[index_for_data + i] = current_byte;
-                            if(write_policy == cache_write_through){
-                                if(mem->store(mpa++,current_byte)) return -1;
-                            }
-                            cast_val_32 >>= 8;
-                        }
-                    else{
-                        for(size_t i = 0; i < sizeof(val); i++){
-                            u8 current_byte = cast_val_64;
-                            cache_data[index_for_data + i] = current_byte;
-                            if(write_policy == cache_write_through){
-                                if(mem->store(mpa++,current_byte)) return -1;
-                            }
-                            cast_val_64 >>= 8;
-                        }
-                   }
-                   return 0;
-                }
-
-                /*
-                *Given an mpa, access the cache to find the corresponding cache_entry, if it exists. 
-                *If it's not there, main memory will be accessed to supply it.
-                *
-                *@param mpa is the machine physical address
-                *@param op is the operation that will be performed. op can only be 'S' (store) or 'L' (load).
-                *@param val is the value that will be stored into memory at the specified address. This variable is ignored on a load.
-                *@precondition The caller must access the TLB and translate the UX va to UX mpa and provide it to this function.
-                *@return the value that was stored/loaded into the cache is returned from where it is stored in the cache_data array.
-                *
-                */
-                template<typename T>
-                buserror_t access_cache(UX mpa, u8 op, T & val){
-                    //Lookup the mpa in the cache
-                    UX index_for_entry = lookup_cache_line(mpa);
-                    cache_entry_t * ent = &cache_key[index_for_entry];
-                    UX index_for_data = ((index_for_entry << cache_line_shift) | (mpa & cache_line_offset_mask)); 
-                    //Check for a hit
-                    if(ent->status == cache_line_hit){
-                        //Hit was found, set the status to filled. 
-                        ent->status = cache_line_filled;
-                        last_access = cache_line_hit;
-                        update_stats(0xC0000010);
-                    }
-
-                    //No hit was found, evict a block
-                    else if(ent->status == cache_line_must_evict){
-                        //If the line is dirty, write its contents to mem
-                        if(write_policy == cache_write_back && ent->state == cache_state_modified){
-                            ent->state = cache_state_shared;
-                            if(allocate(ent->pcln << cache_line_shift, 'S', index_for_entry)) return -1;
-                        }
-                        //Set the LRU counter for the current line to be 0, and update all the other lines in the set.
-                        ent->LRU_count = 0;
-                        update_LRU_counters(ent->pcln & num_entries_mask, ent);
-                        //Load the block from memory into the cache.
-                        ent->pcln = mpa >> cache_line_shift;
-                        ent->ppn = ent->pcln >> num_entries_shift;
-                        ent->status = cache_line_filled;
-                        last_access = cache_line_must_evict;
-                        update_stats(0xC0000018);
-                        update_stats(0xC0000020);
-                        if(allocate(mpa, 'L', index_for_entry)) return -1;
-                    }
-                    //No hit was found, but an empty line was found.
-                    else if(ent->status == cache_line_empty){
-                        ent->pcln = mpa >> cache_line_shift;
-                        ent->ppn = ent->pcln >> num_entries_shift;
-                        ent->status = cache_line_filled;
-                        last_access = cache_line_empty;
-                        update_stats(0xC0000018);
-                        if(allocate(mpa,'L', index_for_entry)) return -1;
-                    }
-                    //If write through policy is used and mem access is a store,
-                    //store the contents of the mpa directly to cache and main mem.
-                    if(op == 'S' && write_policy == cache_write_through){
-                        if(store_val(mpa,index_for_data,val)) return -1;
-                        //u8 memVal;
-                        //mem->load(mpa,memVal);
-                    }
-                    //If write back policy is used and mem access is a store,
-                    //set the cache state to modified (aka dirty) and store to cache only
-                    else if(op == 'S' && write_policy == cache_write_back){
-                        ent->state = cache_state_modified;
-                        if(store_val(mpa,index_for_data,val)) return -1;
-                    }
-                    //If loading, load from the cache_data array into val;
-                    else{
-                        if(load_val(mpa,index_for_data,val)) return -1;
-                    }
-                    return 0;
-                }
+		bool enabled() { return num_entries != 0; }
+
+		bool cached(UX mpa)
+		{
+			return enabled() && mpa >= default_ram_base && mpa <= default_ram_base + default_ram_size;
+		}
+
+		u8* line_data(size_t index) { return cache_data.data() + (index << cache_line_shift); }
+
+		UX line_mpa(size_t index)
+		{
+			UX set = index >> num_ways_shift;
+			return ((cache_key[index].tag << num_entries_shift) | set) << cache_line_shift;
+		}
 
 		/*
-                * Performs a lookup in the cache to determine if there is a cache line corresponding to the provided mpa.
-                *
-                * @param mpa is the machine physical address that is being looked up.
-		* @return the index for the cache_key array that can lookup the tagged_cache_entry for the given mpa.
-                *
-                */
-                UX lookup_cache_line(UX mpa)
+		*Moves lines to and from the next level. A next level cache transfers whole lines,
+		*memory is copied in bulk when the line is host backed, otherwise a word at a time.
+		*/
+		template <typename M>
+		static auto read_next(M &next, UX mpa, u8 *data, size_t len, int)
+			-> decltype(next.read_line(mpa, data, len))
 		{
-                    //Variables to record entry, position, and misc data as we search the set 
-                    UX emptyLineIndex = 0, maxLRUIndex = 0;
-                    u8 found_empty_line = 0, maxLRU = 0;
-                    cache_entry_t * line_to_evict = nullptr;
-
-                    //Variables to hold the entry and ppn
-                    UX pcln = mpa >> cache_line_shift;
-		    UX entry = pcln & num_entries_mask;
-                    UX ppn = pcln >> num_entries_shift;
-                    
-                    for (size_t i = 0; i < num_ways; i++) {
-                        //Index to lookup in cache_key
-                        UX index = ((entry << num_ways_shift) + i);
-                        //cache entry at index location
-                        cache_entry_t *ent = cache_key + index;
-                        //Check if hit
-                        if (ent->ppn == ppn) {
-                            ent->status = cache_line_hit;
-                            return index;
+			return next.read_line(mpa, data, len);
+		}
+
+		template <typename M>
+		static buserror_t read_next(M &next, UX mpa, u8 *data, size_t len, long)
+		{
+			auto page = next.mpa_to_page(mpa);
+			if (page && page->uva) {
+				memcpy(data, reinterpret_cast<u8*>(page->uva + (mpa & (page_size - 1))), len);
+				return 0;
+			}
+			for (size_t offset = 0; offset < len; offset += sizeof(u64)) {
+				u64 word;
+				if (next.load(UX(mpa + offset), word)) return -1;
+				memcpy(data + offset, &word, sizeof(word));
+			}
+			return 0;
+		}
+
+		template <typename M>
+		static auto write_next(M &next, UX mpa, const u8 *data, size_t len, int)
+			-> decltype(next.write_line(mpa, data, len))
+		{
+			return next.write_line(mpa, data, len);
+		}
+
+		template <typename M>
+		static buserror_t write_next(M &next, UX mpa, const u8 *data, size_t len, long)
+		{
+			auto page = next.mpa_to_page(mpa);
+			if (page && page->uva) {
+				memcpy(reinterpret_cast<u8*>(page->uva + (mpa & (page_size - 1))), data, len);
+				return 0;
+			}
+			for (size_t offset = 0; offset < len; offset += sizeof(u64)) {
+				u64 word;
+				memcpy(&word, data + offset, sizeof(word));
+				if (next.store(UX(mpa + offset), word)) return -1;
+			}
+			return 0;
+		}
+
+		/*
+		* Performs a lookup in the cache for the line containing the mpa and records
+		* whether it was a hit, found an empty way or must evict in last_access.
+		*
+		* @param mpa is the machine physical address that is being looked up.
+		* @return the index in cache_key of the hit, empty or victim line.
+		*/
+		size_t lookup_cache_line(UX mpa)
+		{
+			UX pcln = mpa >> cache_line_shift;
+			size_t set = pcln & num_entries_mask;
+			UX tag = pcln >> num_entries_shift;
+			size_t base = set << num_ways_shift, empty = num_ways;
+			for (size_t way = 0; way < num_ways; way++) {
+				cache_entry_t &ent = cache_key[base + way];
+				if (ent.status == cache_line_empty) {
+					if (empty == num_ways) empty = way;
+				} else if (ent.tag == tag) {
+					last_access = cache_line_hit;
+					return base + way;
+				}
+			}
+			if (empty != num_ways) {
+				last_access = cache_line_empty;
+				return base + empty;
+			}
+			last_access = cache_line_must_evict;
+			return base + replacement->victim(set);
+		}
+
+		/*
+		*Makes the line containing the mpa resident, writing back a dirty victim and
+		*filling from the next level on a miss.
+		*
+		*@param mpa is the machine physical address
+		*@param index is set to the index of the line in cache_key
+		*/
+		buserror_t access_line(UX mpa, size_t &index)
+		{
+			index = lookup_cache_line(mpa);
+			cache_entry_t &ent = cache_key[index];
+			size_t set = index >> num_ways_shift, way = index & (num_ways - 1);
+			if (last_access == cache_line_hit) {
+				stats.hits++;
+				replacement->hit(set, way);
+				return 0;
+			}
+			stats.misses++;
+			if (last_access == cache_line_must_evict) {
+				stats.evictions++;
+				set_conflicts[set]++;
+				if (ent.state == cache_state_modified) {
+					stats.writebacks++;
+					if (write_next(*mem, line_mpa(index), line_data(index), line_size, 0)) return -1;
+				}
+			}
+			ent.tag = mpa >> (cache_line_shift + num_entries_shift);
+			ent.state = cache_state_shared;
+			ent.status = cache_line_filled;
+			if (read_next(*mem, mpa & ~cache_line_offset_mask, line_data(index), line_size, 0)) {
+				ent.status = cache_line_empty;
+				return -1;
+			}
+			replacement->fill(set, way);
+			return 0;
+		}
+
+		/*
+		*Given an mpa, access the cache to find the corresponding cache_entry, if it exists.
+		*If it's not there, the next level will be accessed to supply it. Values are held in
+		*host (little endian) byte order and must not cross a line.
+		*
+		*@param mpa is the machine physical address
+		*@param op is the operation that will be performed. op can only be 'S' (store) or 'L' (load).
+		*@param val is the value that will be stored, or is set to the value loaded.
+		*/
+		template <typename T>
+		buserror_t access_cache(UX mpa, u8 op, T &val)
+		{
+			size_t index;
+			if (access_line(mpa, index)) return -1;
+			u8 *data = line_data(index) + (mpa & cache_line_offset_mask);
+			if (op == 'S') {
+				memcpy(data, &val, sizeof(val));
+				if (write_policy == cache_write_through) return mem->store(mpa, val);
+				cache_key[index].state = cache_state_modified;
+			} else {
+				memcpy(&val, data, sizeof(val));
+			}
+			return 0;
+		}
+
+		/* accesses that cross a line are split into bytes */
+		template <typename T>
+		buserror_t access_split(UX mpa, u8 op, T &val)
+		{
+			u8 bytes[sizeof(T)];
+			memcpy(bytes, &val, sizeof(val));
+			for (size_t i = 0; i < sizeof(T); i++) {
+				if (access_cache(UX(mpa + i), op, bytes[i])) return -1;
+			}
+			memcpy(&val, bytes, sizeof(val));
+			return 0;
+		}
+
+		/*
+		*Function used by the mmu or the level above to load from the cache.
+		*
+		*@param mpa is the machine physical address being loaded from
+		*@param val is set to the value loaded from the mpa
+		*/
+		template <typename T>
+		buserror_t load(UX mpa, T &val)
+		{
+			if (!cached(mpa)) return mem->load(mpa, val);
+			stats.loads++;
+			if (unlikely((mpa & cache_line_offset_mask) + sizeof(T) > line_size)) {
+				return access_split(mpa, 'L', val);
+			}
+			return access_cache(mpa, 'L', val);
+		}
+
+		/*
+		*Function used by the mmu or the level above to store to the cache.
+		*
+		*@param mpa is the machine physical address being stored to
+		*@param val is the value that will be stored at the mpa
+		*/
+		template <typename T>
+		buserror_t store(UX mpa, T val)
+		{
+			if (!cached(mpa)) return mem->store(mpa, val);
+			stats.stores++;
+			if (unlikely((mpa & cache_line_offset_mask) + sizeof(T) > line_size)) {
+				return access_split(mpa, 'S', val);
+			}
+			return access_cache(mpa, 'S', val);
+		}
+
+		/*
+		*Line transfers for the level above, which may use a different line size.
+		*Each line of this cache touched by the transfer counts as one access.
+		*/
+		buserror_t read_line(UX mpa, u8 *data, size_t len)
+		{
+			if (!cached(mpa)) return read_next(*mem, mpa, data, len, 0);
+			for (size_t offset = 0, chunk; offset < len; offset += chunk) {
+				UX line_offset = (mpa + offset) & cache_line_offset_mask;
+				size_t index;
+				chunk = std::min(len - offset, size_t(line_size - line_offset));
+				stats.loads++;
+				if (access_line(UX(mpa + offset), index)) return -1;
+				memcpy(data + offset, line_data(index) + line_offset, chunk);
+			}
+			return 0;
+		}
+
+		buserror_t write_line(UX mpa, const u8 *data, size_t len)
+		{
+			if (!cached(mpa)) return write_next(*mem, mpa, data, len, 0);
+			for (size_t offset = 0, chunk; offset < len; offset += chunk) {
+				UX line_offset = (mpa + offset) & cache_line_offset_mask;
+				size_t index;
+				chunk = std::min(len - offset, size_t(line_size - line_offset));
+				stats.stores++;
+				if (access_line(UX(mpa + offset), index)) return -1;
+				memcpy(line_data(index) + line_offset, data + offset, chunk);
+				if (write_policy == cache_write_back) {
+					cache_key[index].state = cache_state_modified;
+				}
+			}
+			if (write_policy == cache_write_through) {
+				return write_next(*mem, mpa, data, len, 0);
+			}
+			return 0;
+		}
+
+		/* write back dirty lines and invalidate every line */
+		buserror_t flush()
+		{
+			for (size_t index = 0; index < cache_key.size(); index++) {
+				cache_entry_t &ent = cache_key[index];
+				if (ent.status != cache_line_empty && ent.state == cache_state_modified) {
+					stats.writebacks++;
+					if (write_next(*mem, line_mpa(index), line_data(index), line_size, 0)) return -1;
+				}
+				ent.state = cache_state_shared;
+				ent.status = cache_line_empty;
+			}
+			return 0;
+		}
+
+		/* write back dirty lines, leaving them resident and clean */
+		buserror_t write_back()
+		{
+			for (size_t index = 0; index < cache_key.size(); index++) {
+				cache_entry_t &ent = cache_key[index];
+				if (ent.status != cache_line_empty && ent.state == cache_state_modified) {
+					stats.writebacks++;
+					if (write_next(*mem, line_mpa(index), line_data(index), line_size, 0)) return -1;
+					ent.state = cache_state_shared;
+				}
+			}
+			return 0;
+		}
+
+		buserror_t load_8 (UX mpa, u8  &val) { return load(mpa, val); }
+		buserror_t load_16(UX mpa, u16 &val) { return load(mpa, val); }
+		buserror_t load_32(UX mpa, u32 &val) { return load(mpa, val); }
+		buserror_t load_64(UX mpa, u64 &val) { return load(mpa, val); }
+
+		buserror_t store_8 (UX mpa, u8  val) { return store(mpa, val); }
+		buserror_t store_16(UX mpa, u16 val) { return store(mpa, val); }
+		buserror_t store_32(UX mpa, u32 val) { return store(mpa, val); }
+		buserror_t store_64(UX mpa, u64 val) { return store(mpa, val); }
+
+		/*
+		*Returns the statistics word at the given index, in the order of cache_stats followed by
+		*the number of sets, the number of ways and the conflict count of each set.
+		*
+		*@param index is the index of the 64-bit word
+		*/
+		u64 stats_word(size_t index)
+		{
+			const size_t num_stats = sizeof(cache_stats) / sizeof(u64);
+			if (index < num_stats) return reinterpret_cast<u64*>(&stats)[index];
+			if (index == num_stats) return num_entries;
+			if (index == num_stats + 1) return num_ways;
+			if (index - num_stats - 2 < num_entries) return set_conflicts[index - num_stats - 2];
+			return 0;
+		}
+
+		const char* write_policy_name()
+		{
+			return write_policy == cache_write_back ? "write_back" : "write_through";
+		}
+
+		/* print the statistics, summarising the conflicts per set */
+		void print_stats(const char *name)
+		{
+			if (!enabled()) {
+				printf("%-8s disabled\n", name);
+				return;
+			}
+			u64 accesses = stats.loads + stats.stores;
+			size_t worst = 0;
+			for (size_t i = 1; i < num_entries; i++) {
+				if (set_conflicts[i] > set_conflicts[worst]) worst = i;
 			}
-                        //Record an empty block if there is one available. This may be used if we cannot find a hit.
-                        else if(!found_empty_line && ent->status == cache_line_empty){
-                            found_empty_line = 1;
-                            emptyLineIndex = index;
-                        }
-                        //Record this block as a potential block to evict if it has a higher/equal LRU count. 
-                        else if(ent->LRU_count >= maxLRU){
-                            line_to_evict = &cache_key[index];
-                            maxLRU = ent->LRU_count;
-                            maxLRUIndex = index;
-                        }
-		    }
-                    //Return the empty block if that's all that could be found
-                    if(found_empty_line) 
-                        return emptyLineIndex; 
-                    //Return the block we're going to evict if no hit or empty block was found.
-                    else { 
-                        line_to_evict->status = cache_line_must_evict;
-                        return maxLRUIndex;
-                    }
+			printf("%-8s size %llu ways %llu line size %llu sets %llu %s %s\n", name,
+				u64(size), u64(num_ways), u64(line_size), u64(num_entries),
+				replacement->name(), write_policy_name());
+			printf("%-8s loads %llu stores %llu hits %llu misses %llu evictions %llu writebacks %llu\n", "",
+				stats.loads, stats.stores, stats.hits, stats.misses, stats.evictions, stats.writebacks);
+			printf("%-8s hit rate %.2f%% most conflicts %llu (set %llu)\n", "",
+				accesses ? 100.0 * double(stats.hits) / double(accesses) : 0.0,
+				set_conflicts[worst], u64(worst));
 		}
 
+		/* write the statistics as a named member of a JSON object */
+		void write_stats_json(FILE *file, const char *name)
+		{
+			fprintf(file, "  \"%s\": {\n", name);
+			fprintf(file, "    \"size\": %llu,\n    \"ways\": %llu,\n    \"line_size\": %llu,\n    \"sets\": %llu,\n",
+				u64(size), u64(num_ways), u64(line_size), u64(num_entries));
+			fprintf(file, "    \"write_policy\": \"%s\",\n    \"replacement\": \"%s\",\n",
+				write_policy_name(), enabled() ? replacement->name() : "none");
+			fprintf(file, "    \"loads\": %llu,\n    \"stores\": %llu,\n    \"hits\": %llu,\n"
+				"    \"misses\": %llu,\n    \"evictions\": %llu,\n    \"writebacks\": %llu,\n",
+				stats.loads, stats.stores, stats.hits, stats.misses, stats.evictions, stats.writebacks);
+			fprintf(file, "    \"set_conflicts\": [");
+			for (size_t i = 0; i < num_entries; i++) {
+				fprintf(file, "%s%llu", i ? ", " : "", set_conflicts[i]);
+			}
+			fprintf(file, "]\n  }");
+		}
 	};
 
-	template <const size_t cache_size, const size_t cache_ways, const size_t cache_line_size>
-	using tagged_cache_rv32 = tagged_cache<param_rv32,cache_size,cache_ways,cache_line_size>;
+	/*
+	 * cache_stats_mmio_device
+	 *
+	 * read-only window onto the statistics of a cache (see tagged_cache::stats_word)
+	 */
+	template <typename CACHE>
+	struct cache_stats_mmio_device : memory_segment<typename CACHE::UX>
+	{
+		typedef typename CACHE::UX UX;
+
+		enum {
+			total_size = page_size
+		};
+
+		std::shared_ptr<CACHE> cache;
+
+		cache_stats_mmio_device(std::shared_ptr<CACHE> cache, UX mpa) :
+			memory_segment<UX>("CACHE", mpa, /*uva*/0, /*size*/total_size,
+				pma_type_io | pma_prot_read),
+			cache(cache) {}
+
+		template <typename T>
+		buserror_t load_stats(UX va, T &val)
+		{
+			val = T(cache->stats_word(va >> 3) >> ((va & 7) << 3));
+			return 0;
+		}
+
+		buserror_t load_8 (UX va, u8  &val) { return load_stats(va, val); }
+		buserror_t load_16(UX va, u16 &val) { return load_stats(va, val); }
+		buserror_t load_32(UX va, u32 &val) { return load_stats(va, val); }
+		buserror_t load_64(UX va, u64 &val) { return load_stats(va, val); }
+	};
+
+	typedef tagged_cache<param_rv32> tagged_cache_rv32;
+	typedef tagged_cache<param_rv64> tagged_cache_rv64;
 
-	template <const size_t cache_size, const size_t cache_ways, const size_t cache_line_size>
-	using tagged_cache_rv64 = tagged_cache<param_rv64,cache_size,cache_ways,cache_line_size>;
-        
 }
 
 #endif
@@ -58,13 +58,12 @@ namespace riscv {
 			if (pollfds[1].revents & POLLIN) {
 				if ((ret = read(STDIN_FILENO, buf, (sizeof(buf)))) < 0) {
 					debug("console: stdin: read: %s", strerror(errno));
-				} else {
-					proc.intr_mutex.lock();
+				} else if (ret > 0) {
 					for (ssize_t i = 0; i < ret; i++) {
 						queue.push_back(buf[i]);
 					}
-					proc.intr_cond.notify_one();
-					proc.intr_mutex.unlock();
+					/* input is routed to the boot hart */
+					proc.post_interrupt(0);
 				}
 			}
 		}
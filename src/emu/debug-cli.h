@@ -64,6 +64,7 @@ namespace riscv {
 			add_command(cmd_quit,   1, 1, "quit",   "",                 "End Simulation");
 			add_command(cmd_reg,    1, 1, "reg",    "",                 "Show Registers");
 			add_command(cmd_run,    1, 2, "run",    "[count]",          "Step processor");
+			add_command(cmd_tlb,    1, 1, "tlb",    "",                 "Show TLB statistics");
 		}
 
 		void add_command(cmd_fn fn, size_t min_args, size_t max_args,
@@ -273,6 +274,24 @@ namespace riscv {
 			return 0;
 		}
 
+		template <typename Q>
+		static auto print_tlb_stats(Q &proc, int) -> decltype(proc.mmu.print_tlb_stats(), void())
+		{
+			proc.mmu.print_tlb_stats();
+		}
+
+		template <typename Q>
+		static void print_tlb_stats(Q &proc, long)
+		{
+			printf("no tlb\n");
+		}
+
+		static size_t cmd_tlb(cmd_state &st, args_t &args)
+		{
+			print_tlb_stats(*st.proc, 0);
+			return 0;
+		}
+
 		static size_t cmd_hist(cmd_state &st, args_t &args)
 		{
 			bool hist_pc = (args[1] == "pc");
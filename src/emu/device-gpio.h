@@ -71,7 +71,7 @@ namespace riscv {
 		void trigger()
 		{
 			if (gpio.out & OUT_POWER_OFF) {
-				proc.raise(P::internal_cause_poweroff, proc.pc);
+				proc.poweroff();
 			}
 			if (gpio.out & OUT_RESET) {
 				proc.reset();
@@ -123,6 +123,7 @@ namespace riscv {
 			}
 			if (va < total_size) *(as_u8() + va) = val;
 			trigger();
+			proc.post_interrupt(0);
 			return 0;
 		}
 
@@ -133,6 +134,7 @@ namespace riscv {
 			}
 			if (va < total_size - 1) *(as_u16() + (va>>1)) = val;
 			trigger();
+			proc.post_interrupt(0);
 			return 0;
 		}
 
@@ -143,6 +145,7 @@ namespace riscv {
 			}
 			if (va < total_size - 3) *(as_u32() + (va>>2)) = val;
 			trigger();
+			proc.post_interrupt(0);
 			return 0;
 		}
 
@@ -153,6 +156,7 @@ namespace riscv {
 			}
 			if (va < total_size - 7) *(as_u64() + (va>>3)) = val;
 			trigger();
+			proc.post_interrupt(0);
 			return 0;
 		}
 
@@ -57,7 +57,7 @@ namespace riscv {
 		void handle_output()
 		{
 			if (htif_tohost == 1) {
-				proc.raise(P::internal_cause_poweroff, proc.pc);
+				proc.poweroff();
 			}
 			u8 device = htif_device(htif_tohost);
 			u8 command = htif_command(htif_tohost);
@@ -7,7 +7,15 @@
 
 namespace riscv {
 
-	/* MIPI MMIO device */
+	/*
+	 * MIPI MMIO device
+	 *
+	 * One IPI word per hart, followed by one remote fence word per hart.
+	 * A 32-bit store to a fence word requests the fences in the stored
+	 * bits and posts an event to the hart, which completes them before
+	 * its next step and clears the word, so the requesting hart can wait
+	 * for the word to read zero.
+	 */
 
 	template <typename P, const int NUM_HARTS = 4>
 	struct mipi_mmio_device : memory_segment<typename P::ux>
@@ -17,7 +25,13 @@ namespace riscv {
 		enum {
 			bits_per_word = sizeof(u32) << 3,
 			num_harts = NUM_HARTS,
-			total_size = bits_per_word * num_harts
+			ipi_size = sizeof(u32) * num_harts,
+			total_size = ipi_size * 2
+		};
+
+		enum : u32 {
+			fence_i = 1,   /* flush instruction fetch state */
+			fence_vm = 2   /* flush address translation state */
 		};
 
 		P &proc;
@@ -25,6 +39,7 @@ namespace riscv {
 		/* MIPI registers */
 
 		u32 hart[NUM_HARTS];
+		u32 fence[NUM_HARTS];
 
 		constexpr u8* as_u8() { return (u8*)&hart[0]; }
 		constexpr u16* as_u16() { return (u16*)&hart[0]; }
@@ -36,7 +51,7 @@ namespace riscv {
 		mipi_mmio_device(P &proc, UX mpa) :
 			memory_segment<UX>("IPI", mpa, /*uva*/0, /*size*/total_size,
 				pma_type_io | pma_prot_read | pma_prot_write), proc(proc),
-				hart{} {}
+				hart{}, fence{} {}
 
 		/* MIPI interface */
 
@@ -45,12 +60,24 @@ namespace riscv {
 			for (size_t i = 0; i < num_harts; i++) {
 				debug("mipi_mmio:hart[%04d]       0x%x", i, hart[i]);
 			}
+			for (size_t i = 0; i < num_harts; i++) {
+				debug("mipi_mmio:fence[%04d]      0x%x", i, fence[i]);
+			}
 		}
 
 		void signal_ipi(UX hart_id, u32 value)
 		{
 			if (hart_id >= num_harts) return;
-			hart[num_harts] |= (1ULL << (hart_id & (bits_per_word-1)));
+			hart[hart_id] = value;
+			proc.post_interrupt(hart_id);
+		}
+
+		/* post interrupt events to the harts whose words were stored */
+		void wake_harts(UX va, size_t len)
+		{
+			for (UX i = va >> 2; i <= (va + len - 1) >> 2 && i < num_harts; i++) {
+				proc.post_interrupt(i);
+			}
 		}
 
 		bool ipi_pending(UX hart_id)
@@ -59,11 +86,26 @@ namespace riscv {
 			return hart[hart_id] > 0;
 		}
 
+		/* request remote fences, posting an event to the hart */
+		void request_fence(UX hart_id, u32 fences)
+		{
+			if (hart_id >= num_harts) return;
+			__atomic_fetch_or(&fence[hart_id], fences, __ATOMIC_SEQ_CST);
+			proc.post_interrupt(hart_id);
+		}
+
+		/* take the remote fences requested of a hart, which completes them */
+		u32 claim_fences(UX hart_id)
+		{
+			if (hart_id >= num_harts) return 0;
+			return __atomic_exchange_n(&fence[hart_id], 0, __ATOMIC_SEQ_CST);
+		}
+
 		/* MIPI MMIO */
 
 		buserror_t load_8 (UX va, u8  &val)
 		{
-			val = (va < total_size) ? *(as_u8() + va) : 0;
+			val = (va < ipi_size) ? *(as_u8() + va) : 0;
 			if (proc.log & proc_log_mmio) {
 				printf("mipi_mmio:0x%04llx -> 0x%02hhx\n", addr_t(va), val);
 			}
@@ -72,7 +114,7 @@ namespace riscv {
 
 		buserror_t load_16(UX va, u16 &val)
 		{
-			val = (va < total_size - 1) ? *(as_u16() + (va>>1)) : 0;
+			val = (va < ipi_size - 1) ? *(as_u16() + (va>>1)) : 0;
 			if (proc.log & proc_log_mmio) {
 				printf("mipi_mmio:0x%04llx -> 0x%04hx\n", addr_t(va), val);
 			}
@@ -81,7 +123,11 @@ namespace riscv {
 
 		buserror_t load_32(UX va, u32 &val)
 		{
-			val = (va < total_size - 3) ? *(as_u32() + (va>>2)) : 0;
+			if (va >= ipi_size && va < total_size - 3) {
+				val = __atomic_load_n(as_u32() + (va>>2), __ATOMIC_SEQ_CST);
+			} else {
+				val = (va < ipi_size - 3) ? *(as_u32() + (va>>2)) : 0;
+			}
 			if (proc.log & proc_log_mmio) {
 				printf("mipi_mmio:0x%04llx -> 0x%08x\n", addr_t(va), val);
 			}
@@ -90,7 +136,7 @@ namespace riscv {
 
 		buserror_t load_64(UX va, u64 &val)
 		{
-			val = (va < total_size - 7) ? *(as_u64() + (va>>3)) : 0;
+			val = (va < ipi_size - 7) ? *(as_u64() + (va>>3)) : 0;
 			if (proc.log & proc_log_mmio) {
 				printf("mipi_mmio:0x%04llx -> 0x%016llx\n", addr_t(va), val);
 			}
@@ -102,7 +148,10 @@ namespace riscv {
 			if (proc.log & proc_log_mmio) {
 				printf("mipi_mmio:0x%04llx <- 0x%02hhx\n", addr_t(va), val);
 			}
-			if (va < total_size) *(as_u8() + va) = val;
+			if (va < ipi_size) {
+				*(as_u8() + va) = val;
+				wake_harts(va, sizeof(val));
+			}
 			return 0;
 		}
 
@@ -111,7 +160,10 @@ namespace riscv {
 			if (proc.log & proc_log_mmio) {
 				printf("mipi_mmio:0x%04llx <- 0x%04hx\n", addr_t(va), val);
 			}
-			if (va < total_size - 1) *(as_u16() + (va>>1)) = val;
+			if (va < ipi_size - 1) {
+				*(as_u16() + (va>>1)) = val;
+				wake_harts(va, sizeof(val));
+			}
 			return 0;
 		}
 
@@ -120,7 +172,12 @@ namespace riscv {
 			if (proc.log & proc_log_mmio) {
 				printf("mipi_mmio:0x%04llx <- 0x%08x\n", addr_t(va), val);
 			}
-			if (va < total_size - 3) *(as_u32() + (va>>2)) = val;
+			if (va >= ipi_size && va < total_size - 3) {
+				request_fence((va - ipi_size) >> 2, val);
+			} else if (va < ipi_size - 3) {
+				*(as_u32() + (va>>2)) = val;
+				wake_harts(va, sizeof(val));
+			}
 			return 0;
 		}
 
@@ -129,7 +186,10 @@ namespace riscv {
 			if (proc.log & proc_log_mmio) {
 				printf("mipi_mmio:0x%04llx <- 0x%016llx\n", addr_t(va), val);
 			}
-			if (va < total_size - 7) *(as_u64() + (va>>3)) = val;
+			if (va < ipi_size - 7) {
+				*(as_u64() + (va>>3)) = val;
+				wake_harts(va, sizeof(val));
+			}
 			return 0;
 		}
 
@@ -103,6 +103,7 @@ namespace riscv {
 				val--;
 				if (val < 32) {
 					served &= ~(1 << val);
+					proc.post_interrupt(0);
 				}
 			}
 			return 0;
@@ -117,6 +118,7 @@ namespace riscv {
 				val--;
 				if (val < 32) {
 					served &= ~(1 << val);
+					proc.post_interrupt(0);
 				}
 			}
 			return 0;
@@ -40,7 +40,8 @@ namespace riscv {
 			debug("rtc_mmio:time              0x%llx", mtime);
 		}
 
-		void update_time(UX time)
+		/* the time is read from the processor clock on demand */
+		void update_time(u64 time)
 		{
 			mtime = time;
 		}
@@ -49,6 +50,7 @@ namespace riscv {
 
 		buserror_t load_32(UX va, u32 &val)
 		{
+			update_time(proc.current_hart->get_time());
 			if (va == 0) {
 				val = u32(mtime);
 			}
@@ -63,6 +65,7 @@ namespace riscv {
 
 		buserror_t load_64(UX va, u64 &val)
 		{
+			update_time(proc.current_hart->get_time());
 			if (va == 0) {
 				val = mtime;
 			}
@@ -17,7 +17,7 @@ namespace riscv {
 		enum {
 			bits_per_word = sizeof(u64) << 3,
 			num_harts = NUM_HARTS,
-			total_size = bits_per_word * num_harts
+			total_size = sizeof(u64) * num_harts
 		};
 
 		P &proc;
@@ -27,6 +27,23 @@ namespace riscv {
 		u64 timecmp[num_harts];
 		u64 claimed[num_harts];
 
+		/*
+		 * Armed timers are kept in a min-heap of (timecmp, hart) so only
+		 * the earliest deadline needs to be compared with the time. The
+		 * timer thread sleeps until that deadline and then posts an
+		 * interrupt event to the harts whose timers are due. Entries for
+		 * timers that have since been claimed or rewritten are dropped
+		 * when they reach the top of the heap.
+		 */
+		typedef std::pair<u64,size_t> deadline_t;
+
+		std::mutex deadline_lock;
+		std::condition_variable deadline_cond;
+		std::vector<deadline_t> deadlines;
+		std::atomic<u64> next_deadline;
+		bool running;
+		std::thread thread;
+
 		constexpr u8* as_u8() { return (u8*)&timecmp[0]; }
 		constexpr u16* as_u16() { return (u16*)&timecmp[0]; }
 		constexpr u32* as_u32() { return (u32*)&timecmp[0]; }
@@ -37,11 +54,66 @@ namespace riscv {
 		timer_mmio_device(P &proc, UX mpa) :
 			memory_segment<UX>("TIMER", mpa, /*uva*/0, /*size*/total_size,
 				pma_type_io | pma_prot_read | pma_prot_write), proc(proc),
-				timecmp{}
+				timecmp{}, next_deadline(std::numeric_limits<u64>::max()),
+				running(true)
 		{
 			for (size_t i = 0; i < num_harts; i++) {
 				claimed[i] = std::numeric_limits<u64>::max();
 			}
+			thread = std::thread(&timer_mmio_device::mainloop, this);
+		}
+
+		~timer_mmio_device()
+		{
+			{
+				std::lock_guard<std::mutex> lock(deadline_lock);
+				running = false;
+			}
+			deadline_cond.notify_one();
+			thread.join();
+		}
+
+		/* Timer thread */
+
+		void block_signals()
+		{
+			sigset_t set;
+			sigemptyset(&set);
+			sigaddset(&set, SIGTERM);
+			sigaddset(&set, SIGQUIT);
+			sigaddset(&set, SIGINT);
+			sigaddset(&set, SIGHUP);
+			sigaddset(&set, SIGUSR1);
+			sigaddset(&set, SIGPIPE);
+			if (pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) {
+				panic("timer_mmio_device: can't set thread signal mask: %s",
+					strerror(errno));
+			}
+		}
+
+		void mainloop()
+		{
+			block_signals();
+			/* in virtual time the harts end their steps at their own deadlines */
+			if (proc.inst_per_tick) return;
+			std::unique_lock<std::mutex> lock(deadline_lock);
+			while (running) {
+				u64 next = deadline(), now = proc.get_time();
+				if (next == std::numeric_limits<u64>::max()) {
+					deadline_cond.wait(lock);
+				} else if (now < next) {
+					deadline_cond.wait_for(lock,
+						std::chrono::nanoseconds((next - now) * proc.RTC_DIV));
+				} else {
+					for (size_t i = 0; i < num_harts; i++) {
+						if (claimed[i] == 0 && timecmp[i] <= now) {
+							proc.post_interrupt(i);
+						}
+					}
+					/* harts claim their timers in isr, which moves the deadline */
+					deadline_cond.wait(lock, [&] { return !running || deadline() != next; });
+				}
+			}
 		}
 
 		/* Timer interface */
@@ -54,11 +126,91 @@ namespace riscv {
 			}
 		}
 
+		static bool deadline_after(const deadline_t &a, const deadline_t &b)
+		{
+			return a.first > b.first;
+		}
+
+		/* drop stale deadlines from the top of the heap and publish the earliest */
+		void update_deadline()
+		{
+			while (deadlines.size() > 0) {
+				deadline_t &top = deadlines.front();
+				if (claimed[top.second] == 0 && timecmp[top.second] == top.first) break;
+				std::pop_heap(deadlines.begin(), deadlines.end(), deadline_after);
+				deadlines.pop_back();
+			}
+			u64 next = deadlines.size() > 0 ? deadlines.front().first :
+				std::numeric_limits<u64>::max();
+			if (next != next_deadline) {
+				next_deadline = next;
+				deadline_cond.notify_one();
+			}
+		}
+
+		/* arm the timer of a hart after a store to its compare register, with deadline_lock held */
+		void arm_timer(size_t hart_id)
+		{
+			claimed[hart_id] = 0;
+			if (hart_id >= proc.num_harts) return;
+			/* stale entries below the top are only dropped by rebuilding the heap */
+			if (deadlines.size() >= num_harts * 4) {
+				deadlines.clear();
+				for (size_t i = 0; i < proc.num_harts; i++) {
+					if (claimed[i] == 0 && i != hart_id) {
+						deadlines.push_back(deadline_t(timecmp[i], i));
+					}
+				}
+				std::make_heap(deadlines.begin(), deadlines.end(), deadline_after);
+			}
+			deadlines.push_back(deadline_t(timecmp[hart_id], hart_id));
+			std::push_heap(deadlines.begin(), deadlines.end(), deadline_after);
+			update_deadline();
+			/* the hart recomputes its step length for the new deadline */
+			if (proc.inst_per_tick) proc.post_interrupt(hart_id);
+		}
+
+		/*
+		 * compare registers are read by the timer thread and other harts
+		 * under deadline_lock, so MMIO accesses take the lock as well
+		 */
+		template <typename T>
+		T load_timecmp(UX va)
+		{
+			std::lock_guard<std::mutex> lock(deadline_lock);
+			return *((T*)as_u8() + va / sizeof(T));
+		}
+
+		template <typename T>
+		void store_timecmp(UX va, T val)
+		{
+			std::lock_guard<std::mutex> lock(deadline_lock);
+			*((T*)as_u8() + va / sizeof(T)) = val;
+			arm_timer(va >> 3);
+		}
+
+		/* compare value of a hart's armed timer, or the maximum if it is not armed */
+		u64 hart_deadline(size_t hart_id)
+		{
+			std::lock_guard<std::mutex> lock(deadline_lock);
+			return hart_id < num_harts && claimed[hart_id] == 0 ? timecmp[hart_id] :
+				std::numeric_limits<u64>::max();
+		}
+
+		/* earliest time at which any armed timer is due */
+		u64 deadline()
+		{
+			return next_deadline.load(std::memory_order_relaxed);
+		}
+
 		bool timer_pending(UX hart_id, u64 time)
 		{
-			if (hart_id >= num_harts || claimed[hart_id] > 0) return false;
+			if (hart_id >= num_harts || time < deadline()) return false;
+			std::lock_guard<std::mutex> lock(deadline_lock);
+			if (claimed[hart_id] > 0) return false;
 			if (timecmp[hart_id] <= time) {
 				claimed[hart_id] = time;
+				update_deadline();
 				return true;
 			} else {
 				return false;
@@ -69,7 +221,7 @@ namespace riscv {
 
 		buserror_t load_8 (UX va, u8  &val)
 		{
-			val = (va < total_size) ? *(as_u8() + va) : 0;
+			val = (va < total_size) ? load_timecmp<u8>(va) : 0;
 			if (proc.log & proc_log_mmio) {
 				printf("timer_mmio:0x%04llx -> 0x%02hhx\n", addr_t(va), val);
 			}
@@ -78,7 +230,7 @@ namespace riscv {
 
 		buserror_t load_16(UX va, u16 &val)
 		{
-			val = (va < total_size - 1) ? *(as_u16() + (va>>1)) : 0;
+			val = (va < total_size - 1) ? load_timecmp<u16>(va) : 0;
 			if (proc.log & proc_log_mmio) {
 				printf("timer_mmio:0x%04llx -> 0x%04hx\n", addr_t(va), val);
 			}
@@ -87,7 +239,7 @@ namespace riscv {
 
 		buserror_t load_32(UX va, u32 &val)
 		{
-			val = (va < total_size - 3) ? *(as_u32() + (va>>2)) : 0;
+			val = (va < total_size - 3) ? load_timecmp<u32>(va) : 0;
 			if (proc.log & proc_log_mmio) {
 				printf("timer_mmio:0x%04llx -> 0x%08x\n", addr_t(va), val);
 			}
@@ -96,7 +248,7 @@ namespace riscv {
 
 		buserror_t load_64(UX va, u64 &val)
 		{
-			val = (va < total_size - 7) ? *(as_u64() + (va>>3)) : 0;
+			val = (va < total_size - 7) ? load_timecmp<u64>(va) : 0;
 			if (proc.log & proc_log_mmio) {
 				printf("timer_mmio:0x%04llx -> 0x%016llx\n", addr_t(va), val);
 			}
@@ -108,10 +260,7 @@ namespace riscv {
 			if (proc.log & proc_log_mmio) {
 				printf("timer_mmio:0x%04llx <- 0x%02hhx\n", addr_t(va), val);
 			}
-			if (va < total_size) {
-				*(as_u8() + va) = val;
-				claimed[va >> 3] = 0;
-			}
+			if (va < total_size) store_timecmp<u8>(va, val);
 			return 0;
 		}
 
@@ -120,10 +269,7 @@ namespace riscv {
 			if (proc.log & proc_log_mmio) {
 				printf("timer_mmio:0x%04llx <- 0x%04hx\n", addr_t(va), val);
 			}
-			if (va < total_size - 1) {
-				*(as_u16() + (va>>1)) = val;
-				claimed[va >> 3] = 0;
-			}
+			if (va < total_size - 1) store_timecmp<u16>(va, val);
 			return 0;
 		}
 
@@ -132,10 +278,7 @@ namespace riscv {
 			if (proc.log & proc_log_mmio) {
 				printf("timer_mmio:0x%04llx <- 0x%08x\n", addr_t(va), val);
 			}
-			if (va < total_size - 3) {
-				*(as_u32() + (va>>2)) = val;
-				claimed[va >> 3] = 0;
-			}
+			if (va < total_size - 3) store_timecmp<u32>(va, val);
 			return 0;
 		}
 
@@ -144,10 +287,7 @@ namespace riscv {
 			if (proc.log & proc_log_mmio) {
 				printf("timer_mmio:0x%04llx <- 0x%016llx\n", addr_t(va), val);
 			}
-			if (va < total_size - 7) {
-				*(as_u64() + (va>>3)) = val;
-				claimed[va >> 3] = 0;
-			}
+			if (va < total_size - 7) store_timecmp<u64>(va, val);
 			return 0;
 		}
 
@@ -239,9 +239,11 @@ namespace riscv {
 				case REG_THR: /* Transmist Holding Register */
 					com.thr = val;
 					console->write_char(val);
+					proc.post_interrupt(0);
 					break;
 				case REG_IER: /* Interrupt Enable Register */
 					com.ier = val & IER_MASK;
+					proc.post_interrupt(0);
 					break;
 				case REG_FCR: /* FIFO Control Register */
 					/* ignore writes */
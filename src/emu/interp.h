@@ -245,12 +245,12 @@ typename P::ux exec_inst_rv32(T &dec, P &proc, typename P::ux pc_offset)
 			break;
 		case rv_op_lr_w:
 			if (rva) {
-				proc.lr = proc.ireg[dec.rs1]; s32 t; proc.mmu.template load<P,s32>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
+				s32 t; proc.mmu.template lr<P,s32>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
 			};
 			break;
 		case rv_op_sc_w:
 			if (rva) {
-				ux res = 0; if (proc.lr != proc.ireg[dec.rs1]) res = 1; else proc.mmu.template store<P,s32>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.w.val); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
+				ux res = 0; proc.mmu.template sc<P,s32>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.w.val, res); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
 			};
 			break;
 		case rv_op_amoswap_w:
@@ -563,6 +563,1434 @@ typename P::ux exec_inst_rv32(T &dec, P &proc, typename P::ux pc_offset)
 	return pc_offset;
 }
 
+/* Execute Block RV32 (direct threaded) */
+
+template <bool rvi, bool rvm, bool rva, bool rvs, bool rvf, bool rvd, bool rvq, bool rvc, typename T, typename P>
+size_t exec_block_rv32(P &proc, T *dec, const void **handler, const riscv::u8 *length, size_t count)
+{
+	using namespace riscv;
+	enum { xlen = 32 };
+	typedef s32 sx;
+	typedef u32 ux;
+
+	static const void *dispatch[] = {
+		&&illegal,
+		rvi ? &&exec_lui : &&illegal,
+		rvi ? &&exec_auipc : &&illegal,
+		rvi ? &&exec_jal : &&illegal,
+		rvi ? &&exec_jalr : &&illegal,
+		rvi ? &&exec_beq : &&illegal,
+		rvi ? &&exec_bne : &&illegal,
+		rvi ? &&exec_blt : &&illegal,
+		rvi ? &&exec_bge : &&illegal,
+		rvi ? &&exec_bltu : &&illegal,
+		rvi ? &&exec_bgeu : &&illegal,
+		rvi ? &&exec_lb : &&illegal,
+		rvi ? &&exec_lh : &&illegal,
+		rvi ? &&exec_lw : &&illegal,
+		rvi ? &&exec_lbu : &&illegal,
+		rvi ? &&exec_lhu : &&illegal,
+		rvi ? &&exec_sb : &&illegal,
+		rvi ? &&exec_sh : &&illegal,
+		rvi ? &&exec_sw : &&illegal,
+		rvi ? &&exec_addi : &&illegal,
+		rvi ? &&exec_slti : &&illegal,
+		rvi ? &&exec_sltiu : &&illegal,
+		rvi ? &&exec_xori : &&illegal,
+		rvi ? &&exec_ori : &&illegal,
+		rvi ? &&exec_andi : &&illegal,
+		rvi ? &&exec_slli : &&illegal,
+		rvi ? &&exec_srli : &&illegal,
+		rvi ? &&exec_srai : &&illegal,
+		rvi ? &&exec_add : &&illegal,
+		rvi ? &&exec_sub : &&illegal,
+		rvi ? &&exec_sll : &&illegal,
+		rvi ? &&exec_slt : &&illegal,
+		rvi ? &&exec_sltu : &&illegal,
+		rvi ? &&exec_xor : &&illegal,
+		rvi ? &&exec_srl : &&illegal,
+		rvi ? &&exec_sra : &&illegal,
+		rvi ? &&exec_or : &&illegal,
+		rvi ? &&exec_and : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rvm ? &&exec_mul : &&illegal,
+		rvm ? &&exec_mulh : &&illegal,
+		rvm ? &&exec_mulhsu : &&illegal,
+		rvm ? &&exec_mulhu : &&illegal,
+		rvm ? &&exec_div : &&illegal,
+		rvm ? &&exec_divu : &&illegal,
+		rvm ? &&exec_rem : &&illegal,
+		rvm ? &&exec_remu : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rva ? &&exec_lr_w : &&illegal,
+		rva ? &&exec_sc_w : &&illegal,
+		rva ? &&exec_amoswap_w : &&illegal,
+		rva ? &&exec_amoadd_w : &&illegal,
+		rva ? &&exec_amoxor_w : &&illegal,
+		rva ? &&exec_amoor_w : &&illegal,
+		rva ? &&exec_amoand_w : &&illegal,
+		rva ? &&exec_amomin_w : &&illegal,
+		rva ? &&exec_amomax_w : &&illegal,
+		rva ? &&exec_amominu_w : &&illegal,
+		rva ? &&exec_amomaxu_w : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rvf ? &&exec_flw : &&illegal,
+		rvf ? &&exec_fsw : &&illegal,
+		rvf ? &&exec_fmadd_s : &&illegal,
+		rvf ? &&exec_fmsub_s : &&illegal,
+		rvf ? &&exec_fnmsub_s : &&illegal,
+		rvf ? &&exec_fnmadd_s : &&illegal,
+		rvf ? &&exec_fadd_s : &&illegal,
+		rvf ? &&exec_fsub_s : &&illegal,
+		rvf ? &&exec_fmul_s : &&illegal,
+		rvf ? &&exec_fdiv_s : &&illegal,
+		rvf ? &&exec_fsgnj_s : &&illegal,
+		rvf ? &&exec_fsgnjn_s : &&illegal,
+		rvf ? &&exec_fsgnjx_s : &&illegal,
+		rvf ? &&exec_fmin_s : &&illegal,
+		rvf ? &&exec_fmax_s : &&illegal,
+		rvf ? &&exec_fsqrt_s : &&illegal,
+		rvf ? &&exec_fle_s : &&illegal,
+		rvf ? &&exec_flt_s : &&illegal,
+		rvf ? &&exec_feq_s : &&illegal,
+		rvf ? &&exec_fcvt_w_s : &&illegal,
+		rvf ? &&exec_fcvt_wu_s : &&illegal,
+		rvf ? &&exec_fcvt_s_w : &&illegal,
+		rvf ? &&exec_fcvt_s_wu : &&illegal,
+		rvf ? &&exec_fmv_x_s : &&illegal,
+		rvf ? &&exec_fclass_s : &&illegal,
+		rvf ? &&exec_fmv_s_x : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rvd ? &&exec_fld : &&illegal,
+		rvd ? &&exec_fsd : &&illegal,
+		rvd ? &&exec_fmadd_d : &&illegal,
+		rvd ? &&exec_fmsub_d : &&illegal,
+		rvd ? &&exec_fnmsub_d : &&illegal,
+		rvd ? &&exec_fnmadd_d : &&illegal,
+		rvd ? &&exec_fadd_d : &&illegal,
+		rvd ? &&exec_fsub_d : &&illegal,
+		rvd ? &&exec_fmul_d : &&illegal,
+		rvd ? &&exec_fdiv_d : &&illegal,
+		rvd ? &&exec_fsgnj_d : &&illegal,
+		rvd ? &&exec_fsgnjn_d : &&illegal,
+		rvd ? &&exec_fsgnjx_d : &&illegal,
+		rvd ? &&exec_fmin_d : &&illegal,
+		rvd ? &&exec_fmax_d : &&illegal,
+		rvd ? &&exec_fcvt_s_d : &&illegal,
+		rvd ? &&exec_fcvt_d_s : &&illegal,
+		rvd ? &&exec_fsqrt_d : &&illegal,
+		rvd ? &&exec_fle_d : &&illegal,
+		rvd ? &&exec_flt_d : &&illegal,
+		rvd ? &&exec_feq_d : &&illegal,
+		rvd ? &&exec_fcvt_w_d : &&illegal,
+		rvd ? &&exec_fcvt_wu_d : &&illegal,
+		rvd ? &&exec_fcvt_d_w : &&illegal,
+		rvd ? &&exec_fcvt_d_wu : &&illegal,
+		rvd ? &&exec_fclass_d : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+	};
+
+	/* resolve the handler for each decoded instruction when length is null */
+	if (!length) {
+		for (size_t i = 0; i < count; i++) {
+			handler[i] = dispatch[dec[i].op];
+		}
+		return 0;
+	}
+
+	/* execute until a taken branch or an instruction without a handler */
+	size_t i = 0;
+	typename P::ux pc_offset = length[0];
+	goto *handler[0];
+
+	exec_lui:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_auipc:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.pc + dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_jal:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.pc + pc_offset; pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_jalr:
+		{
+			ux new_offset = (proc.ireg[dec[i].rs1] + dec[i].imm - proc.pc) & ~1; proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.pc + pc_offset; pc_offset = new_offset;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_beq:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val == proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bne:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val != proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_blt:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val < proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bge:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val >= proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bltu:
+		{
+			if (proc.ireg[dec[i].rs1].r.xu.val < proc.ireg[dec[i].rs2].r.xu.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bgeu:
+		{
+			if (proc.ireg[dec[i].rs1].r.xu.val >= proc.ireg[dec[i].rs2].r.xu.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lb:
+		{
+			s8 t; proc.mmu.template load<P,s8>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lh:
+		{
+			s16 t; proc.mmu.template load<P,s16>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lw:
+		{
+			s32 t; proc.mmu.template load<P,s32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lbu:
+		{
+			u8 t; proc.mmu.template load<P,u8>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lhu:
+		{
+			u16 t; proc.mmu.template load<P,u16>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sb:
+		{
+			proc.mmu.template store<P,s8>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, s8(proc.ireg[dec[i].rs2]));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sh:
+		{
+			proc.mmu.template store<P,s16>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, s16(proc.ireg[dec[i].rs2]));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sw:
+		{
+			proc.mmu.template store<P,s32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.ireg[dec[i].rs2].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_addi:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val + sx(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slti:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val < sx(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sltiu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val < ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_xori:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val ^ ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_ori:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val | ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_andi:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val & ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slli:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val << dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srli:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val >> dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srai:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val >> dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_add:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val + proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sub:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val - proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sll:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val << (proc.ireg[dec[i].rs2] & 0b1111111);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slt:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val < proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sltu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val < proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_xor:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val ^ proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srl:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val >> (proc.ireg[dec[i].rs2] & 0b1111111);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sra:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val >> (proc.ireg[dec[i].rs2] & 0b1111111);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_or:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val | proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_and:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val & proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mul:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val * proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulh:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::mulh(proc.ireg[dec[i].rs1].r.x.val, proc.ireg[dec[i].rs2].r.x.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulhsu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::mulhsu(proc.ireg[dec[i].rs1].r.x.val, proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulhu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::mulhu(proc.ireg[dec[i].rs1].r.xu.val, proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_div:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val == std::numeric_limits<sx>::min() && proc.ireg[dec[i].rs2].r.x.val == -1 ? std::numeric_limits<sx>::min() : proc.ireg[dec[i].rs2].r.x.val == 0 ? -1 : proc.ireg[dec[i].rs1].r.x.val / proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_divu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.x.val == 0 ? -1 : sx(proc.ireg[dec[i].rs1].r.xu.val / proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_rem:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val == std::numeric_limits<sx>::min() && proc.ireg[dec[i].rs2].r.x.val == -1 ? 0 : proc.ireg[dec[i].rs2].r.x.val == 0 ? proc.ireg[dec[i].rs1].r.x.val : proc.ireg[dec[i].rs1].r.x.val % proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_remu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.x.val == 0 ? proc.ireg[dec[i].rs1].r.x.val : sx(proc.ireg[dec[i].rs1].r.xu.val % proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lr_w:
+		{
+			s32 t; proc.mmu.template lr<P,s32>(proc, proc.ireg[dec[i].rs1], t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sc_w:
+		{
+			ux res = 0; proc.mmu.template sc<P,s32>(proc, proc.ireg[dec[i].rs1], proc.ireg[dec[i].rs2].r.w.val, res); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : res;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoswap_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoswap, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoadd_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoadd, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoxor_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoxor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoor_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoand_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoand, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomin_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amomin, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomax_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amomax, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amominu_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amominu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomaxu_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amomaxu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_flw:
+		{
+			u32 t; proc.mmu.template load<P,u32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.freg[dec[i].rd].r.wu.val = t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsw:
+		{
+			proc.mmu.template store<P,f32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.freg[dec[i].rs2].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmadd_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * proc.freg[dec[i].rs2].r.s.val + proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmsub_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * proc.freg[dec[i].rs2].r.s.val - proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmsub_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * -proc.freg[dec[i].rs2].r.s.val + proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmadd_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * -proc.freg[dec[i].rs2].r.s.val - proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fadd_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val + proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsub_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val - proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmul_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fdiv_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val / proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnj_s:
+		{
+			proc.freg[dec[i].rd].r.wu.val = (proc.freg[dec[i].rs1].r.wu.val & u32(~(1U<<31))) | (proc.freg[dec[i].rs2].r.wu.val & u32(1U<<31));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjn_s:
+		{
+			proc.freg[dec[i].rd].r.wu.val = (proc.freg[dec[i].rs1].r.wu.val & u32(~(1U<<31))) | (~proc.freg[dec[i].rs2].r.wu.val & u32(1U<<31));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjx_s:
+		{
+			proc.freg[dec[i].rd].r.wu.val = proc.freg[dec[i].rs1].r.wu.val ^ (proc.freg[dec[i].rs2].r.wu.val & u32(1U<<31));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmin_s:
+		{
+			proc.freg[dec[i].rd].r.s.val = (proc.freg[dec[i].rs1].r.s.val < proc.freg[dec[i].rs2].r.s.val) || std::isnan(proc.freg[dec[i].rs2].r.s.val) ? proc.freg[dec[i].rs1].r.s.val : proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmax_s:
+		{
+			proc.freg[dec[i].rd].r.s.val = (proc.freg[dec[i].rs1].r.s.val > proc.freg[dec[i].rs2].r.s.val) || std::isnan(proc.freg[dec[i].rs2].r.s.val) ? proc.freg[dec[i].rs1].r.s.val : proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsqrt_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = riscv::f32_sqrt(proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fle_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.s.val <= proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_flt_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.s.val < proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_feq_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.s.val == proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_w_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_w(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_wu_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_wu(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_w:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_wu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_x_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : std::isnan(proc.freg[dec[i].rs1].r.s.val) ? s32(0x7fc00000) : proc.freg[dec[i].rs1].r.w.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fclass_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : f32_classify(proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_s_x:
+		{
+			proc.freg[dec[i].rd].r.wu.val = proc.ireg[dec[i].rs1].r.wu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fld:
+		{
+			u64 t; proc.mmu.template load<P,u64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.freg[dec[i].rd].r.lu.val = t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsd:
+		{
+			proc.mmu.template store<P,f64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.freg[dec[i].rs2].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmadd_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * proc.freg[dec[i].rs2].r.d.val + proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmsub_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * proc.freg[dec[i].rs2].r.d.val - proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmsub_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * -proc.freg[dec[i].rs2].r.d.val + proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmadd_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * -proc.freg[dec[i].rs2].r.d.val - proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fadd_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val + proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsub_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val - proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmul_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fdiv_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val / proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnj_d:
+		{
+			proc.freg[dec[i].rd].r.lu.val = (proc.freg[dec[i].rs1].r.lu.val & u64(~(1ULL<<63))) | (proc.freg[dec[i].rs2].r.lu.val & u64(1ULL<<63));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjn_d:
+		{
+			proc.freg[dec[i].rd].r.lu.val = (proc.freg[dec[i].rs1].r.lu.val & u64(~(1ULL<<63))) | (~proc.freg[dec[i].rs2].r.lu.val & u64(1ULL<<63));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjx_d:
+		{
+			proc.freg[dec[i].rd].r.lu.val = proc.freg[dec[i].rs1].r.lu.val ^ (proc.freg[dec[i].rs2].r.lu.val & u64(1ULL<<63));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmin_d:
+		{
+			proc.freg[dec[i].rd].r.d.val = (proc.freg[dec[i].rs1].r.d.val < proc.freg[dec[i].rs2].r.d.val) || std::isnan(proc.freg[dec[i].rs2].r.d.val) ? proc.freg[dec[i].rs1].r.d.val : proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmax_d:
+		{
+			proc.freg[dec[i].rd].r.d.val = (proc.freg[dec[i].rs1].r.d.val > proc.freg[dec[i].rs2].r.d.val) || std::isnan(proc.freg[dec[i].rs2].r.d.val) ? proc.freg[dec[i].rs1].r.d.val : proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsqrt_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = riscv::f64_sqrt(proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fle_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.d.val <= proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_flt_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.d.val < proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_feq_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.d.val == proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_w_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_w(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_wu_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_wu(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_w:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_wu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fclass_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : f64_classify(proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	illegal:
+		return i;
+}
+
 /* Execute Instruction RV64 */
 
 template <bool rvi, bool rvm, bool rva, bool rvs, bool rvf, bool rvd, bool rvq, bool rvc, typename T, typename P>
@@ -886,12 +2314,12 @@ typename P::ux exec_inst_rv64(T &dec, P &proc, typename P::ux pc_offset)
 			break;
 		case rv_op_lr_w:
 			if (rva) {
-				proc.lr = proc.ireg[dec.rs1]; s32 t; proc.mmu.template load<P,s32>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
+				s32 t; proc.mmu.template lr<P,s32>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
 			};
 			break;
 		case rv_op_sc_w:
 			if (rva) {
-				ux res = 0; if (proc.lr != proc.ireg[dec.rs1]) res = 1; else proc.mmu.template store<P,s32>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.w.val); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
+				ux res = 0; proc.mmu.template sc<P,s32>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.w.val, res); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
 			};
 			break;
 		case rv_op_amoswap_w:
@@ -941,12 +2369,12 @@ typename P::ux exec_inst_rv64(T &dec, P &proc, typename P::ux pc_offset)
 			break;
 		case rv_op_lr_d:
 			if (rva) {
-				proc.lr = proc.ireg[dec.rs1]; s64 t; proc.mmu.template load<P,s64>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
+				s64 t; proc.mmu.template lr<P,s64>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
 			};
 			break;
 		case rv_op_sc_d:
 			if (rva) {
-				ux res = 0; if (proc.lr != proc.ireg[dec.rs1]) res = 1; else proc.mmu.template store<P,s64>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.l.val); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
+				ux res = 0; proc.mmu.template sc<P,s64>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.l.val, res); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
 			};
 			break;
 		case rv_op_amoswap_d:
@@ -1309,6 +2737,1814 @@ typename P::ux exec_inst_rv64(T &dec, P &proc, typename P::ux pc_offset)
 	return pc_offset;
 }
 
+/* Execute Block RV64 (direct threaded) */
+
+template <bool rvi, bool rvm, bool rva, bool rvs, bool rvf, bool rvd, bool rvq, bool rvc, typename T, typename P>
+size_t exec_block_rv64(P &proc, T *dec, const void **handler, const riscv::u8 *length, size_t count)
+{
+	using namespace riscv;
+	enum { xlen = 64 };
+	typedef s64 sx;
+	typedef u64 ux;
+
+	static const void *dispatch[] = {
+		&&illegal,
+		rvi ? &&exec_lui : &&illegal,
+		rvi ? &&exec_auipc : &&illegal,
+		rvi ? &&exec_jal : &&illegal,
+		rvi ? &&exec_jalr : &&illegal,
+		rvi ? &&exec_beq : &&illegal,
+		rvi ? &&exec_bne : &&illegal,
+		rvi ? &&exec_blt : &&illegal,
+		rvi ? &&exec_bge : &&illegal,
+		rvi ? &&exec_bltu : &&illegal,
+		rvi ? &&exec_bgeu : &&illegal,
+		rvi ? &&exec_lb : &&illegal,
+		rvi ? &&exec_lh : &&illegal,
+		rvi ? &&exec_lw : &&illegal,
+		rvi ? &&exec_lbu : &&illegal,
+		rvi ? &&exec_lhu : &&illegal,
+		rvi ? &&exec_sb : &&illegal,
+		rvi ? &&exec_sh : &&illegal,
+		rvi ? &&exec_sw : &&illegal,
+		rvi ? &&exec_addi : &&illegal,
+		rvi ? &&exec_slti : &&illegal,
+		rvi ? &&exec_sltiu : &&illegal,
+		rvi ? &&exec_xori : &&illegal,
+		rvi ? &&exec_ori : &&illegal,
+		rvi ? &&exec_andi : &&illegal,
+		rvi ? &&exec_slli : &&illegal,
+		rvi ? &&exec_srli : &&illegal,
+		rvi ? &&exec_srai : &&illegal,
+		rvi ? &&exec_add : &&illegal,
+		rvi ? &&exec_sub : &&illegal,
+		rvi ? &&exec_sll : &&illegal,
+		rvi ? &&exec_slt : &&illegal,
+		rvi ? &&exec_sltu : &&illegal,
+		rvi ? &&exec_xor : &&illegal,
+		rvi ? &&exec_srl : &&illegal,
+		rvi ? &&exec_sra : &&illegal,
+		rvi ? &&exec_or : &&illegal,
+		rvi ? &&exec_and : &&illegal,
+		&&illegal,
+		&&illegal,
+		rvi ? &&exec_lwu : &&illegal,
+		rvi ? &&exec_ld : &&illegal,
+		rvi ? &&exec_sd : &&illegal,
+		rvi ? &&exec_addiw : &&illegal,
+		rvi ? &&exec_slliw : &&illegal,
+		rvi ? &&exec_srliw : &&illegal,
+		rvi ? &&exec_sraiw : &&illegal,
+		rvi ? &&exec_addw : &&illegal,
+		rvi ? &&exec_subw : &&illegal,
+		rvi ? &&exec_sllw : &&illegal,
+		rvi ? &&exec_srlw : &&illegal,
+		rvi ? &&exec_sraw : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rvm ? &&exec_mul : &&illegal,
+		rvm ? &&exec_mulh : &&illegal,
+		rvm ? &&exec_mulhsu : &&illegal,
+		rvm ? &&exec_mulhu : &&illegal,
+		rvm ? &&exec_div : &&illegal,
+		rvm ? &&exec_divu : &&illegal,
+		rvm ? &&exec_rem : &&illegal,
+		rvm ? &&exec_remu : &&illegal,
+		rvm ? &&exec_mulw : &&illegal,
+		rvm ? &&exec_divw : &&illegal,
+		rvm ? &&exec_divuw : &&illegal,
+		rvm ? &&exec_remw : &&illegal,
+		rvm ? &&exec_remuw : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rva ? &&exec_lr_w : &&illegal,
+		rva ? &&exec_sc_w : &&illegal,
+		rva ? &&exec_amoswap_w : &&illegal,
+		rva ? &&exec_amoadd_w : &&illegal,
+		rva ? &&exec_amoxor_w : &&illegal,
+		rva ? &&exec_amoor_w : &&illegal,
+		rva ? &&exec_amoand_w : &&illegal,
+		rva ? &&exec_amomin_w : &&illegal,
+		rva ? &&exec_amomax_w : &&illegal,
+		rva ? &&exec_amominu_w : &&illegal,
+		rva ? &&exec_amomaxu_w : &&illegal,
+		rva ? &&exec_lr_d : &&illegal,
+		rva ? &&exec_sc_d : &&illegal,
+		rva ? &&exec_amoswap_d : &&illegal,
+		rva ? &&exec_amoadd_d : &&illegal,
+		rva ? &&exec_amoxor_d : &&illegal,
+		rva ? &&exec_amoor_d : &&illegal,
+		rva ? &&exec_amoand_d : &&illegal,
+		rva ? &&exec_amomin_d : &&illegal,
+		rva ? &&exec_amomax_d : &&illegal,
+		rva ? &&exec_amominu_d : &&illegal,
+		rva ? &&exec_amomaxu_d : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rvf ? &&exec_flw : &&illegal,
+		rvf ? &&exec_fsw : &&illegal,
+		rvf ? &&exec_fmadd_s : &&illegal,
+		rvf ? &&exec_fmsub_s : &&illegal,
+		rvf ? &&exec_fnmsub_s : &&illegal,
+		rvf ? &&exec_fnmadd_s : &&illegal,
+		rvf ? &&exec_fadd_s : &&illegal,
+		rvf ? &&exec_fsub_s : &&illegal,
+		rvf ? &&exec_fmul_s : &&illegal,
+		rvf ? &&exec_fdiv_s : &&illegal,
+		rvf ? &&exec_fsgnj_s : &&illegal,
+		rvf ? &&exec_fsgnjn_s : &&illegal,
+		rvf ? &&exec_fsgnjx_s : &&illegal,
+		rvf ? &&exec_fmin_s : &&illegal,
+		rvf ? &&exec_fmax_s : &&illegal,
+		rvf ? &&exec_fsqrt_s : &&illegal,
+		rvf ? &&exec_fle_s : &&illegal,
+		rvf ? &&exec_flt_s : &&illegal,
+		rvf ? &&exec_feq_s : &&illegal,
+		rvf ? &&exec_fcvt_w_s : &&illegal,
+		rvf ? &&exec_fcvt_wu_s : &&illegal,
+		rvf ? &&exec_fcvt_s_w : &&illegal,
+		rvf ? &&exec_fcvt_s_wu : &&illegal,
+		rvf ? &&exec_fmv_x_s : &&illegal,
+		rvf ? &&exec_fclass_s : &&illegal,
+		rvf ? &&exec_fmv_s_x : &&illegal,
+		rvf ? &&exec_fcvt_l_s : &&illegal,
+		rvf ? &&exec_fcvt_lu_s : &&illegal,
+		rvf ? &&exec_fcvt_s_l : &&illegal,
+		rvf ? &&exec_fcvt_s_lu : &&illegal,
+		rvd ? &&exec_fld : &&illegal,
+		rvd ? &&exec_fsd : &&illegal,
+		rvd ? &&exec_fmadd_d : &&illegal,
+		rvd ? &&exec_fmsub_d : &&illegal,
+		rvd ? &&exec_fnmsub_d : &&illegal,
+		rvd ? &&exec_fnmadd_d : &&illegal,
+		rvd ? &&exec_fadd_d : &&illegal,
+		rvd ? &&exec_fsub_d : &&illegal,
+		rvd ? &&exec_fmul_d : &&illegal,
+		rvd ? &&exec_fdiv_d : &&illegal,
+		rvd ? &&exec_fsgnj_d : &&illegal,
+		rvd ? &&exec_fsgnjn_d : &&illegal,
+		rvd ? &&exec_fsgnjx_d : &&illegal,
+		rvd ? &&exec_fmin_d : &&illegal,
+		rvd ? &&exec_fmax_d : &&illegal,
+		rvd ? &&exec_fcvt_s_d : &&illegal,
+		rvd ? &&exec_fcvt_d_s : &&illegal,
+		rvd ? &&exec_fsqrt_d : &&illegal,
+		rvd ? &&exec_fle_d : &&illegal,
+		rvd ? &&exec_flt_d : &&illegal,
+		rvd ? &&exec_feq_d : &&illegal,
+		rvd ? &&exec_fcvt_w_d : &&illegal,
+		rvd ? &&exec_fcvt_wu_d : &&illegal,
+		rvd ? &&exec_fcvt_d_w : &&illegal,
+		rvd ? &&exec_fcvt_d_wu : &&illegal,
+		rvd ? &&exec_fclass_d : &&illegal,
+		rvd ? &&exec_fcvt_l_d : &&illegal,
+		rvd ? &&exec_fcvt_lu_d : &&illegal,
+		rvd ? &&exec_fmv_x_d : &&illegal,
+		rvd ? &&exec_fcvt_d_l : &&illegal,
+		rvd ? &&exec_fcvt_d_lu : &&illegal,
+		rvd ? &&exec_fmv_d_x : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+	};
+
+	/* resolve the handler for each decoded instruction when length is null */
+	if (!length) {
+		for (size_t i = 0; i < count; i++) {
+			handler[i] = dispatch[dec[i].op];
+		}
+		return 0;
+	}
+
+	/* execute until a taken branch or an instruction without a handler */
+	size_t i = 0;
+	typename P::ux pc_offset = length[0];
+	goto *handler[0];
+
+	exec_lui:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_auipc:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.pc + dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_jal:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.pc + pc_offset; pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_jalr:
+		{
+			ux new_offset = (proc.ireg[dec[i].rs1] + dec[i].imm - proc.pc) & ~1; proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.pc + pc_offset; pc_offset = new_offset;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_beq:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val == proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bne:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val != proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_blt:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val < proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bge:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val >= proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bltu:
+		{
+			if (proc.ireg[dec[i].rs1].r.xu.val < proc.ireg[dec[i].rs2].r.xu.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bgeu:
+		{
+			if (proc.ireg[dec[i].rs1].r.xu.val >= proc.ireg[dec[i].rs2].r.xu.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lb:
+		{
+			s8 t; proc.mmu.template load<P,s8>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lh:
+		{
+			s16 t; proc.mmu.template load<P,s16>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lw:
+		{
+			s32 t; proc.mmu.template load<P,s32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lbu:
+		{
+			u8 t; proc.mmu.template load<P,u8>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lhu:
+		{
+			u16 t; proc.mmu.template load<P,u16>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sb:
+		{
+			proc.mmu.template store<P,s8>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, s8(proc.ireg[dec[i].rs2]));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sh:
+		{
+			proc.mmu.template store<P,s16>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, s16(proc.ireg[dec[i].rs2]));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sw:
+		{
+			proc.mmu.template store<P,s32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.ireg[dec[i].rs2].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_addi:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val + sx(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slti:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val < sx(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sltiu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val < ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_xori:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val ^ ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_ori:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val | ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_andi:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val & ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slli:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val << dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srli:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val >> dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srai:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val >> dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_add:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val + proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sub:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val - proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sll:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val << (proc.ireg[dec[i].rs2] & 0b1111111);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slt:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val < proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sltu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val < proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_xor:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val ^ proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srl:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val >> (proc.ireg[dec[i].rs2] & 0b1111111);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sra:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val >> (proc.ireg[dec[i].rs2] & 0b1111111);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_or:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val | proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_and:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val & proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lwu:
+		{
+			u32 t; proc.mmu.template load<P,u32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_ld:
+		{
+			s64 t; proc.mmu.template load<P,s64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sd:
+		{
+			proc.mmu.template store<P,s64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.ireg[dec[i].rs2].r.l.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_addiw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.w.val + dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slliw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val << dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srliw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val >> dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sraiw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.w.val >> dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_addw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.w.val + proc.ireg[dec[i].rs2].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_subw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.w.val - proc.ireg[dec[i].rs2].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sllw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val << (proc.ireg[dec[i].rs2] & 0b11111));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srlw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val >> (proc.ireg[dec[i].rs2] & 0b11111));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sraw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.w.val >> (proc.ireg[dec[i].rs2] & 0b11111));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mul:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val * proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulh:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::mulh(proc.ireg[dec[i].rs1].r.x.val, proc.ireg[dec[i].rs2].r.x.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulhsu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::mulhsu(proc.ireg[dec[i].rs1].r.x.val, proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulhu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::mulhu(proc.ireg[dec[i].rs1].r.xu.val, proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_div:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val == std::numeric_limits<sx>::min() && proc.ireg[dec[i].rs2].r.x.val == -1 ? std::numeric_limits<sx>::min() : proc.ireg[dec[i].rs2].r.x.val == 0 ? -1 : proc.ireg[dec[i].rs1].r.x.val / proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_divu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.x.val == 0 ? -1 : sx(proc.ireg[dec[i].rs1].r.xu.val / proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_rem:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val == std::numeric_limits<sx>::min() && proc.ireg[dec[i].rs2].r.x.val == -1 ? 0 : proc.ireg[dec[i].rs2].r.x.val == 0 ? proc.ireg[dec[i].rs1].r.x.val : proc.ireg[dec[i].rs1].r.x.val % proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_remu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.x.val == 0 ? proc.ireg[dec[i].rs1].r.x.val : sx(proc.ireg[dec[i].rs1].r.xu.val % proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val * proc.ireg[dec[i].rs2].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_divw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.w.val == std::numeric_limits<s32>::min() && proc.ireg[dec[i].rs2].r.w.val == -1 ? std::numeric_limits<s32>::min() : proc.ireg[dec[i].rs2].r.w.val == 0 ? -1 : proc.ireg[dec[i].rs1].r.w.val / proc.ireg[dec[i].rs2].r.w.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_divuw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.w.val == 0 ? -1 : s32(proc.ireg[dec[i].rs1].r.wu.val / proc.ireg[dec[i].rs2].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_remw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.w.val == std::numeric_limits<s32>::min() && proc.ireg[dec[i].rs2].r.w.val == -1 ? 0 : proc.ireg[dec[i].rs2].r.w.val == 0 ? proc.ireg[dec[i].rs1].r.w.val : proc.ireg[dec[i].rs1].r.w.val % proc.ireg[dec[i].rs2].r.w.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_remuw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.w.val == 0 ? proc.ireg[dec[i].rs1].r.w.val : s32(proc.ireg[dec[i].rs1].r.wu.val % proc.ireg[dec[i].rs2].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lr_w:
+		{
+			s32 t; proc.mmu.template lr<P,s32>(proc, proc.ireg[dec[i].rs1], t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sc_w:
+		{
+			ux res = 0; proc.mmu.template sc<P,s32>(proc, proc.ireg[dec[i].rs1], proc.ireg[dec[i].rs2].r.w.val, res); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : res;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoswap_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoswap, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoadd_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoadd, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoxor_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoxor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoor_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoand_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoand, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomin_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amomin, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomax_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amomax, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amominu_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amominu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomaxu_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amomaxu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lr_d:
+		{
+			s64 t; proc.mmu.template lr<P,s64>(proc, proc.ireg[dec[i].rs1], t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sc_d:
+		{
+			ux res = 0; proc.mmu.template sc<P,s64>(proc, proc.ireg[dec[i].rs1], proc.ireg[dec[i].rs2].r.l.val, res); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : res;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoswap_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoswap, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoadd_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoadd, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoxor_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoxor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoor_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoand_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoand, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomin_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amomin, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomax_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amomax, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amominu_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amominu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomaxu_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amomaxu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_flw:
+		{
+			u32 t; proc.mmu.template load<P,u32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.freg[dec[i].rd].r.wu.val = t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsw:
+		{
+			proc.mmu.template store<P,f32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.freg[dec[i].rs2].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmadd_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * proc.freg[dec[i].rs2].r.s.val + proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmsub_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * proc.freg[dec[i].rs2].r.s.val - proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmsub_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * -proc.freg[dec[i].rs2].r.s.val + proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmadd_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * -proc.freg[dec[i].rs2].r.s.val - proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fadd_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val + proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsub_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val - proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmul_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fdiv_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val / proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnj_s:
+		{
+			proc.freg[dec[i].rd].r.wu.val = (proc.freg[dec[i].rs1].r.wu.val & u32(~(1U<<31))) | (proc.freg[dec[i].rs2].r.wu.val & u32(1U<<31));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjn_s:
+		{
+			proc.freg[dec[i].rd].r.wu.val = (proc.freg[dec[i].rs1].r.wu.val & u32(~(1U<<31))) | (~proc.freg[dec[i].rs2].r.wu.val & u32(1U<<31));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjx_s:
+		{
+			proc.freg[dec[i].rd].r.wu.val = proc.freg[dec[i].rs1].r.wu.val ^ (proc.freg[dec[i].rs2].r.wu.val & u32(1U<<31));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmin_s:
+		{
+			proc.freg[dec[i].rd].r.s.val = (proc.freg[dec[i].rs1].r.s.val < proc.freg[dec[i].rs2].r.s.val) || std::isnan(proc.freg[dec[i].rs2].r.s.val) ? proc.freg[dec[i].rs1].r.s.val : proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmax_s:
+		{
+			proc.freg[dec[i].rd].r.s.val = (proc.freg[dec[i].rs1].r.s.val > proc.freg[dec[i].rs2].r.s.val) || std::isnan(proc.freg[dec[i].rs2].r.s.val) ? proc.freg[dec[i].rs1].r.s.val : proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsqrt_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = riscv::f32_sqrt(proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fle_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.s.val <= proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_flt_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.s.val < proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_feq_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.s.val == proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_w_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_w(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_wu_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_wu(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_w:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_wu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_x_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : std::isnan(proc.freg[dec[i].rs1].r.s.val) ? s32(0x7fc00000) : proc.freg[dec[i].rs1].r.w.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fclass_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : f32_classify(proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_s_x:
+		{
+			proc.freg[dec[i].rd].r.wu.val = proc.ireg[dec[i].rs1].r.wu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_l_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_l(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_lu_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_lu(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_l:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.l.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_lu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.lu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fld:
+		{
+			u64 t; proc.mmu.template load<P,u64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.freg[dec[i].rd].r.lu.val = t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsd:
+		{
+			proc.mmu.template store<P,f64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.freg[dec[i].rs2].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmadd_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * proc.freg[dec[i].rs2].r.d.val + proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmsub_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * proc.freg[dec[i].rs2].r.d.val - proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmsub_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * -proc.freg[dec[i].rs2].r.d.val + proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmadd_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * -proc.freg[dec[i].rs2].r.d.val - proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fadd_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val + proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsub_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val - proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmul_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fdiv_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val / proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnj_d:
+		{
+			proc.freg[dec[i].rd].r.lu.val = (proc.freg[dec[i].rs1].r.lu.val & u64(~(1ULL<<63))) | (proc.freg[dec[i].rs2].r.lu.val & u64(1ULL<<63));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjn_d:
+		{
+			proc.freg[dec[i].rd].r.lu.val = (proc.freg[dec[i].rs1].r.lu.val & u64(~(1ULL<<63))) | (~proc.freg[dec[i].rs2].r.lu.val & u64(1ULL<<63));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjx_d:
+		{
+			proc.freg[dec[i].rd].r.lu.val = proc.freg[dec[i].rs1].r.lu.val ^ (proc.freg[dec[i].rs2].r.lu.val & u64(1ULL<<63));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmin_d:
+		{
+			proc.freg[dec[i].rd].r.d.val = (proc.freg[dec[i].rs1].r.d.val < proc.freg[dec[i].rs2].r.d.val) || std::isnan(proc.freg[dec[i].rs2].r.d.val) ? proc.freg[dec[i].rs1].r.d.val : proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmax_d:
+		{
+			proc.freg[dec[i].rd].r.d.val = (proc.freg[dec[i].rs1].r.d.val > proc.freg[dec[i].rs2].r.d.val) || std::isnan(proc.freg[dec[i].rs2].r.d.val) ? proc.freg[dec[i].rs1].r.d.val : proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsqrt_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = riscv::f64_sqrt(proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fle_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.d.val <= proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_flt_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.d.val < proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_feq_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.d.val == proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_w_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_w(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_wu_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_wu(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_w:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_wu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fclass_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : f64_classify(proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_l_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_l(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_lu_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_lu(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_x_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : std::isnan(proc.freg[dec[i].rs1].r.d.val) ? s64(0x7ff8000000000000ULL) : proc.freg[dec[i].rs1].r.l.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_l:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.l.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_lu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.lu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_d_x:
+		{
+			proc.freg[dec[i].rd].r.lu.val = proc.ireg[dec[i].rs1].r.lu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	illegal:
+		return i;
+}
+
 /* Execute Instruction RV128 */
 
 template <bool rvi, bool rvm, bool rva, bool rvs, bool rvf, bool rvd, bool rvq, bool rvc, typename T, typename P>
@@ -1632,12 +4868,12 @@ typename P::ux exec_inst_rv128(T &dec, P &proc, typename P::ux pc_offset)
 			break;
 		case rv_op_lr_w:
 			if (rva) {
-				proc.lr = proc.ireg[dec.rs1]; s32 t; proc.mmu.template load<P,s32>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
+				s32 t; proc.mmu.template lr<P,s32>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
 			};
 			break;
 		case rv_op_sc_w:
 			if (rva) {
-				ux res = 0; if (proc.lr != proc.ireg[dec.rs1]) res = 1; else proc.mmu.template store<P,s32>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.w.val); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
+				ux res = 0; proc.mmu.template sc<P,s32>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.w.val, res); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
 			};
 			break;
 		case rv_op_amoswap_w:
@@ -1687,12 +4923,12 @@ typename P::ux exec_inst_rv128(T &dec, P &proc, typename P::ux pc_offset)
 			break;
 		case rv_op_lr_d:
 			if (rva) {
-				proc.lr = proc.ireg[dec.rs1]; s64 t; proc.mmu.template load<P,s64>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
+				s64 t; proc.mmu.template lr<P,s64>(proc, proc.ireg[dec.rs1], t); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : t;
 			};
 			break;
 		case rv_op_sc_d:
 			if (rva) {
-				ux res = 0; if (proc.lr != proc.ireg[dec.rs1]) res = 1; else proc.mmu.template store<P,s64>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.l.val); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
+				ux res = 0; proc.mmu.template sc<P,s64>(proc, proc.ireg[dec.rs1], proc.ireg[dec.rs2].r.l.val, res); proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : res;
 			};
 			break;
 		case rv_op_amoswap_d:
@@ -2055,4 +5291,1812 @@ typename P::ux exec_inst_rv128(T &dec, P &proc, typename P::ux pc_offset)
 	return pc_offset;
 }
 
+/* Execute Block RV128 (direct threaded) */
+
+template <bool rvi, bool rvm, bool rva, bool rvs, bool rvf, bool rvd, bool rvq, bool rvc, typename T, typename P>
+size_t exec_block_rv128(P &proc, T *dec, const void **handler, const riscv::u8 *length, size_t count)
+{
+	using namespace riscv;
+	enum { xlen = 128 };
+	typedef s128 sx;
+	typedef u128 ux;
+
+	static const void *dispatch[] = {
+		&&illegal,
+		rvi ? &&exec_lui : &&illegal,
+		rvi ? &&exec_auipc : &&illegal,
+		rvi ? &&exec_jal : &&illegal,
+		rvi ? &&exec_jalr : &&illegal,
+		rvi ? &&exec_beq : &&illegal,
+		rvi ? &&exec_bne : &&illegal,
+		rvi ? &&exec_blt : &&illegal,
+		rvi ? &&exec_bge : &&illegal,
+		rvi ? &&exec_bltu : &&illegal,
+		rvi ? &&exec_bgeu : &&illegal,
+		rvi ? &&exec_lb : &&illegal,
+		rvi ? &&exec_lh : &&illegal,
+		rvi ? &&exec_lw : &&illegal,
+		rvi ? &&exec_lbu : &&illegal,
+		rvi ? &&exec_lhu : &&illegal,
+		rvi ? &&exec_sb : &&illegal,
+		rvi ? &&exec_sh : &&illegal,
+		rvi ? &&exec_sw : &&illegal,
+		rvi ? &&exec_addi : &&illegal,
+		rvi ? &&exec_slti : &&illegal,
+		rvi ? &&exec_sltiu : &&illegal,
+		rvi ? &&exec_xori : &&illegal,
+		rvi ? &&exec_ori : &&illegal,
+		rvi ? &&exec_andi : &&illegal,
+		rvi ? &&exec_slli : &&illegal,
+		rvi ? &&exec_srli : &&illegal,
+		rvi ? &&exec_srai : &&illegal,
+		rvi ? &&exec_add : &&illegal,
+		rvi ? &&exec_sub : &&illegal,
+		rvi ? &&exec_sll : &&illegal,
+		rvi ? &&exec_slt : &&illegal,
+		rvi ? &&exec_sltu : &&illegal,
+		rvi ? &&exec_xor : &&illegal,
+		rvi ? &&exec_srl : &&illegal,
+		rvi ? &&exec_sra : &&illegal,
+		rvi ? &&exec_or : &&illegal,
+		rvi ? &&exec_and : &&illegal,
+		&&illegal,
+		&&illegal,
+		rvi ? &&exec_lwu : &&illegal,
+		rvi ? &&exec_ld : &&illegal,
+		rvi ? &&exec_sd : &&illegal,
+		rvi ? &&exec_addiw : &&illegal,
+		rvi ? &&exec_slliw : &&illegal,
+		rvi ? &&exec_srliw : &&illegal,
+		rvi ? &&exec_sraiw : &&illegal,
+		rvi ? &&exec_addw : &&illegal,
+		rvi ? &&exec_subw : &&illegal,
+		rvi ? &&exec_sllw : &&illegal,
+		rvi ? &&exec_srlw : &&illegal,
+		rvi ? &&exec_sraw : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rvm ? &&exec_mul : &&illegal,
+		rvm ? &&exec_mulh : &&illegal,
+		rvm ? &&exec_mulhsu : &&illegal,
+		rvm ? &&exec_mulhu : &&illegal,
+		rvm ? &&exec_div : &&illegal,
+		rvm ? &&exec_divu : &&illegal,
+		rvm ? &&exec_rem : &&illegal,
+		rvm ? &&exec_remu : &&illegal,
+		rvm ? &&exec_mulw : &&illegal,
+		rvm ? &&exec_divw : &&illegal,
+		rvm ? &&exec_divuw : &&illegal,
+		rvm ? &&exec_remw : &&illegal,
+		rvm ? &&exec_remuw : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rva ? &&exec_lr_w : &&illegal,
+		rva ? &&exec_sc_w : &&illegal,
+		rva ? &&exec_amoswap_w : &&illegal,
+		rva ? &&exec_amoadd_w : &&illegal,
+		rva ? &&exec_amoxor_w : &&illegal,
+		rva ? &&exec_amoor_w : &&illegal,
+		rva ? &&exec_amoand_w : &&illegal,
+		rva ? &&exec_amomin_w : &&illegal,
+		rva ? &&exec_amomax_w : &&illegal,
+		rva ? &&exec_amominu_w : &&illegal,
+		rva ? &&exec_amomaxu_w : &&illegal,
+		rva ? &&exec_lr_d : &&illegal,
+		rva ? &&exec_sc_d : &&illegal,
+		rva ? &&exec_amoswap_d : &&illegal,
+		rva ? &&exec_amoadd_d : &&illegal,
+		rva ? &&exec_amoxor_d : &&illegal,
+		rva ? &&exec_amoor_d : &&illegal,
+		rva ? &&exec_amoand_d : &&illegal,
+		rva ? &&exec_amomin_d : &&illegal,
+		rva ? &&exec_amomax_d : &&illegal,
+		rva ? &&exec_amominu_d : &&illegal,
+		rva ? &&exec_amomaxu_d : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		rvf ? &&exec_flw : &&illegal,
+		rvf ? &&exec_fsw : &&illegal,
+		rvf ? &&exec_fmadd_s : &&illegal,
+		rvf ? &&exec_fmsub_s : &&illegal,
+		rvf ? &&exec_fnmsub_s : &&illegal,
+		rvf ? &&exec_fnmadd_s : &&illegal,
+		rvf ? &&exec_fadd_s : &&illegal,
+		rvf ? &&exec_fsub_s : &&illegal,
+		rvf ? &&exec_fmul_s : &&illegal,
+		rvf ? &&exec_fdiv_s : &&illegal,
+		rvf ? &&exec_fsgnj_s : &&illegal,
+		rvf ? &&exec_fsgnjn_s : &&illegal,
+		rvf ? &&exec_fsgnjx_s : &&illegal,
+		rvf ? &&exec_fmin_s : &&illegal,
+		rvf ? &&exec_fmax_s : &&illegal,
+		rvf ? &&exec_fsqrt_s : &&illegal,
+		rvf ? &&exec_fle_s : &&illegal,
+		rvf ? &&exec_flt_s : &&illegal,
+		rvf ? &&exec_feq_s : &&illegal,
+		rvf ? &&exec_fcvt_w_s : &&illegal,
+		rvf ? &&exec_fcvt_wu_s : &&illegal,
+		rvf ? &&exec_fcvt_s_w : &&illegal,
+		rvf ? &&exec_fcvt_s_wu : &&illegal,
+		rvf ? &&exec_fmv_x_s : &&illegal,
+		rvf ? &&exec_fclass_s : &&illegal,
+		rvf ? &&exec_fmv_s_x : &&illegal,
+		rvf ? &&exec_fcvt_l_s : &&illegal,
+		rvf ? &&exec_fcvt_lu_s : &&illegal,
+		rvf ? &&exec_fcvt_s_l : &&illegal,
+		rvf ? &&exec_fcvt_s_lu : &&illegal,
+		rvd ? &&exec_fld : &&illegal,
+		rvd ? &&exec_fsd : &&illegal,
+		rvd ? &&exec_fmadd_d : &&illegal,
+		rvd ? &&exec_fmsub_d : &&illegal,
+		rvd ? &&exec_fnmsub_d : &&illegal,
+		rvd ? &&exec_fnmadd_d : &&illegal,
+		rvd ? &&exec_fadd_d : &&illegal,
+		rvd ? &&exec_fsub_d : &&illegal,
+		rvd ? &&exec_fmul_d : &&illegal,
+		rvd ? &&exec_fdiv_d : &&illegal,
+		rvd ? &&exec_fsgnj_d : &&illegal,
+		rvd ? &&exec_fsgnjn_d : &&illegal,
+		rvd ? &&exec_fsgnjx_d : &&illegal,
+		rvd ? &&exec_fmin_d : &&illegal,
+		rvd ? &&exec_fmax_d : &&illegal,
+		rvd ? &&exec_fcvt_s_d : &&illegal,
+		rvd ? &&exec_fcvt_d_s : &&illegal,
+		rvd ? &&exec_fsqrt_d : &&illegal,
+		rvd ? &&exec_fle_d : &&illegal,
+		rvd ? &&exec_flt_d : &&illegal,
+		rvd ? &&exec_feq_d : &&illegal,
+		rvd ? &&exec_fcvt_w_d : &&illegal,
+		rvd ? &&exec_fcvt_wu_d : &&illegal,
+		rvd ? &&exec_fcvt_d_w : &&illegal,
+		rvd ? &&exec_fcvt_d_wu : &&illegal,
+		rvd ? &&exec_fclass_d : &&illegal,
+		rvd ? &&exec_fcvt_l_d : &&illegal,
+		rvd ? &&exec_fcvt_lu_d : &&illegal,
+		rvd ? &&exec_fmv_x_d : &&illegal,
+		rvd ? &&exec_fcvt_d_l : &&illegal,
+		rvd ? &&exec_fcvt_d_lu : &&illegal,
+		rvd ? &&exec_fmv_d_x : &&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+		&&illegal,
+	};
+
+	/* resolve the handler for each decoded instruction when length is null */
+	if (!length) {
+		for (size_t i = 0; i < count; i++) {
+			handler[i] = dispatch[dec[i].op];
+		}
+		return 0;
+	}
+
+	/* execute until a taken branch or an instruction without a handler */
+	size_t i = 0;
+	typename P::ux pc_offset = length[0];
+	goto *handler[0];
+
+	exec_lui:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_auipc:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.pc + dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_jal:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.pc + pc_offset; pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_jalr:
+		{
+			ux new_offset = (proc.ireg[dec[i].rs1] + dec[i].imm - proc.pc) & ~1; proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.pc + pc_offset; pc_offset = new_offset;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_beq:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val == proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bne:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val != proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_blt:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val < proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bge:
+		{
+			if (proc.ireg[dec[i].rs1].r.x.val >= proc.ireg[dec[i].rs2].r.x.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bltu:
+		{
+			if (proc.ireg[dec[i].rs1].r.xu.val < proc.ireg[dec[i].rs2].r.xu.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_bgeu:
+		{
+			if (proc.ireg[dec[i].rs1].r.xu.val >= proc.ireg[dec[i].rs2].r.xu.val) pc_offset = dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lb:
+		{
+			s8 t; proc.mmu.template load<P,s8>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lh:
+		{
+			s16 t; proc.mmu.template load<P,s16>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lw:
+		{
+			s32 t; proc.mmu.template load<P,s32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lbu:
+		{
+			u8 t; proc.mmu.template load<P,u8>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lhu:
+		{
+			u16 t; proc.mmu.template load<P,u16>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sb:
+		{
+			proc.mmu.template store<P,s8>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, s8(proc.ireg[dec[i].rs2]));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sh:
+		{
+			proc.mmu.template store<P,s16>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, s16(proc.ireg[dec[i].rs2]));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sw:
+		{
+			proc.mmu.template store<P,s32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.ireg[dec[i].rs2].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_addi:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val + sx(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slti:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val < sx(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sltiu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val < ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_xori:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val ^ ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_ori:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val | ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_andi:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val & ux(dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slli:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val << dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srli:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val >> dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srai:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val >> dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_add:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val + proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sub:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val - proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sll:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val << (proc.ireg[dec[i].rs2] & 0b1111111);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slt:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val < proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sltu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val < proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_xor:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val ^ proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srl:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val >> (proc.ireg[dec[i].rs2] & 0b1111111);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sra:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val >> (proc.ireg[dec[i].rs2] & 0b1111111);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_or:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val | proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_and:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.xu.val & proc.ireg[dec[i].rs2].r.xu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lwu:
+		{
+			u32 t; proc.mmu.template load<P,u32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_ld:
+		{
+			s64 t; proc.mmu.template load<P,s64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sd:
+		{
+			proc.mmu.template store<P,s64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.ireg[dec[i].rs2].r.l.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_addiw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.w.val + dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_slliw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val << dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srliw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val >> dec[i].imm);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sraiw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.w.val >> dec[i].imm;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_addw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.w.val + proc.ireg[dec[i].rs2].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_subw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.w.val - proc.ireg[dec[i].rs2].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sllw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val << (proc.ireg[dec[i].rs2] & 0b11111));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_srlw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val >> (proc.ireg[dec[i].rs2] & 0b11111));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sraw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.w.val >> (proc.ireg[dec[i].rs2] & 0b11111));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mul:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val * proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulh:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::mulh(proc.ireg[dec[i].rs1].r.x.val, proc.ireg[dec[i].rs2].r.x.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulhsu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::mulhsu(proc.ireg[dec[i].rs1].r.x.val, proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulhu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::mulhu(proc.ireg[dec[i].rs1].r.xu.val, proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_div:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val == std::numeric_limits<sx>::min() && proc.ireg[dec[i].rs2].r.x.val == -1 ? std::numeric_limits<sx>::min() : proc.ireg[dec[i].rs2].r.x.val == 0 ? -1 : proc.ireg[dec[i].rs1].r.x.val / proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_divu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.x.val == 0 ? -1 : sx(proc.ireg[dec[i].rs1].r.xu.val / proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_rem:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.x.val == std::numeric_limits<sx>::min() && proc.ireg[dec[i].rs2].r.x.val == -1 ? 0 : proc.ireg[dec[i].rs2].r.x.val == 0 ? proc.ireg[dec[i].rs1].r.x.val : proc.ireg[dec[i].rs1].r.x.val % proc.ireg[dec[i].rs2].r.x.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_remu:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.x.val == 0 ? proc.ireg[dec[i].rs1].r.x.val : sx(proc.ireg[dec[i].rs1].r.xu.val % proc.ireg[dec[i].rs2].r.xu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_mulw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : s32(proc.ireg[dec[i].rs1].r.wu.val * proc.ireg[dec[i].rs2].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_divw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.w.val == std::numeric_limits<s32>::min() && proc.ireg[dec[i].rs2].r.w.val == -1 ? std::numeric_limits<s32>::min() : proc.ireg[dec[i].rs2].r.w.val == 0 ? -1 : proc.ireg[dec[i].rs1].r.w.val / proc.ireg[dec[i].rs2].r.w.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_divuw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.w.val == 0 ? -1 : s32(proc.ireg[dec[i].rs1].r.wu.val / proc.ireg[dec[i].rs2].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_remw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs1].r.w.val == std::numeric_limits<s32>::min() && proc.ireg[dec[i].rs2].r.w.val == -1 ? 0 : proc.ireg[dec[i].rs2].r.w.val == 0 ? proc.ireg[dec[i].rs1].r.w.val : proc.ireg[dec[i].rs1].r.w.val % proc.ireg[dec[i].rs2].r.w.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_remuw:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.ireg[dec[i].rs2].r.w.val == 0 ? proc.ireg[dec[i].rs1].r.w.val : s32(proc.ireg[dec[i].rs1].r.wu.val % proc.ireg[dec[i].rs2].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lr_w:
+		{
+			s32 t; proc.mmu.template lr<P,s32>(proc, proc.ireg[dec[i].rs1], t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sc_w:
+		{
+			ux res = 0; proc.mmu.template sc<P,s32>(proc, proc.ireg[dec[i].rs1], proc.ireg[dec[i].rs2].r.w.val, res); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : res;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoswap_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoswap, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoadd_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoadd, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoxor_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoxor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoor_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoand_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amoand, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomin_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amomin, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomax_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amomax, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amominu_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amominu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomaxu_w:
+		{
+			s32 t1, t2 = proc.ireg[dec[i].rs2].r.w.val; proc.mmu.template amo<P,s32>(proc, amomaxu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_lr_d:
+		{
+			s64 t; proc.mmu.template lr<P,s64>(proc, proc.ireg[dec[i].rs1], t); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_sc_d:
+		{
+			ux res = 0; proc.mmu.template sc<P,s64>(proc, proc.ireg[dec[i].rs1], proc.ireg[dec[i].rs2].r.l.val, res); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : res;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoswap_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoswap, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoadd_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoadd, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoxor_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoxor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoor_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoor, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amoand_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amoand, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomin_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amomin, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomax_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amomax, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amominu_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amominu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_amomaxu_d:
+		{
+			s64 t1, t2 = proc.ireg[dec[i].rs2].r.l.val; proc.mmu.template amo<P,s64>(proc, amomaxu, proc.ireg[dec[i].rs1], t1, t2); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : t1;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_flw:
+		{
+			u32 t; proc.mmu.template load<P,u32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.freg[dec[i].rd].r.wu.val = t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsw:
+		{
+			proc.mmu.template store<P,f32>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.freg[dec[i].rs2].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmadd_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * proc.freg[dec[i].rs2].r.s.val + proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmsub_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * proc.freg[dec[i].rs2].r.s.val - proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmsub_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * -proc.freg[dec[i].rs2].r.s.val + proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmadd_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * -proc.freg[dec[i].rs2].r.s.val - proc.freg[dec[i].rs3].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fadd_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val + proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsub_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val - proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmul_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val * proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fdiv_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = proc.freg[dec[i].rs1].r.s.val / proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnj_s:
+		{
+			proc.freg[dec[i].rd].r.wu.val = (proc.freg[dec[i].rs1].r.wu.val & u32(~(1U<<31))) | (proc.freg[dec[i].rs2].r.wu.val & u32(1U<<31));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjn_s:
+		{
+			proc.freg[dec[i].rd].r.wu.val = (proc.freg[dec[i].rs1].r.wu.val & u32(~(1U<<31))) | (~proc.freg[dec[i].rs2].r.wu.val & u32(1U<<31));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjx_s:
+		{
+			proc.freg[dec[i].rd].r.wu.val = proc.freg[dec[i].rs1].r.wu.val ^ (proc.freg[dec[i].rs2].r.wu.val & u32(1U<<31));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmin_s:
+		{
+			proc.freg[dec[i].rd].r.s.val = (proc.freg[dec[i].rs1].r.s.val < proc.freg[dec[i].rs2].r.s.val) || std::isnan(proc.freg[dec[i].rs2].r.s.val) ? proc.freg[dec[i].rs1].r.s.val : proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmax_s:
+		{
+			proc.freg[dec[i].rd].r.s.val = (proc.freg[dec[i].rs1].r.s.val > proc.freg[dec[i].rs2].r.s.val) || std::isnan(proc.freg[dec[i].rs2].r.s.val) ? proc.freg[dec[i].rs1].r.s.val : proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsqrt_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = riscv::f32_sqrt(proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fle_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.s.val <= proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_flt_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.s.val < proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_feq_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.s.val == proc.freg[dec[i].rs2].r.s.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_w_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_w(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_wu_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_wu(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_w:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_wu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_x_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : std::isnan(proc.freg[dec[i].rs1].r.s.val) ? s32(0x7fc00000) : proc.freg[dec[i].rs1].r.w.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fclass_s:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : f32_classify(proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_s_x:
+		{
+			proc.freg[dec[i].rd].r.wu.val = proc.ireg[dec[i].rs1].r.wu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_l_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_l(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_lu_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_lu(proc.fcsr, proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_l:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.l.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_lu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.ireg[dec[i].rs1].r.lu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fld:
+		{
+			u64 t; proc.mmu.template load<P,u64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, t); proc.freg[dec[i].rd].r.lu.val = t;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsd:
+		{
+			proc.mmu.template store<P,f64>(proc, proc.ireg[dec[i].rs1] + dec[i].imm, proc.freg[dec[i].rs2].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmadd_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * proc.freg[dec[i].rs2].r.d.val + proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmsub_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * proc.freg[dec[i].rs2].r.d.val - proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmsub_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * -proc.freg[dec[i].rs2].r.d.val + proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fnmadd_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * -proc.freg[dec[i].rs2].r.d.val - proc.freg[dec[i].rs3].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fadd_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val + proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsub_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val - proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmul_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val * proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fdiv_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = proc.freg[dec[i].rs1].r.d.val / proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnj_d:
+		{
+			proc.freg[dec[i].rd].r.lu.val = (proc.freg[dec[i].rs1].r.lu.val & u64(~(1ULL<<63))) | (proc.freg[dec[i].rs2].r.lu.val & u64(1ULL<<63));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjn_d:
+		{
+			proc.freg[dec[i].rd].r.lu.val = (proc.freg[dec[i].rs1].r.lu.val & u64(~(1ULL<<63))) | (~proc.freg[dec[i].rs2].r.lu.val & u64(1ULL<<63));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsgnjx_d:
+		{
+			proc.freg[dec[i].rd].r.lu.val = proc.freg[dec[i].rs1].r.lu.val ^ (proc.freg[dec[i].rs2].r.lu.val & u64(1ULL<<63));
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmin_d:
+		{
+			proc.freg[dec[i].rd].r.d.val = (proc.freg[dec[i].rs1].r.d.val < proc.freg[dec[i].rs2].r.d.val) || std::isnan(proc.freg[dec[i].rs2].r.d.val) ? proc.freg[dec[i].rs1].r.d.val : proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmax_d:
+		{
+			proc.freg[dec[i].rd].r.d.val = (proc.freg[dec[i].rs1].r.d.val > proc.freg[dec[i].rs2].r.d.val) || std::isnan(proc.freg[dec[i].rs2].r.d.val) ? proc.freg[dec[i].rs1].r.d.val : proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_s_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.s.val = f32(proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_s:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.freg[dec[i].rs1].r.s.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fsqrt_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = riscv::f64_sqrt(proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fle_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.d.val <= proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_flt_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.d.val < proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_feq_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : proc.freg[dec[i].rs1].r.d.val == proc.freg[dec[i].rs2].r.d.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_w_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_w(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_wu_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_wu(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_w:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.w.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_wu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.wu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fclass_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : f64_classify(proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_l_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_l(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_lu_d:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : riscv::fcvt_lu(proc.fcsr, proc.freg[dec[i].rs1].r.d.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_x_d:
+		{
+			proc.ireg[dec[i].rd] = (dec[i].rd == 0) ? 0 : std::isnan(proc.freg[dec[i].rs1].r.d.val) ? s64(0x7ff8000000000000ULL) : proc.freg[dec[i].rs1].r.l.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_l:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.l.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fcvt_d_lu:
+		{
+			fenv_setrm((proc.fcsr >> 5) & 0b111); proc.freg[dec[i].rd].r.d.val = f64(proc.ireg[dec[i].rs1].r.lu.val);
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	exec_fmv_d_x:
+		{
+			proc.freg[dec[i].rd].r.lu.val = proc.ireg[dec[i].rs1].r.lu.val;
+		}
+		proc.pc += pc_offset;
+		proc.instret++;
+		if (pc_offset != length[i] || ++i == count) return count;
+		pc_offset = length[i];
+		goto *handler[i];
+
+	illegal:
+		return i;
+}
+
 #endif
@@ -92,10 +92,32 @@ namespace riscv {
 	{
                 typedef std::shared_ptr<memory_segment<UX>> memory_segment_type;
 
+		/*
+		 * Machine physical pages are found through a two level radix map.
+		 * A page that is wholly inside one segment records the segment, and
+		 * for segments backed by host memory (non zero uva) the user virtual
+		 * address of the page, so main memory accesses are a host pointer
+		 * dereference. Pages shared by segments, partially covered pages and
+		 * addresses above the map fall back to scanning the segment list.
+		 */
+		enum : size_t {
+			radix_bits = 40,
+			region_shift = 28,
+			region_pages = 1ULL << (region_shift - page_shift),
+			region_count = 1ULL << (radix_bits - region_shift)
+		};
+
+		struct memory_page
+		{
+			addr_t uva;                   /* page user virtual address (host) or 0 */
+			memory_segment<UX> *segment;  /* segment containing the whole page */
+		};
+
 		std::vector<memory_segment_type> segments;
+		std::vector<std::unique_ptr<memory_page[]>> regions;
 		bool log;
 
-		user_memory() : log(false) {}
+		user_memory() : regions(region_count), log(false) {}
 		~user_memory() { clear_segments(); }
 
 		/* print memory */
@@ -124,6 +146,7 @@ namespace riscv {
 		void add_segment(memory_segment_type seg)
 		{
 			segments.push_back(seg);
+			map_segments();
 			if (log) {
 				print_memory_segment(seg);
 			}
@@ -150,11 +173,59 @@ namespace riscv {
 		void clear_segments()
 		{
 			segments.clear();
+			map_segments();
+		}
+
+		/*
+		 * rebuild the page map, visiting segments in reverse so that pages
+		 * resolve to the first segment that contains them, as in the scan
+		 */
+		void map_segments()
+		{
+			for (auto &region : regions) {
+				region.reset();
+			}
+			for (auto si = segments.rbegin(); si != segments.rend(); si++) {
+				memory_segment<UX> *seg = si->get();
+				u64 seg_begin = u64(seg->mpa);
+				u64 seg_end = seg_begin + seg->size;
+				if (seg_begin >= (1ULL << radix_bits)) continue;
+				if (seg_end > (1ULL << radix_bits) || seg_end < seg_begin) {
+					seg_end = 1ULL << radix_bits;
+				}
+				for (u64 pa = seg_begin & ~u64(page_size - 1); pa < seg_end; pa += page_size) {
+					auto &region = regions[pa >> region_shift];
+					if (!region) {
+						region = std::unique_ptr<memory_page[]>(new memory_page[region_pages]());
+					}
+					memory_page &page = region[(pa >> page_shift) & (region_pages - 1)];
+					if (pa >= seg_begin && pa + page_size <= seg_end) {
+						page.segment = seg;
+						page.uva = seg->uva ? seg->uva + addr_t(pa - seg_begin) : 0;
+					} else {
+						page.segment = nullptr;
+						page.uva = 0;
+					}
+				}
+			}
+		}
+
+		/* find the page map entry for a machine physical address */
+		memory_page* mpa_to_page(UX mpa)
+		{
+			u64 region = u64(mpa) >> region_shift;
+			if (unlikely(region >= region_count || !regions[region])) return nullptr;
+			return &regions[region][(u64(mpa) >> page_shift) & (region_pages - 1)];
 		}
 
 		/* convert machine physical address to user virtual address */
 		addr_t mpa_to_uva(memory_segment<UX>* &out_seg, UX mpa)
 		{
+			memory_page *page = mpa_to_page(mpa);
+			if (likely(page && page->segment)) {
+				out_seg = page->segment;
+				return page->segment->uva + (mpa - page->segment->mpa);
+			}
 			for (auto &seg : segments) {
 				if (mpa >= seg->mpa && /* note the upper limit may wrap to 0 */
 					((mpa < seg->mpa + seg->size) || (seg->mpa + seg->size == 0))) {
@@ -165,70 +236,66 @@ namespace riscv {
 			return 0;
 		}
 
-		virtual buserror_t load_8(UX va, u8 &val)
+		/* convert machine physical page address to user virtual address if the
+		   whole page is main memory with the given PMA flags, otherwise 0 */
+		addr_t mpa_to_host_page(UX mpa, UX flags)
 		{
 			memory_segment<UX> *segment = nullptr;
-			addr_t uva = mpa_to_uva(segment, va);
-                        if (unlikely(!segment)) return -1;
-			return segment->load_8(uva, val);
+			addr_t uva = mpa_to_uva(segment, mpa);
+			if (!segment || (segment->flags & flags) != flags) return 0;
+			if (mpa - segment->mpa + page_size > segment->size) return 0;
+			return uva;
 		}
 
-		virtual buserror_t load_16(UX va, u16 &val)
-		{
-			memory_segment<UX> *segment = nullptr;
-			addr_t uva = mpa_to_uva(segment, va);
-			if (unlikely(!segment)) return -1;
-			return segment->load_16(uva, val);
-		}
-
-		virtual buserror_t load_32(UX va, u32 &val)
+		/* host address of a main memory word, or nullptr if it is not in host memory */
+		template <typename T>
+		T* host_word(UX mpa)
 		{
-			memory_segment<UX> *segment = nullptr;
-			addr_t uva = mpa_to_uva(segment, va);
-			if (unlikely(!segment)) return -1;
-			return segment->load_32(uva, val);
+			memory_page *page = mpa_to_page(mpa);
+			if (likely(page && page->uva && (mpa & (page_size - 1)) <= page_size - sizeof(T))) {
+				return static_cast<T*>((void*)(page->uva + (mpa & (page_size - 1))));
+			}
+			return nullptr;
 		}
 
-		virtual buserror_t load_64(UX va, u64 &val)
+		/* main memory is accessed directly, everything else through its segment */
+		template <typename T>
+		buserror_t load(UX mpa, T &val)
 		{
+			memory_page *page = mpa_to_page(mpa);
+			if (likely(page && page->uva && (mpa & (page_size - 1)) <= page_size - sizeof(T))) {
+				val = *static_cast<T*>((void*)(page->uva + (mpa & (page_size - 1))));
+				return 0;
+			}
 			memory_segment<UX> *segment = nullptr;
-			addr_t uva = mpa_to_uva(segment, va);
+			addr_t uva = mpa_to_uva(segment, mpa);
 			if (unlikely(!segment)) return -1;
-			return segment->load_64(uva, val);
+			return segment->load(uva, val);
 		}
 
-		virtual buserror_t store_8 (UX va, u8  val)
-		{
-			memory_segment<UX> *segment = nullptr;
-			addr_t uva = mpa_to_uva(segment, va);
-                        if (unlikely(!segment)) return -1;
-                        return segment->store_8(uva, val);
-		}
-
-		virtual buserror_t store_16(UX va, u16 val)
-		{
-			memory_segment<UX> *segment = nullptr;
-			addr_t uva = mpa_to_uva(segment, va);
-                        if (unlikely(!segment)) return -1;
-			return segment->store_16(uva, val);
-		}
-
-		virtual buserror_t store_32(UX va, u32 val)
+		template <typename T>
+		buserror_t store(UX mpa, T val)
 		{
+			memory_page *page = mpa_to_page(mpa);
+			if (likely(page && page->uva && (mpa & (page_size - 1)) <= page_size - sizeof(T))) {
+				*static_cast<T*>((void*)(page->uva + (mpa & (page_size - 1)))) = val;
+				return 0;
+			}
 			memory_segment<UX> *segment = nullptr;
-			addr_t uva = mpa_to_uva(segment, va);
+			addr_t uva = mpa_to_uva(segment, mpa);
 			if (unlikely(!segment)) return -1;
-			return segment->store_32(uva, val);
+			return segment->store(uva, val);
 		}
 
-		virtual buserror_t store_64(UX va, u64 val)
-		{
-			memory_segment<UX> *segment = nullptr;
-			addr_t uva = mpa_to_uva(segment, va);
-			if (unlikely(!segment)) return -1;
-                        return segment->store_64(uva, val);
-		}
+		virtual buserror_t load_8 (UX va, u8  &val) { return load(va, val); }
+		virtual buserror_t load_16(UX va, u16 &val) { return load(va, val); }
+		virtual buserror_t load_32(UX va, u32 &val) { return load(va, val); }
+		virtual buserror_t load_64(UX va, u64 &val) { return load(va, val); }
 
+		virtual buserror_t store_8 (UX va, u8  val) { return store(va, val); }
+		virtual buserror_t store_16(UX va, u16 val) { return store(va, val); }
+		virtual buserror_t store_32(UX va, u32 val) { return store(va, val); }
+		virtual buserror_t store_64(UX va, u64 val) { return store(va, val); }
 	};
 
 }
@@ -71,9 +71,26 @@ namespace riscv {
 		template <typename P, typename T>
 		void amo(P &proc, const amo_op a_op, UX va, T &val1, T val2)
 		{
-			val1 = UX(*(T*)addr_t(va & (memory_top - 1)));
-			val2 = amo_fn<UX>(a_op, val1, val2);
-			*((T*)addr_t(va & (memory_top - 1))) = val2;
+			val1 = amo_host<T>(a_op, (T*)addr_t(va & (memory_top - 1)), val2);
+		}
+
+		template <typename T> T* host_ptr(UX va)
+		{
+			return enfore_memory_top ? (T*)addr_t(va & (memory_top - 1)) : (T*)addr_t(va);
+		}
+
+		template <typename P, typename T> void lr(P &proc, UX va, T &val)
+		{
+			val = __atomic_load_n(host_ptr<T>(va), __ATOMIC_SEQ_CST);
+			proc.lr = va;
+			proc.lr_val = val;
+		}
+
+		template <typename P, typename T> void sc(P &proc, UX va, T val, typename P::ux &res)
+		{
+			bool reserved = (proc.lr == va);
+			proc.lr = UX(-1);
+			res = (reserved && sc_host<T>(host_ptr<T>(va), T(proc.lr_val), val)) ? 0 : 1;
 		}
 
 		template <typename P, typename T> void load(P &proc, UX va, T &val)
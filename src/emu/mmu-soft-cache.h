@@ -8,15 +8,94 @@
 
 namespace riscv {
 
-	template <typename UX, typename TLB, typename PMA, typename CACHE, typename MEMORY = user_memory<UX>>
+	/*
+	 * cache_sampler
+	 *
+	 * systematic sampling of the cache model. Each period runs functionally
+	 * with the caches bypassed, then warms up the invalidated caches and
+	 * measures a window. The miss rate and misses per thousand instructions
+	 * of each window are samples for the whole run, which are extrapolated
+	 * with 95% confidence intervals using the normal approximation.
+	 */
+
+	struct cache_sample_stat
+	{
+		u64 n;
+		double mean;
+		double m2;
+
+		cache_sample_stat() : n(0), mean(0), m2(0) {}
+
+		void add(double x)
+		{
+			double delta = x - mean;
+			mean += delta / ++n;
+			m2 += delta * (x - mean);
+		}
+
+		double ci95() const { return n > 1 ? 1.96 * sqrt(m2 / (n - 1) / n) : 0; }
+	};
+
+	struct cache_sampler
+	{
+		enum : size_t { num_levels = 3 };
+
+		enum phase_type {
+			phase_fast,
+			phase_warmup,
+			phase_measure
+		};
+
+		u64 period;
+		u64 warmup;
+		u64 measure;
+		phase_type phase;
+		u64 phase_end;
+		u64 window_start;
+		cache_stats window[num_levels];
+		cache_sample_stat miss_rate[num_levels];
+		cache_sample_stat mpki[num_levels];
+
+		cache_sampler() : period(0), warmup(0), measure(0), phase(phase_fast),
+			phase_end(0), window_start(0) {}
+
+		bool enabled() const { return period != 0; }
+
+		/* PERIOD:WARMUP:MEASURE instructions, where K and M are 1000 and 1000000 */
+		bool parse(std::string spec)
+		{
+			std::vector<std::string> comps = split(spec, ":");
+			if (comps.size() != 3 ||
+				!cache_parse_count(comps[0], period, 1000) ||
+				!cache_parse_count(comps[1], warmup, 1000) ||
+				!cache_parse_count(comps[2], measure, 1000)) return false;
+			if (measure == 0 || warmup + measure > period) return false;
+			phase = phase_fast;
+			phase_end = period - warmup - measure;
+			return true;
+		}
+	};
+
+	/*
+	 * mmu_soft_cache
+	 *
+	 * soft MMU that models a cache hierarchy. Instruction fetches go through
+	 * the L1 instruction cache, loads, stores and page walks go through the
+	 * L1 data cache, and both L1 caches fill from a shared L2. Each level is
+	 * a tagged_cache layered on the next, with the geometry set at runtime.
+	 */
+
+	template <typename UX, typename TLB, typename PMA, typename PARAM, typename MEMORY = user_memory<UX>>
 	struct mmu_soft_cache
 	{
 		typedef TLB    tlb_type;
 		typedef PMA    pma_type;
-                typedef std::shared_ptr<MEMORY> memory_type;
-	        typedef std::shared_ptr<CACHE>  cache_type;
+		typedef page_walk_cache<64,UX> pwc_type;
+		typedef std::shared_ptr<MEMORY> memory_type;
+		typedef tagged_cache<PARAM,MEMORY> l2_cache_type;
+		typedef tagged_cache<PARAM,l2_cache_type> l1_cache_type;
 
-                enum mmu_op {
+		enum mmu_op {
 			op_fetch,
 			op_load,
 			op_store
@@ -26,14 +105,188 @@ namespace riscv {
 
 		tlb_type       l1_itlb;     /* L1 Instruction TLB */
 		tlb_type       l1_dtlb;     /* L1 Data TLB */
+		pwc_type       pwc;         /* Page walk cache */
 		pma_type       pma;         /* PMA table */
-                memory_type    mem;         /* memory device */
-                cache_type     cache;       /* L1 Cache */
+		memory_type    mem;         /* memory device */
+		std::shared_ptr<l1_cache_type> icache;   /* L1 Instruction Cache */
+		std::shared_ptr<l1_cache_type> dcache;   /* L1 Data Cache */
+		std::shared_ptr<l2_cache_type> l2cache;  /* L2 Unified Cache */
+		std::string    cache_stats_json;         /* JSON statistics file */
+		cache_sampler  sampler;                  /* sampled simulation schedule */
+		bool           detailed;                 /* accesses go through the caches */
 
 		/* MMU constructor */
 
-		mmu_soft_cache() : mem(std::make_shared<MEMORY>()), cache(std::make_shared<CACHE>(mem,cache_write_through)){}
-		mmu_soft_cache(memory_type mem) : mem(mem), cache(std::make_shared<CACHE>(mem,cache_write_through)){}
+		mmu_soft_cache() : mmu_soft_cache(std::make_shared<MEMORY>()) {}
+		mmu_soft_cache(memory_type mem) : mem(mem), detailed(true)
+		{
+			configure_caches(default_l1_geometry(), default_l1_geometry(), default_l2_geometry());
+		}
+
+		/*
+		 * The caches default to write through so that memory stays current for
+		 * devices and the loader, which access RAM directly
+		 */
+		static cache_geometry default_l1_geometry()
+		{
+			return cache_geometry(32768, 8, 64, cache_write_through);
+		}
+
+		static cache_geometry default_l2_geometry()
+		{
+			return cache_geometry(262144, 8, 64, cache_write_through);
+		}
+
+		/* rebuild the cache hierarchy, discarding the contents and statistics */
+		void configure_caches(cache_geometry l1i, cache_geometry l1d, cache_geometry l2)
+		{
+			l2cache = std::make_shared<l2_cache_type>(mem, l2);
+			icache = std::make_shared<l1_cache_type>(l2cache, l1i);
+			dcache = std::make_shared<l1_cache_type>(l2cache, l1d);
+		}
+
+		/*
+		 * fence.i: dirty L1D lines are written back to the L2, and the L2 to
+		 * memory, before the L1I is invalidated so refetched lines see stores
+		 */
+		void sync_icache()
+		{
+			if (dcache->write_back() || l2cache->write_back() || icache->flush()) {
+				panic("cache: write back failed");
+			}
+		}
+
+		/* caches are bypassed between sampled windows */
+		template <typename T> buserror_t fetch_mem(UX mpa, T &val)
+		{
+			return likely(detailed) ? icache->load(mpa, val) : mem->load(mpa, val);
+		}
+
+		template <typename T> buserror_t load_mem(UX mpa, T &val)
+		{
+			return likely(detailed) ? dcache->load(mpa, val) : mem->load(mpa, val);
+		}
+
+		template <typename T> buserror_t store_mem(UX mpa, T val)
+		{
+			return likely(detailed) ? dcache->store(mpa, val) : mem->store(mpa, val);
+		}
+
+		/* start sampling, beginning with a functional phase */
+		void configure_sampling(cache_sampler schedule)
+		{
+			sampler = schedule;
+			detailed = !sampler.enabled();
+		}
+
+		cache_stats& level_stats(size_t level)
+		{
+			switch (level) {
+				case 0: return icache->stats;
+				case 1: return dcache->stats;
+				default: return l2cache->stats;
+			}
+		}
+
+		/* advance the sampling schedule, returning the instructions until the next phase */
+		size_t sample(u64 instret, size_t count)
+		{
+			if (!sampler.enabled()) return count;
+			while (instret >= sampler.phase_end) {
+				switch (sampler.phase) {
+					case cache_sampler::phase_fast:
+						detailed = true;
+						sampler.phase = cache_sampler::phase_warmup;
+						sampler.phase_end += sampler.warmup;
+						break;
+					case cache_sampler::phase_warmup:
+						for (size_t level = 0; level < cache_sampler::num_levels; level++) {
+							sampler.window[level] = level_stats(level);
+						}
+						sampler.window_start = instret;
+						sampler.phase = cache_sampler::phase_measure;
+						sampler.phase_end += sampler.measure;
+						break;
+					case cache_sampler::phase_measure:
+						sample_window(instret);
+						/* L1 write backs reach the L2 before it is flushed to memory */
+						if (icache->flush() || dcache->flush() || l2cache->flush()) {
+							panic("cache: write back failed");
+						}
+						detailed = false;
+						sampler.phase = cache_sampler::phase_fast;
+						sampler.phase_end += sampler.period - sampler.warmup - sampler.measure;
+						break;
+				}
+			}
+			return std::min(count, size_t(sampler.phase_end - instret));
+		}
+
+		/* add the miss rate and MPKI of the measured window to the samples */
+		void sample_window(u64 instret)
+		{
+			u64 insts = instret - sampler.window_start;
+			for (size_t level = 0; level < cache_sampler::num_levels; level++) {
+				cache_stats &now = level_stats(level), &then = sampler.window[level];
+				u64 accesses = (now.loads - then.loads) + (now.stores - then.stores);
+				u64 misses = now.misses - then.misses;
+				if (accesses) {
+					sampler.miss_rate[level].add(double(misses) / double(accesses));
+				}
+				if (insts) {
+					sampler.mpki[level].add(double(misses) * 1000.0 / double(insts));
+				}
+			}
+		}
+
+		/* print cache statistics, also writing them as JSON if a file was given */
+		void print_cache_stats(u64 instret)
+		{
+			static const char* level_names[] = { "l1i", "l1d", "l2" };
+			icache->print_stats("l1i");
+			dcache->print_stats("l1d");
+			l2cache->print_stats("l2");
+			if (sampler.enabled()) {
+				printf("sampled  period %llu warmup %llu measure %llu samples %llu instret %llu\n",
+					sampler.period, sampler.warmup, sampler.measure,
+					sampler.mpki[0].n, instret);
+				for (size_t level = 0; level < cache_sampler::num_levels; level++) {
+					cache_sample_stat &rate = sampler.miss_rate[level], &mpki = sampler.mpki[level];
+					printf("%-8s miss rate %.3f%% +/- %.3f%% mpki %.3f +/- %.3f misses %.0f +/- %.0f\n",
+						level_names[level], rate.mean * 100.0, rate.ci95() * 100.0,
+						mpki.mean, mpki.ci95(),
+						mpki.mean * instret / 1000.0, mpki.ci95() * instret / 1000.0);
+				}
+			}
+			if (cache_stats_json.size() == 0) return;
+			FILE *file = fopen(cache_stats_json.c_str(), "w");
+			if (!file) {
+				debug("cache: unable to open %s: %s", cache_stats_json.c_str(), strerror(errno));
+				return;
+			}
+			fprintf(file, "{\n");
+			icache->write_stats_json(file, "l1i");
+			fprintf(file, ",\n");
+			dcache->write_stats_json(file, "l1d");
+			fprintf(file, ",\n");
+			l2cache->write_stats_json(file, "l2");
+			if (sampler.enabled()) {
+				fprintf(file, ",\n  \"sampling\": {\n");
+				fprintf(file, "    \"period\": %llu,\n    \"warmup\": %llu,\n    \"measure\": %llu,\n"
+					"    \"samples\": %llu,\n    \"instret\": %llu",
+					sampler.period, sampler.warmup, sampler.measure, sampler.mpki[0].n, instret);
+				for (size_t level = 0; level < cache_sampler::num_levels; level++) {
+					cache_sample_stat &rate = sampler.miss_rate[level], &mpki = sampler.mpki[level];
+					fprintf(file, ",\n    \"%s\": { \"miss_rate\": %g, \"miss_rate_ci95\": %g, "
+						"\"mpki\": %g, \"mpki_ci95\": %g, \"misses\": %g, \"misses_ci95\": %g }",
+						level_names[level], rate.mean, rate.ci95(), mpki.mean, mpki.ci95(),
+						mpki.mean * instret / 1000.0, mpki.ci95() * instret / 1000.0);
+				}
+				fprintf(file, "\n  }");
+			}
+			fprintf(file, "\n}\n");
+			fclose(file);
+		}
 
 		/* MMU methods */
 
@@ -119,7 +372,7 @@ namespace riscv {
 			if (!mpa) return 0;
 
 			/* check execute permissions and fetch first 32 bits */
-			if (unlikely(fetch_access_fault(proc, proc.mode, tlb_ent) || cache->load(mpa, inst_32))) {
+			if (unlikely(fetch_access_fault(proc, proc.mode, tlb_ent) || fetch_mem(mpa, inst_32))) {
 				proc.raise(rv_cause_fault_fetch, pc);
 				return 0;
 			}
@@ -136,14 +389,14 @@ namespace riscv {
 			} else if ((inst & 0b11100) != 0b11100) {
 				pc_offset = 4;
 			} else if ((inst & 0b111111) == 0b011111) {
-				if (unlikely(cache->load(mpa + 4, inst_16))) {
+				if (unlikely(fetch_mem(mpa + 4, inst_16))) {
                                         proc.raise(rv_cause_fault_fetch, pc);
 					return 0;
 				}
 				inst |= inst_t(htole16(inst_16)) << 32;
 				pc_offset = 6;
 			} else if ((inst & 0b1111111) == 0b0111111) {
-				if (unlikely(cache->load(mpa + 4, inst_32))) {
+				if (unlikely(fetch_mem(mpa + 4, inst_32))) {
                                         proc.raise(rv_cause_fault_fetch, pc);
 					return 0;
 				}
@@ -175,21 +428,46 @@ namespace riscv {
 			/* TODO - plumb amo interface into the memory bus */
 
 			/* Check read permissions and perform load */
-			if (unlikely(load_access_fault(proc, proc.mode, tlb_ent) || cache->load(mpa, val1))) {
+			if (unlikely(load_access_fault(proc, proc.mode, tlb_ent) || load_mem(mpa, val1))) {
 				proc.raise(rv_cause_fault_store, va);
 				return;
 			}
 
 			/* execute atomic op */
-			val2 = amo_fn<UX>(a_op, val1, val2);
+			val2 = amo_fn<T>(a_op, val1, val2);
 
 			/* Check write permissions and perform store */
-			if (unlikely(store_access_fault(proc, proc.mode, tlb_ent) || cache->store(mpa, val2))) {
+			if (unlikely(store_access_fault(proc, proc.mode, tlb_ent) || store_mem(mpa, val2))) {
 				proc.raise(rv_cause_fault_store, va);
 			}
 
 		}
 
+		/*
+		 * load reserved and store conditional. The cache model runs a single
+		 * hart, so the reservation is only lost to another store conditional.
+		 */
+		template <typename P, typename T, const mmu_op op = op_load>
+		void lr(P &proc, UX va, T &val)
+		{
+			load<P,T,op>(proc, va, val);
+			proc.lr = va;
+			proc.lr_val = val;
+		}
+
+		template <typename P, typename T, const mmu_op op = op_store>
+		void sc(P &proc, UX va, T val, typename P::ux &res)
+		{
+			bool reserved = (proc.lr == va);
+			proc.lr = UX(-1);
+			if (!reserved) {
+				res = 1;
+				return;
+			}
+			store<P,T,op>(proc, va, val);
+			res = 0;
+		}
+
 		/* load */
 		template <typename P, typename T, const mmu_op op = op_load>
 		void load(P &proc, UX va, T &val)
@@ -207,7 +485,7 @@ namespace riscv {
 			if (!mpa) return;
 
 			/* check read permissions and perform load */
-                        if (unlikely(load_access_fault(proc, proc.mode, tlb_ent)|| cache->load(mpa, val))) {
+                        if (unlikely(load_access_fault(proc, proc.mode, tlb_ent)|| load_mem(mpa, val))) {
 				proc.raise(rv_cause_fault_load, va);
 			}
 
@@ -230,12 +508,20 @@ namespace riscv {
 			if (!mpa) return;
 		
                         /* check write permissions and perform store */
-			if (unlikely(store_access_fault(proc, proc.mode, tlb_ent) || cache->store(mpa, val))) {
+			if (unlikely(store_access_fault(proc, proc.mode, tlb_ent) || store_mem(mpa, val))) {
 				proc.raise(rv_cause_fault_store, va);
 			}
 
 		}
 
+		/* print TLB statistics */
+		void print_tlb_stats()
+		{
+			l1_itlb.print_stats("l1_itlb");
+			l1_dtlb.print_stats("l1_dtlb");
+			pwc.print_stats("pwc");
+		}
+
 		template <typename P> constexpr UX effective_mode(P &proc, const mmu_op op)
 		{
 			/*
@@ -295,10 +581,10 @@ namespace riscv {
 			if (tlb_ent) {
 				/* check if accessed and dirty flags are up-to-date */
 				uintptr_t ad_flags = pte_flag_A | (op == op_store ? pte_flag_D : 0);
-				if ((tlb_ent->pteb & ad_flags) != ad_flags) {
-					/* rewalk the page table to find the PTE address and update flags */
+				if ((tlb_ent->pteb & ad_flags) == ad_flags) {
 					return page_translate_offset<PTM>(tlb_ent->ppn, va, tlb_ent->ptel);
 				}
+				/* rewalk the page table to find the PTE address and update flags */
 			}
 			return page_translate_addr_tlb_miss<P,PTM>(proc, va, op, tlb, tlb_ent);
 		}
@@ -309,17 +595,10 @@ namespace riscv {
 			P &proc, UX va, mmu_op op,
 			tlb_type &tlb, typename tlb_type::tlb_entry_t* &tlb_ent)
 		{
-			/*
-			 * The simple direct mapped TLB implementation currently maps page_size
-			 * entries so as a byproduct, the code will rewalk the page table every
-			 * page_size interval, even if the PTE points to a megapage or gigapage.
-			 * Can be solved by adding a secondary TLB with larger scoped entries.
-			 */
-
 			typename PTM::pte_type pte;
 			UX level;
 
-			/* TODO: TLB statistics */
+			tlb.walks++;
 
 			/* Walk the page table to find a leaf PTE entry
 			 * (access fault is raised if leaf PTE is not found) */
@@ -349,8 +628,11 @@ namespace riscv {
 
 			/* TODO: canonical address check */
 
+			/* start below the deepest cached non-leaf PTE */
+			level = pwc.template walk_start<PTM>(proc.sptbr, va, ppn);
+
 			/* walk the page table */
-			for (level = PTM::levels - 1; level >= 0; level--) {
+			for (; level >= 0; level--) {
 
 				/* calculate the shift for this page table level */
 				shift = PTM::bits * level + page_shift;
@@ -359,7 +641,7 @@ namespace riscv {
                                 
 
 				/* load the PTE from memory */
-				if (unlikely(cache->load(pte_mpa, *(typename PTM::size_type*)&pte))) goto fault;
+				if (unlikely(load_mem(pte_mpa, *(typename PTM::size_type*)&pte))) goto fault;
                                 
 
 
@@ -369,6 +651,9 @@ namespace riscv {
 					  (pte.xu.val >> pte_shift_X)) & 1) == 0)
 				{
 					ppn = pte.val.ppn << page_shift;
+					if (level > 0 && (pte.val.flags & pte_flag_V)) {
+						pwc.template insert<PTM>(proc.sptbr, va, level, ppn);
+					}
 					continue;
 				};
 
@@ -387,9 +672,8 @@ namespace riscv {
 					if ((pte.val.flags & ad_flags) != ad_flags) {
 						pte.val.flags |= ad_flags;
 						/* update PTE (note this reall needs to be atomic) */
-						if (unlikely(cache->load(pte_mpa, *(typename PTM::size_type*)&pte))) goto fault;
-
-                                        }
+						if (unlikely(store_mem(pte_mpa, *(typename PTM::size_type*)&pte))) goto fault;
+					}
 
 					if (proc.log & proc_log_pagewalk) {
 						debug("walk_page_table va=0x%llx sptbr=0x%llx, level=%d "
@@ -413,9 +697,9 @@ namespace riscv {
 			}
 
 			switch (op) {
-				case op_fetch: proc.raise(rv_cause_fault_fetch, va);
-				case op_load:  proc.raise(rv_cause_fault_load, va);
-				case op_store: proc.raise(rv_cause_fault_store, va);
+				case op_fetch: proc.raise(rv_cause_fault_fetch, va); break;
+				case op_load:  proc.raise(rv_cause_fault_load, va); break;
+				case op_store: proc.raise(rv_cause_fault_store, va); break;
 			}
 
 			return 0;
@@ -428,11 +712,8 @@ namespace riscv {
 	typedef pma_table<u32,8> pma_table_rv32;
 	typedef pma_table<u64,8> pma_table_rv64;
 
-        typedef tagged_cache_rv32<32768,8,64> cache_type_rv32;
-        typedef tagged_cache_rv64<32768,8,64> cache_type_rv64;
-
-	using mmu_soft_cache_rv32 = mmu_soft_cache<u32,tlb_type_rv32,pma_table_rv32,cache_type_rv32>;
-	using mmu_soft_cache_rv64 = mmu_soft_cache<u64,tlb_type_rv64,pma_table_rv64,cache_type_rv64>;
+	using mmu_soft_cache_rv32 = mmu_soft_cache<u32,tlb_type_rv32,pma_table_rv32,param_rv32>;
+	using mmu_soft_cache_rv64 = mmu_soft_cache<u64,tlb_type_rv64,pma_table_rv64,param_rv64>;
 
 }
 
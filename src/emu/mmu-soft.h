@@ -13,6 +13,7 @@ namespace riscv {
 	{
 		typedef TLB    tlb_type;
 		typedef PMA    pma_type;
+		typedef page_walk_cache<64,UX> pwc_type;
 		typedef std::shared_ptr<MEMORY> memory_type;
 		
                 enum mmu_op {
@@ -25,13 +26,16 @@ namespace riscv {
 
 		tlb_type       l1_itlb;     /* L1 Instruction TLB */
 		tlb_type       l1_dtlb;     /* L1 Data TLB */
+		pwc_type       pwc;         /* Page walk cache */
 		pma_type       pma;         /* PMA table */
 		memory_type    mem;         /* memory device */
+		std::set<addr_t> code_pages;/* machine physical pages with JIT traces */
+		bool           code_dirty;  /* a store has modified a page in code_pages */
 		
                 /* MMU constructor */
 
-		mmu_soft() : mem(std::make_shared<MEMORY>()) {}
-		mmu_soft(memory_type mem) : mem(mem) {}
+		mmu_soft() : mem(std::make_shared<MEMORY>()), code_dirty(false) {}
+		mmu_soft(memory_type mem) : mem(mem), code_dirty(false) {}
 
 		/* MMU methods */
 
@@ -123,7 +127,11 @@ namespace riscv {
 
 			/* record pc histogram using machine physical address */
 			if (proc.log & proc_log_hist_pc) {
-				proc.histogram_add_pc(mpa);
+				size_t iters = proc.histogram_add_pc(mpa);
+				if ((proc.log & proc_log_jit_trap) &&
+					iters != P::hostspot_trace_skip && iters >= proc.trace_iters) {
+					proc.raise(P::internal_cause_hotspot, mpa);
+				}
 			}
 
 			/* decode length and fetch any remaining instruction bytes */
@@ -189,21 +197,77 @@ namespace riscv {
 			addr_t mpa = translate_addr<P,op>(proc, va, tlb_ent);
 			if (!mpa) return;
 
-			/* TODO - plumb amo interface into the memory bus */
+			/* check read and write permissions */
+			if (unlikely(load_access_fault(proc, proc.mode, tlb_ent) ||
+				store_access_fault(proc, proc.mode, tlb_ent)))
+			{
+				proc.raise(rv_cause_fault_store, va);
+				return;
+			}
 
-			/* Check read permissions and perform load */
-			if (unlikely(load_access_fault(proc, proc.mode, tlb_ent) || mem->load(mpa, val1))) {
+			/* main memory is updated with a host atomic, IO with a load and store */
+			T *ptr = mem->template host_word<T>(mpa);
+			if (likely(ptr != nullptr)) {
+				val1 = amo_host<T>(a_op, ptr, val2);
+			} else if (mem->load(mpa, val1) || mem->store(mpa, amo_fn<T>(a_op, val1, val2))) {
 				proc.raise(rv_cause_fault_store, va);
 				return;
 			}
 
-			/* execute atomic op */
-			val2 = amo_fn<UX>(a_op, val1, val2);
+			code_store(mpa);
+		}
+
+		/* load reserved, the reservation holds the address and the value loaded */
+		template <typename P, typename T, const mmu_op op = op_load>
+		void lr(P &proc, UX va, T &val)
+		{
+			load<P,T,op>(proc, va, val);
+			proc.lr = va;
+			proc.lr_val = val;
+		}
+
+		/* store conditional, res is 0 on success and 1 on failure */
+		template <typename P, typename T, const mmu_op op = op_store>
+		void sc(P &proc, UX va, T val, typename P::ux &res)
+		{
+			typename tlb_type::tlb_entry_t* tlb_ent = nullptr;
 
-			/* Check write permissions and perform store */
-			if (unlikely(store_access_fault(proc, proc.mode, tlb_ent) || mem->store(mpa, val2))) {
+			/* raise exception if address is misalligned */
+			if (unlikely(misaligned<T>(va))) {
+				proc.raise(rv_cause_misaligned_store, va);
+				return;
+			}
+
+			/* every store conditional releases the reservation */
+			bool reserved = (proc.lr == va);
+			proc.lr = UX(-1);
+			if (!reserved) {
+				res = 1;
+				return;
+			}
+
+			/* translate to physical (raises exception on fault) */
+			addr_t mpa = translate_addr<P,op>(proc, va, tlb_ent);
+			if (!mpa) return;
+
+			/* check write permissions */
+			if (unlikely(store_access_fault(proc, proc.mode, tlb_ent))) {
 				proc.raise(rv_cause_fault_store, va);
+				return;
+			}
+
+			/* main memory is compared against the reserved value and swapped */
+			T *ptr = mem->template host_word<T>(mpa);
+			if (likely(ptr != nullptr)) {
+				res = sc_host<T>(ptr, T(proc.lr_val), val) ? 0 : 1;
+			} else if (mem->store(mpa, val)) {
+				proc.raise(rv_cause_fault_store, va);
+				return;
+			} else {
+				res = 0;
 			}
+
+			if (res == 0) code_store(mpa);
 		}
 
 		/* load */
@@ -226,7 +290,11 @@ namespace riscv {
 			/* check read permissions and perform load */
 			if (unlikely(load_access_fault(proc, proc.mode, tlb_ent)|| mem->load(mpa, val))) {
 				proc.raise(rv_cause_fault_load, va);
+				return;
 			}
+
+			/* record host address for inline translation */
+			if (tlb_ent && (proc.log & proc_log_jit_trap)) tlb_set_host<op>(tlb_ent, va, mpa);
 		}
 
 		/* store */
@@ -248,9 +316,77 @@ namespace riscv {
 			/* check write permissions and perform store */
 			if (unlikely(store_access_fault(proc, proc.mode, tlb_ent) || mem->store(mpa, val))) {
 				proc.raise(rv_cause_fault_store, va);
+				return;
+			}
+
+			/* record host address for inline translation unless this is a code page */
+			if (!code_store(mpa) && tlb_ent && (proc.log & proc_log_jit_trap)) {
+				tlb_set_host<op>(tlb_ent, va, mpa);
+			}
+		}
+
+		/*
+		 * mark a machine physical page as containing JIT translated code.
+		 * host store tags are dropped so that stores to the page take the
+		 * slow path through store() where they are detected by code_store()
+		 */
+		void set_code_page(addr_t mpa)
+		{
+			if (code_pages.insert(mpa & ~addr_t(page_size - 1)).second) {
+				l1_dtlb.flush_host();
 			}
 		}
 
+		void clear_code_pages()
+		{
+			code_pages.clear();
+			code_dirty = false;
+		}
+
+		/* flag a store to a page containing JIT translated code */
+		bool code_store(addr_t mpa)
+		{
+			if (likely(code_pages.empty()) ||
+				code_pages.find(mpa & ~addr_t(page_size - 1)) == code_pages.end()) {
+				return false;
+			}
+			code_dirty = true;
+			return true;
+		}
+
+		/*
+		 * record the host address of a page of main memory in a TLB entry
+		 * after a permitted access, setting the load or store tag so that
+		 * JIT emitted code can translate subsequent accesses inline. Only
+		 * data TLB entries are tagged, and only when JIT traces are enabled.
+		 * Superpages are tagged through a page sized alias of the accessed
+		 * page, as the inline probe only reads way 0 of the set for the VA
+		 */
+		template <const mmu_op op>
+		void tlb_set_host(typename tlb_type::tlb_entry_t* tlb_ent, UX va, addr_t mpa)
+		{
+			const UX page_mask = ~UX(page_size - 1);
+			addr_t uva = mem->mpa_to_host_page(mpa & page_mask,
+				pma_type_main | (op == op_store ? pma_prot_write : pma_prot_read));
+			if (!uva) return;
+			if (tlb_ent->ptel != 0) tlb_ent = l1_dtlb.alias(tlb_ent, va);
+			l1_dtlb.tag_host(tlb_ent);
+			tlb_ent->addend = uintptr_t(uva) - uintptr_t(va & page_mask);
+			if (op == op_store) {
+				tlb_ent->stag = va & page_mask;
+			} else {
+				tlb_ent->ltag = va & page_mask;
+			}
+		}
+
+		/* print TLB statistics */
+		void print_tlb_stats()
+		{
+			l1_itlb.print_stats("l1_itlb");
+			l1_dtlb.print_stats("l1_dtlb");
+			pwc.print_stats("pwc");
+		}
+
 		template <typename P> constexpr UX effective_mode(P &proc, const mmu_op op)
 		{
 			/*
@@ -310,10 +446,10 @@ namespace riscv {
 			if (tlb_ent) {
 				/* check if accessed and dirty flags are up-to-date */
 				uintptr_t ad_flags = pte_flag_A | (op == op_store ? pte_flag_D : 0);
-				if ((tlb_ent->pteb & ad_flags) != ad_flags) {
-					/* rewalk the page table to find the PTE address and update flags */
+				if ((tlb_ent->pteb & ad_flags) == ad_flags) {
 					return page_translate_offset<PTM>(tlb_ent->ppn, va, tlb_ent->ptel);
 				}
+				/* rewalk the page table to find the PTE address and update flags */
 			}
 			return page_translate_addr_tlb_miss<P,PTM>(proc, va, op, tlb, tlb_ent);
 		}
@@ -324,17 +460,10 @@ namespace riscv {
 			P &proc, UX va, mmu_op op,
 			tlb_type &tlb, typename tlb_type::tlb_entry_t* &tlb_ent)
 		{
-			/*
-			 * The simple direct mapped TLB implementation currently maps page_size
-			 * entries so as a byproduct, the code will rewalk the page table every
-			 * page_size interval, even if the PTE points to a megapage or gigapage.
-			 * Can be solved by adding a secondary TLB with larger scoped entries.
-			 */
-
 			typename PTM::pte_type pte;
 			UX level;
 
-			/* TODO: TLB statistics */
+			tlb.walks++;
 
 			/* Walk the page table to find a leaf PTE entry
 			 * (access fault is raised if leaf PTE is not found) */
@@ -364,8 +493,11 @@ namespace riscv {
 
 			/* TODO: canonical address check */
 
+			/* start below the deepest cached non-leaf PTE */
+			level = pwc.template walk_start<PTM>(proc.sptbr, va, ppn);
+
 			/* walk the page table */
-			for (level = PTM::levels - 1; level >= 0; level--) {
+			for (; level >= 0; level--) {
 
 				/* calculate the shift for this page table level */
 				shift = PTM::bits * level + page_shift;
@@ -381,6 +513,9 @@ namespace riscv {
 					  (pte.xu.val >> pte_shift_X)) & 1) == 0)
 				{
 					ppn = pte.val.ppn << page_shift;
+					if (level > 0 && (pte.val.flags & pte_flag_V)) {
+						pwc.template insert<PTM>(proc.sptbr, va, level, ppn);
+					}
 					continue;
 				};
 
@@ -424,9 +559,9 @@ namespace riscv {
 			}
 
 			switch (op) {
-				case op_fetch: proc.raise(rv_cause_fault_fetch, va);
-				case op_load:  proc.raise(rv_cause_fault_load, va);
-				case op_store: proc.raise(rv_cause_fault_store, va);
+				case op_fetch: proc.raise(rv_cause_fault_fetch, va); break;
+				case op_load:  proc.raise(rv_cause_fault_load, va); break;
+				case op_store: proc.raise(rv_cause_fault_store, va); break;
 			}
 
 			return 0;
@@ -8,111 +8,104 @@
 namespace riscv {
 
 	/*
-	 * work-in-progress node class for eventual SMP implementation
+	 * SMP node
+	 *
+	 * The boot hart creates the memory map and devices and runs in the
+	 * main thread. Secondary harts share the memory map and devices of
+	 * the boot hart and each runs in its own host thread. Secondary hart
+	 * threads block asynchronous signals so that they are delivered to
+	 * the main thread and only take synchronous faults such as SIGSEGV.
 	 *
 	 * TODO
 	 *
-	 *  - change rv-sys to create a node with n harts
-	 *  - move the shared memory map into the node class
 	 *  - rewire debug CLI to node and allow selection of hart
 	 */
 
 	template <typename P>
-	struct node_processor : P, std::thread
-	{
-		node_processor() : P(), std::thread(&node_processor::mainloop) {}
-
-		void mainloop()
-		{
-			P::init();
-			P::run();
-		}
-	};
-
-	struct node_fault
-	{
-		static node_fault *current;
-	};
-
-	node_fault* node_fault::current = nullptr;
-
-	template <typename P>
-	struct node : node_fault
+	struct node_processor : P
 	{
-		std::vector<std::shared_ptr<P>> nodes;
-
-		node(size_t num_nodes)
-		{
-			init();
-			for (size_t i = 0; i < num_nodes; i++) {
-				nodes.push_back(std::make_shared<P>());
-			}
-		}
+		std::thread thread;
 
-		static void signal_handler(int signum, siginfo_t *info, void *)
+		void start()
 		{
-			static_cast<node<P>*>
-				(node_fault::current)->signal_dispatch(signum, info);
+			thread = std::thread(&node_processor::mainloop, this);
 		}
 
-		void signal_dispatch(int signum, siginfo_t *info)
+		void join()
 		{
-			printf("SIGNAL   :%s\n", signal_name(signum));
+			if (thread.joinable()) thread.join();
 		}
 
-		void init()
+		void block_signals()
 		{
-			/*
-			 * Note: the processor currently runs in the main thread.
-			 * When SMP is implemented, hart threads will be changed
-			 * to block all interrupts except for SIGSEGV and the main
-			 * thread will be configured to monitor for interrupts and
-			 * signals to deliver to the hart threads.
-			 */
-
-			// block signals before so we don't deadlock in signal handlers
 			sigset_t set;
 			sigemptyset(&set);
-			sigaddset(&set, SIGSEGV);
 			sigaddset(&set, SIGTERM);
 			sigaddset(&set, SIGQUIT);
 			sigaddset(&set, SIGINT);
 			sigaddset(&set, SIGHUP);
 			sigaddset(&set, SIGUSR1);
+			sigaddset(&set, SIGPIPE);
 			if (pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) {
-				panic("can't set thread signal mask: %s", strerror(errno));
+				panic("node_processor: can't set thread signal mask: %s",
+					strerror(errno));
 			}
+		}
 
-			// disable unwanted signals
-			sigset_t sigpipe_set;
-			sigemptyset(&sigpipe_set);
-			sigaddset(&sigpipe_set, SIGPIPE);
-			sigprocmask(SIG_BLOCK, &sigpipe_set, nullptr);
-
-			// install signal handler
-			struct sigaction sigaction_handler;
-			memset(&sigaction_handler, 0, sizeof(sigaction_handler));
-			sigaction_handler.sa_sigaction = &node<P>::signal_handler;
-			sigaction_handler.sa_flags = SA_SIGINFO;
-			sigaction(SIGSEGV, &sigaction_handler, nullptr);
-			sigaction(SIGTERM, &sigaction_handler, nullptr);
-			sigaction(SIGQUIT, &sigaction_handler, nullptr);
-			sigaction(SIGINT, &sigaction_handler, nullptr);
-			sigaction(SIGHUP, &sigaction_handler, nullptr);
-			sigaction(SIGUSR1, &sigaction_handler, nullptr);
-			node_fault::current = this;
-
-			/* unblock signals */
-			if (pthread_sigmask(SIG_UNBLOCK, &set, NULL) != 0) {
-				panic("can't set thread signal mask: %s", strerror(errno));
+		void mainloop()
+		{
+			block_signals();
+			processor_singleton::current = this;
+			P::current_hart = this;
+			P::run();
+		}
+	};
+
+	template <typename P>
+	struct node
+	{
+		typedef node_processor<P> hart_type;
+
+		P &boot;
+		std::vector<std::unique_ptr<hart_type>> harts;
+
+		node(P &boot) : boot(boot) {}
+
+		~node()
+		{
+			shutdown();
+		}
+
+		/* create secondary harts attached to the boot hart */
+		void create_harts(size_t num_harts)
+		{
+			for (size_t i = 1; i < num_harts; i++) {
+				hart_type *hart = new hart_type();
+				harts.push_back(std::unique_ptr<hart_type>(hart));
+				hart->log = boot.log;
+				hart->threaded = boot.threaded;
+				hart->init_secondary(boot, u16(i));
+				hart->reset();
+				boot.harts.push_back(hart);
+			}
+			for (auto &hart : harts) {
+				hart->harts = boot.harts;
+			}
+		}
+
+		/* secondary harts start in the boot ROM like the boot hart */
+		void start()
+		{
+			for (auto &hart : harts) {
+				hart->start();
 			}
 		}
 
 		void shutdown()
 		{
-			for (auto &node : nodes) {
-				node->shutdown();
-				node->join();
+			boot.stop_harts();
+			for (auto &hart : harts) {
+				hart->join();
 			}
 		}
 	};
@@ -163,7 +163,8 @@ namespace riscv {
 		u16 node_id;                  /* Node Identifier */
 		u16 hart_id;                  /* Hardware Thread Identifier */
 		u32 log;                      /* Log flags */
-		SX lr;                        /* Load Reservation (TODO - global) */
+		UX lr;                        /* Load Reservation address (-1 for none) */
+		SX lr_val;                    /* Load Reservation value */
 		SX cause;                     /* Fault cause */
 		SX badaddr;                   /* Fault address */
 		jmp_buf env;                  /* Fault handler */
@@ -171,9 +172,12 @@ namespace riscv {
 		bool running;                 /* Run Loop control */
 		bool debugging;               /* Debug Step control */
 		bool exceptions;              /* Trap on exceptions */
+		bool threaded;                /* Direct threaded block execution */
 		UX breakpoint;                /* Breakpoint */
 		UX trace_iters;               /* Trace iterations */
 		UX trace_length;              /* Trace length */
+		s64 trace_budget;             /* Trace entries and back-edges before isr */
+		size_t trace_cache_limit;     /* Trace code cache budget in bytes (0 is unlimited) */
 
 		u64 trace_pc[trace_l1_size];
 		u64 trace_fn[trace_l1_size];
@@ -185,10 +189,10 @@ namespace riscv {
 		u32 fcsr;                     /* Floating-Point Control and Status Register */
 
 		processor_base() : pc(0), ireg(), freg(),
-			node_id(0), hart_id(0), log(0), lr(0), cause(0), badaddr(0), env(),
-			running(true), debugging(false), exceptions(true),
-			breakpoint(0), trace_iters(0), trace_length(0),
-			trace_pc(), trace_fn(),
+			node_id(0), hart_id(0), log(0), lr(-1), lr_val(0), cause(0), badaddr(0), env(),
+			running(true), debugging(false), exceptions(true), threaded(false),
+			breakpoint(0), trace_iters(0), trace_length(0), trace_budget(0),
+			trace_cache_limit(0), trace_pc(), trace_fn(),
 			time(0), instret(0), fcsr(0) {}
 
 		/* Internal setjmp/longjump causes */
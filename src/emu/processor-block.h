@@ -0,0 +1,184 @@
+//
+//  processor-block.h
+//
+
+#ifndef rv_processor_block_h
+#define rv_processor_block_h
+
+namespace riscv {
+
+	/*
+	 * Pre-decoded basic block cache
+	 *
+	 * Blocks are keyed by program counter and translation context, that is
+	 * the privilege mode, vm mode and ASID, and hold the decoded instructions
+	 * up to the first control transfer or system instruction, so that the
+	 * interpreter fetches and translates once per block. A block does not
+	 * extend past the page of its first instruction, which means instructions
+	 * after the first can not take fetch faults. The cache is flushed by
+	 * fence.i, sfence.vm and changes to sptbr.
+	 *
+	 * When the processor is threaded, the handler for each instruction in
+	 * the direct threaded interpreter is resolved when the block is built.
+	 */
+
+	template <typename P>
+	struct block_cache
+	{
+		enum : size_t {
+			block_size = 32,
+			cache_size = 1024
+		};
+
+		/* log flags that need each instruction to be stepped */
+		static const u32 inst_log_mask = proc_log_inst | proc_log_operands |
+			proc_log_int_reg | proc_log_hist_reg | proc_log_hist_inst;
+
+		struct block_ent
+		{
+			typename P::ux pc;
+			u64 context;
+			size_t count;
+			inst_t inst[block_size];
+			u8 length[block_size];
+			const void *handler[block_size];
+			typename P::decode_type dec[block_size];
+
+			block_ent() : pc(0), context(0), count(0) {}
+		};
+
+		std::vector<block_ent> blocks;
+		u64 root;
+
+		block_cache() : blocks(cache_size), root(0) {}
+
+		void flush()
+		{
+			for (auto &blk : blocks) {
+				blk.count = 0;
+			}
+		}
+
+		template <typename Q>
+		static auto block_context(Q &proc, int) -> decltype(proc.sptbr, u64())
+		{
+			/* M mode fetches are untranslated and bare mode ignores sptbr */
+			if (proc.mode >= rv_mode_M || proc.mstatus.r.vm == rv_vm_mbare) {
+				return proc.mode;
+			}
+			return proc.mode | (u64(proc.mstatus.r.vm) << 2) |
+				(u64(proc.sptbr >> Q::mmu_type::tlb_type::ppn_bits) << 8);
+		}
+
+		template <typename Q>
+		static u64 block_context(Q &proc, long)
+		{
+			return 0;
+		}
+
+		template <typename Q>
+		static auto block_root(Q &proc, int) -> decltype(proc.sptbr, u64())
+		{
+			return proc.sptbr;
+		}
+
+		template <typename Q>
+		static u64 block_root(Q &proc, long)
+		{
+			return 0;
+		}
+
+		static bool block_end(int op)
+		{
+			switch (op) {
+				case rv_op_illegal:
+				case rv_op_jal:
+				case rv_op_jalr:
+				case rv_op_beq:
+				case rv_op_bne:
+				case rv_op_blt:
+				case rv_op_bge:
+				case rv_op_bltu:
+				case rv_op_bgeu:
+				case rv_op_fence_i:
+				case rv_op_ecall:
+				case rv_op_ebreak:
+				case rv_op_uret:
+				case rv_op_sret:
+				case rv_op_hret:
+				case rv_op_mret:
+				case rv_op_dret:
+				case rv_op_sfence_vm:
+				case rv_op_wfi:
+				case rv_op_csrrw:
+				case rv_op_csrrs:
+				case rv_op_csrrc:
+				case rv_op_csrrwi:
+				case rv_op_csrrsi:
+				case rv_op_csrrci:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		/* find or build the block at the current program counter */
+		template <typename Q>
+		block_ent& fetch(Q &proc)
+		{
+			typename P::ux pc = proc.pc, fetch_pc = pc, pc_offset;
+			u64 context = block_context(proc, 0);
+			block_ent &blk = blocks[(pc >> 1) & (cache_size - 1)];
+			if (likely(blk.count != 0 && blk.pc == pc && blk.context == context)) {
+				return blk;
+			}
+
+			/* the entry stays empty if the first fetch traps */
+			blk.count = 0;
+			blk.pc = pc;
+			blk.context = context;
+			typename P::ux page_offset;
+			do {
+				inst_t inst = proc.mmu.inst_fetch(proc, fetch_pc, pc_offset);
+				proc.inst_decode(blk.dec[blk.count], inst);
+				blk.inst[blk.count] = inst;
+				blk.length[blk.count] = u8(pc_offset);
+				fetch_pc += pc_offset;
+				page_offset = fetch_pc & (page_size - 1);
+			} while (!block_end(blk.dec[blk.count++].op) && blk.count < block_size &&
+				page_offset != 0 && page_offset <= page_size - 4);
+			if (proc.threaded) {
+				proc.inst_exec_block(blk.dec, blk.handler, nullptr, blk.count);
+			}
+			return blk;
+		}
+
+		/* flush after instructions that may change code or translations */
+		template <typename Q>
+		void sync(Q &proc, typename P::decode_type &dec)
+		{
+			switch (dec.op) {
+				case rv_op_fence_i:
+				case rv_op_sfence_vm:
+					flush();
+					break;
+				case rv_op_csrrw:
+				case rv_op_csrrs:
+				case rv_op_csrrc:
+				case rv_op_csrrwi:
+				case rv_op_csrrsi:
+				case rv_op_csrrci:
+					if (block_root(proc, 0) != root) {
+						root = block_root(proc, 0);
+						flush();
+					}
+					break;
+				default:
+					break;
+			}
+		}
+	};
+
+}
+
+#endif
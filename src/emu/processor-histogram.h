@@ -27,13 +27,13 @@ namespace riscv {
 		}
 
 		hist_pc_map_t hist_pc_reduce;
-		hist_pc_reduce.set_empty_key(0);
-		for (auto ent : proc.hist_pc) {
-			addr_t key = ent.first >> addr_shift;
+		hist_pc_reduce.set_empty_key(-1);
+		proc.hist_pc.for_each([&](addr_t pc, size_t count) {
+			addr_t key = pc >> addr_shift;
 			auto hi = hist_pc_reduce.find(key);
-			if (hi == hist_pc_reduce.end()) hist_pc_reduce.insert(hist_pc_pair_t(key, ent.second));
-			else hi->second += ent.second;
-		}
+			if (hi == hist_pc_reduce.end()) hist_pc_reduce.insert(hist_pc_pair_t(key, count));
+			else hi->second += count;
+		});
 
 		size_t max = 0, total = 0;
 		std::vector<hist_pc_pair_t> hist_pc_s;
@@ -42,6 +42,85 @@ namespace riscv {
 	typedef std::pair<size_t,size_t> hist_reg_pair_t;
 	typedef std::pair<size_t,size_t> hist_inst_pair_t;
 
+	/*
+	 * Program counter histogram
+	 *
+	 * Counters are held in per page arrays with one counter per 16-bit
+	 * instruction parcel. Pages are found through a small direct mapped
+	 * cache of page pointers, so the page map is only consulted when
+	 * execution moves to a page that is not in the cache.
+	 */
+	struct hist_pc_table
+	{
+		enum : size_t {
+			page_shift = 12,
+			parcel_shift = 1,
+			page_counters = (1 << page_shift) >> parcel_shift,
+			cache_size = 64
+		};
+
+		struct hist_page { size_t count[page_counters]; };
+
+		google::dense_hash_map<addr_t,hist_page*> pages;
+		addr_t cache_page[cache_size];
+		hist_page *cache_ptr[cache_size];
+
+		hist_pc_table()
+		{
+			pages.set_empty_key(addr_t(-1));
+			pages.set_deleted_key(addr_t(-2));
+			for (size_t i = 0; i < cache_size; i++) {
+				cache_page[i] = addr_t(-1);
+				cache_ptr[i] = nullptr;
+			}
+		}
+
+		hist_pc_table(const hist_pc_table&) = delete;
+		hist_pc_table& operator=(const hist_pc_table&) = delete;
+
+		~hist_pc_table()
+		{
+			for (auto ent : pages) {
+				delete ent.second;
+			}
+		}
+
+		size_t& operator[](addr_t pc)
+		{
+			addr_t page = pc >> page_shift;
+			size_t slot = page & (cache_size - 1);
+			if (unlikely(cache_page[slot] != page)) {
+				auto pi = pages.find(page);
+				if (pi == pages.end()) {
+					pi = pages.insert(std::pair<addr_t,hist_page*>(page, new hist_page())).first;
+				}
+				cache_page[slot] = page;
+				cache_ptr[slot] = pi->second;
+			}
+			return cache_ptr[slot]->count[(pc & ((1 << page_shift) - 1)) >> parcel_shift];
+		}
+
+		/* call fn(pc, count) for each pc with a non zero count */
+		template <typename F>
+		void for_each(F fn)
+		{
+			for (auto ent : pages) {
+				for (size_t i = 0; i < page_counters; i++) {
+					if (ent.second->count[i] != 0) {
+						fn((ent.first << page_shift) | (addr_t(i) << parcel_shift), ent.second->count[i]);
+					}
+				}
+			}
+		}
+
+		size_t size()
+		{
+			size_t n = 0;
+			for_each([&](addr_t pc, size_t count) { n++; });
+			return n;
+		}
+	};
+
 	template<typename T, typename P, typename M>
 	struct processor_impl : P
 	{
@@ -50,15 +129,13 @@ namespace riscv {
 		typedef M mmu_type;
 
 		mmu_type mmu;
-		hist_pc_map_t hist_pc;
+		hist_pc_table hist_pc;
 		hist_reg_map_t hist_reg;
 		hist_inst_map_t hist_inst;
 		std::function<const char*(addr_t)> symlookup;
 
 		processor_impl() : P()
 		{
-			hist_pc.set_empty_key(0);
-			hist_pc.set_deleted_key(-1);
 			hist_reg.set_empty_key(-1);
 			hist_inst.set_empty_key(-1);
 		}
@@ -97,16 +174,11 @@ namespace riscv {
 
 		size_t histogram_add_pc(addr_t key)
 		{
-			auto hi = hist_pc.find(key);
-			if (hi == hist_pc.end()) {
-				hist_pc.insert(hist_pc_pair_t(key, 1));
-				return 1;
-			} else {
-				if (hi->second < P::hostspot_trace_limit) {
-					hi->second++;
-				}
-				return hi->second;
+			size_t &count = hist_pc[key];
+			if (count < P::hostspot_trace_limit) {
+				count++;
 			}
+			return count;
 		}
 
 		void histogram_add_reg(size_t key)
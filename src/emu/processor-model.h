@@ -42,6 +42,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv32<RV_I>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv32<RV_I>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -61,6 +65,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv32<RV_IMA>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv32<RV_IMA>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -81,6 +89,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv32<RV_IMAC>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv32<RV_IMAC>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -100,6 +112,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv32<RV_IMAFD>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv32<RV_IMAFD>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -120,6 +136,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv32<RV_IMAFDC>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv32<RV_IMAFDC>(*this, dec, handler, length, count);
+		}
 	};
 
 
@@ -142,6 +162,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv64<RV_I>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv64<RV_I>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -161,6 +185,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv64<RV_IMA>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv64<RV_IMA>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -181,6 +209,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv64<RV_IMAC>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv64<RV_IMAC>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -200,6 +232,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv64<RV_IMAFD>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv64<RV_IMAFD>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -220,6 +256,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv64<RV_IMAFDC>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv64<RV_IMAFDC>(*this, dec, handler, length, count);
+		}
 	};
 
 
@@ -242,6 +282,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv128<RV_I>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv128<RV_I>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -261,6 +305,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv128<RV_IMA>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv128<RV_IMA>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -281,6 +329,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv128<RV_IMAC>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv128<RV_IMAC>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -300,6 +352,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv128<RV_IMAFD>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv128<RV_IMAFD>(*this, dec, handler, length, count);
+		}
 	};
 
 	template <typename T, typename P, typename M, typename B = processor_impl<T,P,M>>
@@ -320,6 +376,10 @@ namespace riscv {
 		addr_t inst_exec(T &dec, addr_t pc_offset) {
 			return exec_inst_rv128<RV_IMAFDC>(dec, *this, pc_offset);
 		}
+
+		size_t inst_exec_block(T *dec, const void **handler, const u8 *length, size_t count) {
+			return exec_block_rv128<RV_IMAFDC>(*this, dec, handler, length, count);
+		}
 	};
 
 }
@@ -263,6 +263,35 @@ namespace riscv {
 		std::mutex intr_mutex;
 		std::condition_variable intr_cond;
 
+		/*
+		 * Devices post an event when they may have changed the interrupt
+		 * state of a hart and the run loop checks the flag between blocks.
+		 * isr only evaluates the interrupt sources after an event, while
+		 * a source was pending at the last evaluation, or once the
+		 * earliest timer deadline has passed.
+		 */
+		std::atomic<bool> intr_pending;
+		bool intr_active;
+
+		/*
+		 * In virtual time (inst_per_tick != 0) the clock of a hart is
+		 * derived from its retired instructions, and WFI with no pending
+		 * work advances the clock to the hart's timer deadline by adding
+		 * the skipped instructions to idle_instret.
+		 */
+		u64 inst_per_tick;
+		u64 idle_instret;
+
+		/* harts sharing the memory map and devices, boot hart first */
+		size_t num_harts;
+		std::vector<processor_privileged*> harts;
+
+		/* a remote fence was completed, so the run loop drops its decoded blocks */
+		bool fence_blocks;
+
+		/* hart running in the calling host thread */
+		static thread_local processor_privileged *current_hart;
+
 		const char* name() { return "rv-sys"; }
 
 		const u64 RTC_FREQ = 10000000;
@@ -272,10 +301,16 @@ namespace riscv {
 		const u64 POWERDOWN_DELAY_DEFAULT = 10000;
 		const u64 POWERDOWN_SLEEP_DEFAULT = 1000000;
 
-		processor_privileged() : intr_sleep_time(0), intr_powerdown_delay(1000), pollfds() {}
+		processor_privileged() : intr_sleep_time(0), intr_powerdown_delay(1000), pollfds(),
+			intr_pending(true), intr_active(false), inst_per_tick(0), idle_instret(0),
+			num_harts(1), harts(), fence_blocks(false) {}
 
 		u64 get_time()
 		{
+			if (inst_per_tick) {
+				return (P::instret + idle_instret) / inst_per_tick;
+			}
+
 			/*
 			 * TODO - add hz to config string
 			 * 10MHz is currently hardcoded in BBL
@@ -283,6 +318,25 @@ namespace riscv {
 			return host_cpu::get_instance().get_time_ns() / RTC_DIV;
 		}
 
+		/* virtual clock of the hart's timer deadline in instructions, or the maximum */
+		u64 deadline_instret()
+		{
+			u64 deadline = device_timer->hart_deadline(P::hart_id);
+			if (deadline >= std::numeric_limits<u64>::max() / inst_per_tick) {
+				return std::numeric_limits<u64>::max();
+			}
+			return deadline * inst_per_tick;
+		}
+
+		/* in virtual time steps end at the timer deadline so it is taken on time */
+		size_t step_count(size_t count)
+		{
+			if (!inst_per_tick) return count;
+			u64 deadline = deadline_instret(), now = P::instret + idle_instret;
+			if (deadline <= now) return count;
+			return size_t(std::min(u64(count), deadline - now));
+		}
+
 		std::string create_config_string()
 		{
 			typename P::ux ram_base = 0;
@@ -316,15 +370,16 @@ ram {
     size 0x%x;
   };
 };
-core {
-  0 {
+core {)CONFIG";
+			static const char* kCoreFormat =
+R"CONFIG(
+  %d {
     0 {
       isa rv64imafd;
       ipi 0x%x;
       timecmp 0x%x;
     };
-  };
-};)CONFIG";
+  };)CONFIG";
 			std::string cfg_str;
 			sprintf(cfg_str, kConfigFormat,
 				device_rtc->mpa,
@@ -332,9 +387,13 @@ core {
 				device_uart->mpa,
 				device_htif->mpa,
 				device_htif->mpa + 8,
-				ram_base, ram_size,
-				device_mipi->mpa,
-				device_timer->mpa);
+				ram_base, ram_size);
+			for (size_t i = 0; i < num_harts; i++) {
+				sprintf(cfg_str, kCoreFormat, i,
+					device_mipi->mpa + i * sizeof(u32),
+					device_timer->mpa + i * sizeof(u64));
+			}
+			cfg_str.append("\n};");
 			return cfg_str;
 		}
 
@@ -356,6 +415,12 @@ core {
 			device_rand = std::make_shared<rand_mmio_device<processor_privileged>>(*this, 0x40006000);
 			device_htif = std::make_shared<htif_mmio_device<processor_privileged>>(*this, 0x40008000, console);
 			device_config = std::make_shared<config_mmio_device<processor_privileged>>(*this, 0x4000f000);
+			if (num_harts < 1 || num_harts > size_t(device_mipi->num_harts) ||
+				num_harts > size_t(device_timer->num_harts))
+			{
+				panic("error: number of harts must be between 1 and %d",
+					std::min(int(device_mipi->num_harts), int(device_timer->num_harts)));
+			}
 			device_string  = std::make_shared<string_mmio_device<processor_privileged>>(*this, 0x40010000, create_config_string());
 
 			if (P::log & proc_log_config) {
@@ -375,10 +440,121 @@ core {
 			P::mmu.mem->add_segment(device_htif);
 			P::mmu.mem->add_segment(device_config);
 			P::mmu.mem->add_segment(device_string);
+
+			/* the boot hart runs in the thread that initializes it */
+			harts.assign(1, this);
+			current_hart = this;
+		}
+
+		/* secondary harts share the memory map and devices of the boot hart */
+		void init_secondary(processor_privileged &boot, u16 hart_id)
+		{
+			P::misa = P::misa_default;
+			P::hart_id = hart_id;
+			P::mhartid = hart_id;
+			P::mmu.mem = boot.mmu.mem;
+			console = boot.console;
+			device_sbi = boot.device_sbi;
+			device_boot = boot.device_boot;
+			device_rtc = boot.device_rtc;
+			device_mipi = boot.device_mipi;
+			device_plic = boot.device_plic;
+			device_uart = boot.device_uart;
+			device_timer = boot.device_timer;
+			device_gpio = boot.device_gpio;
+			device_rand = boot.device_rand;
+			device_htif = boot.device_htif;
+			device_config = boot.device_config;
+			device_string = boot.device_string;
+			num_harts = boot.num_harts;
+			inst_per_tick = boot.inst_per_tick;
+		}
+
+		/* wake a hart waiting for interrupt */
+		void wake_hart(size_t hart_id)
+		{
+			if (hart_id >= harts.size()) return;
+			processor_privileged *hart = harts[hart_id];
+			std::lock_guard<std::mutex> intr_lock(hart->intr_mutex);
+			hart->intr_cond.notify_one();
+		}
+
+		/* post an interrupt event to a hart */
+		void post_interrupt(size_t hart_id)
+		{
+			if (hart_id >= harts.size()) return;
+			harts[hart_id]->intr_pending.store(true, std::memory_order_release);
+			wake_hart(hart_id);
 		}
 
+		/* complete the fences requested of this hart by another hart's SBI call */
+		void remote_fence(u32 fences)
+		{
+			typedef mipi_mmio_device<processor_privileged> mipi_type;
+			if (fences & mipi_type::fence_vm) {
+				P::mmu.l1_itlb.flush(P::pdid);
+				P::mmu.l1_dtlb.flush(P::pdid);
+				P::mmu.pwc.flush();
+			}
+			if (fences & mipi_type::fence_i) {
+				flush_icache(P::mmu, 0);
+			}
+			if (fences) fence_blocks = true;
+		}
+
+		/* interrupt enables changed, re-evaluate if a source is pending */
+		void enables_changed()
+		{
+			if (intr_active) intr_pending.store(true, std::memory_order_relaxed);
+		}
+
+		/* stop all harts at the end of their current step */
+		void stop_harts()
+		{
+			for (auto hart : harts) {
+				hart->running = false;
+			}
+			for (size_t i = 0; i < harts.size(); i++) {
+				wake_hart(i);
+			}
+		}
+
+		/* power off requested by a device, the requesting hart stops immediately */
+		void poweroff()
+		{
+			stop_harts();
+			current_hart->raise(P::internal_cause_poweroff, current_hart->pc);
+		}
+
+		template <typename M>
+		auto print_cache_stats(M &mmu, int) -> decltype(mmu.print_cache_stats(0))
+		{
+			mmu.print_cache_stats(P::instret);
+		}
+
+		template <typename M>
+		void print_cache_stats(M &mmu, long) {}
+
+		/* dirty data lines are written back and instruction cache lines are refetched after fence.i */
+		template <typename M>
+		auto flush_icache(M &mmu, int) -> decltype(mmu.sync_icache(), void())
+		{
+			mmu.sync_icache();
+		}
+
+		template <typename M>
+		void flush_icache(M &mmu, long) {}
+
 		void exit(int rc)
 		{
+			/* print cache statistics */
+			if (P::log & proc_log_cache_stats) {
+				printf("\n");
+				printf("cache statistics\n");
+				printf("~~~~~~~~~~~~~~~~\n");
+				print_cache_stats(P::mmu, 0);
+			}
+
 			if (!(P::log & proc_log_exit_stats)) ::exit(rc);
 
 			/* print integer register file */
@@ -399,6 +575,12 @@ core {
 			printf("~~~~~~~~~~~~~~~~~~~\n");
 			print_device_registers();
 
+			/* TLB statistics */
+			printf("\n");
+			printf("tlb statistics\n");
+			printf("~~~~~~~~~~~~~~\n");
+			P::mmu.print_tlb_stats();
+
 			/* print program counter histogram */
 			if (P::log & proc_log_hist_pc) {
 				printf("\n");
@@ -424,34 +606,23 @@ core {
 				histogram_inst(*this, false);
 				printf("\n");
 			}
-                        /* print cache statistics */
-                        if(P:: log & proc_log_cache_stats) {
-                                printf("\n");
-                                printf("cache statistics\n");
-                                printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~\n");
-                                u64 memVal; P::mmu.mem->load(0xC0000000,memVal);
-                                printf("Number of loads/reads from the cache: %lld\n", memVal);
-                                P::mmu.mem->load(0xC0000008,memVal);
-                                printf("Number of stores/writes to the cache: %lld\n", memVal);
-                                P::mmu.mem->load(0xC0000010,memVal);
-                                printf("Number of cache hits: %lld\n", memVal);
-                                P::mmu.mem->load(0xC0000018,memVal);
-                                printf("Number of cache misses: %lld\n", memVal);
-                                P::mmu.mem->load(0xC0000020,memVal);
-                                printf("Number of cache lines evicted: %lld\n", memVal);
-                                u64 hits, loads, stores;
-                                P::mmu.mem->load(0xC0000000, loads);
-                                P::mmu.mem->load(0xC0000008, stores);
-                                P::mmu.mem->load(0xC0000010, hits);
-                                printf("Overall hit rate for the cache: %lf\%%\n", ((double)(hits)) / (loads + stores) * 100); 
-                                printf("\n");
-                        }
 		}
 
 		void wait_for_interrupt()
 		{
 			auto &cpu = host_cpu::get_instance();
 
+			/* skip idle time in virtual time, unless only an event can wake the hart */
+			if (inst_per_tick) {
+				if (intr_pending.load(std::memory_order_relaxed) || intr_active) return;
+				u64 deadline = deadline_instret(), now = P::instret + idle_instret;
+				if (deadline != std::numeric_limits<u64>::max()) {
+					if (deadline > now) idle_instret += deadline - now;
+					intr_pending.store(true, std::memory_order_relaxed);
+					return;
+				}
+			}
+
 			/* get time in nanoseconds */
 			u64 t = cpu.get_time_ns();
 
@@ -461,10 +632,12 @@ core {
 				return;
 			}
 
-			/* sleep on interrupt condition variable */
+			/* sleep on interrupt condition variable until an event is posted */
 			std::unique_lock<std::mutex> intr_lock(intr_mutex);
 			if (intr_cond.wait_for(intr_lock, std::chrono::nanoseconds
-				(POWERDOWN_SLEEP_DEFAULT)) == std::cv_status::no_timeout)
+				(POWERDOWN_SLEEP_DEFAULT), [this] {
+					return intr_pending.load(std::memory_order_acquire) || !P::running;
+				}))
 			{
 				intr_powerdown_delay = POWERDOWN_DELAY_INTERRUPT;
 			} else {
@@ -612,6 +785,16 @@ core {
 			}
 		}
 
+		/*
+		 * invalidate the inline translation tags in the data TLB whenever
+		 * the privilege mode, mstatus or sptbr change, as the tags cache
+		 * the outcome of permission checks made in the previous context
+		 */
+		void flush_host_tlb()
+		{
+			P::mmu.l1_dtlb.flush_host();
+		}
+
 		addr_t inst_csr(typename P::decode_type &dec, int op, int csr, typename P::ux value, addr_t pc_offset)
 		{
 			/*
@@ -690,15 +873,19 @@ core {
 				case rv_csr_mimpid:   P::get_csr(dec, P::mode, op, csr, P::mimpid, value);     break;
 				case rv_csr_mhartid:  P::get_csr(dec, P::mode, op, csr, P::mhartid, value);    break;
 				case rv_csr_mstatus:  P::set_csr(dec, P::mode, op, csr, P::mstatus.xu.val, value,
-				                             mstatus_wmask, mstatus_rmask);                    break;
+				                             mstatus_wmask, mstatus_rmask);
+				                      enables_changed();
+				                      flush_host_tlb();                                        break;
 				case rv_csr_mtvec:    P::set_csr(dec, P::mode, op, csr, P::mtvec, value,
 					                         tvec_rmask, tvec_wmask);                          break;
 				case rv_csr_medeleg:  P::set_csr(dec, P::mode, op, csr, P::medeleg, value);    break;
 				case rv_csr_mideleg:  P::set_csr(dec, P::mode, op, csr, P::mideleg, value);    break;
 				case rv_csr_mip:      P::set_csr(dec, P::mode, op, csr, P::mip.xu.val, value,
-				                             mi_mask, mi_mask);                                break;
+				                             mi_mask, mi_mask);
+				                      intr_pending = true;                                     break;
 				case rv_csr_mie:      P::set_csr(dec, P::mode, op, csr, P::mie.xu.val, value,
-				                             mi_mask, mi_mask);                                break;
+				                             mi_mask, mi_mask);
+				                      enables_changed();                                       break;
 				case rv_csr_mhcounteren: P::set_csr(dec, P::mode, op, csr, P::mhcounteren.xu.val, value); break;
 				case rv_csr_mscounteren: P::set_csr(dec, P::mode, op, csr, P::mscounteren.xu.val, value); break;
 				case rv_csr_mucounteren: P::set_csr(dec, P::mode, op, csr, P::mucounteren.xu.val, value); break;
@@ -717,20 +904,26 @@ core {
 				case rv_csr_mcycleh:  P::set_csr_hi(dec, P::mode, op, csr, P::instret, value); break;
 				case rv_csr_minstreth:P::set_csr_hi(dec, P::mode, op, csr, P::instret, value); break;
 				case rv_csr_sstatus:  P::set_csr(dec, P::mode, op, csr, P::mstatus.xu.val, value,
-				                             sstatus_wmask, sstatus_rmask);                    break;
+				                             sstatus_wmask, sstatus_rmask);
+				                      enables_changed();
+				                      flush_host_tlb();                                        break;
 				case rv_csr_stvec:    P::set_csr(dec, P::mode, op, csr, P::stvec, value,
 					                         tvec_rmask, tvec_wmask);                          break;
 				case rv_csr_sedeleg:  P::set_csr(dec, P::mode, op, csr, P::sedeleg, value);    break;
 				case rv_csr_sideleg:  P::set_csr(dec, P::mode, op, csr, P::sideleg, value);    break;
 				case rv_csr_sip:      P::set_csr(dec, P::mode, op, csr, P::mip.xu.val, value,
-				                             si_mask, si_mask);                                break;
+				                             si_mask, si_mask);
+				                      intr_pending = true;                                     break;
 				case rv_csr_sie:      P::set_csr(dec, P::mode, op, csr, P::mie.xu.val, value,
-				                             si_mask, si_mask);                                break;
+				                             si_mask, si_mask);
+				                      enables_changed();                                       break;
 				case rv_csr_sscratch: P::set_csr(dec, P::mode, op, csr, P::sscratch, value);   break;
 				case rv_csr_sepc:     P::set_csr(dec, P::mode, op, csr, P::sepc, value);       break;
 				case rv_csr_scause:   P::set_csr(dec, P::mode, op, csr, P::scause, value);     break;
 				case rv_csr_sbadaddr: P::set_csr(dec, P::mode, op, csr, P::sbadaddr, value);   break;
-				case rv_csr_sptbr:    P::set_csr(dec, P::mode, op, csr, P::sptbr, value);      break;
+				case rv_csr_sptbr:    P::set_csr(dec, P::mode, op, csr, P::sptbr, value);
+				                      P::mmu.pwc.flush();
+				                      flush_host_tlb();                                        break;
 				default: return -1; /* illegal instruction */
 			}
 			return pc_offset;
@@ -751,6 +944,8 @@ core {
 						P::mstatus.r.spp = rv_mode_U;
 						P::mstatus.r.sie = P::mstatus.r.spie;
 						P::mstatus.r.spie = 0;
+						enables_changed();
+						flush_host_tlb();
 						return P::sepc - P::pc;
 					} else {
 						return -1; /* illegal instruction */
@@ -761,6 +956,8 @@ core {
 						P::mstatus.r.mpp = rv_mode_U;
 						P::mstatus.r.mie = P::mstatus.r.mpie;
 						P::mstatus.r.mpie = 0;
+						enables_changed();
+						flush_host_tlb();
 						return P::mepc - P::pc;
 					} else {
 						return -1; /* illegal instruction */
@@ -769,6 +966,7 @@ core {
 					if (P::mode >= rv_mode_S) {
 						P::mmu.l1_itlb.flush(P::pdid, P::sptbr >> P::mmu_type::tlb_type::ppn_bits);
 						P::mmu.l1_dtlb.flush(P::pdid, P::sptbr >> P::mmu_type::tlb_type::ppn_bits);
+						P::mmu.pwc.flush();
 						return pc_offset;
 					} else {
 						return -1; /* illegal instruction */
@@ -776,6 +974,9 @@ core {
 				case rv_op_wfi:
 					if (P::mode >= rv_mode_S) {
 						wait_for_interrupt();
+						if (!P::running) {
+							P::raise(P::internal_cause_poweroff, P::pc);
+						}
 						return pc_offset;
 					} else {
 						return -1; /* illegal instruction */
@@ -783,6 +984,7 @@ core {
 				case rv_op_fence:
 					return pc_offset;
 				case rv_op_fence_i:
+					flush_icache(P::mmu, 0);
 					return pc_offset;
 				default: break;
 			}
@@ -798,6 +1000,7 @@ core {
 			P::mstatus.r.sie = 0;
 			P::mode = rv_mode_S;
 			P::pc = P::stvec;
+			flush_host_tlb();
 			if (P::debugging && (P::log & proc_log_trap_cli)) {
 				P::raise(P::internal_cause_cli, P::pc);
 			}
@@ -812,6 +1015,7 @@ core {
 			P::mstatus.r.mie = 0;
 			P::mode = rv_mode_M;
 			P::pc = P::mtvec;
+			flush_host_tlb();
 			if (P::debugging && (P::log & proc_log_trap_cli)) {
 				P::raise(P::internal_cause_cli, P::pc);
 			}
@@ -819,17 +1023,31 @@ core {
 
 		void isr()
 		{
+			/* nothing can have become pending without an event or a timer deadline */
+			bool event = intr_pending.exchange(false, std::memory_order_acquire);
+			if (event) remote_fence(device_mipi->claim_fences(P::hart_id));
+			P::time = get_time();
+			if (!event && !intr_active && P::time < device_timer->deadline()) {
+				return;
+			}
+			intr_active = true;
+
+			/* external interrupts and the console are routed to the boot hart */
+			bool boot_hart = (P::hart_id == 0);
+
 			/* service all external devices connected to the PLIC */
 
-			device_uart->service();
-			device_gpio->service();
+			if (boot_hart) {
+				device_uart->service();
+				device_gpio->service();
+			}
 
 			/*
 			 * service external interrupts from the PLIC if enabled
 			 */
 
 			/* NOTE: delegation is implicit based on enable bits in this model */
-			bool eip = device_plic->irq_pending();
+			bool eip = boot_hart && device_plic->irq_pending();
 			if (eip) {
 				P::mip.r.meip = 1;
 				P::mip.r.seip = 1;
@@ -850,7 +1068,6 @@ core {
 			 */
 
 			/* NOTE: delegation is implicit based on enable bits in this model */
-			device_rtc->update_time(P::time);
 			bool tip = device_timer->timer_pending(P::hart_id, P::time);
 			if (tip) {
 				P::mip.r.mtip = 1;
@@ -872,7 +1089,7 @@ core {
 			 */
 
 			/* NOTE: delegation is implicit based on enable bits in this model */
-			bool sip = device_mipi->ipi_pending(P::hart_id) || console->has_char();
+			bool sip = device_mipi->ipi_pending(P::hart_id) || (boot_hart && console->has_char());
 			if (sip) {
 				P::mip.r.msip = 1;
 				P::mip.r.ssip = 1;
@@ -888,6 +1105,7 @@ core {
 				P::mip.r.ssip = 0;
 			}
 
+			intr_active = eip || tip || sip;
 		}
 
 		void debug_enter()
@@ -957,7 +1175,7 @@ core {
 			/* if reqeusted, terminate and dump register state */
 			if (terminate) {
 				exit(0);
-				P::running = false;
+				stop_harts();
 				return;
 			}
 
@@ -1017,10 +1235,14 @@ core {
 			P::mstatus.r.mie = 0;
 			P::mcause = 0;
 			P::pc = P::resetvec;
+			flush_host_tlb();
 		}
 
 	};
 
+	template <typename P>
+	thread_local processor_privileged<P>* processor_privileged<P>::current_hart = nullptr;
+
 }
 
 #endif
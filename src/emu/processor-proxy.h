@@ -7,17 +7,146 @@
 
 namespace riscv {
 
+	/*
+	 * Guest threads
+	 *
+	 * Threads created by clone share the proxy address space and each
+	 * runs its own processor and run loop in a host thread. Futexes are
+	 * guest words in host memory so waiters queue on the host address.
+	 * Run loops that can not run in more than one thread leave create
+	 * unset and clone fails with ENOSYS.
+	 */
+
+	template <typename P>
+	struct proxy_threads
+	{
+		struct futex_waiter
+		{
+			addr_t addr;
+			bool woken;
+			std::condition_variable cond;
+		};
+
+		std::atomic<int> next_tid;
+		std::mutex futex_lock;
+		std::list<futex_waiter*> futex_waiters;
+		std::function<std::shared_ptr<P>()> create;
+		std::function<void(std::shared_ptr<P>)> start;
+
+		proxy_threads() : next_tid(1) {}
+
+		/* guest threads run in processor_runloop Q */
+		template <typename Q>
+		void set_runloop()
+		{
+			create = [] {
+				return std::shared_ptr<P>(std::make_shared<Q>());
+			};
+			start = [] (std::shared_ptr<P> proc) {
+				std::thread([proc] {
+					Q *q = static_cast<Q*>(proc.get());
+					fenv_init();
+					fenv_setrm((q->fcsr >> 5) & 0x7);
+					q->init();
+					block_signals();
+					q->run();
+				}).detach();
+			};
+		}
+
+		/* asynchronous signals are delivered to the main thread */
+		static void block_signals()
+		{
+			sigset_t set;
+			sigemptyset(&set);
+			sigaddset(&set, SIGTERM);
+			sigaddset(&set, SIGQUIT);
+			sigaddset(&set, SIGINT);
+			sigaddset(&set, SIGHUP);
+			sigaddset(&set, SIGUSR1);
+			if (pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) {
+				panic("proxy_threads: can't set thread signal mask: %s",
+					strerror(errno));
+			}
+		}
+
+		/* sleep while the futex word holds val, until woken or the deadline */
+		template <typename C>
+		int futex_wait(addr_t addr, s32 val, const typename C::time_point *deadline)
+		{
+			std::unique_lock<std::mutex> guard(futex_lock);
+			if (__atomic_load_n((s32*)addr, __ATOMIC_SEQ_CST) != val) {
+				return -EAGAIN;
+			}
+			futex_waiter waiter;
+			waiter.addr = addr;
+			waiter.woken = false;
+			auto wi = futex_waiters.insert(futex_waiters.end(), &waiter);
+			if (deadline) {
+				waiter.cond.wait_until(guard, *deadline, [&] { return waiter.woken; });
+			} else {
+				waiter.cond.wait(guard, [&] { return waiter.woken; });
+			}
+			if (!waiter.woken) {
+				futex_waiters.erase(wi);
+				return -ETIMEDOUT;
+			}
+			return 0;
+		}
+
+		/* wake up to count waiters on the futex word, in the order they slept */
+		int futex_wake(addr_t addr, int count)
+		{
+			std::lock_guard<std::mutex> guard(futex_lock);
+			int woken = 0;
+			for (auto wi = futex_waiters.begin(); wi != futex_waiters.end() && woken < count;) {
+				if ((*wi)->addr == addr) {
+					(*wi)->woken = true;
+					(*wi)->cond.notify_one();
+					wi = futex_waiters.erase(wi);
+					woken++;
+				} else {
+					wi++;
+				}
+			}
+			return woken;
+		}
+	};
+
 	/* Processor ABI/AEE proxy emulator that delegates ecall to an abi proxy */
 
 	template <typename P>
 	struct processor_proxy : P
 	{
-		int set_child_tid;
-		int clear_child_tid;
+		typedef proxy_threads<processor_proxy<P>> threads_type;
+
+		std::shared_ptr<threads_type> threads;
+		int tid;
+		addr_t clear_child_tid;
+
+		/* called before the host kernel writes guest memory in a syscall */
+		std::function<void(addr_t,size_t)> guest_write;
+
+		processor_proxy() : tid(0), clear_child_tid(0) {}
 
 		const char* name() { return "rv-sim"; }
 
-		void init() {}
+		void init()
+		{
+			if (!threads) threads = std::make_shared<threads_type>();
+			if (!tid) tid = threads->next_tid++;
+		}
+
+		/* allow clone to start threads running in processor_runloop Q */
+		template <typename Q>
+		void enable_threads()
+		{
+			init();
+			threads->template set_runloop<Q>();
+		}
+
+		/* main thread of the process, exiting it exits the process */
+		bool main_thread() { return tid == 1; }
 
 		void exit(int rc)
 		{
@@ -112,6 +241,7 @@ namespace riscv {
 				case rv_op_csrrwi: return inst_csr(dec, csr_rw, dec.imm, dec.rs1, pc_offset);
 				case rv_op_csrrsi: return inst_csr(dec, csr_rs, dec.imm, dec.rs1, pc_offset);
 				case rv_op_csrrci: return inst_csr(dec, csr_rc, dec.imm, dec.rs1, pc_offset);
+				case rv_op_fence_i: return pc_offset; /* runloop flushes decoded blocks */
 				default: break;
 			}
 			return -1; /* illegal instruction */
@@ -7,14 +7,15 @@
 
 namespace riscv {
 
-	/* Simple processor stepper with instruction cache */
+	/* Simple processor stepper with instruction and block caches */
 
+	/* each hart thread dispatches its own synchronous signals */
 	struct processor_singleton
 	{
-		static processor_singleton *current;
+		static thread_local processor_singleton *current;
 	};
 
-	processor_singleton* processor_singleton::current = nullptr;
+	thread_local processor_singleton* processor_singleton::current = nullptr;
 
 	template <typename P>
 	struct processor_runloop : processor_singleton, P
@@ -31,6 +32,7 @@ namespace riscv {
 		};
 
 		rv_inst_cache_ent inst_cache[inst_cache_size];
+		block_cache<P> blocks;
 
 		processor_runloop() : cli(std::make_shared<debug_cli<P>>()), inst_cache() {}
 		processor_runloop(std::shared_ptr<debug_cli<P>> cli) : cli(cli), inst_cache() {}
@@ -93,6 +95,58 @@ namespace riscv {
 			P::init();
 		}
 
+		/* the cache model sees every fetch, except between sampled windows */
+		template <typename M>
+		static auto fetch_each_inst(M &mmu, int) -> decltype(mmu.detailed, bool())
+		{
+			return mmu.detailed;
+		}
+
+		template <typename M>
+		static bool fetch_each_inst(M &mmu, long) { return false; }
+
+		/* steps end at sampling phase changes */
+		template <typename M>
+		static auto sample_count(M &mmu, u64 instret, size_t count, int) -> decltype(mmu.sample(instret, count))
+		{
+			return mmu.sample(instret, count);
+		}
+
+		template <typename M>
+		static size_t sample_count(M &mmu, u64 instret, size_t count, long) { return count; }
+
+		/* steps end at the timer deadline in virtual time */
+		template <typename Q>
+		static auto step_count(Q &proc, size_t count, int) -> decltype(proc.step_count(count))
+		{
+			return proc.step_count(count);
+		}
+
+		template <typename Q>
+		static size_t step_count(Q &proc, size_t count, long) { return count; }
+
+		/* steps end early when a device posts an interrupt event */
+		template <typename Q>
+		static auto intr_posted(Q &proc, int) -> decltype(proc.intr_pending.load(), bool())
+		{
+			return proc.intr_pending.load(std::memory_order_relaxed);
+		}
+
+		template <typename Q>
+		static bool intr_posted(Q &proc, long) { return false; }
+
+		/* decoded blocks are dropped after the interrupt service routine completes a remote fence */
+		template <typename Q>
+		static auto remote_fenced(Q &proc, int) -> decltype(proc.fence_blocks, bool())
+		{
+			bool fenced = proc.fence_blocks;
+			proc.fence_blocks = false;
+			return fenced;
+		}
+
+		template <typename Q>
+		static bool remote_fenced(Q &proc, long) { return false; }
+
 		void run(exit_cause ex = exit_cause_continue)
 		{
 			u32 logsave = P::log;
@@ -100,6 +154,8 @@ namespace riscv {
 			for (;;) {
 				switch (ex) {
 					case exit_cause_continue:
+						/* another hart may have powered off the node */
+						if (!P::running) return;
 						break;
 					case exit_cause_cli:
 						P::debugging = true;
@@ -115,7 +171,7 @@ namespace riscv {
 					case exit_cause_poweroff:
 						return;
 				}
-				ex = step(count);
+				ex = step(step_count(*this, sample_count(P::mmu, P::instret, count, 0), 0));
 				if (P::debugging && ex == exit_cause_continue) {
 					ex = exit_cause_cli;
 				}
@@ -130,8 +186,8 @@ namespace riscv {
 			inst_t inst = 0, inst_cache_key;
 
 			/* interrupt service routine */
-			P::time = cpu_cycle_clock();
 			P::isr();
+			if (remote_fenced(*this, 0)) blocks.flush();
 
 			/* trap return path */
 			int cause;
@@ -156,24 +212,60 @@ namespace riscv {
                                 if (P::pc == P::breakpoint && P::breakpoint != 0) {
 					return exit_cause_cli;
 				}
-				inst = P::mmu.inst_fetch(*this, P::pc, pc_offset);
-				inst_cache_key = inst % inst_cache_size;
-				if (inst_cache[inst_cache_key].inst == inst) {
-					dec = inst_cache[inst_cache_key].dec;
-				} else {
-					P::inst_decode(dec, inst);
-					inst_cache[inst_cache_key].inst = inst;
-					inst_cache[inst_cache_key].dec = dec;
+				if (unlikely(intr_posted(*this, 0)) && !P::debugging) {
+					return exit_cause_continue;
+				}
+
+				/* the pc histogram and the cache model see every fetch so bypass the block cache */
+				if ((P::log & proc_log_hist_pc) || fetch_each_inst(P::mmu, 0)) {
+					inst = P::mmu.inst_fetch(*this, P::pc, pc_offset);
+					inst_cache_key = inst % inst_cache_size;
+					if (inst_cache[inst_cache_key].inst == inst) {
+						dec = inst_cache[inst_cache_key].dec;
+					} else {
+						P::inst_decode(dec, inst);
+						inst_cache[inst_cache_key].inst = inst;
+						inst_cache[inst_cache_key].dec = dec;
+					}
+					if ((new_offset = P::inst_exec(dec, pc_offset)) != typename P::ux(-1)  ||
+						(new_offset = P::inst_priv(dec, pc_offset)) != typename P::ux(-1))
+					{
+						if (P::log) P::print_log(dec, inst);
+						P::pc += new_offset;
+						P::instret++;
+					} else {
+						P::raise(rv_cause_illegal_instruction, P::pc);
+					}
+					blocks.sync(*this, dec);
+					continue;
 				}
-				if ((new_offset = P::inst_exec(dec, pc_offset)) != typename P::ux(-1)  ||
-					(new_offset = P::inst_priv(dec, pc_offset)) != typename P::ux(-1))
+
+				/* execute until the block ends or leaves the fall through path */
+				auto &blk = blocks.fetch(*this);
+				size_t i = 0;
+				if (P::threaded && !(P::log & blocks.inst_log_mask) && P::breakpoint == 0 &&
+					typename P::ux(inststop - P::instret) >= blk.count)
 				{
-					if (P::log) P::print_log(dec, inst);
-					P::pc += new_offset;
-					P::instret++;
-				} else {
-					P::raise(rv_cause_illegal_instruction, P::pc);
+					/* stops before instructions it has no handler for */
+					i = P::inst_exec_block(blk.dec, blk.handler, blk.length, blk.count);
+					if (i == blk.count) continue;
+				}
+				for (; i < blk.count; i++) {
+					dec = blk.dec[i];
+					pc_offset = blk.length[i];
+					if ((new_offset = P::inst_exec(dec, pc_offset)) != typename P::ux(-1)  ||
+						(new_offset = P::inst_priv(dec, pc_offset)) != typename P::ux(-1))
+					{
+						if (P::log) P::print_log(dec, blk.inst[i]);
+						P::pc += new_offset;
+						P::instret++;
+					} else {
+						P::raise(rv_cause_illegal_instruction, P::pc);
+					}
+					if (new_offset != pc_offset || P::instret == inststop ||
+						(P::pc == P::breakpoint && P::breakpoint != 0)) break;
 				}
+				blocks.sync(*this, dec);
 			}
 			return exit_cause_continue;
 		}
@@ -13,6 +13,12 @@ namespace riscv {
 	 * protection domain and address space tagged virtual to physical mapping with page attributes
 	 *
 	 * tlb[PDID:ASID:VPN] = PPN:PTE.bits:PMA
+	 *
+	 * Entries mapping directly accessible main memory additionally carry
+	 * page aligned load and store tags and a host address addend, so that
+	 * JIT emitted code can translate with a single compare and add. The
+	 * tags are only valid for the translation context (privilege mode,
+	 * mstatus and sptbr) that filled them and are cleared by flush_host.
 	 */
 
 	template <typename PARAM>
@@ -42,7 +48,13 @@ namespace riscv {
 		UX      ptel : ptel_bits;      /* PTE Level */
 		UX      pteb : pteb_bits;      /* PTE Bits */
 		pdid_t  pdid;                  /* Protection Domain Identifier */
+		u32     gen;                   /* Flush epoch when inserted */
 		pma_t   pma;                   /* Physical Memory Attributes copy */
+		UX      ltag;                  /* Host load tag (page VA or invalid_tag) */
+		UX      stag;                  /* Host store tag (page VA or invalid_tag) */
+		uintptr_t addend;              /* Host address minus VA */
+
+		static const UX invalid_tag = UX(-1);
 
 		tagged_tlb_entry() :
 			ppn(ppn_limit),
@@ -51,7 +63,11 @@ namespace riscv {
 			ptel(0),
 			pteb(0),
 			pdid(0),
-			pma(0) {}
+			gen(0),
+			pma(0),
+			ltag(invalid_tag),
+			stag(invalid_tag),
+			addend(0) {}
 
 		tagged_tlb_entry(UX pdid, UX asid, UX vpn, UX ptel, UX pteb, UX ppn) :
 			ppn(ppn),
@@ -60,74 +76,378 @@ namespace riscv {
 			ptel(ptel),
 			pteb(pteb),
 			pdid(pdid),
-			pma(0) {}
+			gen(0),
+			pma(0),
+			ltag(invalid_tag),
+			stag(invalid_tag),
+			addend(0) {}
 	};
 
 
 	/*
 	 * tagged_tlb
 	 *
-	 * protection domain and address space tagged direct mapped tlb
+	 * protection domain and address space tagged set associative tlb
 	 *
 	 * tlb[PDID:ASID:VPN] = PPN:PTE.bits:PMA
+	 *
+	 * Page entries are held in sets of tlb_ways entries kept in most recently
+	 * used order, so way 0 of each set is laid out as a direct mapped table
+	 * with a stride of tlb_ways entries for the JIT inline translation probe.
+	 * Entries evicted from a set move to a small fully associative victim
+	 * buffer. Superpage entries (ptel > 0) are held at their real size in a
+	 * separate fully associative array with the VPN truncated to the level.
+	 * The inline probe does not search that array, so host tags for a
+	 * superpage are set on a page sized alias installed in way 0 instead.
+	 *
+	 * Entries are invalidated by generation rather than by rewriting them.
+	 * Each flush advances the epoch and records it as the global flush epoch,
+	 * or as the flush epoch of an ASID slot (ASIDs hashed into asid_slots),
+	 * and an entry is only valid if it was inserted at or after both. This
+	 * makes sfence.vm O(1), except that entries holding JIT host tags are
+	 * cleared so that inline translation can not use a flushed entry.
+	 * Host tagged entries only move within the set of their VPN and the
+	 * victim buffer, so the sets tagged since the last host flush are
+	 * recorded and flush_host only clears those sets and the small victim
+	 * buffer, rather than the whole TLB.
+	 *
+	 * The hit, miss and walk counters only count lookups made by the MMU,
+	 * not translations made inline by JIT emitted code.
 	 */
 
-	template <const size_t tlb_size, typename PARAM>
+	template <const size_t tlb_size, typename PARAM,
+		const size_t tlb_ways = 2, const size_t victim_size = 8, const size_t super_size = 16>
 	struct tagged_tlb
 	{
 		static_assert(ispow2(tlb_size), "tlb_size must be a power of 2");
+		static_assert(ispow2(tlb_ways) && tlb_ways <= tlb_size, "tlb_ways must be a power of 2 <= tlb_size");
+		static_assert(ispow2(victim_size), "victim_size must be a power of 2");
+		static_assert(ispow2(super_size), "super_size must be a power of 2");
 
 		typedef typename PARAM::UX UX;
 		typedef tagged_tlb_entry<PARAM> tlb_entry_t;
 
 		enum : UX {
 			size = tlb_size,
-			shift = ctz_pow2(size),
+			ways = tlb_ways,
+			sets = tlb_size / tlb_ways,
+			shift = ctz_pow2(sets),
 			mask = (1ULL << shift) - 1,
 			key_size = sizeof(tlb_entry_t),
 			asid_bits = PARAM::asid_bits,
-			ppn_bits = PARAM::ppn_bits
+			ppn_bits = PARAM::ppn_bits,
+			level_bits = sizeof(UX) == 4 ? 10 : 9, /* sv32 or sv39/sv48 VPN bits per level */
+			asid_slots = 256
 		};
 
 		// TODO - map TLB to machine address space with user_memory::add_segment
 
 		tlb_entry_t tlb[size];
+		tlb_entry_t victim[victim_size];
+		tlb_entry_t super[super_size];
+		size_t victim_next;
+		size_t super_next;
+		u32 epoch;                      /* current epoch */
+		u32 global_flush;               /* epoch of the last global flush */
+		u32 asid_flush[asid_slots];     /* epoch of the last flush of each ASID slot */
+		bool host_tags;                 /* entries may hold JIT host tags */
+		size_t host_sets[sets];         /* sets tagged since the last host flush */
+		size_t host_set_count;          /* recorded sets, all sets if sets or more */
 
-		tagged_tlb() : tlb() {}
+		/* statistics */
 
-		void flush(UX pdid)
+		u64 hits;          /* lookups that found an entry */
+		u64 victim_hits;   /* hits in the victim buffer */
+		u64 super_hits;    /* hits in the superpage array */
+		u64 misses;        /* lookups that found no entry */
+		u64 walks;         /* page table walks by the MMU */
+		u64 flushes;       /* flush operations */
+
+		tagged_tlb() : tlb(), victim(), super(), victim_next(0), super_next(0),
+			epoch(1), global_flush(1), asid_flush(), host_tags(false),
+			host_sets(), host_set_count(0),
+			hits(0), victim_hits(0), super_hits(0), misses(0), walks(0), flushes(0) {}
+
+		static constexpr UX level_mask(UX level)
 		{
-			for (size_t i = 0; i < size; i++) {
-				if (tlb[i].pdid != pdid) continue;
-				tlb[i] = tlb_entry_t();
+			return (UX(1) << (level_bits * level)) - 1;
+		}
+
+		/* an entry is valid if inserted since the last global and ASID flush */
+		bool valid(const tlb_entry_t &ent)
+		{
+			return ent.gen >= global_flush && ent.gen >= asid_flush[ent.asid & (asid_slots - 1)];
+		}
+
+		bool match(tlb_entry_t &ent, UX pdid, UX asid, UX vpn)
+		{
+			return ent.pdid == pdid && ent.asid == asid && ent.vpn == vpn && valid(ent);
+		}
+
+		bool match_super(tlb_entry_t &ent, UX pdid, UX asid, UX vpn)
+		{
+			return ent.ptel != 0 && ent.pdid == pdid && ent.asid == asid &&
+				ent.vpn == (vpn & ~level_mask(ent.ptel)) && valid(ent);
+		}
+
+		tlb_entry_t make(UX pdid, UX asid, UX vpn, UX ptel, UX pteb, UX ppn)
+		{
+			tlb_entry_t ent(pdid, asid, vpn, ptel, pteb, ppn);
+			ent.gen = epoch;
+			return ent;
+		}
+
+		/* move way i of a set to way 0, shifting more recently used ways down */
+		static tlb_entry_t* promote(tlb_entry_t *set, size_t i)
+		{
+			if (i == 0) return set;
+			tlb_entry_t ent = set[i];
+			for (; i > 0; i--) {
+				set[i] = set[i - 1];
 			}
+			set[0] = ent;
+			return set;
 		}
 
+		/* replace the least recently used way of a set, retaining it as a victim */
+		tlb_entry_t* replace(tlb_entry_t *set, const tlb_entry_t &ent)
+		{
+			if (valid(set[ways - 1])) {
+				victim[victim_next++ & (victim_size - 1)] = set[ways - 1];
+			}
+			set[ways - 1] = ent;
+			return promote(set, ways - 1);
+		}
+
+		/* advance the epoch, resetting all entries if it wraps */
+		u32 next_epoch()
+		{
+			if (unlikely(epoch == u32(-1))) {
+				for (size_t i = 0; i < size; i++) tlb[i] = tlb_entry_t();
+				for (size_t i = 0; i < victim_size; i++) victim[i] = tlb_entry_t();
+				for (size_t i = 0; i < super_size; i++) super[i] = tlb_entry_t();
+				for (size_t i = 0; i < asid_slots; i++) asid_flush[i] = 0;
+				host_tags = false;
+				host_set_count = 0;
+				global_flush = epoch = 1;
+			}
+			return ++epoch;
+		}
+
+		/* flushes are per epoch, so flushing a PDID flushes all entries */
+		void flush(UX pdid)
+		{
+			global_flush = next_epoch();
+			if (host_tags) flush_host();
+			flushes++;
+		}
+
+		/* flush the entries of one ASID, or all entries if the ASID is 0 */
 		void flush(UX pdid, UX asid)
 		{
-			for (size_t i = 0; i < size; i++) {
-				if (asid != 0 && tlb[i].pdid != pdid && tlb[i].asid != asid) continue;
-				tlb[i] = tlb_entry_t();
+			if (asid == 0) {
+				global_flush = next_epoch();
+			} else {
+				asid_flush[asid & (asid_slots - 1)] = next_epoch();
 			}
+			if (host_tags) flush_host();
+			flushes++;
+		}
+
+		/* note an entry is about to be given host tags, recording its set */
+		void tag_host(tlb_entry_t *ent)
+		{
+			host_tags = true;
+			if (ent < tlb || ent >= tlb + size) return;
+			if (ent->ltag != tlb_entry_t::invalid_tag || ent->stag != tlb_entry_t::invalid_tag) return;
+			if (host_set_count < sets) host_sets[host_set_count] = size_t(ent - tlb) / ways;
+			host_set_count++;
+		}
+
+		// invalidate host load and store tags when the translation context changes
+		void flush_host()
+		{
+			if (host_set_count < sets) {
+				for (size_t i = 0; i < host_set_count; i++) {
+					tlb_entry_t *set = tlb + host_sets[i] * ways;
+					for (size_t j = 0; j < ways; j++) {
+						set[j].ltag = set[j].stag = tlb_entry_t::invalid_tag;
+					}
+				}
+			} else {
+				for (size_t i = 0; i < size; i++) {
+					tlb[i].ltag = tlb[i].stag = tlb_entry_t::invalid_tag;
+				}
+			}
+			for (size_t i = 0; i < victim_size; i++) {
+				victim[i].ltag = victim[i].stag = tlb_entry_t::invalid_tag;
+			}
+			host_tags = false;
+			host_set_count = 0;
 		}
 
 		// lookup TLB entry for the given PDID + ASID + X:12[VA] + 11:0[PTE.bits] -> PPN]
 		tlb_entry_t* lookup(UX pdid, UX asid, UX va)
 		{
 			UX vpn = va >> page_shift;
-			size_t i = vpn & mask;
-			return tlb[i].pdid == pdid && tlb[i].asid == asid && tlb[i].vpn == vpn ?
-				tlb + i : nullptr;
+			tlb_entry_t *set = tlb + (vpn & mask) * ways;
+			for (size_t i = 0; i < ways; i++) {
+				if (match(set[i], pdid, asid, vpn)) {
+					hits++;
+					return promote(set, i);
+				}
+			}
+			for (size_t i = 0; i < super_size; i++) {
+				if (match_super(super[i], pdid, asid, vpn)) {
+					hits++;
+					super_hits++;
+					return super + i;
+				}
+			}
+			for (size_t i = 0; i < victim_size; i++) {
+				if (match(victim[i], pdid, asid, vpn)) {
+					hits++;
+					victim_hits++;
+					tlb_entry_t ent = victim[i];
+					victim[i].gen = 0;
+					return replace(set, ent);
+				}
+			}
+			misses++;
+			return nullptr;
 		}
 
 		// insert TLB entry for the given PDID + ASID + X:12[VA] + 11:0[PTE.bits] <- PPN]
 		tlb_entry_t* insert(UX pdid, UX asid, UX va, UX ptel, UX pteb, UX ppn)
 		{
 			UX vpn = va >> page_shift;
-			size_t i = vpn & mask;
-			// we are implicitly evicting an entry by overwriting it
-			tlb[i] = tlb_entry_t(pdid, asid, vpn, ptel, pteb, ppn);
-			return &tlb[i];
+			if (ptel != 0) {
+				vpn &= ~level_mask(ptel);
+				for (size_t i = 0; i < super_size; i++) {
+					if (super[i].ptel == ptel && match(super[i], pdid, asid, vpn)) {
+						super[i] = make(pdid, asid, vpn, ptel, pteb, ppn);
+						return super + i;
+					}
+				}
+				tlb_entry_t *ent = super + (super_next++ & (super_size - 1));
+				*ent = make(pdid, asid, vpn, ptel, pteb, ppn);
+				return ent;
+			}
+			tlb_entry_t *set = tlb + (vpn & mask) * ways;
+			for (size_t i = 0; i < ways; i++) {
+				if (match(set[i], pdid, asid, vpn)) {
+					set[i] = make(pdid, asid, vpn, ptel, pteb, ppn);
+					return promote(set, i);
+				}
+			}
+			return replace(set, make(pdid, asid, vpn, ptel, pteb, ppn));
+		}
+
+		/* insert a page sized entry for va translating the same as a superpage entry */
+		tlb_entry_t* alias(tlb_entry_t *ent, UX va)
+		{
+			UX vpn = va >> page_shift;
+			return insert(ent->pdid, ent->asid, va, 0, ent->pteb,
+				ent->ppn + (vpn & level_mask(ent->ptel)));
+		}
+
+		void print_stats(const char *name)
+		{
+			u64 lookups = hits + misses;
+			printf("%-8s hits=%llu (victim=%llu super=%llu) misses=%llu walks=%llu "
+				"flushes=%llu hit-rate=%.2f%%\n", name,
+				hits, victim_hits, super_hits, misses, walks, flushes,
+				lookups ? 100.0 * double(hits) / double(lookups) : 0.0);
+		}
+	};
+
+	/*
+	 * page_walk_cache
+	 *
+	 * direct mapped cache of non-leaf PTEs used to skip the upper levels of
+	 * the page table walk, tagged by the page table root and paging mode
+	 *
+	 * pwc[SPTBR:LEVELS:LEVEL:VA[X:LEVEL]] = next level page table address
+	 *
+	 * A hit at level n starts the walk at level n-1, saving the loads of
+	 * the levels above it. The cache is flushed by sfence.vm and sptbr writes.
+	 */
+
+	template <const size_t pwc_size, typename UX>
+	struct page_walk_cache
+	{
+		static_assert(ispow2(pwc_size), "pwc_size must be a power of 2");
+
+		enum : UX {
+			size = pwc_size,
+			mask = pwc_size - 1
+		};
+
+		struct pwc_entry
+		{
+			UX root;       /* page table root (sptbr) */
+			UX tag;        /* VA bits translated by this and higher levels */
+			UX table;      /* next level page table address */
+			u8 levels;     /* paging mode levels, 0 if invalid */
+			u8 level;      /* level of the non-leaf PTE */
+		};
+
+		pwc_entry pwc[size];
+
+		/* statistics */
+
+		u64 hits;          /* walks started below the root */
+		u64 misses;        /* walks started at the root */
+		u64 saved;         /* page table loads saved */
+		u64 flushes;       /* flush operations */
+
+		page_walk_cache() : pwc(), hits(0), misses(0), saved(0), flushes(0) {}
+
+		static size_t index(UX tag, UX level)
+		{
+			return ((tag << 2) | level) & mask;
+		}
+
+		void flush()
+		{
+			for (size_t i = 0; i < size; i++) {
+				pwc[i].levels = 0;
+			}
+			flushes++;
+		}
+
+		/* find the deepest cached level for a VA, returning the level to start the walk */
+		template <typename PTM>
+		UX walk_start(UX root, UX va, UX &table)
+		{
+			for (UX level = 1; level < PTM::levels; level++) {
+				UX tag = va >> (PTM::bits * level + page_shift);
+				pwc_entry &ent = pwc[index(tag, level)];
+				if (ent.levels == PTM::levels && ent.level == level &&
+					ent.root == root && ent.tag == tag)
+				{
+					table = ent.table;
+					hits++;
+					saved += PTM::levels - level;
+					return level - 1;
+				}
+			}
+			misses++;
+			return PTM::levels - 1;
+		}
+
+		/* record the next level page table address for a non-leaf PTE */
+		template <typename PTM>
+		void insert(UX root, UX va, UX level, UX table)
+		{
+			UX tag = va >> (PTM::bits * level + page_shift);
+			pwc[index(tag, level)] = pwc_entry{root, tag, table, u8(PTM::levels), u8(level)};
+		}
+
+		void print_stats(const char *name)
+		{
+			printf("%-8s hits=%llu misses=%llu saved=%llu flushes=%llu\n",
+				name, hits, misses, saved, flushes);
 		}
 	};
 
@@ -27,6 +27,183 @@ std::vector<cmdline_option> rv_gen_interp::get_cmdline_options()
 	};
 }
 
+static std::string format_pseudocode(std::string inst)
+{
+	inst = replace(inst, "imm", "dec.imm");
+	inst = replace(inst, "ptr", "addr_t");
+	inst = replace(inst, "fcsr", "proc.fcsr");
+	inst = replace(inst, "pc_offset", "PC_OFFSET");
+	inst = replace(inst, "pc", "proc.pc");
+	inst = replace(inst, "PC_OFFSET", "pc_offset");
+	inst = replace(inst, "length(inst)", "pc_offset");
+	inst = replace(inst, "u32(f32(NAN))", "0x7fc00000");
+	inst = replace(inst, "u64(f64(NAN))", "0x7ff8000000000000ULL");
+	inst = replace(inst, "isnan", "std::isnan");
+	inst = replace(inst, "sx(INT_MIN)", "std::numeric_limits<sx>::min()");
+	inst = replace(inst, "s32(INT_MIN)", "std::numeric_limits<s32>::min()");
+	inst = replace(inst, "s64(INT_MIN)", "std::numeric_limits<s64>::min()");
+	inst = replace(inst, "ux(INT_MIN)", "std::numeric_limits<ux>::min()");
+	inst = replace(inst, "u32(INT_MIN)", "std::numeric_limits<u32>::min()");
+	inst = replace(inst, "u64(INT_MIN)", "std::numeric_limits<u64>::min()");
+	inst = replace(inst, "sx(INT_MAX)", "std::numeric_limits<sx>::max()");
+	inst = replace(inst, "s32(INT_MAX)", "std::numeric_limits<s32>::max()");
+	inst = replace(inst, "s64(INT_MAX)", "std::numeric_limits<s64>::max()");
+	inst = replace(inst, "ux(INT_MAX)", "std::numeric_limits<ux>::max()");
+	inst = replace(inst, "u32(INT_MAX)", "std::numeric_limits<u32>::max()");
+	inst = replace(inst, "u64(INT_MAX)", "std::numeric_limits<u64>::max()");
+	inst = replace(inst, "f32(frd)", "frd.r.s.val");
+	inst = replace(inst, "f32(frs1)", "frs1.r.s.val");
+	inst = replace(inst, "f32(frs2)", "frs2.r.s.val");
+	inst = replace(inst, "f32(frs3)", "frs3.r.s.val");
+	inst = replace(inst, "f64(frd)", "frd.r.d.val");
+	inst = replace(inst, "f64(frs1)", "frs1.r.d.val");
+	inst = replace(inst, "f64(frs2)", "frs2.r.d.val");
+	inst = replace(inst, "f64(frs3)", "frs3.r.d.val");
+	inst = replace(inst, "u32(frd)", "frd.r.wu.val");
+	inst = replace(inst, "u32(frs1)", "frs1.r.wu.val");
+	inst = replace(inst, "u32(frs2)", "frs2.r.wu.val");
+	inst = replace(inst, "u64(frd)", "frd.r.lu.val");
+	inst = replace(inst, "u64(frs1)", "frs1.r.lu.val");
+	inst = replace(inst, "u64(frs2)", "frs2.r.lu.val");
+	inst = replace(inst, "s32(frd)", "frd.r.w.val");
+	inst = replace(inst, "s32(frs1)", "frs1.r.w.val");
+	inst = replace(inst, "s32(frs2)", "frs2.r.w.val");
+	inst = replace(inst, "s64(frd)", "frd.r.l.val");
+	inst = replace(inst, "s64(frs1)", "frs1.r.l.val");
+	inst = replace(inst, "s64(frs2)", "frs2.r.l.val");
+	inst = replace(inst, "ux(rd)", "rd.r.xu.val");
+	inst = replace(inst, "ux(rs1)", "rs1.r.xu.val");
+	inst = replace(inst, "ux(rs2)", "rs2.r.xu.val");
+	inst = replace(inst, "u32(rd)", "rd.r.wu.val");
+	inst = replace(inst, "u32(rs1)", "rs1.r.wu.val");
+	inst = replace(inst, "u32(rs2)", "rs2.r.wu.val");
+	inst = replace(inst, "u64(rd)", "rd.r.lu.val");
+	inst = replace(inst, "u64(rs1)", "rs1.r.lu.val");
+	inst = replace(inst, "u64(rs2)", "rs2.r.lu.val");
+	inst = replace(inst, "sx(rd)", "rd.r.x.val");
+	inst = replace(inst, "sx(rs1)", "rs1.r.x.val");
+	inst = replace(inst, "sx(rs2)", "rs2.r.x.val");
+	inst = replace(inst, "s32(rd)", "rd.r.w.val");
+	inst = replace(inst, "s32(rs1)", "rs1.r.w.val");
+	inst = replace(inst, "s32(rs2)", "rs2.r.w.val");
+	inst = replace(inst, "s64(rd)", "rd.r.l.val");
+	inst = replace(inst, "s64(rs1)", "rs1.r.l.val");
+	inst = replace(inst, "s64(rs2)", "rs2.r.l.val");
+	inst = replace(inst, "mmu.amo<s32>(", "proc.mmu.template amo<P,s32>(proc, ");
+	inst = replace(inst, "mmu.amo<s64>(", "proc.mmu.template amo<P,s64>(proc, ");
+	inst = replace(inst, "mmu.lr<s32>(", "proc.mmu.template lr<P,s32>(proc, ");
+	inst = replace(inst, "mmu.lr<s64>(", "proc.mmu.template lr<P,s64>(proc, ");
+	inst = replace(inst, "mmu.sc<s32>(", "proc.mmu.template sc<P,s32>(proc, ");
+	inst = replace(inst, "mmu.sc<s64>(", "proc.mmu.template sc<P,s64>(proc, ");
+	inst = replace(inst, "mmu.load<u8>(", "proc.mmu.template load<P,u8>(proc, ");
+	inst = replace(inst, "mmu.load<u16>(", "proc.mmu.template load<P,u16>(proc, ");
+	inst = replace(inst, "mmu.load<u32>(", "proc.mmu.template load<P,u32>(proc, ");
+	inst = replace(inst, "mmu.load<u64>(", "proc.mmu.template load<P,u64>(proc, ");
+	inst = replace(inst, "mmu.load<s8>(", "proc.mmu.template load<P,s8>(proc, ");
+	inst = replace(inst, "mmu.load<s16>(", "proc.mmu.template load<P,s16>(proc, ");
+	inst = replace(inst, "mmu.load<s32>(", "proc.mmu.template load<P,s32>(proc, ");
+	inst = replace(inst, "mmu.load<s64>(", "proc.mmu.template load<P,s64>(proc, ");
+	inst = replace(inst, "mmu.load<f32>(", "proc.mmu.template load<P,f32>(proc, ");
+	inst = replace(inst, "mmu.load<f64>(", "proc.mmu.template load<P,f64>(proc, ");
+	inst = replace(inst, "mmu.store<s8>(", "proc.mmu.template store<P,s8>(proc, ");
+	inst = replace(inst, "mmu.store<s16>(", "proc.mmu.template store<P,s16>(proc, ");
+	inst = replace(inst, "mmu.store<s32>(", "proc.mmu.template store<P,s32>(proc, ");
+	inst = replace(inst, "mmu.store<s64>(", "proc.mmu.template store<P,s64>(proc, ");
+	inst = replace(inst, "mmu.store<f32>(", "proc.mmu.template store<P,f32>(proc, ");
+	inst = replace(inst, "mmu.store<f64>(", "proc.mmu.template store<P,f64>(proc, ");
+	inst = replace(inst, "frd", "FRD");
+	inst = replace(inst, "frs1", "FRS1");
+	inst = replace(inst, "frs2", "FRS2");
+	inst = replace(inst, "rd = ", "proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : ");
+	inst = replace(inst, "rs1", "proc.ireg[dec.rs1]");
+	inst = replace(inst, "rs2", "proc.ireg[dec.rs2]");
+	inst = replace(inst, "FRD", "frd");
+	inst = replace(inst, "FRS1", "frs1");
+	inst = replace(inst, "FRS2", "frs2");
+	inst = replace(inst, "frd", "proc.freg[dec.rd]");
+	inst = replace(inst, "frs1", "proc.freg[dec.rs1]");
+	inst = replace(inst, "frs2", "proc.freg[dec.rs2]");
+	inst = replace(inst, "frs3", "proc.freg[dec.rs3]");
+	inst = replace(inst, "fenv_setrm(rm)", "fenv_setrm((proc.fcsr >> 5) & 0b111)");
+	return inst;
+}
+
+/*
+ * Direct threaded variant that executes a pre-decoded block. The handler
+ * addresses are resolved once when the block is decoded, and each handler
+ * ends with its own indirect jump to the next handler.
+ */
+static void print_interp_block(rv_gen *gen, size_t isa_width, std::string isa_prefix)
+{
+	std::vector<rv_opcode_ptr> opcode_by_num(gen->opcodes.size() + 1);
+	for (auto &opcode : gen->all_opcodes) {
+		if (opcode->pseudocode_c.size() == 0) continue;
+		if (!opcode->include_isa(isa_width)) continue;
+		opcode_by_num[opcode->num] = opcode;
+	}
+
+	printf("/* Execute Block RV%lu (direct threaded) */\n\n", isa_width);
+	printf("template <");
+	std::vector<std::string> mnems = gen->get_inst_mnemonics(false, true);
+	for (auto mi = mnems.begin(); mi != mnems.end(); mi++) {
+		printf("bool %s, ", mi->c_str());
+	}
+	printf("typename T, typename P>\n");
+	printf("size_t exec_block_%s(P &proc, T *dec, const void **handler, const riscv::u8 *length, size_t count)\n",
+		isa_prefix.c_str());
+	printf("{\n");
+	printf("\tusing namespace riscv;\n");
+	printf("\tenum { xlen = %zu };\n", isa_width);
+	printf("\ttypedef s%zu sx;\n", isa_width);
+	printf("\ttypedef u%zu ux;\n", isa_width);
+	printf("\n");
+	printf("\tstatic const void *dispatch[] = {\n");
+	printf("\t\t&&illegal,\n");
+	for (size_t num = 1; num < opcode_by_num.size(); num++) {
+		auto &opcode = opcode_by_num[num];
+		if (opcode) {
+			printf("\t\trv%c ? &&%s : &&illegal,\n",
+				opcode->extensions.front()->alpha_code,
+				rv_meta_model::opcode_format("exec_", opcode, "_").c_str());
+		} else {
+			printf("\t\t&&illegal,\n");
+		}
+	}
+	printf("\t};\n");
+	printf("\n");
+	printf("\t/* resolve the handler for each decoded instruction when length is null */\n");
+	printf("\tif (!length) {\n");
+	printf("\t\tfor (size_t i = 0; i < count; i++) {\n");
+	printf("\t\t\thandler[i] = dispatch[dec[i].op];\n");
+	printf("\t\t}\n");
+	printf("\t\treturn 0;\n");
+	printf("\t}\n");
+	printf("\n");
+	printf("\t/* execute until a taken branch or an instruction without a handler */\n");
+	printf("\tsize_t i = 0;\n");
+	printf("\ttypename P::ux pc_offset = length[0];\n");
+	printf("\tgoto *handler[0];\n");
+	printf("\n");
+	for (size_t num = 1; num < opcode_by_num.size(); num++) {
+		auto &opcode = opcode_by_num[num];
+		if (!opcode) continue;
+		std::string inst = replace(format_pseudocode(opcode->pseudocode_c), "dec.", "dec[i].");
+		printf("\t%s:\n", rv_meta_model::opcode_format("exec_", opcode, "_").c_str());
+		printf("\t\t{\n");
+		printf("\t\t\t%s;\n", inst.c_str());
+		printf("\t\t}\n");
+		printf("\t\tproc.pc += pc_offset;\n");
+		printf("\t\tproc.instret++;\n");
+		printf("\t\tif (pc_offset != length[i] || ++i == count) return count;\n");
+		printf("\t\tpc_offset = length[i];\n");
+		printf("\t\tgoto *handler[i];\n");
+		printf("\n");
+	}
+	printf("\tillegal:\n");
+	printf("\t\treturn i;\n");
+	printf("}\n\n");
+}
+
 static void print_interp_h(rv_gen *gen)
 {
 	printf(kCHeader, "interp.h");
@@ -55,99 +232,7 @@ static void print_interp_h(rv_gen *gen)
 			if (inst.size() == 0) continue;
 			if (!opcode->include_isa(isa_width.first)) continue;
 			printf("\t\tcase %s:\n", rv_meta_model::opcode_format("rv_op_", opcode, "_").c_str());
-			inst = replace(inst, "imm", "dec.imm");
-			inst = replace(inst, "ptr", "addr_t");
-			inst = replace(inst, "fcsr", "proc.fcsr");
-			inst = replace(inst, "lr", "proc.lr");
-			inst = replace(inst, "pc_offset", "PC_OFFSET");
-			inst = replace(inst, "pc", "proc.pc");
-			inst = replace(inst, "PC_OFFSET", "pc_offset");
-			inst = replace(inst, "length(inst)", "pc_offset");
-			inst = replace(inst, "u32(f32(NAN))", "0x7fc00000");
-			inst = replace(inst, "u64(f64(NAN))", "0x7ff8000000000000ULL");
-			inst = replace(inst, "isnan", "std::isnan");
-			inst = replace(inst, "sx(INT_MIN)", "std::numeric_limits<sx>::min()");
-			inst = replace(inst, "s32(INT_MIN)", "std::numeric_limits<s32>::min()");
-			inst = replace(inst, "s64(INT_MIN)", "std::numeric_limits<s64>::min()");
-			inst = replace(inst, "ux(INT_MIN)", "std::numeric_limits<ux>::min()");
-			inst = replace(inst, "u32(INT_MIN)", "std::numeric_limits<u32>::min()");
-			inst = replace(inst, "u64(INT_MIN)", "std::numeric_limits<u64>::min()");
-			inst = replace(inst, "sx(INT_MAX)", "std::numeric_limits<sx>::max()");
-			inst = replace(inst, "s32(INT_MAX)", "std::numeric_limits<s32>::max()");
-			inst = replace(inst, "s64(INT_MAX)", "std::numeric_limits<s64>::max()");
-			inst = replace(inst, "ux(INT_MAX)", "std::numeric_limits<ux>::max()");
-			inst = replace(inst, "u32(INT_MAX)", "std::numeric_limits<u32>::max()");
-			inst = replace(inst, "u64(INT_MAX)", "std::numeric_limits<u64>::max()");
-			inst = replace(inst, "f32(frd)", "frd.r.s.val");
-			inst = replace(inst, "f32(frs1)", "frs1.r.s.val");
-			inst = replace(inst, "f32(frs2)", "frs2.r.s.val");
-			inst = replace(inst, "f32(frs3)", "frs3.r.s.val");
-			inst = replace(inst, "f64(frd)", "frd.r.d.val");
-			inst = replace(inst, "f64(frs1)", "frs1.r.d.val");
-			inst = replace(inst, "f64(frs2)", "frs2.r.d.val");
-			inst = replace(inst, "f64(frs3)", "frs3.r.d.val");
-			inst = replace(inst, "u32(frd)", "frd.r.wu.val");
-			inst = replace(inst, "u32(frs1)", "frs1.r.wu.val");
-			inst = replace(inst, "u32(frs2)", "frs2.r.wu.val");
-			inst = replace(inst, "u64(frd)", "frd.r.lu.val");
-			inst = replace(inst, "u64(frs1)", "frs1.r.lu.val");
-			inst = replace(inst, "u64(frs2)", "frs2.r.lu.val");
-			inst = replace(inst, "s32(frd)", "frd.r.w.val");
-			inst = replace(inst, "s32(frs1)", "frs1.r.w.val");
-			inst = replace(inst, "s32(frs2)", "frs2.r.w.val");
-			inst = replace(inst, "s64(frd)", "frd.r.l.val");
-			inst = replace(inst, "s64(frs1)", "frs1.r.l.val");
-			inst = replace(inst, "s64(frs2)", "frs2.r.l.val");
-			inst = replace(inst, "ux(rd)", "rd.r.xu.val");
-			inst = replace(inst, "ux(rs1)", "rs1.r.xu.val");
-			inst = replace(inst, "ux(rs2)", "rs2.r.xu.val");
-			inst = replace(inst, "u32(rd)", "rd.r.wu.val");
-			inst = replace(inst, "u32(rs1)", "rs1.r.wu.val");
-			inst = replace(inst, "u32(rs2)", "rs2.r.wu.val");
-			inst = replace(inst, "u64(rd)", "rd.r.lu.val");
-			inst = replace(inst, "u64(rs1)", "rs1.r.lu.val");
-			inst = replace(inst, "u64(rs2)", "rs2.r.lu.val");
-			inst = replace(inst, "sx(rd)", "rd.r.x.val");
-			inst = replace(inst, "sx(rs1)", "rs1.r.x.val");
-			inst = replace(inst, "sx(rs2)", "rs2.r.x.val");
-			inst = replace(inst, "s32(rd)", "rd.r.w.val");
-			inst = replace(inst, "s32(rs1)", "rs1.r.w.val");
-			inst = replace(inst, "s32(rs2)", "rs2.r.w.val");
-			inst = replace(inst, "s64(rd)", "rd.r.l.val");
-			inst = replace(inst, "s64(rs1)", "rs1.r.l.val");
-			inst = replace(inst, "s64(rs2)", "rs2.r.l.val");
-			inst = replace(inst, "mmu.amo<s32>(", "proc.mmu.template amo<P,s32>(proc, ");
-			inst = replace(inst, "mmu.amo<s64>(", "proc.mmu.template amo<P,s64>(proc, ");
-			inst = replace(inst, "mmu.load<u8>(", "proc.mmu.template load<P,u8>(proc, ");
-			inst = replace(inst, "mmu.load<u16>(", "proc.mmu.template load<P,u16>(proc, ");
-			inst = replace(inst, "mmu.load<u32>(", "proc.mmu.template load<P,u32>(proc, ");
-			inst = replace(inst, "mmu.load<u64>(", "proc.mmu.template load<P,u64>(proc, ");
-			inst = replace(inst, "mmu.load<s8>(", "proc.mmu.template load<P,s8>(proc, ");
-			inst = replace(inst, "mmu.load<s16>(", "proc.mmu.template load<P,s16>(proc, ");
-			inst = replace(inst, "mmu.load<s32>(", "proc.mmu.template load<P,s32>(proc, ");
-			inst = replace(inst, "mmu.load<s64>(", "proc.mmu.template load<P,s64>(proc, ");
-			inst = replace(inst, "mmu.load<f32>(", "proc.mmu.template load<P,f32>(proc, ");
-			inst = replace(inst, "mmu.load<f64>(", "proc.mmu.template load<P,f64>(proc, ");
-			inst = replace(inst, "mmu.store<s8>(", "proc.mmu.template store<P,s8>(proc, ");
-			inst = replace(inst, "mmu.store<s16>(", "proc.mmu.template store<P,s16>(proc, ");
-			inst = replace(inst, "mmu.store<s32>(", "proc.mmu.template store<P,s32>(proc, ");
-			inst = replace(inst, "mmu.store<s64>(", "proc.mmu.template store<P,s64>(proc, ");
-			inst = replace(inst, "mmu.store<f32>(", "proc.mmu.template store<P,f32>(proc, ");
-			inst = replace(inst, "mmu.store<f64>(", "proc.mmu.template store<P,f64>(proc, ");
-			inst = replace(inst, "frd", "FRD");
-			inst = replace(inst, "frs1", "FRS1");
-			inst = replace(inst, "frs2", "FRS2");
-			inst = replace(inst, "rd = ", "proc.ireg[dec.rd] = (dec.rd == 0) ? 0 : ");
-			inst = replace(inst, "rs1", "proc.ireg[dec.rs1]");
-			inst = replace(inst, "rs2", "proc.ireg[dec.rs2]");
-			inst = replace(inst, "FRD", "frd");
-			inst = replace(inst, "FRS1", "frs1");
-			inst = replace(inst, "FRS2", "frs2");
-			inst = replace(inst, "frd", "proc.freg[dec.rd]");
-			inst = replace(inst, "frs1", "proc.freg[dec.rs1]");
-			inst = replace(inst, "frs2", "proc.freg[dec.rs2]");
-			inst = replace(inst, "frs3", "proc.freg[dec.rs3]");
-			inst = replace(inst, "fenv_setrm(rm)", "fenv_setrm((proc.fcsr >> 5) & 0b111)");
+			inst = format_pseudocode(inst);
 			printf("\t\t\tif (rv%c) {\n", opcode->extensions.front()->alpha_code);
 			printf("\t\t\t\t%s;\n",  inst.c_str());
 			printf("\t\t\t};\n");
@@ -157,6 +242,7 @@ static void print_interp_h(rv_gen *gen)
 		printf("\t}\n");
 		printf("\treturn pc_offset;\n");
 		printf("}\n\n");
+		print_interp_block(gen, isa_width.first, isa_width.second);
 	}
 	printf("#endif\n");
 }
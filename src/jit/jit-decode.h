@@ -24,15 +24,16 @@ namespace riscv {
 		u8     aq   : 1;   /* acquire for atomic ops */
 		u8     rl   : 1;   /* release for atomic ops */
 		u8     sz   : 4;   /* fused instruction size */
+		u8     taken: 1;   /* branch taken when the trace was recorded */
 
 		jit_decode()
-			: pc(0), inst(0), imm(0), op(0), codec(0), rd(0), rs1(0), rs2(0), rs3(0), rm(0), pred(0), succ(0), aq(0), rl(0), sz(0) {}
+			: pc(0), inst(0), imm(0), op(0), codec(0), rd(0), rs1(0), rs2(0), rs3(0), rm(0), pred(0), succ(0), aq(0), rl(0), sz(0), taken(0) {}
 
 		jit_decode(addr_t pc, u64 inst, u16 op, u8 rd, s32 imm)
-			: pc(pc), inst(inst), imm(imm), op(op), codec(0), rd(rd), rs1(0), rs2(0), rs3(0), rm(0), pred(0), succ(0), aq(0), rl(0), sz(0) {}
+			: pc(pc), inst(inst), imm(imm), op(op), codec(0), rd(rd), rs1(0), rs2(0), rs3(0), rm(0), pred(0), succ(0), aq(0), rl(0), sz(0), taken(0) {}
 
 		jit_decode(addr_t pc, u64 inst, u16 op, u8 rd, u8 rs1, s32 imm)
-			: pc(pc), inst(inst), imm(imm), op(op), codec(0), rd(rd), rs1(rs1), rs2(0), rs3(0), rm(0), pred(0), succ(0), aq(0), rl(0), sz(0) {}
+			: pc(pc), inst(inst), imm(imm), op(op), codec(0), rd(rd), rs1(rs1), rs2(0), rs3(0), rm(0), pred(0), succ(0), aq(0), rl(0), sz(0), taken(0) {}
 	};
 
 	enum jit_op {
@@ -78,6 +79,56 @@ namespace riscv {
 		sw_fn sw;
 		sd_fn sd;
 	};
+
+	/*
+	 * helpers called from trace code. traces call them through a table
+	 * of addresses at the end of the trace, so the code itself is position
+	 * independent and a saved trace only needs the table relocated.
+	 */
+	enum jit_helper {
+		jit_helper_lookup_trace,
+		jit_helper_lb,
+		jit_helper_lh,
+		jit_helper_lw,
+		jit_helper_ld,
+		jit_helper_sb,
+		jit_helper_sh,
+		jit_helper_sw,
+		jit_helper_sd,
+		jit_helper_count
+	};
+
+	inline intptr_t jit_helper_address(jit_helper helper, mmu_ops &ops, TraceLookup lookup_trace)
+	{
+		switch (helper) {
+			case jit_helper_lookup_trace: return func_address(lookup_trace);
+			case jit_helper_lb: return func_address(ops.lb);
+			case jit_helper_lh: return func_address(ops.lh);
+			case jit_helper_lw: return func_address(ops.lw);
+			case jit_helper_ld: return func_address(ops.ld);
+			case jit_helper_sb: return func_address(ops.sb);
+			case jit_helper_sh: return func_address(ops.sh);
+			case jit_helper_sw: return func_address(ops.sw);
+			case jit_helper_sd: return func_address(ops.sd);
+			case jit_helper_count: break;
+		}
+		return 0;
+	}
+
+	/*
+	 * soft TLB layout used to emit inline translation on loads and stores.
+	 * entries is the offset of the TLB entries from the processor (rbp)
+	 * and is zero if the processor has no soft TLB.
+	 */
+	struct mmu_tlb
+	{
+		size_t entries;
+		size_t mask;
+		size_t entry_size;
+		size_t ltag;
+		size_t stag;
+		size_t addend;
+	};
 }
 
 #endif
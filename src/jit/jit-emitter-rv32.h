@@ -15,30 +15,46 @@ namespace riscv {
 		typedef P processor_type;
 		typedef typename P::decode_type decode_type;
 
-		#define proc_offset(member) offsetof(typename P::processor_type, member)
+		/*
+		 * offsets are taken from the live processor as offsetof is not
+		 * valid for processors that are not standard layout (rv-sys)
+		 */
+		#define proc_offset(member) size_t(uintptr_t(&proc_base().member) - uintptr_t(&proc_base()))
 
 		P &proc;
 		X86Assembler as;
 		CodeHolder &code;
 		mmu_ops ops, ops_wrap;
+		mmu_tlb dtlb;     /* unused: rv32 loads and stores call the mmu */
 		TraceLookup lookup_trace_slow;
 		TraceLookup lookup_trace_fast;
 		std::map<addr_t,Label> labels;
 		std::map<addr_t,Label> jmp_tramp_labels;
 		std::map<addr_t,Label> exit_tramp_labels;
+		std::map<addr_t,Label> side_exit_labels;
 		std::map<addr_t,std::vector<Label>> jmp_fixup_labels;
+		std::map<jit_helper,Label> helper_labels;
 		std::vector<addr_t> callstack;
 		u32 term_pc;
 		bool use_mmu;
-		Label start, term;
+		bool check_budget;  /* unused: rv32 traces are only run on the proxy */
+		Label start, term, helper_table;
+
+		/* bumped when emitted code changes, invalidating saved traces */
+		static const int emitter_version = 1;
 
 		jit_emitter_rv32(P &proc, CodeHolder &code, mmu_ops &ops, TraceLookup lookup_trace_slow, TraceLookup lookup_trace_fast)
-			: proc(proc), as(&code), code(code), ops(ops),
+			: proc(proc), as(&code), code(code), ops(ops), dtlb(),
 			  lookup_trace_slow(lookup_trace_slow),
 			  lookup_trace_fast(lookup_trace_fast),
-			  term_pc(0), use_mmu(false)
+			  term_pc(0), use_mmu(false), check_budget(false)
 		{}
 
+		typename P::processor_type& proc_base()
+		{
+			return static_cast<typename P::processor_type&>(proc);
+		}
+
 		void log_trace(const char* fmt, ...)
 		{
 			if (proc.log & proc_log_jit_trace) {
@@ -145,6 +161,9 @@ namespace riscv {
 			return -1;
 		}
 
+		/* rv32 traces use the fixed register map */
+		void allocate_registers(const size_t reg_uses[32]) {}
+
 		const char* rbp_reg_str_d(int reg)
 		{
 			static char buf[32];
@@ -202,11 +221,21 @@ namespace riscv {
 			as.pop(x86::r12);
 			as.ret();
 
+			/* side exits to a pc recorded later in the trace join the trace */
+			for (auto &sel : side_exit_labels) {
+				as.bind(sel.second);
+				auto li = labels.find(sel.first);
+				if (li != labels.end()) {
+					as.jmp(li->second);
+				} else {
+					emit_jump_fixup(sel.first);
+				}
+			}
 
 			for (auto &jtl : jmp_tramp_labels) {
 				as.bind(jtl.second);
 				emit_pc(jtl.first);
-				as.jmp(Imm(func_address(lookup_trace_fast)));
+				as.jmp(helper_ptr(jit_helper_lookup_trace));
 			}
 
 			for (auto &jtl : exit_tramp_labels) {
@@ -214,6 +243,31 @@ namespace riscv {
 				emit_pc(jtl.first);
 				as.jmp(term);
 			}
+
+			emit_helper_table();
+		}
+
+		/* rip relative slot in the helper table emitted at the end of the trace */
+		X86Mem helper_ptr(jit_helper helper)
+		{
+			auto hl = helper_labels.find(helper);
+			if (hl == helper_labels.end()) {
+				hl = helper_labels.insert(helper_labels.end(),
+					std::pair<jit_helper,Label>(helper, as.newLabel()));
+			}
+			return x86::qword_ptr(hl->second);
+		}
+
+		void emit_helper_table()
+		{
+			as.align(kAlignData, 8);
+			helper_table = as.newLabel();
+			as.bind(helper_table);
+			for (auto &hl : helper_labels) {
+				intptr_t addr = jit_helper_address(hl.first, ops, lookup_trace_fast);
+				as.bind(hl.second);
+				as.embed(&addr, sizeof(addr));
+			}
 		}
 
 		TraceLookup create_trace_lookup(JitRuntime &rt)
@@ -388,7 +442,13 @@ namespace riscv {
 		void end()
 		{
 			if (term_pc) {
-				emit_pc(term_pc);
+				auto li = labels.find(term_pc);
+				if (li != labels.end()) {
+					/* a jump back into the trace closes the loop */
+					as.jmp(li->second);
+				} else {
+					emit_pc(term_pc);
+				}
 				log_trace("\t# 0x%016llx", term_pc);
 			}
 			as.bind(term);
@@ -1908,6 +1968,10 @@ namespace riscv {
 			return jfl;
 		}
 
+		/*
+		 * jumps to other traces always go through a fixup, which the run
+		 * loop links to the target trace and unlinks if it is invalidated
+		 */
 		void emit_jump_fixup(addr_t pc)
 		{
 			auto jtl = create_jump_tramp(pc);
@@ -1918,14 +1982,19 @@ namespace riscv {
 			jfl->second.push_back(label);
 		}
 
-		void emit_branch_fixup(x86::Cond bf, addr_t pc)
+		/*
+		 * label for a branch leaving the trace. side exits are emitted after
+		 * the trace body so that the recorded path falls through and so
+		 * they can be resolved once the whole trace is known
+		 */
+		Label side_exit(addr_t pc)
 		{
-			auto jtl = create_jump_tramp(pc);
-			auto jfl = create_jump_fixup(pc);
-			as.j(bf, jtl->second);
-			Label label = as.newLabel();
-			as.bind(label);
-			jfl->second.push_back(label);
+			auto sel = side_exit_labels.find(pc);
+			if (sel == side_exit_labels.end()) {
+				sel = side_exit_labels.insert(side_exit_labels.end(),
+					std::pair<addr_t,Label>(pc, as.newLabel()));
+			}
+			return sel->second;
 		}
 
 		bool emit_branch(decode_type &dec, bool cond, x86::Cond bf, x86::Cond ibf)
@@ -1944,38 +2013,18 @@ namespace riscv {
 			}
 			else if (cond && branch_i != labels.end()) {
 				as.j(bf, branch_i->second);
-				uintptr_t cont_addr = lookup_trace_slow(cont_pc);
-				if (cont_addr) {
-					as.jmp(Imm(cont_addr));
-				} else {
-					emit_jump_fixup(cont_pc);
-				}
+				emit_jump_fixup(cont_pc);
 				term_pc = 0;
 			}
 			else if (!cond && cont_i != labels.end()) {
 				as.j(ibf, cont_i->second);
-				uintptr_t branch_addr = lookup_trace_slow(branch_pc);
-				if (branch_addr) {
-					as.jmp(Imm(branch_addr));
-				} else {
-					emit_jump_fixup(branch_pc);
-				}
+				emit_jump_fixup(branch_pc);
 				term_pc = 0;
 			} else if (cond) {
-				uintptr_t cont_addr = lookup_trace_slow(cont_pc);
-				if (cont_addr) {
-					as.j(ibf, Imm(cont_addr));
-				} else {
-					emit_branch_fixup(ibf, cont_pc);
-				}
+				as.j(ibf, side_exit(cont_pc));
 				term_pc = branch_pc;
 			} else {
-				uintptr_t branch_addr = lookup_trace_slow(branch_pc);
-				if (branch_addr) {
-					as.j(bf, Imm(branch_addr));
-				} else {
-					emit_branch_fixup(bf, branch_pc);
-				}
+				as.j(bf, side_exit(branch_pc));
 				term_pc = cont_pc;
 			}
 			return true;
@@ -1983,38 +2032,32 @@ namespace riscv {
 
 		bool emit_bne(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.x.val != proc.ireg[dec.rs2].r.x.val;
-			return emit_branch(dec, cond, x86::kCondNE, x86::kCondE);
+			return emit_branch(dec, dec.taken, x86::kCondNE, x86::kCondE);
 		}
 
 		bool emit_beq(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.x.val == proc.ireg[dec.rs2].r.x.val;
-			return emit_branch(dec, cond, x86::kCondE, x86::kCondNE);
+			return emit_branch(dec, dec.taken, x86::kCondE, x86::kCondNE);
 		}
 
 		bool emit_blt(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.x.val < proc.ireg[dec.rs2].r.x.val;
-			return emit_branch(dec, cond, x86::kCondL, x86::kCondGE);
+			return emit_branch(dec, dec.taken, x86::kCondL, x86::kCondGE);
 		}
 
 		bool emit_bge(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.x.val >= proc.ireg[dec.rs2].r.x.val;
-			return emit_branch(dec, cond, x86::kCondGE, x86::kCondL);
+			return emit_branch(dec, dec.taken, x86::kCondGE, x86::kCondL);
 		}
 
 		bool emit_bltu(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.xu.val < proc.ireg[dec.rs2].r.xu.val;
-			return emit_branch(dec, cond, x86::kCondB, x86::kCondAE);
+			return emit_branch(dec, dec.taken, x86::kCondB, x86::kCondAE);
 		}
 
 		bool emit_bgeu(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.xu.val >= proc.ireg[dec.rs2].r.xu.val;
-			return emit_branch(dec, cond, x86::kCondAE, x86::kCondB);
+			return emit_branch(dec, dec.taken, x86::kCondAE, x86::kCondB);
 		}
 
 		bool emit_lw(decode_type &dec)
@@ -2037,7 +2080,7 @@ namespace riscv {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs1));
 						as.lea(x86::eax, x86::dword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lw)));
+					as.call(helper_ptr(jit_helper_lw));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2090,7 +2133,7 @@ namespace riscv {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs1));
 						as.lea(x86::eax, x86::dword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lh)));
+					as.call(helper_ptr(jit_helper_lh));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2144,7 +2187,7 @@ namespace riscv {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs1));
 						as.lea(x86::eax, x86::dword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lh)));
+					as.call(helper_ptr(jit_helper_lh));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2198,7 +2241,7 @@ namespace riscv {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs1));
 						as.lea(x86::eax, x86::dword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lb)));
+					as.call(helper_ptr(jit_helper_lb));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2252,7 +2295,7 @@ namespace riscv {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs1));
 						as.lea(x86::eax, x86::dword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lb)));
+					as.call(helper_ptr(jit_helper_lb));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2300,7 +2343,7 @@ namespace riscv {
 						as.lea(x86::eax, x86::dword_ptr(x86::ecx, dec.imm));
 					}
 					as.xor_(x86::ecx, x86::ecx);
-					as.call(Imm(func_address(ops.sw)));
+					as.call(helper_ptr(jit_helper_sw));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2329,7 +2372,7 @@ namespace riscv {
 					} else {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs2));
 					}
-					as.call(Imm(func_address(ops.sw)));
+					as.call(helper_ptr(jit_helper_sw));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2372,7 +2415,7 @@ namespace riscv {
 						as.lea(x86::eax, x86::dword_ptr(x86::ecx, dec.imm));
 					}
 					as.xor_(x86::ecx, x86::ecx);
-					as.call(Imm(func_address(ops.sh)));
+					as.call(helper_ptr(jit_helper_sh));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2401,7 +2444,7 @@ namespace riscv {
 					} else {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs2));
 					}
-					as.call(Imm(func_address(ops.sh)));
+					as.call(helper_ptr(jit_helper_sh));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2444,7 +2487,7 @@ namespace riscv {
 						as.lea(x86::eax, x86::dword_ptr(x86::ecx, dec.imm));
 					}
 					as.xor_(x86::ecx, x86::ecx);
-					as.call(Imm(func_address(ops.sb)));
+					as.call(helper_ptr(jit_helper_sb));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2472,7 +2515,7 @@ namespace riscv {
 					} else {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs2));
 					}
-					as.call(Imm(func_address(ops.sb)));
+					as.call(helper_ptr(jit_helper_sb));
 					auto okay = as.newLabel();
 					as.cmp(x86::dword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
@@ -2585,7 +2628,7 @@ namespace riscv {
 					as.mov(rbp_reg_d(dec.rd), x86::eax);
 				}
 
-				as.jmp(Imm(func_address(lookup_trace_fast)));
+				as.jmp(helper_ptr(jit_helper_lookup_trace));
 
 				return false;
 			}
@@ -2692,6 +2735,16 @@ namespace riscv {
 			Label l = as.newLabel();
 			labels[dec.pc] = l;
 			as.bind(l);
+			if (emit_inst(dec)) {
+				return true;
+			}
+			/* the trace ends before this instruction so nothing may jump to it */
+			labels.erase(dec.pc);
+			return false;
+		}
+
+		bool emit_inst(decode_type &dec)
+		{
 			switch(dec.op) {
 				case rv_op_auipc: return emit_auipc(dec);
 				case rv_op_add: return emit_add(dec);
@@ -15,29 +15,59 @@ namespace riscv {
 		typedef P processor_type;
 		typedef typename P::decode_type decode_type;
 
-		#define proc_offset(member) offsetof(typename P::processor_type, member)
+		/*
+		 * offsets are taken from the live processor as offsetof is not
+		 * valid for processors that are not standard layout (rv-sys)
+		 */
+		#define proc_offset(member) size_t(uintptr_t(&proc_base().member) - uintptr_t(&proc_base()))
 
 		P &proc;
 		X86Assembler as;
 		CodeHolder &code;
 		mmu_ops ops, ops_wrap;
+		mmu_tlb dtlb;
 		TraceLookup lookup_trace_slow;
 		TraceLookup lookup_trace_fast;
 		std::map<addr_t,Label> labels;
 		std::map<addr_t,Label> jmp_tramp_labels;
 		std::map<addr_t,Label> exit_tramp_labels;
+		std::map<addr_t,Label> back_edge_labels;
+		std::map<addr_t,Label> side_exit_labels;
 		std::map<addr_t,std::vector<Label>> jmp_fixup_labels;
+		std::map<jit_helper,Label> helper_labels;
 		std::vector<addr_t> callstack;
 		u64 term_pc;
 		bool use_mmu;
-		Label start, term;
+		bool check_budget;
+		bool remapped;
+		int x86_map[32];  /* rv register -> x86 register for this trace */
+		int rv_map[16];   /* x86 register -> rv register for this trace */
+		Label start, term, helper_table;
+
+		/* minimum trace uses for a register to displace a pinned register */
+		static const size_t regalloc_min_gain = 2;
+
+		/* bumped when emitted code changes, invalidating saved traces */
+		static const int emitter_version = 1;
 
 		jit_emitter_rv64(P &proc, CodeHolder &code, mmu_ops &ops, TraceLookup lookup_trace_slow, TraceLookup lookup_trace_fast)
-			: proc(proc), as(&code), code(code), ops(ops),
+			: proc(proc), as(&code), code(code), ops(ops), dtlb(),
 			  lookup_trace_slow(lookup_trace_slow),
 			  lookup_trace_fast(lookup_trace_fast),
-			  term_pc(0), use_mmu(false)
-		{}
+			  term_pc(0), use_mmu(false), check_budget(false), remapped(false)
+		{
+			for (int i = 0; i < 32; i++) {
+				x86_map[i] = x86_reg_abi(i);
+			}
+			for (int i = 0; i < 16; i++) {
+				rv_map[i] = rv_reg_abi(i);
+			}
+		}
+
+		typename P::processor_type& proc_base()
+		{
+			return static_cast<typename P::processor_type&>(proc);
+		}
 
 		void log_trace(const char* fmt, ...)
 		{
@@ -148,7 +178,12 @@ namespace riscv {
 			return "";
 		}
 
-		static int x86_reg(int rd)
+		/*
+		 * Fixed register map used at trace boundaries. Traces are entered,
+		 * chained and exited with these registers live in host registers,
+		 * so lookup_trace_fast and trace fixups can jump between traces.
+		 */
+		static int x86_reg_abi(int rd)
 		{
 			switch (rd) {
 				case rv_ireg_zero: return 0;
@@ -168,6 +203,90 @@ namespace riscv {
 			return -1;
 		}
 
+		static int rv_reg_abi(int x86)
+		{
+			switch (x86) {
+				case 2:  return rv_ireg_ra; /* rdx */
+				case 3:  return rv_ireg_sp; /* rbx */
+				case 6:  return rv_ireg_t0; /* rsi */
+				case 7:  return rv_ireg_t1; /* rdi */
+				case 8:  return rv_ireg_a0; /* r8  */
+				case 9:  return rv_ireg_a1; /* r9  */
+				case 10: return rv_ireg_a2; /* r10 */
+				case 11: return rv_ireg_a3; /* r11 */
+				case 12: return rv_ireg_a4; /* r12 */
+				case 13: return rv_ireg_a5; /* r13 */
+				case 14: return rv_ireg_a6; /* r14 */
+				case 15: return rv_ireg_a7; /* r15 */
+			}
+			return -1;
+		}
+
+		/* register map for the current trace, see allocate_registers */
+		int x86_reg(int rd)
+		{
+			return x86_map[rd];
+		}
+
+		/*
+		 * Per-trace register allocation
+		 *
+		 * The pinned registers in x86_reg_abi that are cold in this trace
+		 * are handed to the hottest unpinned registers (e.g. s0-s11 loop
+		 * variables). Live ranges span the whole trace, so a register is
+		 * only filled at trace entry and spilled when leaving the trace.
+		 */
+		void allocate_registers(const size_t reg_uses[32])
+		{
+			std::vector<int> cand, victims;
+			for (int i = 1; i < 32; i++) {
+				if (x86_reg_abi(i) > 0) {
+					victims.push_back(i);
+				} else if (reg_uses[i] > 0) {
+					cand.push_back(i);
+				}
+			}
+			std::stable_sort(cand.begin(), cand.end(), [&](int a, int b) {
+				return reg_uses[a] > reg_uses[b];
+			});
+			std::stable_sort(victims.begin(), victims.end(), [&](int a, int b) {
+				return reg_uses[a] < reg_uses[b];
+			});
+			for (size_t i = 0; i < cand.size() && i < victims.size(); i++) {
+				int rv = cand[i], victim = victims[i];
+				if (reg_uses[rv] < reg_uses[victim] + regalloc_min_gain) break;
+				int x86 = x86_map[victim];
+				x86_map[victim] = -1;
+				x86_map[rv] = x86;
+				rv_map[x86] = rv;
+				remapped = true;
+				log_trace("\t# regalloc %s -> %s (spill %s)",
+					rv_ireg_name_sym[rv], x86_reg_str_q(x86), rv_ireg_name_sym[victim]);
+			}
+		}
+
+		/* switch from the fixed register map to the trace register map */
+		void emit_fill_trace_regs()
+		{
+			for (int x86 = 0; x86 < 16; x86++) {
+				int rv = rv_map[x86], abi = rv_reg_abi(x86);
+				if (rv == abi) continue;
+				as.mov(rbp_reg_q(abi), x86::gpq(x86));
+				as.mov(x86::gpq(x86), rbp_reg_q(rv));
+			}
+		}
+
+		/* switch from the trace register map back to the fixed register map */
+		void emit_spill_trace_regs()
+		{
+			for (int x86 = 0; x86 < 16; x86++) {
+				int rv = rv_map[x86], abi = rv_reg_abi(x86);
+				if (rv == abi) continue;
+				as.mov(rbp_reg_q(rv), x86::gpq(x86));
+				as.mov(x86::gpq(x86), rbp_reg_q(abi));
+			}
+		}
+
 		const char* rbp_reg_str_d(int reg)
 		{
 			static char buf[32];
@@ -192,6 +311,12 @@ namespace riscv {
 			return x86::qword_ptr(x86::rbp, proc_offset(ireg) + reg * (P::xlen >> 3));
 		}
 
+		/* rdx is borrowed by mul/div, so stash it in the slot of the rv register it holds */
+		const X86Mem rdx_save_slot()
+		{
+			return rbp_reg_q(rv_map[2]);
+		}
+
 		void emit_prolog()
 		{
 			as.push(x86::r12);
@@ -217,18 +342,11 @@ namespace riscv {
 
 		void emit_epilog()
 		{
-			as.mov(rbp_reg_q(rv_ireg_ra), x86::rdx);
-			as.mov(rbp_reg_q(rv_ireg_sp), x86::rbx);
-			as.mov(rbp_reg_q(rv_ireg_t0), x86::rsi);
-			as.mov(rbp_reg_q(rv_ireg_t1), x86::rdi);
-			as.mov(rbp_reg_q(rv_ireg_a0), x86::r8);
-			as.mov(rbp_reg_q(rv_ireg_a1), x86::r9);
-			as.mov(rbp_reg_q(rv_ireg_a2), x86::r10);
-			as.mov(rbp_reg_q(rv_ireg_a3), x86::r11);
-			as.mov(rbp_reg_q(rv_ireg_a4), x86::r12);
-			as.mov(rbp_reg_q(rv_ireg_a5), x86::r13);
-			as.mov(rbp_reg_q(rv_ireg_a6), x86::r14);
-			as.mov(rbp_reg_q(rv_ireg_a7), x86::r15);
+			for (int x86 = 0; x86 < 16; x86++) {
+				if (rv_map[x86] > 0) {
+					as.mov(rbp_reg_q(rv_map[x86]), x86::gpq(x86));
+				}
+			}
 			as.pop(x86::rbp);
 			as.pop(x86::rbx);
 			as.pop(x86::r15);
@@ -237,10 +355,27 @@ namespace riscv {
 			as.pop(x86::r12);
 			as.ret();
 
+			/* side exits to a pc recorded later in the trace join the trace */
+			for (auto &sel : side_exit_labels) {
+				as.bind(sel.second);
+				auto li = labels.find(sel.first);
+				if (li != labels.end()) {
+					as.jmp(li->second);
+				} else {
+					emit_exit_jump(sel.first);
+				}
+			}
+
 			for (auto &jtl : jmp_tramp_labels) {
 				as.bind(jtl.second);
 				emit_pc(jtl.first);
-				as.jmp(Imm(func_address(lookup_trace_fast)));
+				as.jmp(helper_ptr(jit_helper_lookup_trace));
+			}
+
+			for (auto &bel : back_edge_labels) {
+				as.bind(bel.second);
+				emit_budget_check(bel.first);
+				as.jmp(labels[bel.first]);
 			}
 
 			for (auto &jtl : exit_tramp_labels) {
@@ -248,6 +383,31 @@ namespace riscv {
 				emit_pc(jtl.first);
 				as.jmp(term);
 			}
+
+			emit_helper_table();
+		}
+
+		/* rip relative slot in the helper table emitted at the end of the trace */
+		X86Mem helper_ptr(jit_helper helper)
+		{
+			auto hl = helper_labels.find(helper);
+			if (hl == helper_labels.end()) {
+				hl = helper_labels.insert(helper_labels.end(),
+					std::pair<jit_helper,Label>(helper, as.newLabel()));
+			}
+			return x86::qword_ptr(hl->second);
+		}
+
+		void emit_helper_table()
+		{
+			as.align(kAlignData, 8);
+			helper_table = as.newLabel();
+			as.bind(helper_table);
+			for (auto &hl : helper_labels) {
+				intptr_t addr = jit_helper_address(hl.first, ops, lookup_trace_fast);
+				as.bind(hl.second);
+				as.embed(&addr, sizeof(addr));
+			}
 		}
 
 		TraceLookup create_trace_lookup(JitRuntime &rt)
@@ -313,26 +473,34 @@ namespace riscv {
 			return lookup_trace_fast;
 		}
 
+		/*
+		 * The load store stubs are shared by all traces, so volatile host
+		 * registers are saved on the stack rather than in the register file
+		 * as they may hold any rv register. 7 pushes plus the 8 byte pad
+		 * keep the stack 16 byte aligned for the call.
+		 */
 		void save_volatile()
 		{
-			as.mov(rbp_reg_q(rv_ireg_ra), x86::rdx);
-			as.mov(rbp_reg_q(rv_ireg_t0), x86::rsi);
-			as.mov(rbp_reg_q(rv_ireg_t1), x86::rdi);
-			as.mov(rbp_reg_q(rv_ireg_a0), x86::r8);
-			as.mov(rbp_reg_q(rv_ireg_a1), x86::r9);
-			as.mov(rbp_reg_q(rv_ireg_a2), x86::r10);
-			as.mov(rbp_reg_q(rv_ireg_a3), x86::r11);
+			as.push(x86::rdx);
+			as.push(x86::rsi);
+			as.push(x86::rdi);
+			as.push(x86::r8);
+			as.push(x86::r9);
+			as.push(x86::r10);
+			as.push(x86::r11);
+			as.sub(x86::rsp, Imm(8));
 		}
 
 		void restore_volatile()
 		{
-			as.mov(x86::rdx, rbp_reg_q(rv_ireg_ra));
-			as.mov(x86::rsi, rbp_reg_q(rv_ireg_t0));
-			as.mov(x86::rdi, rbp_reg_q(rv_ireg_t1));
-			as.mov(x86::r8, rbp_reg_q(rv_ireg_a0));
-			as.mov(x86::r9, rbp_reg_q(rv_ireg_a1));
-			as.mov(x86::r10, rbp_reg_q(rv_ireg_a2));
-			as.mov(x86::r11, rbp_reg_q(rv_ireg_a3));
+			as.add(x86::rsp, Imm(8));
+			as.pop(x86::r11);
+			as.pop(x86::r10);
+			as.pop(x86::r9);
+			as.pop(x86::r8);
+			as.pop(x86::rdi);
+			as.pop(x86::rsi);
+			as.pop(x86::rdx);
 		}
 
 		mmu_ops create_load_store(JitRuntime &rt)
@@ -436,12 +604,21 @@ namespace riscv {
 			term = as.newLabel();
 			start = as.newLabel();
 			as.bind(start);
+			if (remapped) {
+				emit_fill_trace_regs();
+			}
 		}
 
 		void end()
 		{
 			if (term_pc) {
-				emit_pc(term_pc);
+				auto li = labels.find(term_pc);
+				if (li != labels.end()) {
+					/* a jump back into the trace closes the loop */
+					as.jmp(back_edge(term_pc, li->second));
+				} else {
+					emit_pc(term_pc);
+				}
 				log_trace("\t# 0x%016llx", term_pc);
 			}
 			as.bind(term);
@@ -826,7 +1003,7 @@ namespace riscv {
 			}
 			else {
 				if (rdx != 2 /* x86::rdx */) {
-					as.mov(x86::qword_ptr(x86::rbp, proc_offset(ireg[rv_ireg_ra])), x86::rdx);
+					as.mov(rdx_save_slot(), x86::rdx);
 				}
 
 				emit_mv_rax_rs1(dec);
@@ -845,7 +1022,7 @@ namespace riscv {
 				}
 
 				if (rdx != 2 /* x86::rdx */) {
-					as.mov(x86::rdx, x86::qword_ptr(x86::rbp, proc_offset(ireg[rv_ireg_ra])));
+					as.mov(x86::rdx, rdx_save_slot());
 				}
 			}
 			return true;
@@ -864,7 +1041,7 @@ namespace riscv {
 			}
 			else {
 				if (rdx != 2 /* x86::rdx */) {
-					as.mov(x86::qword_ptr(x86::rbp, proc_offset(ireg[rv_ireg_ra])), x86::rdx);
+					as.mov(rdx_save_slot(), x86::rdx);
 				}
 
 				emit_mv_rax_rs1(dec);
@@ -883,7 +1060,7 @@ namespace riscv {
 				}
 
 				if (rdx != 2 /* x86::rdx */) {
-					as.mov(x86::rdx, x86::qword_ptr(x86::rbp, proc_offset(ireg[rv_ireg_ra])));
+					as.mov(x86::rdx, rdx_save_slot());
 				}
 			}
 			return true;
@@ -902,7 +1079,7 @@ namespace riscv {
 			}
 			else {
 				if (rdx != 2 /* x86::rdx */ || (rs1x == 2 /* x86::rdx */ || rs2x == 2 /* x86::rdx */)) {
-					as.mov(x86::qword_ptr(x86::rbp, proc_offset(ireg[rv_ireg_ra])), x86::rdx);
+					as.mov(rdx_save_slot(), x86::rdx);
 				}
 
 				/* if rs1 is positive branch to umul */
@@ -925,7 +1102,7 @@ namespace riscv {
 
 				/* if necessary restore rdx input operand */
 				if (rs1x == 2 || rs2x == 2 /* x86::rdx */) {
-					as.mov(x86::rdx, x86::qword_ptr(x86::rbp, proc_offset(ireg[rv_ireg_ra])));
+					as.mov(x86::rdx, rdx_save_slot());
 				}
 
 				/* second multiply */
@@ -963,7 +1140,7 @@ namespace riscv {
 				}
 
 				if (rdx != 2 /* x86::rdx */) {
-					as.mov(x86::rdx, x86::qword_ptr(x86::rbp, proc_offset(ireg[rv_ireg_ra])));
+					as.mov(x86::rdx, rdx_save_slot());
 				}
 			}
 			return true;
@@ -2825,21 +3002,53 @@ namespace riscv {
 			return jfl;
 		}
 
-		void emit_jump_fixup(addr_t pc)
+		/*
+		 * decrement the trace budget and leave the trace at pc when it is
+		 * exhausted so that the run loop can service interrupts
+		 */
+		void emit_budget_check(addr_t pc)
 		{
-			auto jtl = create_jump_tramp(pc);
-			auto jfl = create_jump_fixup(pc);
-			as.jmp(jtl->second);
-			Label label = as.newLabel();
-			as.bind(label);
-			jfl->second.push_back(label);
+			auto etl = create_exit_tramp(pc);
+			as.sub(x86::qword_ptr(x86::rbp, proc_offset(trace_budget)), Imm(1));
+			as.js(etl->second);
+		}
+
+		/*
+		 * label for a branch leaving the trace. side exits are emitted after
+		 * the trace body so that the recorded path falls through and so
+		 * they can be resolved once the whole trace is known
+		 */
+		Label side_exit(addr_t pc)
+		{
+			auto sel = side_exit_labels.find(pc);
+			if (sel == side_exit_labels.end()) {
+				sel = side_exit_labels.insert(side_exit_labels.end(),
+					std::pair<addr_t,Label>(pc, as.newLabel()));
+			}
+			return sel->second;
 		}
 
-		void emit_branch_fixup(x86::Cond bf, addr_t pc)
+		/* label for a branch back into the trace, checking the budget if enabled */
+		Label back_edge(addr_t pc, Label target)
+		{
+			if (!check_budget) return target;
+			auto bel = back_edge_labels.find(pc);
+			if (bel == back_edge_labels.end()) {
+				bel = back_edge_labels.insert(back_edge_labels.end(),
+					std::pair<addr_t,Label>(pc, as.newLabel()));
+			}
+			return bel->second;
+		}
+
+		/*
+		 * jumps to other traces always go through a fixup, which the run
+		 * loop links to the target trace and unlinks if it is invalidated
+		 */
+		void emit_jump_fixup(addr_t pc)
 		{
 			auto jtl = create_jump_tramp(pc);
 			auto jfl = create_jump_fixup(pc);
-			as.j(bf, jtl->second);
+			as.jmp(jtl->second);
 			Label label = as.newLabel();
 			as.bind(label);
 			jfl->second.push_back(label);
@@ -2856,82 +3065,65 @@ namespace riscv {
 			emit_cmp(dec);
 
 			if (branch_i != labels.end() && cont_i != labels.end()) {
-				as.j(bf, branch_i->second);
-				as.jmp(cont_i->second);
+				as.j(bf, back_edge(branch_pc, branch_i->second));
+				as.jmp(back_edge(cont_pc, cont_i->second));
 			}
 			else if (cond && branch_i != labels.end()) {
-				as.j(bf, branch_i->second);
-				uintptr_t cont_addr = lookup_trace_slow(cont_pc);
-				if (cont_addr) {
-					as.jmp(Imm(cont_addr));
-				} else {
-					emit_jump_fixup(cont_pc);
-				}
+				as.j(bf, back_edge(branch_pc, branch_i->second));
+				emit_exit_jump(cont_pc);
 				term_pc = 0;
 			}
 			else if (!cond && cont_i != labels.end()) {
-				as.j(ibf, cont_i->second);
-				uintptr_t branch_addr = lookup_trace_slow(branch_pc);
-				if (branch_addr) {
-					as.jmp(Imm(branch_addr));
-				} else {
-					emit_jump_fixup(branch_pc);
-				}
+				as.j(ibf, back_edge(cont_pc, cont_i->second));
+				emit_exit_jump(branch_pc);
 				term_pc = 0;
 			} else if (cond) {
-				uintptr_t cont_addr = lookup_trace_slow(cont_pc);
-				if (cont_addr) {
-					as.j(ibf, Imm(cont_addr));
-				} else {
-					emit_branch_fixup(ibf, cont_pc);
-				}
+				as.j(ibf, side_exit(cont_pc));
 				term_pc = branch_pc;
 			} else {
-				uintptr_t branch_addr = lookup_trace_slow(branch_pc);
-				if (branch_addr) {
-					as.j(bf, Imm(branch_addr));
-				} else {
-					emit_branch_fixup(bf, branch_pc);
-				}
+				as.j(bf, side_exit(branch_pc));
 				term_pc = cont_pc;
 			}
 			return true;
 		}
 
+		/* leave the trace, chaining to the target trace once it exists */
+		void emit_exit_jump(addr_t pc)
+		{
+			if (remapped) {
+				emit_spill_trace_regs();
+			}
+			emit_jump_fixup(pc);
+		}
+
 		bool emit_bne(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.x.val != proc.ireg[dec.rs2].r.x.val;
-			return emit_branch(dec, cond, x86::kCondNE, x86::kCondE);
+			return emit_branch(dec, dec.taken, x86::kCondNE, x86::kCondE);
 		}
 
 		bool emit_beq(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.x.val == proc.ireg[dec.rs2].r.x.val;
-			return emit_branch(dec, cond, x86::kCondE, x86::kCondNE);
+			return emit_branch(dec, dec.taken, x86::kCondE, x86::kCondNE);
 		}
 
 		bool emit_blt(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.x.val < proc.ireg[dec.rs2].r.x.val;
-			return emit_branch(dec, cond, x86::kCondL, x86::kCondGE);
+			return emit_branch(dec, dec.taken, x86::kCondL, x86::kCondGE);
 		}
 
 		bool emit_bge(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.x.val >= proc.ireg[dec.rs2].r.x.val;
-			return emit_branch(dec, cond, x86::kCondGE, x86::kCondL);
+			return emit_branch(dec, dec.taken, x86::kCondGE, x86::kCondL);
 		}
 
 		bool emit_bltu(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.xu.val < proc.ireg[dec.rs2].r.xu.val;
-			return emit_branch(dec, cond, x86::kCondB, x86::kCondAE);
+			return emit_branch(dec, dec.taken, x86::kCondB, x86::kCondAE);
 		}
 
 		bool emit_bgeu(decode_type &dec)
 		{
-			bool cond = proc.ireg[dec.rs1].r.xu.val >= proc.ireg[dec.rs2].r.xu.val;
-			return emit_branch(dec, cond, x86::kCondAE, x86::kCondB);
+			return emit_branch(dec, dec.taken, x86::kCondAE, x86::kCondB);
 		}
 
 		bool emit_ld(decode_type &dec)
@@ -2939,7 +3131,7 @@ namespace riscv {
 			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
 			term_pc = dec.pc + inst_length(dec.inst);
 			int rdx = x86_reg(dec.rd), rs1x = x86_reg(dec.rs1);
-			if (dec.rd == rv_ireg_zero) {
+			if (dec.rd == rv_ireg_zero && !use_mmu) {
 				// nop
 			}
 			else {
@@ -2954,14 +3146,18 @@ namespace riscv {
 						as.mov(x86::rcx, rbp_reg_q(dec.rs1));
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.ld)));
 					auto okay = as.newLabel();
+					emit_tlb_load(8, okay);
+					as.call(helper_ptr(jit_helper_ld));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
 					as.jmp(term);
 					as.bind(okay);
-					if (rdx > 0) {
+					if (dec.rd == rv_ireg_zero) {
+						/* loads to x0 still translate and may fault */
+					}
+					else if (rdx > 0) {
 						as.mov(x86::gpq(rdx), x86::rax);
 					} else {
 						as.mov(rbp_reg_q(dec.rd), x86::rax);
@@ -2993,7 +3189,7 @@ namespace riscv {
 			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
 			term_pc = dec.pc + inst_length(dec.inst);
 			int rdx = x86_reg(dec.rd), rs1x = x86_reg(dec.rs1);
-			if (dec.rd == rv_ireg_zero) {
+			if (dec.rd == rv_ireg_zero && !use_mmu) {
 				// nop
 			}
 			else {
@@ -3008,14 +3204,18 @@ namespace riscv {
 						as.mov(x86::rcx, rbp_reg_q(dec.rs1));
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lw)));
 					auto okay = as.newLabel();
+					emit_tlb_load(4, okay);
+					as.call(helper_ptr(jit_helper_lw));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
 					as.jmp(term);
 					as.bind(okay);
-					if (rdx > 0) {
+					if (dec.rd == rv_ireg_zero) {
+						/* loads to x0 still translate and may fault */
+					}
+					else if (rdx > 0) {
 						as.movsxd(x86::gpq(rdx), x86::eax);
 					} else {
 						as.movsxd(x86::rax, x86::eax);
@@ -3048,7 +3248,7 @@ namespace riscv {
 			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
 			term_pc = dec.pc + inst_length(dec.inst);
 			int rdx = x86_reg(dec.rd), rs1x = x86_reg(dec.rs1);
-			if (dec.rd == rv_ireg_zero) {
+			if (dec.rd == rv_ireg_zero && !use_mmu) {
 				// nop
 			}
 			else {
@@ -3063,14 +3263,18 @@ namespace riscv {
 						as.mov(x86::rcx, rbp_reg_q(dec.rs1));
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lw)));
 					auto okay = as.newLabel();
+					emit_tlb_load(4, okay);
+					as.call(helper_ptr(jit_helper_lw));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
 					as.jmp(term);
 					as.bind(okay);
-					if (rdx > 0) {
+					if (dec.rd == rv_ireg_zero) {
+						/* loads to x0 still translate and may fault */
+					}
+					else if (rdx > 0) {
 						as.mov(x86::gpd(rdx), x86::eax);
 					} else {
 						as.mov(rbp_reg_q(dec.rd), x86::rax);
@@ -3102,7 +3306,7 @@ namespace riscv {
 			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
 			term_pc = dec.pc + inst_length(dec.inst);
 			int rdx = x86_reg(dec.rd), rs1x = x86_reg(dec.rs1);
-			if (dec.rd == rv_ireg_zero) {
+			if (dec.rd == rv_ireg_zero && !use_mmu) {
 				// nop
 			}
 			else {
@@ -3117,14 +3321,18 @@ namespace riscv {
 						as.mov(x86::rcx, rbp_reg_q(dec.rs1));
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lh)));
 					auto okay = as.newLabel();
+					emit_tlb_load(2, okay);
+					as.call(helper_ptr(jit_helper_lh));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
 					as.jmp(term);
 					as.bind(okay);
-					if (rdx > 0) {
+					if (dec.rd == rv_ireg_zero) {
+						/* loads to x0 still translate and may fault */
+					}
+					else if (rdx > 0) {
 						as.movsx(x86::gpq(rdx), x86::ax);
 					} else {
 						as.movsx(x86::rax, x86::ax);
@@ -3157,7 +3365,7 @@ namespace riscv {
 			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
 			term_pc = dec.pc + inst_length(dec.inst);
 			int rdx = x86_reg(dec.rd), rs1x = x86_reg(dec.rs1);
-			if (dec.rd == rv_ireg_zero) {
+			if (dec.rd == rv_ireg_zero && !use_mmu) {
 				// nop
 			}
 			else {
@@ -3172,14 +3380,18 @@ namespace riscv {
 						as.mov(x86::rcx, rbp_reg_q(dec.rs1));
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lh)));
 					auto okay = as.newLabel();
+					emit_tlb_load(2, okay);
+					as.call(helper_ptr(jit_helper_lh));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
 					as.jmp(term);
 					as.bind(okay);
-					if (rdx > 0) {
+					if (dec.rd == rv_ireg_zero) {
+						/* loads to x0 still translate and may fault */
+					}
+					else if (rdx > 0) {
 						as.mov(x86::gpd(rdx), x86::eax);
 					} else {
 						as.mov(rbp_reg_q(dec.rd), x86::rax);
@@ -3211,7 +3423,7 @@ namespace riscv {
 			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
 			term_pc = dec.pc + inst_length(dec.inst);
 			int rdx = x86_reg(dec.rd), rs1x = x86_reg(dec.rs1);
-			if (dec.rd == rv_ireg_zero) {
+			if (dec.rd == rv_ireg_zero && !use_mmu) {
 				// nop
 			}
 			else {
@@ -3226,14 +3438,18 @@ namespace riscv {
 						as.mov(x86::rcx, rbp_reg_q(dec.rs1));
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lb)));
 					auto okay = as.newLabel();
+					emit_tlb_load(1, okay);
+					as.call(helper_ptr(jit_helper_lb));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
 					as.jmp(term);
 					as.bind(okay);
-					if (rdx > 0) {
+					if (dec.rd == rv_ireg_zero) {
+						/* loads to x0 still translate and may fault */
+					}
+					else if (rdx > 0) {
 						as.movsx(x86::gpq(rdx), x86::al);
 					} else {
 						as.movsx(x86::rax, x86::al);
@@ -3266,7 +3482,7 @@ namespace riscv {
 			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
 			term_pc = dec.pc + inst_length(dec.inst);
 			int rdx = x86_reg(dec.rd), rs1x = x86_reg(dec.rs1);
-			if (dec.rd == rv_ireg_zero) {
+			if (dec.rd == rv_ireg_zero && !use_mmu) {
 				// nop
 			}
 			else {
@@ -3281,14 +3497,18 @@ namespace riscv {
 						as.mov(x86::rcx, rbp_reg_q(dec.rs1));
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
-					as.call(Imm(func_address(ops.lb)));
 					auto okay = as.newLabel();
+					emit_tlb_load(1, okay);
+					as.call(helper_ptr(jit_helper_lb));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
 					as.jmp(term);
 					as.bind(okay);
-					if (rdx > 0) {
+					if (dec.rd == rv_ireg_zero) {
+						/* loads to x0 still translate and may fault */
+					}
+					else if (rdx > 0) {
 						as.mov(x86::gpd(rdx), x86::eax);
 					} else {
 						as.mov(rbp_reg_q(dec.rd), x86::rax);
@@ -3329,8 +3549,9 @@ namespace riscv {
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
 					as.xor_(x86::ecx, x86::ecx);
-					as.call(Imm(func_address(ops.sd)));
 					auto okay = as.newLabel();
+					emit_tlb_store(8, okay);
+					as.call(helper_ptr(jit_helper_sd));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
@@ -3357,8 +3578,9 @@ namespace riscv {
 					} else {
 						as.mov(x86::rcx, rbp_reg_q(dec.rs2));
 					}
-					as.call(Imm(func_address(ops.sd)));
 					auto okay = as.newLabel();
+					emit_tlb_store(8, okay);
+					as.call(helper_ptr(jit_helper_sd));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
@@ -3401,8 +3623,9 @@ namespace riscv {
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
 					as.xor_(x86::ecx, x86::ecx);
-					as.call(Imm(func_address(ops.sw)));
 					auto okay = as.newLabel();
+					emit_tlb_store(4, okay);
+					as.call(helper_ptr(jit_helper_sw));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
@@ -3429,8 +3652,9 @@ namespace riscv {
 					} else {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs2));
 					}
-					as.call(Imm(func_address(ops.sw)));
 					auto okay = as.newLabel();
+					emit_tlb_store(4, okay);
+					as.call(helper_ptr(jit_helper_sw));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
@@ -3472,8 +3696,9 @@ namespace riscv {
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
 					as.xor_(x86::ecx, x86::ecx);
-					as.call(Imm(func_address(ops.sh)));
 					auto okay = as.newLabel();
+					emit_tlb_store(2, okay);
+					as.call(helper_ptr(jit_helper_sh));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
@@ -3501,8 +3726,9 @@ namespace riscv {
 					} else {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs2));
 					}
-					as.call(Imm(func_address(ops.sh)));
 					auto okay = as.newLabel();
+					emit_tlb_store(2, okay);
+					as.call(helper_ptr(jit_helper_sh));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
@@ -3544,8 +3770,9 @@ namespace riscv {
 						as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
 					}
 					as.xor_(x86::ecx, x86::ecx);
-					as.call(Imm(func_address(ops.sb)));
 					auto okay = as.newLabel();
+					emit_tlb_store(1, okay);
+					as.call(helper_ptr(jit_helper_sb));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
@@ -3573,8 +3800,9 @@ namespace riscv {
 					} else {
 						as.mov(x86::ecx, rbp_reg_d(dec.rs2));
 					}
-					as.call(Imm(func_address(ops.sb)));
 					auto okay = as.newLabel();
+					emit_tlb_store(1, okay);
+					as.call(helper_ptr(jit_helper_sb));
 					as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
 					as.je(okay);
 					emit_pc(dec.pc);
@@ -3649,7 +3877,12 @@ namespace riscv {
 				callstack.pop_back();
 
 				auto etl = create_exit_tramp(dec.pc);
-				as.cmp(x86::gpq(x86_reg(rv_ireg_ra)), Imm(link_addr));
+				int linkx = x86_reg(rv_ireg_ra);
+				if (linkx > 0) {
+					as.cmp(x86::gpq(linkx), Imm(link_addr));
+				} else {
+					as.cmp(rbp_reg_q(rv_ireg_ra), Imm(link_addr));
+				}
 				as.jne(etl->second);
 
 				return true;
@@ -3686,7 +3919,10 @@ namespace riscv {
 					as.mov(rbp_reg_q(dec.rd), x86::rax);
 				}
 
-				as.jmp(Imm(func_address(lookup_trace_fast)));
+				if (remapped) {
+					emit_spill_trace_regs();
+				}
+				as.jmp(helper_ptr(jit_helper_lookup_trace));
 
 				return false;
 			}
@@ -3727,14 +3963,14 @@ namespace riscv {
 				as.mov(x86::gpq(rs1x), Imm(term_pc));
 			} else {
 				as.mov(x86::rax, Imm(term_pc));
-				as.mov(rbp_reg_q(dec.rs1), x86::rax);
+				as.mov(rbp_reg_q(dec.rd), x86::rax);
 			}
 
 			if (rdx > 0) {
 				as.mov(x86::gpq(rdx), Imm(link_addr));
 			} else {
 				as.mov(x86::rax, Imm(link_addr));
-				as.mov(rbp_reg_q(dec.rd), x86::rax);
+				as.mov(rbp_reg_q(rv_ireg_ra), x86::rax);
 			}
 
 			return true;
@@ -3794,15 +4030,593 @@ namespace riscv {
 			return true;
 		}
 
+		/*
+		 * Floating point
+		 *
+		 * The interpreter keeps the host rounding mode in sync with frm and
+		 * reads accrued exceptions from the host floating point environment
+		 * (fenv_setrm, fenv_getflags), so scalar SSE ops that use the host
+		 * MXCSR have the same fflags and frm semantics. Conversions to
+		 * integer and fclass are left to the interpreter.
+		 */
+
+		const X86Mem rbp_freg_d(int reg)
+		{
+			return x86::dword_ptr(x86::rbp, proc_offset(freg) + reg * sizeof(typename P::freg_t));
+		}
+
+		const X86Mem rbp_freg_q(int reg)
+		{
+			return x86::qword_ptr(x86::rbp, proc_offset(freg) + reg * sizeof(typename P::freg_t));
+		}
+
+		void emit_mv_rax_addr(decode_type &dec)
+		{
+			int rs1x = x86_reg(dec.rs1);
+			if (dec.rs1 == rv_ireg_zero) {
+				as.mov(x86::rax, Imm(dec.imm));
+			}
+			else if (rs1x > 0) {
+				as.lea(x86::rax, x86::qword_ptr(x86::gpq(rs1x), dec.imm));
+			}
+			else {
+				as.mov(x86::rcx, rbp_reg_q(dec.rs1));
+				as.lea(x86::rax, x86::qword_ptr(x86::rcx, dec.imm));
+			}
+		}
+
+		void emit_mmu_check(decode_type &dec, Label okay)
+		{
+			as.cmp(x86::qword_ptr(x86::rbp, proc_offset(cause)), Imm(0));
+			as.je(okay);
+			emit_pc(dec.pc);
+			as.jmp(term);
+			as.bind(okay);
+		}
+
+		/*
+		 * probe the soft TLB for the guest address in rax, branching to miss
+		 * if the entry tag does not match the page or the access is not
+		 * naturally aligned, otherwise adding the host addend to rax.
+		 * clobbers rcx; rdx is preserved on the stack.
+		 */
+		void emit_tlb_probe(size_t tag, size_t size, Label miss)
+		{
+			as.push(x86::rdx);
+			as.mov(x86::rdx, x86::rax);
+			as.mov(x86::ecx, x86::eax);
+			as.shr(x86::ecx, Imm(page_shift));
+			as.and_(x86::ecx, Imm(dtlb.mask));
+			as.imul(x86::ecx, x86::ecx, Imm(dtlb.entry_size));
+			as.and_(x86::rdx, Imm(int32_t(~(page_size - 1) | (size - 1))));
+			as.cmp(x86::rdx, x86::qword_ptr(x86::rbp, x86::rcx, 0, int32_t(dtlb.entries + tag)));
+			as.pop(x86::rdx);
+			as.jne(miss);
+			as.add(x86::rax, x86::qword_ptr(x86::rbp, x86::rcx, 0, int32_t(dtlb.entries + dtlb.addend)));
+		}
+
+		/* inline load on TLB hit (zero extended into rax), falls through on miss */
+		void emit_tlb_load(size_t size, Label hit)
+		{
+			if (!dtlb.entries) return;
+			auto miss = as.newLabel();
+			emit_tlb_probe(dtlb.ltag, size, miss);
+			switch (size) {
+				case 1: as.movzx(x86::eax, x86::byte_ptr(x86::rax)); break;
+				case 2: as.movzx(x86::eax, x86::word_ptr(x86::rax)); break;
+				case 4: as.mov(x86::eax, x86::dword_ptr(x86::rax)); break;
+				case 8: as.mov(x86::rax, x86::qword_ptr(x86::rax)); break;
+			}
+			as.jmp(hit);
+			as.bind(miss);
+		}
+
+		/* inline store of rcx on TLB hit, falls through on miss */
+		void emit_tlb_store(size_t size, Label hit)
+		{
+			if (!dtlb.entries) return;
+			auto miss = as.newLabel();
+			as.push(x86::rcx);
+			emit_tlb_probe(dtlb.stag, size, miss);
+			as.pop(x86::rcx);
+			switch (size) {
+				case 1: as.mov(x86::byte_ptr(x86::rax), x86::cl); break;
+				case 2: as.mov(x86::word_ptr(x86::rax), x86::cx); break;
+				case 4: as.mov(x86::dword_ptr(x86::rax), x86::ecx); break;
+				case 8: as.mov(x86::qword_ptr(x86::rax), x86::rcx); break;
+			}
+			as.jmp(hit);
+			as.bind(miss);
+			as.pop(x86::rcx);
+		}
+
+		bool emit_fld(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			int rs1x = x86_reg(dec.rs1);
+			if (use_mmu) {
+				emit_mv_rax_addr(dec);
+				auto okay = as.newLabel();
+				emit_tlb_load(8, okay);
+				as.call(helper_ptr(jit_helper_ld));
+				emit_mmu_check(dec, okay);
+			}
+			else if (rs1x > 0) {
+				as.mov(x86::rax, x86::qword_ptr(x86::gpq(rs1x), dec.imm));
+			}
+			else {
+				as.mov(x86::rax, rbp_reg_q(dec.rs1));
+				as.mov(x86::rax, x86::qword_ptr(x86::rax, dec.imm));
+			}
+			as.mov(rbp_freg_q(dec.rd), x86::rax);
+			return true;
+		}
+
+		bool emit_flw(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			int rs1x = x86_reg(dec.rs1);
+			if (use_mmu) {
+				emit_mv_rax_addr(dec);
+				auto okay = as.newLabel();
+				emit_tlb_load(4, okay);
+				as.call(helper_ptr(jit_helper_lw));
+				emit_mmu_check(dec, okay);
+			}
+			else if (rs1x > 0) {
+				as.mov(x86::eax, x86::dword_ptr(x86::gpq(rs1x), dec.imm));
+			}
+			else {
+				as.mov(x86::rax, rbp_reg_q(dec.rs1));
+				as.mov(x86::eax, x86::dword_ptr(x86::rax, dec.imm));
+			}
+			as.mov(rbp_freg_d(dec.rd), x86::eax);
+			return true;
+		}
+
+		bool emit_fsd(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			int rs1x = x86_reg(dec.rs1);
+			if (use_mmu) {
+				emit_mv_rax_addr(dec);
+				as.mov(x86::rcx, rbp_freg_q(dec.rs2));
+				auto okay = as.newLabel();
+				emit_tlb_store(8, okay);
+				as.call(helper_ptr(jit_helper_sd));
+				emit_mmu_check(dec, okay);
+			}
+			else if (rs1x > 0) {
+				as.mov(x86::rcx, rbp_freg_q(dec.rs2));
+				as.mov(x86::qword_ptr(x86::gpq(rs1x), dec.imm), x86::rcx);
+			}
+			else {
+				as.mov(x86::rcx, rbp_freg_q(dec.rs2));
+				as.mov(x86::rax, rbp_reg_q(dec.rs1));
+				as.mov(x86::qword_ptr(x86::rax, dec.imm), x86::rcx);
+			}
+			return true;
+		}
+
+		bool emit_fsw(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			int rs1x = x86_reg(dec.rs1);
+			if (use_mmu) {
+				emit_mv_rax_addr(dec);
+				as.mov(x86::ecx, rbp_freg_d(dec.rs2));
+				auto okay = as.newLabel();
+				emit_tlb_store(4, okay);
+				as.call(helper_ptr(jit_helper_sw));
+				emit_mmu_check(dec, okay);
+			}
+			else if (rs1x > 0) {
+				as.mov(x86::ecx, rbp_freg_d(dec.rs2));
+				as.mov(x86::dword_ptr(x86::gpq(rs1x), dec.imm), x86::ecx);
+			}
+			else {
+				as.mov(x86::ecx, rbp_freg_d(dec.rs2));
+				as.mov(x86::rax, rbp_reg_q(dec.rs1));
+				as.mov(x86::dword_ptr(x86::rax, dec.imm), x86::ecx);
+			}
+			return true;
+		}
+
+		bool emit_fop_d(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			switch (dec.op) {
+				case rv_op_fadd_d:
+					as.movsd(x86::xmm0, rbp_freg_q(dec.rs1));
+					as.addsd(x86::xmm0, rbp_freg_q(dec.rs2));
+					break;
+				case rv_op_fsub_d:
+					as.movsd(x86::xmm0, rbp_freg_q(dec.rs1));
+					as.subsd(x86::xmm0, rbp_freg_q(dec.rs2));
+					break;
+				case rv_op_fmul_d:
+					as.movsd(x86::xmm0, rbp_freg_q(dec.rs1));
+					as.mulsd(x86::xmm0, rbp_freg_q(dec.rs2));
+					break;
+				case rv_op_fdiv_d:
+					as.movsd(x86::xmm0, rbp_freg_q(dec.rs1));
+					as.divsd(x86::xmm0, rbp_freg_q(dec.rs2));
+					break;
+				case rv_op_fsqrt_d:
+					as.sqrtsd(x86::xmm0, rbp_freg_q(dec.rs1));
+					break;
+				case rv_op_fcvt_d_s:
+					as.cvtss2sd(x86::xmm0, rbp_freg_d(dec.rs1));
+					break;
+				default:
+					return false;
+			}
+			as.movsd(rbp_freg_q(dec.rd), x86::xmm0);
+			return true;
+		}
+
+		bool emit_fop_s(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			switch (dec.op) {
+				case rv_op_fadd_s:
+					as.movss(x86::xmm0, rbp_freg_d(dec.rs1));
+					as.addss(x86::xmm0, rbp_freg_d(dec.rs2));
+					break;
+				case rv_op_fsub_s:
+					as.movss(x86::xmm0, rbp_freg_d(dec.rs1));
+					as.subss(x86::xmm0, rbp_freg_d(dec.rs2));
+					break;
+				case rv_op_fmul_s:
+					as.movss(x86::xmm0, rbp_freg_d(dec.rs1));
+					as.mulss(x86::xmm0, rbp_freg_d(dec.rs2));
+					break;
+				case rv_op_fdiv_s:
+					as.movss(x86::xmm0, rbp_freg_d(dec.rs1));
+					as.divss(x86::xmm0, rbp_freg_d(dec.rs2));
+					break;
+				case rv_op_fsqrt_s:
+					as.sqrtss(x86::xmm0, rbp_freg_d(dec.rs1));
+					break;
+				case rv_op_fcvt_s_d:
+					as.cvtsd2ss(x86::xmm0, rbp_freg_q(dec.rs1));
+					break;
+				default:
+					return false;
+			}
+			as.movss(rbp_freg_d(dec.rd), x86::xmm0);
+			return true;
+		}
+
+		bool emit_fmadd_d(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			/*
+			 * the interpreter computes rs1 * -rs2 +/- rs3 unfused, so the product
+			 * is rounded before the add here too rather than using FMA3, and
+			 * traces give the same result and fflags on every host
+			 */
+			as.mov(x86::rax, rbp_freg_q(dec.rs2));
+			if (dec.op == rv_op_fnmsub_d || dec.op == rv_op_fnmadd_d) {
+				as.btc(x86::rax, Imm(63));
+			}
+			as.movq(x86::xmm0, x86::rax);
+			as.mulsd(x86::xmm0, rbp_freg_q(dec.rs1));
+			switch (dec.op) {
+				case rv_op_fmadd_d:
+				case rv_op_fnmsub_d: as.addsd(x86::xmm0, rbp_freg_q(dec.rs3)); break;
+				case rv_op_fmsub_d:
+				case rv_op_fnmadd_d: as.subsd(x86::xmm0, rbp_freg_q(dec.rs3)); break;
+				default: return false;
+			}
+			as.movsd(rbp_freg_q(dec.rd), x86::xmm0);
+			return true;
+		}
+
+		bool emit_fmadd_s(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			/* unfused as in emit_fmadd_d */
+			as.mov(x86::eax, rbp_freg_d(dec.rs2));
+			if (dec.op == rv_op_fnmsub_s || dec.op == rv_op_fnmadd_s) {
+				as.btc(x86::eax, Imm(31));
+			}
+			as.movd(x86::xmm0, x86::eax);
+			as.mulss(x86::xmm0, rbp_freg_d(dec.rs1));
+			switch (dec.op) {
+				case rv_op_fmadd_s:
+				case rv_op_fnmsub_s: as.addss(x86::xmm0, rbp_freg_d(dec.rs3)); break;
+				case rv_op_fmsub_s:
+				case rv_op_fnmadd_s: as.subss(x86::xmm0, rbp_freg_d(dec.rs3)); break;
+				default: return false;
+			}
+			as.movss(rbp_freg_d(dec.rd), x86::xmm0);
+			return true;
+		}
+
+		bool emit_fsgnj_d(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			as.mov(x86::rax, rbp_freg_q(dec.rs1));
+			as.mov(x86::rcx, rbp_freg_q(dec.rs2));
+			if (dec.op == rv_op_fsgnjn_d) {
+				as.not_(x86::rcx);
+			}
+			as.shr(x86::rcx, Imm(63));
+			as.shl(x86::rcx, Imm(63));
+			if (dec.op != rv_op_fsgnjx_d) {
+				as.btr(x86::rax, Imm(63));
+				as.or_(x86::rax, x86::rcx);
+			} else {
+				as.xor_(x86::rax, x86::rcx);
+			}
+			as.mov(rbp_freg_q(dec.rd), x86::rax);
+			return true;
+		}
+
+		bool emit_fsgnj_s(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			as.mov(x86::eax, rbp_freg_d(dec.rs1));
+			as.mov(x86::ecx, rbp_freg_d(dec.rs2));
+			if (dec.op == rv_op_fsgnjn_s) {
+				as.not_(x86::ecx);
+			}
+			as.and_(x86::ecx, Imm(0x80000000));
+			if (dec.op != rv_op_fsgnjx_s) {
+				as.and_(x86::eax, Imm(0x7fffffff));
+				as.or_(x86::eax, x86::ecx);
+			} else {
+				as.xor_(x86::eax, x86::ecx);
+			}
+			as.mov(rbp_freg_d(dec.rd), x86::eax);
+			return true;
+		}
+
+		/*
+		 * fmin/fmax: rs1 if (rs1 < rs2) || isnan(rs2) else rs2, using the
+		 * same signalling (comisd) and quiet (ucomisd) compares as the
+		 * interpreter so that invalid flags match
+		 */
+		bool emit_fminmax_d(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			Label take_rs1 = as.newLabel(), out = as.newLabel();
+			as.movsd(x86::xmm0, rbp_freg_q(dec.rs1));
+			as.movsd(x86::xmm1, rbp_freg_q(dec.rs2));
+			if (dec.op == rv_op_fmin_d) {
+				as.comisd(x86::xmm1, x86::xmm0);
+			} else {
+				as.comisd(x86::xmm0, x86::xmm1);
+			}
+			as.ja(take_rs1);
+			as.ucomisd(x86::xmm1, x86::xmm1);
+			as.jp(take_rs1);
+			as.movsd(rbp_freg_q(dec.rd), x86::xmm1);
+			as.jmp(out);
+			as.bind(take_rs1);
+			as.movsd(rbp_freg_q(dec.rd), x86::xmm0);
+			as.bind(out);
+			return true;
+		}
+
+		bool emit_fminmax_s(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			Label take_rs1 = as.newLabel(), out = as.newLabel();
+			as.movss(x86::xmm0, rbp_freg_d(dec.rs1));
+			as.movss(x86::xmm1, rbp_freg_d(dec.rs2));
+			if (dec.op == rv_op_fmin_s) {
+				as.comiss(x86::xmm1, x86::xmm0);
+			} else {
+				as.comiss(x86::xmm0, x86::xmm1);
+			}
+			as.ja(take_rs1);
+			as.ucomiss(x86::xmm1, x86::xmm1);
+			as.jp(take_rs1);
+			as.movss(rbp_freg_d(dec.rd), x86::xmm1);
+			as.jmp(out);
+			as.bind(take_rs1);
+			as.movss(rbp_freg_d(dec.rd), x86::xmm0);
+			as.bind(out);
+			return true;
+		}
+
+		void emit_mv_rd_al(decode_type &dec)
+		{
+			int rdx = x86_reg(dec.rd);
+			if (rdx > 0) {
+				as.movzx(x86::gpd(rdx), x86::al);
+			} else {
+				as.movzx(x86::eax, x86::al);
+				as.mov(rbp_reg_q(dec.rd), x86::rax);
+			}
+		}
+
+		bool emit_fcmp_d(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			if (dec.rd == rv_ireg_zero) {
+				// nop
+				return true;
+			}
+			switch (dec.op) {
+				case rv_op_feq_d:
+					as.movsd(x86::xmm0, rbp_freg_q(dec.rs1));
+					as.ucomisd(x86::xmm0, rbp_freg_q(dec.rs2));
+					as.sete(x86::al);
+					as.setnp(x86::cl);
+					as.and_(x86::al, x86::cl);
+					break;
+				case rv_op_flt_d:
+					as.movsd(x86::xmm0, rbp_freg_q(dec.rs2));
+					as.comisd(x86::xmm0, rbp_freg_q(dec.rs1));
+					as.seta(x86::al);
+					break;
+				case rv_op_fle_d:
+					as.movsd(x86::xmm0, rbp_freg_q(dec.rs2));
+					as.comisd(x86::xmm0, rbp_freg_q(dec.rs1));
+					as.setae(x86::al);
+					break;
+				default:
+					return false;
+			}
+			emit_mv_rd_al(dec);
+			return true;
+		}
+
+		bool emit_fcmp_s(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			if (dec.rd == rv_ireg_zero) {
+				// nop
+				return true;
+			}
+			switch (dec.op) {
+				case rv_op_feq_s:
+					as.movss(x86::xmm0, rbp_freg_d(dec.rs1));
+					as.ucomiss(x86::xmm0, rbp_freg_d(dec.rs2));
+					as.sete(x86::al);
+					as.setnp(x86::cl);
+					as.and_(x86::al, x86::cl);
+					break;
+				case rv_op_flt_s:
+					as.movss(x86::xmm0, rbp_freg_d(dec.rs2));
+					as.comiss(x86::xmm0, rbp_freg_d(dec.rs1));
+					as.seta(x86::al);
+					break;
+				case rv_op_fle_s:
+					as.movss(x86::xmm0, rbp_freg_d(dec.rs2));
+					as.comiss(x86::xmm0, rbp_freg_d(dec.rs1));
+					as.setae(x86::al);
+					break;
+				default:
+					return false;
+			}
+			emit_mv_rd_al(dec);
+			return true;
+		}
+
+		bool emit_fcvt_f_x(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			emit_mv_rax_rs1(dec);
+			switch (dec.op) {
+				case rv_op_fcvt_d_w:
+					as.cvtsi2sd(x86::xmm0, x86::eax);
+					as.movsd(rbp_freg_q(dec.rd), x86::xmm0);
+					break;
+				case rv_op_fcvt_d_wu:
+					as.mov(x86::eax, x86::eax);
+					as.cvtsi2sd(x86::xmm0, x86::rax);
+					as.movsd(rbp_freg_q(dec.rd), x86::xmm0);
+					break;
+				case rv_op_fcvt_d_l:
+					as.cvtsi2sd(x86::xmm0, x86::rax);
+					as.movsd(rbp_freg_q(dec.rd), x86::xmm0);
+					break;
+				case rv_op_fcvt_s_w:
+					as.cvtsi2ss(x86::xmm0, x86::eax);
+					as.movss(rbp_freg_d(dec.rd), x86::xmm0);
+					break;
+				case rv_op_fcvt_s_wu:
+					as.mov(x86::eax, x86::eax);
+					as.cvtsi2ss(x86::xmm0, x86::rax);
+					as.movss(rbp_freg_d(dec.rd), x86::xmm0);
+					break;
+				case rv_op_fcvt_s_l:
+					as.cvtsi2ss(x86::xmm0, x86::rax);
+					as.movss(rbp_freg_d(dec.rd), x86::xmm0);
+					break;
+				default:
+					return false;
+			}
+			return true;
+		}
+
+		bool emit_fmv_f_x(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			emit_mv_rax_rs1(dec);
+			if (dec.op == rv_op_fmv_d_x) {
+				as.mov(rbp_freg_q(dec.rd), x86::rax);
+			} else {
+				as.mov(rbp_freg_d(dec.rd), x86::eax);
+			}
+			return true;
+		}
+
+		/* fmv.x.d and fmv.x.s return the canonical NaN as in the interpreter */
+		bool emit_fmv_x_f(decode_type &dec)
+		{
+			log_trace("\t# 0x%016llx\t%s", dec.pc, disasm_inst_simple(dec).c_str());
+			term_pc = dec.pc + inst_length(dec.inst);
+			int rdx = x86_reg(dec.rd);
+			if (dec.rd == rv_ireg_zero) {
+				// nop
+				return true;
+			}
+			Label out = as.newLabel();
+			if (dec.op == rv_op_fmv_x_d) {
+				as.movsd(x86::xmm0, rbp_freg_q(dec.rs1));
+				as.mov(x86::rax, rbp_freg_q(dec.rs1));
+				as.ucomisd(x86::xmm0, x86::xmm0);
+				as.jnp(out);
+				as.mov(x86::rax, Imm(0x7ff8000000000000ULL));
+			} else {
+				as.movss(x86::xmm0, rbp_freg_d(dec.rs1));
+				as.movsxd(x86::rax, rbp_freg_d(dec.rs1));
+				as.ucomiss(x86::xmm0, x86::xmm0);
+				as.jnp(out);
+				as.mov(x86::eax, Imm(0x7fc00000));
+			}
+			as.bind(out);
+			if (rdx > 0) {
+				as.mov(x86::gpq(rdx), x86::rax);
+			} else {
+				as.mov(rbp_reg_q(dec.rd), x86::rax);
+			}
+			return true;
+		}
+
 		bool emit(decode_type &dec)
 		{
 			auto li = labels.find(dec.pc);
 			if (li != labels.end()) {
 				return false; /* trace complete */
 			}
+			if (check_budget && labels.empty()) {
+				emit_budget_check(dec.pc);
+			}
 			Label l = as.newLabel();
 			labels[dec.pc] = l;
 			as.bind(l);
+			if (emit_inst(dec)) {
+				return true;
+			}
+			/* the trace ends before this instruction so nothing may jump to it */
+			labels.erase(dec.pc);
+			return false;
+		}
+
+		bool emit_inst(decode_type &dec)
+		{
 			switch(dec.op) {
 				case rv_op_auipc: return emit_auipc(dec);
 				case rv_op_add: return emit_add(dec);
@@ -3870,6 +4684,56 @@ namespace riscv {
 				case jit_op_call: return emit_call(dec);
 				case jit_op_zextw: return emit_zextw(dec);
 				case jit_op_addiwz: return emit_addiwz(dec);
+				case rv_op_fld: return emit_fld(dec);
+				case rv_op_flw: return emit_flw(dec);
+				case rv_op_fsd: return emit_fsd(dec);
+				case rv_op_fsw: return emit_fsw(dec);
+				case rv_op_fadd_d: return emit_fop_d(dec);
+				case rv_op_fsub_d: return emit_fop_d(dec);
+				case rv_op_fmul_d: return emit_fop_d(dec);
+				case rv_op_fdiv_d: return emit_fop_d(dec);
+				case rv_op_fsqrt_d: return emit_fop_d(dec);
+				case rv_op_fcvt_d_s: return emit_fop_d(dec);
+				case rv_op_fadd_s: return emit_fop_s(dec);
+				case rv_op_fsub_s: return emit_fop_s(dec);
+				case rv_op_fmul_s: return emit_fop_s(dec);
+				case rv_op_fdiv_s: return emit_fop_s(dec);
+				case rv_op_fsqrt_s: return emit_fop_s(dec);
+				case rv_op_fcvt_s_d: return emit_fop_s(dec);
+				case rv_op_fmadd_d: return emit_fmadd_d(dec);
+				case rv_op_fmsub_d: return emit_fmadd_d(dec);
+				case rv_op_fnmsub_d: return emit_fmadd_d(dec);
+				case rv_op_fnmadd_d: return emit_fmadd_d(dec);
+				case rv_op_fmadd_s: return emit_fmadd_s(dec);
+				case rv_op_fmsub_s: return emit_fmadd_s(dec);
+				case rv_op_fnmsub_s: return emit_fmadd_s(dec);
+				case rv_op_fnmadd_s: return emit_fmadd_s(dec);
+				case rv_op_fsgnj_d: return emit_fsgnj_d(dec);
+				case rv_op_fsgnjn_d: return emit_fsgnj_d(dec);
+				case rv_op_fsgnjx_d: return emit_fsgnj_d(dec);
+				case rv_op_fsgnj_s: return emit_fsgnj_s(dec);
+				case rv_op_fsgnjn_s: return emit_fsgnj_s(dec);
+				case rv_op_fsgnjx_s: return emit_fsgnj_s(dec);
+				case rv_op_fmin_d: return emit_fminmax_d(dec);
+				case rv_op_fmax_d: return emit_fminmax_d(dec);
+				case rv_op_fmin_s: return emit_fminmax_s(dec);
+				case rv_op_fmax_s: return emit_fminmax_s(dec);
+				case rv_op_feq_d: return emit_fcmp_d(dec);
+				case rv_op_flt_d: return emit_fcmp_d(dec);
+				case rv_op_fle_d: return emit_fcmp_d(dec);
+				case rv_op_feq_s: return emit_fcmp_s(dec);
+				case rv_op_flt_s: return emit_fcmp_s(dec);
+				case rv_op_fle_s: return emit_fcmp_s(dec);
+				case rv_op_fcvt_d_w: return emit_fcvt_f_x(dec);
+				case rv_op_fcvt_d_wu: return emit_fcvt_f_x(dec);
+				case rv_op_fcvt_d_l: return emit_fcvt_f_x(dec);
+				case rv_op_fcvt_s_w: return emit_fcvt_f_x(dec);
+				case rv_op_fcvt_s_wu: return emit_fcvt_f_x(dec);
+				case rv_op_fcvt_s_l: return emit_fcvt_f_x(dec);
+				case rv_op_fmv_d_x: return emit_fmv_f_x(dec);
+				case rv_op_fmv_s_x: return emit_fmv_f_x(dec);
+				case rv_op_fmv_x_d: return emit_fmv_x_f(dec);
+				case rv_op_fmv_x_s: return emit_fmv_x_f(dec);
 			}
 			return false;
 		}
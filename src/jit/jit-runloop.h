@@ -30,6 +30,12 @@ namespace riscv {
 
 		static const size_t inst_cache_size = 8191;
 		static const int inst_step = 100000;
+		static const int trace_step = 10000;
+		static const size_t code_page_write_limit = 16;
+		static const int trace_cache_version = 2;
+		static const size_t trace_record_limit = 1024;
+		static const size_t trace_queue_size = 64;
+		static const int trace_worker_idle_us = 100;
 
 		struct rv_inst_cache_ent
 		{
@@ -37,30 +43,187 @@ namespace riscv {
 			typename P::decode_type dec;
 		};
 
+		/*
+		 * Traces are keyed by virtual pc so they are only valid within the
+		 * translation context they were recorded in (privilege mode, vm mode
+		 * and sptbr). The active context uses trace_cache_prolog,
+		 * trace_cache_entry and jmp_fixup_addrs directly and the traces for
+		 * other contexts are stashed in a trace_set until they are resumed
+		 * or dropped by sfence.vm, fence.i or a store to a code page.
+		 */
+		typedef std::pair<u64,u64> trace_context_t;
+
+		/*
+		 * A jump from one trace to another. Links are kept after they are
+		 * patched so they can be pointed back at the lookup trampoline when
+		 * the target trace is invalidated.
+		 */
+		struct trace_link
+		{
+			intptr_t fixup_addr;  /* address following the jump rel32 */
+			intptr_t tramp_addr;  /* lookup trampoline for the unlinked jump */
+			addr_t trace_pc;      /* trace containing the jump */
+		};
+
+		typedef std::map<addr_t,std::vector<trace_link>> trace_link_map;
+
+		/* a recorded trace on its way through the compile thread */
+		struct trace_job
+		{
+			addr_t key;                /* histogram key of the hotspot */
+			addr_t pc;
+			u64 generation;            /* code generation when recorded */
+			trace_context_t context;
+			std::vector<typename P::decode_type> trace;
+			std::vector<addr_t> pages;
+			CodeHolder code;
+			jit_logger logger;
+			std::unique_ptr<jit_emitter> emitter;
+			bool emitted;
+
+			trace_job() : key(0), pc(0), generation(0), context(), emitted(false) {}
+		};
+
+		/*
+		 * code size and aged execution count used to pick eviction victims,
+		 * and the entry and helper table offsets needed to save the trace
+		 */
+		struct trace_stat
+		{
+			size_t size;
+			u64 execs;
+			size_t entry;
+			size_t helpers;
+		};
+
+		/*
+		 * Saved trace cache layout. The header is followed by the pcs that
+		 * could not be traced and then by each trace: its record, helper
+		 * table slots, links, source pages and code padded to 8 bytes.
+		 * Trace code is position independent; the helper table is relocated
+		 * and the jumps to other traces, which are saved pointing at their
+		 * lookup trampolines, are relinked when the trace is loaded.
+		 */
+		struct trace_file_header
+		{
+			char magic[16];          /* "rv8-trace-cache" */
+			u32 version;             /* trace_cache_version */
+			u32 emitter_version;
+			u64 processor_size;      /* traces embed processor offsets */
+			u64 num_skips;
+			u64 num_traces;
+		};
+
+		struct trace_file_entry
+		{
+			u64 pc;
+			u32 code_size;
+			u32 entry_offset;
+			u32 num_helpers;
+			u32 num_links;
+			u32 num_pages;
+			u32 helper_offset;
+		};
+
+		/* a helper table slot and the helper it holds */
+		struct trace_file_helper
+		{
+			u32 offset;
+			u32 helper;
+		};
+
+		struct trace_file_link
+		{
+			u32 offset;              /* offset following the jump rel32 */
+			u32 reserved;
+			u64 target_pc;
+		};
+
+		/* a trace is only loaded if the pages it was recorded from are unchanged */
+		struct trace_file_page
+		{
+			u64 addr;
+			u8 digest[SHA512_OUTPUT_BYTES];
+		};
+
+		struct trace_set
+		{
+			google::dense_hash_map<addr_t,TraceFunc> prolog;
+			google::dense_hash_map<addr_t,TraceFunc> entry;
+			google::dense_hash_map<addr_t,trace_stat> stats;
+			trace_link_map fixups;
+
+			trace_set()
+			{
+				prolog.set_empty_key(0);
+				prolog.set_deleted_key(-1);
+				entry.set_empty_key(0);
+				entry.set_deleted_key(-1);
+				stats.set_empty_key(0);
+				stats.set_deleted_key(-1);
+			}
+		};
+
 		JitRuntime rt;
 		google::dense_hash_map<addr_t,TraceFunc> trace_cache_prolog;
 		google::dense_hash_map<addr_t,TraceFunc> trace_cache_entry;
 		google::dense_hash_map<addr_t,TraceFunc> audit_trace_cache_prolog;
-		std::map<addr_t,std::vector<intptr_t>> jmp_fixup_addrs;
+		google::dense_hash_map<addr_t,trace_stat> trace_stats;
+		trace_link_map jmp_fixup_addrs;
+		std::map<trace_context_t,trace_set> trace_sets;
+		trace_context_t trace_context;
+		std::map<addr_t,std::vector<addr_t>> code_page_traces;
+		std::map<addr_t,size_t> code_page_writes;
+		std::vector<TraceFunc> trace_release;
 		std::shared_ptr<debug_cli<P>> cli;
 		rv_inst_cache_ent inst_cache[inst_cache_size];
+		block_cache<P> blocks;
 		TraceLookup lookup_trace_fast;
 		mmu_ops ops;
+		mmu_tlb dtlb;
+		bool use_mmu;
+		bool code_unprotected;
+		size_t trace_cache_bytes;
+		u64 trace_hits;
+		u64 trace_misses;
+		u64 trace_compiles;
+		u64 trace_loads;
+		u64 trace_evictions;
+		u64 trace_invalidations;
+		std::string trace_cache_file;
+		bool trace_thread_enable;
+		std::thread trace_thread;
+		std::atomic<bool> trace_thread_running;
+		queue_atomic<trace_job*> trace_queue;
+		queue_atomic<trace_job*> trace_done;
+		size_t trace_jobs_pending;
+		u64 code_generation;
 
 		jit_runloop() : jit_runloop(std::make_shared<debug_cli<P>>()) {}
-		jit_runloop(std::shared_ptr<debug_cli<P>> cli) : cli(cli), inst_cache(), ops{
+		jit_runloop(std::shared_ptr<debug_cli<P>> cli) : trace_context(), cli(cli), inst_cache(), ops{
 			.lb = mmu_lb, .lh = mmu_lh, .lw = mmu_lw, .ld = mmu_ld,
 			.sb = mmu_sb, .sh = mmu_sh, .sw = mmu_sw, .sd = mmu_sd
-		}
+		}, dtlb(), use_mmu(false), code_unprotected(false), trace_cache_bytes(0),
+			trace_hits(0), trace_misses(0), trace_compiles(0), trace_loads(0), trace_evictions(0),
+			trace_invalidations(0), trace_thread_enable(false), trace_thread_running(false),
+			trace_queue(trace_queue_size), trace_done(trace_queue_size),
+			trace_jobs_pending(0), code_generation(0)
 		{
 			trace_cache_prolog.set_empty_key(0);
 			trace_cache_prolog.set_deleted_key(-1);
 			trace_cache_entry.set_empty_key(0);
 			trace_cache_entry.set_deleted_key(-1);
+			trace_stats.set_empty_key(0);
+			trace_stats.set_deleted_key(-1);
 			audit_trace_cache_prolog.set_empty_key(0);
 			audit_trace_cache_prolog.set_deleted_key(-1);
 		}
 
+		~jit_runloop()
+		{
+			stop_trace_thread();
+		}
+
 		virtual bool handleError(Error err, const char* message, CodeEmitter* origin)
 		{
 			printf("%s", message);
@@ -73,8 +236,243 @@ namespace riscv {
 				(jit_singleton::current)->signal_dispatch(signum, info);
 		}
 
+		static void exit_handler()
+		{
+			jit_runloop<P,J> *runloop = static_cast<jit_runloop<P,J>*>(jit_singleton::current);
+			if (runloop->trace_cache_file.size() > 0) {
+				runloop->save_trace_cache();
+			}
+			if (runloop->log & proc_log_exit_stats) {
+				runloop->print_trace_stats();
+			}
+		}
+
+		/*
+		 * The trace cache holds the code of the traces in the active
+		 * context and the pcs that could not be traced, so that a later run
+		 * of the same program starts with its traces installed instead of
+		 * profiling and emitting them again. Only traces whose source pages
+		 * are write protected are saved, as those pages are known to be
+		 * unchanged since the trace was recorded.
+		 */
+		void save_trace_cache()
+		{
+			std::vector<addr_t> traces, skips;
+			std::map<addr_t,std::vector<addr_t>> trace_pages;
+			std::map<addr_t,std::vector<std::pair<addr_t,trace_link>>> trace_links;
+			P::hist_pc.for_each([&](addr_t pc, size_t count) {
+				if (count == P::hostspot_trace_skip) {
+					skips.push_back(pc);
+				}
+			});
+			if (!use_mmu && !code_unprotected) {
+				for (auto &cpt : code_page_traces) {
+					for (addr_t pc : cpt.second) {
+						trace_pages[pc].push_back(cpt.first);
+					}
+				}
+				for (auto &jfa : jmp_fixup_addrs) {
+					for (auto &link : jfa.second) {
+						trace_links[link.trace_pc].push_back(std::pair<addr_t,trace_link>(jfa.first, link));
+					}
+				}
+				for (auto &ent : trace_cache_prolog) {
+					if (trace_pages.find(ent.first) != trace_pages.end()) {
+						traces.push_back(ent.first);
+					}
+				}
+			}
+			std::sort(traces.begin(), traces.end());
+			std::sort(skips.begin(), skips.end());
+
+			/* write a temporary file and rename it so readers never see a partial cache */
+			std::string tmp_file = trace_cache_file + format_string(".%d", getpid());
+			FILE *file = fopen(tmp_file.c_str(), "w");
+			if (!file) return;
+			trace_file_header header = {};
+			strncpy(header.magic, "rv8-trace-cache", sizeof(header.magic));
+			header.version = trace_cache_version;
+			header.emitter_version = jit_emitter::emitter_version;
+			header.processor_size = sizeof(typename P::processor_type);
+			header.num_skips = skips.size();
+			header.num_traces = traces.size();
+			fwrite(&header, sizeof(header), 1, file);
+			for (addr_t pc : skips) {
+				u64 val = pc;
+				fwrite(&val, sizeof(val), 1, file);
+			}
+			for (addr_t pc : traces) {
+				save_trace(file, pc, trace_pages[pc], trace_links[pc]);
+			}
+			bool okay = !ferror(file);
+			if (fclose(file) == 0 && okay) {
+				rename(tmp_file.c_str(), trace_cache_file.c_str());
+			} else {
+				unlink(tmp_file.c_str());
+			}
+		}
+
+		void save_trace(FILE *file, addr_t pc, std::vector<addr_t> &pages,
+			std::vector<std::pair<addr_t,trace_link>> &links)
+		{
+			trace_stat &stat = trace_stats[pc];
+			intptr_t prolog_addr = func_address(trace_cache_prolog[pc]);
+			std::vector<u8> code((u8*)prolog_addr, (u8*)prolog_addr + stat.size);
+			code.resize((code.size() + 7) & ~size_t(7));
+
+			/* jumps are saved unlinked and the helper table is filled in when loaded */
+			for (auto &link : links) {
+				int rel = int(link.second.tramp_addr - link.second.fixup_addr);
+				memcpy(&code[link.second.fixup_addr - prolog_addr - 4], &rel, sizeof(rel));
+			}
+			std::vector<trace_file_helper> helpers;
+			for (size_t offset = stat.helpers; offset + sizeof(intptr_t) <= stat.size; offset += sizeof(intptr_t)) {
+				intptr_t addr;
+				memcpy(&addr, &code[offset], sizeof(addr));
+				for (u32 helper = 0; helper < jit_helper_count; helper++) {
+					if (addr == jit_helper_address(jit_helper(helper), ops, lookup_trace_fast)) {
+						helpers.push_back(trace_file_helper{ u32(offset), helper });
+						break;
+					}
+				}
+				memset(&code[offset], 0, sizeof(addr));
+			}
+
+			trace_file_entry ent = { u64(pc), u32(stat.size), u32(stat.entry),
+				u32(helpers.size()), u32(links.size()), u32(pages.size()), u32(stat.helpers) };
+			fwrite(&ent, sizeof(ent), 1, file);
+			fwrite(helpers.data(), sizeof(trace_file_helper), helpers.size(), file);
+			for (auto &link : links) {
+				trace_file_link tfl = { u32(link.second.fixup_addr - prolog_addr), 0, u64(link.first) };
+				fwrite(&tfl, sizeof(tfl), 1, file);
+			}
+			for (addr_t page : pages) {
+				trace_file_page tfp = { u64(page), {} };
+				hash_page(page, tfp.digest);
+				fwrite(&tfp, sizeof(tfp), 1, file);
+			}
+			fwrite(code.data(), 1, code.size(), file);
+		}
+
+		void load_trace_cache()
+		{
+			int fd = open(trace_cache_file.c_str(), O_RDONLY);
+			if (fd < 0) return;
+			struct stat st;
+			void *addr = MAP_FAILED;
+			if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(trace_file_header)) {
+				addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			}
+			close(fd);
+			if (addr == MAP_FAILED) return;
+			const u8 *p = (const u8*)addr, *end = p + st.st_size;
+			const trace_file_header *header = (const trace_file_header*)p;
+			p += sizeof(trace_file_header);
+			if (strncmp(header->magic, "rv8-trace-cache", sizeof(header->magic)) == 0 &&
+				header->version == trace_cache_version &&
+				header->emitter_version == jit_emitter::emitter_version &&
+				header->processor_size == sizeof(typename P::processor_type) &&
+				header->num_skips <= size_t(end - p) / sizeof(u64) && !use_mmu)
+			{
+				const u64 *skips = (const u64*)p;
+				for (u64 i = 0; i < header->num_skips; i++) {
+					P::histogram_set_pc(addr_t(skips[i]), P::hostspot_trace_skip);
+				}
+				p += header->num_skips * sizeof(u64);
+				for (u64 i = 0; i < header->num_traces && p != nullptr; i++) {
+					p = load_trace(p, end);
+				}
+			}
+			munmap(addr, st.st_size);
+		}
+
+		/* install one saved trace, returning the next record or null if the file is truncated */
+		const u8* load_trace(const u8 *p, const u8 *end)
+		{
+			if (size_t(end - p) < sizeof(trace_file_entry)) return nullptr;
+			const trace_file_entry *ent = (const trace_file_entry*)p;
+			size_t code_size = (size_t(ent->code_size) + 7) & ~size_t(7);
+			size_t len = sizeof(trace_file_entry) +
+				ent->num_helpers * sizeof(trace_file_helper) +
+				ent->num_links * sizeof(trace_file_link) +
+				ent->num_pages * sizeof(trace_file_page) + code_size;
+			if (size_t(end - p) < len) return nullptr;
+			const trace_file_helper *helpers = (const trace_file_helper*)(ent + 1);
+			const trace_file_link *links = (const trace_file_link*)(helpers + ent->num_helpers);
+			const trace_file_page *pages = (const trace_file_page*)(links + ent->num_links);
+			const u8 *code = (const u8*)(pages + ent->num_pages);
+
+			bool valid = ent->num_pages > 0 && ent->entry_offset < ent->code_size &&
+				ent->helper_offset <= ent->code_size;
+			for (u32 i = 0; valid && i < ent->num_helpers; i++) {
+				valid = helpers[i].helper < jit_helper_count &&
+					helpers[i].offset + sizeof(intptr_t) <= ent->code_size;
+			}
+			for (u32 i = 0; valid && i < ent->num_links; i++) {
+				valid = links[i].offset >= 4 && links[i].offset <= ent->code_size;
+			}
+			std::vector<addr_t> page_addrs;
+			for (u32 i = 0; valid && i < ent->num_pages; i++) {
+				u8 digest[SHA512_OUTPUT_BYTES];
+				valid = page_mapped(addr_t(pages[i].addr));
+				if (valid) {
+					hash_page(addr_t(pages[i].addr), digest);
+					valid = memcmp(digest, pages[i].digest, sizeof(digest)) == 0;
+				}
+				page_addrs.push_back(addr_t(pages[i].addr));
+			}
+			if (valid && jit_load(ent, helpers, links, code)) {
+				jit_protect_pages(addr_t(ent->pc), page_addrs);
+			} else {
+				/* the head is traced on its first execution instead */
+				size_t iters = P::trace_iters > 0 ? size_t(P::trace_iters) - 1 : 0;
+				P::histogram_set_pc(addr_t(ent->pc), iters);
+			}
+			return p + len;
+		}
+
+		/* guest code pages are mapped at their guest address on the proxy */
+		static void hash_page(addr_t page, u8 digest[SHA512_OUTPUT_BYTES])
+		{
+			sha512_ctx_t sha512;
+			sha512_init(&sha512);
+			sha512_update(&sha512, (const unsigned char*)page, page_size);
+			sha512_final(&sha512, digest);
+		}
+
+		/* traces from pages that are not mapped yet, such as generated code, are not loaded */
+		static bool page_mapped(addr_t page)
+		{
+			return msync((void*)page, page_size, MS_ASYNC) == 0;
+		}
+
+		void print_trace_stats()
+		{
+			size_t traces = trace_cache_prolog.size();
+			for (auto &set : trace_sets) {
+				traces += set.second.prolog.size();
+			}
+			printf("\n");
+			printf("jit trace cache\n");
+			printf("~~~~~~~~~~~~~~~\n");
+			printf("trace lookup hits   : %llu\n", trace_hits);
+			printf("trace lookup misses : %llu\n", trace_misses);
+			printf("traces compiled     : %llu\n", trace_compiles);
+			printf("traces loaded       : %llu\n", trace_loads);
+			printf("traces evicted      : %llu\n", trace_evictions);
+			printf("traces invalidated  : %llu\n", trace_invalidations);
+			printf("traces cached       : %llu\n", (u64)traces);
+			printf("code cache bytes    : %llu\n", (u64)trace_cache_bytes);
+			printf("code cache limit    : %llu\n", (u64)P::trace_cache_limit);
+		}
+
 		void signal_dispatch(int signum, siginfo_t *info)
 		{
+			/* stores to write protected code pages invalidate their traces */
+			if (signum == SIGSEGV && jit_code_write(addr_t(info->si_addr))) {
+				return;
+			}
+
 			printf("SIGNAL   :%s pc:0x%0llx si_addr:0x%0llx\n",
 				signal_name(signum), (addr_t)P::pc, (addr_t)info->si_addr);
 
@@ -127,6 +525,53 @@ namespace riscv {
 			/* create trace lookup and load store functions */
 			create_trace_lookup();
 			create_load_store();
+
+			/* record the data TLB layout for inline translation */
+			dtlb = create_tlb_layout(P::mmu, 0);
+
+			/* soft-mmu traces translate through the TLB and can fault */
+			use_mmu = dtlb.entries != 0;
+			trace_context = current_trace_context(*this, 0);
+
+			/* syscalls writing guest memory unprotect traced code pages first */
+			set_guest_write(*this, 0);
+
+			/* install the traces saved by an earlier run of the same program */
+			if (trace_cache_file.size() > 0) {
+				load_trace_cache();
+			}
+
+			/* generate code off the emulation thread */
+			if (trace_thread_enable && (P::log & proc_log_jit_trap)) {
+				start_trace_thread();
+			}
+
+			/* save the trace cache and report statistics after the exit statistics */
+			if (P::log & proc_log_jit_trap) {
+				atexit(&jit_runloop<P,J>::exit_handler);
+			}
+		}
+
+		template <typename M>
+		auto create_tlb_layout(M &mmu, int) -> decltype(mmu.l1_dtlb, mmu_tlb())
+		{
+			typedef typename M::tlb_type tlb_type;
+			typedef typename tlb_type::tlb_entry_t tlb_entry_t;
+			return mmu_tlb{
+				.entries = size_t(uintptr_t(mmu.l1_dtlb.tlb) -
+					uintptr_t(static_cast<typename P::processor_type*>(this))),
+				.mask = size_t(tlb_type::mask),
+				.entry_size = sizeof(tlb_entry_t) * tlb_type::ways, /* way 0 of each set */
+				.ltag = offsetof(tlb_entry_t, ltag),
+				.stag = offsetof(tlb_entry_t, stag),
+				.addend = offsetof(tlb_entry_t, addend)
+			};
+		}
+
+		template <typename M>
+		mmu_tlb create_tlb_layout(M &mmu, long)
+		{
+			return mmu_tlb();
 		}
 
 		void create_trace_lookup()
@@ -180,22 +625,332 @@ namespace riscv {
 		{
 			switch(dec.op) {
 				case rv_op_fence_i:
-					clear_trace_cache_prolog();
+					jit_fence_i();
 					return pc_offset;
 				default: break;
 			}
 			return -1; /* illegal instruction */
 		}
 
-		void clear_trace_cache_prolog()
+		typename P::ux inst_priv(typename P::decode_type &dec, typename P::ux pc_offset)
+		{
+			typename P::ux new_offset = P::inst_priv(dec, pc_offset);
+			if (new_offset != typename P::ux(-1) && dec.op == rv_op_sfence_vm) {
+				clear_trace_cache();
+			}
+			return new_offset;
+		}
+
+		/*
+		 * stores to traced code are caught when they happen, by write
+		 * protecting code pages on the proxy or in the soft-mmu store path,
+		 * so fence.i only drops traces that may be stale
+		 */
+		void jit_fence_i()
+		{
+			if (code_dirty(P::mmu, 0) || code_unprotected) {
+				clear_trace_cache();
+			}
+			jit_release_traces();
+		}
+
+		/* release the traces for all translation contexts */
+		void clear_trace_cache()
 		{
 			for (auto ent : trace_cache_prolog) {
 				rt.release(ent.second);
 			}
+			for (auto &set : trace_sets) {
+				for (auto ent : set.second.prolog) {
+					rt.release(ent.second);
+				}
+			}
+			trace_sets.clear();
 			trace_cache_prolog.clear_no_resize();
 			trace_cache_entry.clear_no_resize();
+			trace_stats.clear_no_resize();
+			trace_cache_bytes = 0;
+			jmp_fixup_addrs.clear();
+			clear_trace_l1();
+			clear_code_pages(P::mmu, 0);
+			for (auto &cpt : code_page_traces) {
+				mprotect((void*)cpt.first, page_size, PROT_READ | PROT_WRITE);
+			}
+			code_page_traces.clear();
+			code_unprotected = false;
+			code_generation++;
+			jit_release_traces();
+		}
+
+		/* release invalidated traces once no trace can be running */
+		void jit_release_traces()
+		{
+			for (auto fn : trace_release) {
+				rt.release(fn);
+			}
+			trace_release.clear();
+		}
+
+		/*
+		 * record the guest pages spanned by an instruction being traced,
+		 * refusing pages whose traces have been invalidated too often
+		 */
+		bool jit_record_pages(std::vector<addr_t> &pages, addr_t pc, addr_t pc_offset)
+		{
+			addr_t first = pc & ~addr_t(page_size - 1);
+			addr_t last = (pc + pc_offset - 1) & ~addr_t(page_size - 1);
+			for (addr_t page = first; page <= last; page += page_size) {
+				auto cpw = code_page_writes.find(page);
+				if (cpw != code_page_writes.end() && cpw->second >= code_page_write_limit) {
+					return false;
+				}
+				if (std::find(pages.begin(), pages.end(), page) == pages.end()) {
+					pages.push_back(page);
+				}
+			}
+			return true;
+		}
+
+		/* write protect the pages a trace was recorded from */
+		void jit_protect_pages(addr_t pc, std::vector<addr_t> &pages)
+		{
+			for (addr_t page : pages) {
+				auto cpt = code_page_traces.find(page);
+				if (cpt == code_page_traces.end()) {
+					if (mprotect((void*)page, page_size, PROT_READ) != 0) {
+						code_unprotected = true;
+						continue;
+					}
+					cpt = code_page_traces.insert(code_page_traces.end(),
+						std::pair<addr_t,std::vector<addr_t>>(page, std::vector<addr_t>()));
+				}
+				cpt->second.push_back(pc);
+			}
+		}
+
+		/* a store to a write protected code page invalidates its traces */
+		bool jit_code_write(addr_t addr)
+		{
+			addr_t page = addr & ~addr_t(page_size - 1);
+			if (code_page_traces.find(page) == code_page_traces.end()) {
+				return false;
+			}
+			jit_invalidate_page(page);
+			code_page_writes[page]++;
+			return mprotect((void*)page, page_size, PROT_READ | PROT_WRITE) == 0;
+		}
+
+		/* a host write to guest memory invalidates the traces of the code pages it overlaps */
+		void jit_guest_write(addr_t addr, size_t len)
+		{
+			addr_t first = addr & ~addr_t(page_size - 1);
+			addr_t last = (addr + len - 1) & ~addr_t(page_size - 1);
+			auto cpt = code_page_traces.lower_bound(first);
+			while (cpt != code_page_traces.end() && cpt->first <= last) {
+				addr_t page = (cpt++)->first;
+				jit_code_write(page);
+			}
+		}
+
+		template <typename Q>
+		auto set_guest_write(Q &proc, int) -> decltype(proc.guest_write, void())
+		{
+			proc.guest_write = [this] (addr_t addr, size_t len) {
+				jit_guest_write(addr, len);
+			};
+		}
+
+		template <typename Q>
+		void set_guest_write(Q &proc, long) {}
+
+		/*
+		 * remove the traces recorded from a code page and unlink the jumps
+		 * into them. this runs in the signal handler, possibly with one of
+		 * the traces executing, so their code is released later
+		 */
+		void jit_invalidate_page(addr_t page)
+		{
+			auto cpt = code_page_traces.find(page);
+			if (cpt == code_page_traces.end()) return;
+			std::set<addr_t> removed;
+			for (addr_t pc : cpt->second) {
+				if (jit_remove_trace(pc)) {
+					removed.insert(pc);
+					trace_invalidations++;
+				}
+			}
+			code_page_traces.erase(cpt);
+			jit_forget_links(removed);
+			clear_trace_l1();
+			code_generation++;
+		}
+
+		/* remove a trace from the active context and unlink the jumps into it */
+		bool jit_remove_trace(addr_t pc)
+		{
+			auto ti = trace_cache_prolog.find(pc);
+			if (ti == trace_cache_prolog.end()) return false;
+			trace_release.push_back(ti->second);
+			trace_cache_prolog.erase(ti);
+			trace_cache_entry.erase(pc);
+			auto si = trace_stats.find(pc);
+			if (si != trace_stats.end()) {
+				trace_cache_bytes -= si->second.size;
+				trace_stats.erase(si);
+			}
+			auto jfa = jmp_fixup_addrs.find(pc);
+			if (jfa != jmp_fixup_addrs.end()) {
+				for (auto &link : jfa->second) {
+					jit_patch_link(link, link.tramp_addr);
+				}
+			}
+			return true;
+		}
+
+		/* drop the links held by jumps inside removed traces */
+		void jit_forget_links(std::set<addr_t> &removed)
+		{
+			if (removed.size() == 0) return;
+			for (auto &jfa : jmp_fixup_addrs) {
+				auto &links = jfa.second;
+				links.erase(std::remove_if(links.begin(), links.end(), [&](trace_link &link) {
+					return removed.find(link.trace_pc) != removed.end();
+				}), links.end());
+			}
+		}
+
+		/*
+		 * make room for size bytes of trace code. the least executed traces
+		 * are evicted until the cache is below three quarters of its budget
+		 * and the remaining counts are halved so traces that have gone cold
+		 * become victims. if evicting from the active context is not enough
+		 * the traces for all contexts are dropped.
+		 */
+		void jit_evict_traces(size_t size)
+		{
+			size_t limit = P::trace_cache_limit;
+			if (limit == 0 || trace_cache_bytes + size <= limit) return;
+			size_t target = limit - limit / 4;
+			std::vector<std::pair<u64,addr_t>> victims;
+			for (auto &ent : trace_stats) {
+				victims.push_back(std::pair<u64,addr_t>(ent.second.execs, ent.first));
+			}
+			std::sort(victims.begin(), victims.end());
+			std::set<addr_t> removed;
+			for (auto &victim : victims) {
+				if (trace_cache_bytes + size <= target) break;
+				if (jit_remove_trace(victim.second)) {
+					removed.insert(victim.second);
+					trace_evictions++;
+				}
+			}
+			jit_forget_links(removed);
+			for (auto &ent : trace_stats) {
+				ent.second.execs >>= 1;
+			}
+			clear_trace_l1();
+			if (trace_cache_bytes + size > target) {
+				trace_evictions += trace_cache_prolog.size();
+				for (auto &set : trace_sets) {
+					trace_evictions += set.second.prolog.size();
+				}
+				clear_trace_cache();
+			}
+		}
+
+		void clear_trace_l1()
+		{
+			memset(P::trace_pc, 0, sizeof(P::trace_pc));
+			memset(P::trace_fn, 0, sizeof(P::trace_fn));
+		}
+
+		/* stash the traces for the active context and resume those for ctx */
+		void switch_trace_context(trace_context_t ctx)
+		{
+			if (trace_cache_prolog.size() > 0) {
+				trace_set &set = trace_sets[trace_context];
+				set.prolog.swap(trace_cache_prolog);
+				set.entry.swap(trace_cache_entry);
+				set.stats.swap(trace_stats);
+				set.fixups.swap(jmp_fixup_addrs);
+			} else {
+				trace_stats.clear_no_resize();
+				jmp_fixup_addrs.clear();
+			}
+			auto si = trace_sets.find(ctx);
+			if (si != trace_sets.end()) {
+				trace_cache_prolog.swap(si->second.prolog);
+				trace_cache_entry.swap(si->second.entry);
+				trace_stats.swap(si->second.stats);
+				jmp_fixup_addrs.swap(si->second.fixups);
+				trace_sets.erase(si);
+			}
+			trace_context = ctx;
+			clear_trace_l1();
+		}
+
+		template <typename Q>
+		auto current_trace_context(Q &proc, int) -> decltype(proc.sptbr, trace_context_t())
+		{
+			/* M mode fetches are untranslated and bare mode ignores sptbr */
+			if (proc.mode >= rv_mode_M) {
+				return trace_context_t(proc.mode, 0);
+			} else if (proc.mstatus.r.vm == rv_vm_mbare) {
+				return trace_context_t(proc.mode | (rv_vm_mbare << 2), 0);
+			}
+			return trace_context_t(proc.mode | (u64(proc.mstatus.r.vm) << 2), proc.sptbr);
+		}
+
+		template <typename Q>
+		trace_context_t current_trace_context(Q &proc, long)
+		{
+			return trace_context_t();
+		}
+
+		/* record the machine physical pages of an instruction being traced */
+		template <typename M>
+		auto set_code_page(M &mmu, typename P::ux pc, typename P::ux pc_offset, int)
+			-> decltype(mmu.code_pages, void())
+		{
+			typename M::tlb_type::tlb_entry_t* tlb_ent = nullptr;
+			addr_t mpa = mmu.template translate_addr<P,M::op_fetch>(*this, pc, tlb_ent);
+			mmu.set_code_page(mpa);
+			mmu.set_code_page(mpa + pc_offset - 1);
+		}
+
+		template <typename M>
+		void set_code_page(M &mmu, typename P::ux pc, typename P::ux pc_offset, long) {}
+
+		template <typename M>
+		auto code_dirty(M &mmu, int) -> decltype(mmu.code_dirty, bool())
+		{
+			return mmu.code_dirty;
+		}
+
+		template <typename M>
+		bool code_dirty(M &mmu, long) { return false; }
+
+		template <typename M>
+		auto clear_code_pages(M &mmu, int) -> decltype(mmu.code_pages, void())
+		{
+			mmu.clear_code_pages();
+		}
+
+		template <typename M>
+		void clear_code_pages(M &mmu, long) {}
+
+		/* traces and decoded blocks are dropped after the interrupt service routine completes a remote fence */
+		template <typename Q>
+		auto remote_fenced(Q &proc, int) -> decltype(proc.fence_blocks, bool())
+		{
+			bool fenced = proc.fence_blocks;
+			proc.fence_blocks = false;
+			return fenced;
 		}
 
+		template <typename Q>
+		bool remote_fenced(Q &proc, long) { return false; }
+
 		static uintptr_t lookup_trace(uintptr_t pc)
 		{
 			auto *proc = static_cast<jit_runloop<P,J>*>(jit_singleton::current);
@@ -260,99 +1015,343 @@ namespace riscv {
 			proc->mmu.template store<P,u64>(*proc, addr, val);
 		}
 
-		void jit_apply_fixups(jit_emitter &emitter, addr_t pc, intptr_t entry_addr)
+		static void jit_patch_link(trace_link &link, intptr_t target_addr)
+		{
+			*(int*)(link.fixup_addr - 4) = (int)(target_addr - link.fixup_addr);
+		}
+
+		void jit_apply_fixups(addr_t pc, intptr_t entry_addr)
 		{
 			auto jfa = jmp_fixup_addrs.find(pc);
 			if (jfa != jmp_fixup_addrs.end()) {
-				for (auto fixup_addr : jfa->second) {
-					*(int*)(fixup_addr - 4) = (int)(entry_addr - fixup_addr);
+				for (auto &link : jfa->second) {
+					jit_patch_link(link, entry_addr);
 				}
-				jmp_fixup_addrs.erase(jfa);
 			}
 		}
 
-		void jit_stash_fixups(jit_emitter &emitter, CodeHolder &code, intptr_t prolog_addr)
+		/* record a jump from the trace at pc to target_pc, linking it if the target is cached */
+		void jit_add_link(addr_t target_pc, intptr_t fixup_addr, addr_t pc)
 		{
-			for (auto &jfl : emitter.jmp_fixup_labels) {
-				addr_t fixup_pc = jfl.first;
-				for (auto &label : jfl.second) {
-					auto jfa = jmp_fixup_addrs.find(fixup_pc);
-					if (jfa == jmp_fixup_addrs.end()) {
-						jfa = jmp_fixup_addrs.insert(jmp_fixup_addrs.end(),
-							std::pair<addr_t,std::vector<intptr_t>>(fixup_pc, std::vector<intptr_t>()));
-					}
-					jfa->second.push_back(prolog_addr + code.getLabelOffset(label));
-				}
+			trace_link link = { fixup_addr, fixup_addr + *(int*)(fixup_addr - 4), pc };
+			auto ti = trace_cache_entry.find(target_pc);
+			if (ti != trace_cache_entry.end()) {
+				jit_patch_link(link, func_address(ti->second));
 			}
+			jmp_fixup_addrs[target_pc].push_back(link);
 		}
 
-		void jit_cache(jit_emitter &emitter, CodeHolder &code, addr_t pc)
+		/* add trace code to the active context, returning the address of its prolog */
+		intptr_t jit_install(addr_t pc, TraceFunc fn, trace_stat &stat)
 		{
+			union { intptr_t i; TraceFunc fn; } r = { .fn = fn };
+			intptr_t prolog_addr = r.i;
+			r.i += stat.entry;
+			trace_cache_bytes += stat.size;
+			trace_stats[pc] = stat;
+			trace_cache_prolog[pc] = fn;
+			trace_cache_entry[pc] = r.fn;
+			return prolog_addr;
+		}
+
+		bool jit_cache(jit_emitter &emitter, CodeHolder &code, addr_t pc)
+		{
+			size_t size = code.getCodeSize();
+			jit_evict_traces(size);
 			TraceFunc fn = nullptr;
 			Error err = rt.add(&fn, &code);
 			if (!err) {
-				union { intptr_t i; TraceFunc fn; } r = { .fn = fn };
-				intptr_t prolog_addr = r.i;
-				r.i += code.getLabelOffset(emitter.start);
-				intptr_t entry_addr = r.i;
-				trace_cache_prolog[pc] = fn;
-				trace_cache_entry[pc] = r.fn;
-				jit_apply_fixups(emitter, pc, entry_addr);
-				jit_stash_fixups(emitter, code, prolog_addr);
+				trace_stat stat = { size, 0, size_t(code.getLabelOffset(emitter.start)),
+					size_t(code.getLabelOffset(emitter.helper_table)) };
+				intptr_t prolog_addr = jit_install(pc, fn, stat);
+				trace_compiles++;
+				for (auto &jfl : emitter.jmp_fixup_labels) {
+					for (auto &label : jfl.second) {
+						jit_add_link(jfl.first, prolog_addr + code.getLabelOffset(label), pc);
+					}
+				}
+				jit_apply_fixups(pc, prolog_addr + stat.entry);
+			}
+			return !err;
+		}
+
+		/* install saved trace code, relocating its helper table and relinking its jumps */
+		bool jit_load(const trace_file_entry *ent, const trace_file_helper *helpers,
+			const trace_file_link *links, const u8 *code_data)
+		{
+			std::vector<u8> buf(code_data, code_data + ent->code_size);
+			for (u32 i = 0; i < ent->num_helpers; i++) {
+				intptr_t addr = jit_helper_address(jit_helper(helpers[i].helper), ops, lookup_trace_fast);
+				memcpy(&buf[helpers[i].offset], &addr, sizeof(addr));
+			}
+			CodeHolder code;
+			code.init(rt.getCodeInfo());
+			code.setErrorHandler(this);
+			X86Assembler as(&code);
+			as.embed(buf.data(), u32(buf.size()));
+			jit_evict_traces(buf.size());
+			TraceFunc fn = nullptr;
+			if (rt.add(&fn, &code)) return false;
+			addr_t pc = addr_t(ent->pc);
+			trace_stat stat = { buf.size(), 0, ent->entry_offset, ent->helper_offset };
+			intptr_t prolog_addr = jit_install(pc, fn, stat);
+			trace_loads++;
+			for (u32 i = 0; i < ent->num_links; i++) {
+				jit_add_link(addr_t(links[i].target_pc), prolog_addr + links[i].offset, pc);
+			}
+			jit_apply_fixups(pc, prolog_addr + stat.entry);
+			return true;
+		}
+
+		/* drop stale traces and select the traces for the current context */
+		void sync_trace_cache()
+		{
+			if (unlikely(code_dirty(P::mmu, 0))) {
+				clear_trace_cache();
+			}
+			if (unlikely(trace_release.size() > 0)) {
+				jit_release_traces();
+			}
+			trace_context_t ctx = current_trace_context(*this, 0);
+			if (unlikely(ctx != trace_context)) {
+				switch_trace_context(ctx);
+			}
+			if (unlikely(trace_jobs_pending > 0)) {
+				jit_publish_traces();
 			}
 		}
 
 		bool jit_exec(P &proc, addr_t pc)
 		{
+			sync_trace_cache();
 			auto ti = trace_cache_prolog.find(pc);
-			if (ti != trace_cache_prolog.end()) {
+			if (ti == trace_cache_prolog.end()) {
+				trace_misses++;
+				return false;
+			}
+			trace_hits++;
+			if (P::trace_cache_limit != 0) {
+				trace_stats[pc].execs++;
+			}
+			if (use_mmu) {
+				/* faults leave the trace at the faulting pc with cause set */
+				P::exceptions = false;
+				P::cause = 0;
+				ti->second(static_cast<typename P::processor_type *>(&proc));
+				P::exceptions = true;
+				if (P::cause != 0) {
+					P::raise(P::cause, P::badaddr);
+				}
+			} else {
 				ti->second(static_cast<typename P::processor_type *>(&proc));
-				return true;
 			}
-			return false;
+			return true;
 		}
 
-		void jit_trace()
+		/* count integer register uses in the recorded trace for the emitter's register allocator */
+		void jit_regalloc(trace_job *job, size_t reg_uses[32])
 		{
-			CodeHolder code;
-			jit_logger logger;
-			logger.addOptions(Logger::kOptionBinaryForm | Logger::kOptionHexDisplacement | Logger::kOptionHexImmediate);
- 			code.init(rt.getCodeInfo());
-			code.setErrorHandler(this);
-			jit_emitter emitter(*this, code, ops, lookup_trace, lookup_trace_fast);
-
-			typename P::ux trace_pc = P::pc;
-			typename P::ux trace_instret = P::instret;
-
-			if (P::log & proc_log_jit_trace) {
-				if (P::xlen == 32) {
-					printf("jit-trace-begin pc=0x%08x\n", (u32)P::pc);
-				} else if (P::xlen == 64) {
-					printf("jit-trace-begin pc=0x%016llx\n", (u64)P::pc);
+			for (auto &dec : job->trace) {
+				const rv_operand_data *operand_data = rv_inst_operand_data[dec.op];
+				while (operand_data->type != rv_type_none) {
+					if (operand_data->type == rv_type_ireg) {
+						reg_uses[P::regnum(dec, operand_data->operand_name)]++;
+					}
+					operand_data++;
 				}
-	 			code.setLogger(&logger);
 			}
+		}
 
-			P::log &= ~proc_log_jit_trap;
-
-			emitter.emit_prolog();
-			emitter.begin();
-			for(;;) {
+		/*
+		 * Interpret from the hotspot recording the decoded path and the
+		 * direction taken by each branch, until the path returns to a
+		 * recorded pc or reaches an instruction that ends a trace. The
+		 * emitter only needs the recording so code generation can run on
+		 * the compile thread.
+		 */
+		void jit_record(trace_job *job)
+		{
+			std::set<addr_t> recorded;
+			size_t limit = P::trace_length != 0 ? size_t(P::trace_length) : trace_record_limit;
+			while (job->trace.size() < limit && recorded.find(P::pc) == recorded.end()) {
 				typename P::decode_type dec;
 				typename P::ux pc_offset, new_offset;
 				inst_t inst = P::mmu.inst_fetch(*this, P::pc, pc_offset);
+				if (P::cause != 0) break;
+				if (!use_mmu && !jit_record_pages(job->pages, P::pc, pc_offset)) break;
 				P::inst_decode(dec, inst);
 				dec.pc = P::pc;
 				dec.inst = inst;
-				if (emitter.emit(dec) == false) break;
+				if (dec.op == rv_op_ecall || dec.op == rv_op_ebreak || dec.op == rv_op_fence_i) break;
+				set_code_page(P::mmu, P::pc, pc_offset, 0);
+				typename P::ireg_t ireg_save = P::ireg[dec.rd];
+				typename P::freg_t freg_save = P::freg[dec.rd];
 				if ((new_offset = P::inst_exec(dec, pc_offset)) == typename P::ux(-1)) break;
+				if (P::cause != 0) {
+					/* the destination is unmodified when an instruction faults */
+					P::ireg[dec.rd] = ireg_save;
+					P::freg[dec.rd] = freg_save;
+					job->trace.push_back(dec);
+					break;
+				}
+				dec.taken = new_offset != pc_offset;
+				job->trace.push_back(dec);
+				recorded.insert(P::pc);
 				P::pc += new_offset;
 				P::instret++;
-				if (P::trace_length != 0 && (P::instret - trace_instret) >= P::trace_length) break;
+			}
+		}
+
+		trace_job* jit_create_job(addr_t key, addr_t pc)
+		{
+			trace_job *job = new trace_job();
+			job->key = key;
+			job->pc = pc;
+			job->generation = code_generation;
+			job->context = trace_context;
+			job->logger.addOptions(Logger::kOptionBinaryForm | Logger::kOptionHexDisplacement | Logger::kOptionHexImmediate);
+			job->code.init(rt.getCodeInfo());
+			job->code.setErrorHandler(this);
+			if (P::log & proc_log_jit_trace) {
+				job->code.setLogger(&job->logger);
+			}
+			job->emitter.reset(new jit_emitter(*this, job->code, ops, lookup_trace, lookup_trace_fast));
+			job->emitter->dtlb = dtlb;
+			job->emitter->use_mmu = use_mmu;
+			job->emitter->check_budget = use_mmu;
+			return job;
+		}
+
+		/* emit a recorded trace, which ends early at an instruction the emitter rejects */
+		void jit_compile(trace_job *job)
+		{
+			jit_emitter &emitter = *job->emitter;
+			size_t emitted = 0, reg_uses[32] = { 0 };
+			jit_regalloc(job, reg_uses);
+			emitter.allocate_registers(reg_uses);
+			emitter.emit_prolog();
+			emitter.begin();
+			for (auto &dec : job->trace) {
+				if (emitter.emit(dec) == false) break;
+				emitted++;
 			}
 			emitter.end();
 			emitter.emit_epilog();
+			job->emitted = emitted > 0;
+		}
+
+		/* install a compiled trace unless the code or context changed since it was recorded */
+		void jit_publish(trace_job *job)
+		{
+			if (job->generation != code_generation || job->context != trace_context) {
+				P::histogram_set_pc(job->key, 0);
+			} else if (!job->emitted) {
+				P::histogram_set_pc(job->key, P::hostspot_trace_skip);
+			} else if (jit_cache(*job->emitter, job->code, job->pc) && !use_mmu && !trace_thread_running) {
+				jit_protect_pages(job->pc, job->pages);
+			}
+			if (trace_thread_running && !use_mmu) {
+				/* recorded pcs were held back from tracing while the job was pending */
+				for (auto &dec : job->trace) {
+					if (dec.pc != u64(job->key)) {
+						P::histogram_set_pc(dec.pc, 0);
+					}
+				}
+			}
+			delete job;
+		}
 
+		void jit_publish_traces()
+		{
+			trace_job *job;
+			while ((job = trace_done.pop_front()) != nullptr) {
+				trace_jobs_pending--;
+				jit_publish(job);
+			}
+		}
+
+		/*
+		 * hand a recorded trace to the compile thread. the pages it was
+		 * recorded from are protected now so that a store before the
+		 * trace is published discards it
+		 */
+		void jit_queue(trace_job *job)
+		{
+			if (!use_mmu) {
+				jit_protect_pages(job->pc, job->pages);
+				for (auto &dec : job->trace) {
+					P::histogram_set_pc(dec.pc, P::hostspot_trace_skip);
+				}
+			}
+			P::histogram_set_pc(job->key, P::hostspot_trace_skip);
+			if (trace_queue.push_back(job)) {
+				trace_jobs_pending++;
+			} else {
+				P::histogram_set_pc(job->key, 0);
+				delete job;
+			}
+		}
+
+		void trace_worker()
+		{
+			while (trace_thread_running) {
+				trace_job *job = trace_queue.pop_front();
+				if (job == nullptr) {
+					usleep(trace_worker_idle_us);
+					continue;
+				}
+				jit_compile(job);
+				while (!trace_done.push_back(job)) {
+					usleep(trace_worker_idle_us);
+				}
+			}
+		}
+
+		void start_trace_thread()
+		{
+			trace_thread_running = true;
+			trace_thread = std::thread(&jit_runloop<P,J>::trace_worker, this);
+		}
+
+		void stop_trace_thread()
+		{
+			if (!trace_thread_running) return;
+			trace_thread_running = false;
+			trace_thread.join();
+			trace_job *job;
+			while ((job = trace_queue.pop_front()) != nullptr) delete job;
+			while ((job = trace_done.pop_front()) != nullptr) delete job;
+			trace_jobs_pending = 0;
+		}
+
+		void jit_trace()
+		{
+			addr_t trace_key = P::badaddr; /* histogram key from the hotspot */
+			typename P::ux trace_pc = P::pc;
+
+			if (P::log & proc_log_jit_trace) {
+				if (P::xlen == 32) {
+					printf("jit-trace-begin pc=0x%08x\n", (u32)P::pc);
+				} else if (P::xlen == 64) {
+					printf("jit-trace-begin pc=0x%016llx\n", (u64)P::pc);
+				}
+			}
+
+			P::log &= ~proc_log_jit_trap;
+
+			/*
+			 * faults are recorded in cause rather than unwinding so that the
+			 * trace can be closed; the faulting instruction is emitted with
+			 * its fault check and the trap is taken once it is recorded
+			 */
+			P::exceptions = false;
+			P::cause = 0;
+
+			sync_trace_cache();
+			trace_job *job = jit_create_job(trace_key, trace_pc);
+			jit_record(job);
+
+			P::exceptions = true;
 			P::log |= proc_log_jit_trap;
 
 			if (P::log & proc_log_jit_trace) {
@@ -363,11 +1362,20 @@ namespace riscv {
 				}
 			}
 
-			if (P::instret == trace_instret) {
-				P::histogram_set_pc(trace_pc, P::hostspot_trace_skip);
+			if (job->trace.size() == 0) {
+				if (P::cause == 0) {
+					P::histogram_set_pc(job->key, P::hostspot_trace_skip);
+				}
+				delete job;
+			} else if (trace_thread_running) {
+				jit_queue(job);
+			} else {
+				jit_compile(job);
+				jit_publish(job);
 			}
-			else {
-				jit_cache(emitter, code, trace_pc);
+
+			if (P::cause != 0) {
+				P::raise(P::cause, P::badaddr);
 			}
 		}
 
@@ -433,7 +1441,7 @@ namespace riscv {
 			/* interpret instruction */
 			typename P::ux new_offset;
 			if ((new_offset = P::inst_exec(dec, pc_offset)) != typename P::ux(-1) ||
-				(new_offset = P::inst_priv(dec, pc_offset)) != typename P::ux(-1))
+				(new_offset = inst_priv(dec, pc_offset)) != typename P::ux(-1))
 			{
 				if (P::log) P::print_log(dec, inst);
 				P::pc += new_offset;
@@ -483,8 +1491,12 @@ namespace riscv {
 			inst_t inst = 0, inst_cache_key;
 
 			/* interrupt service routine */
-			P::time = cpu_cycle_clock();
 			P::isr();
+			if (remote_fenced(*this, 0)) {
+				clear_trace_cache();
+				blocks.flush();
+			}
+			P::trace_budget = trace_step;
 
 			/* trap return path */
 			int cause;
@@ -510,11 +1522,45 @@ namespace riscv {
 			/* step the processor */
 			while (P::instret != inststop) {
 				if ((P::log & proc_log_jit_trap) && jit_exec(*this, P::pc)) {
+					/* return to service interrupts when the trace budget is spent */
+					if (P::trace_budget <= 0) break;
 					continue;
 				}
 				if (P::pc == P::breakpoint && P::breakpoint != 0) {
 					return exit_cause_cli;
 				}
+
+				/* hotspot detection and audits need every fetch, see block_cache */
+				if (!(P::log & (proc_log_hist_pc | proc_log_jit_audit))) {
+					auto &blk = blocks.fetch(*this);
+					size_t i = 0;
+					if (P::threaded && !(P::log & blocks.inst_log_mask) && P::breakpoint == 0 &&
+						typename P::ux(inststop - P::instret) >= blk.count)
+					{
+						/* stops before instructions it has no handler for */
+						i = P::inst_exec_block(blk.dec, blk.handler, blk.length, blk.count);
+						if (i == blk.count) continue;
+					}
+					for (; i < blk.count; i++) {
+						dec = blk.dec[i];
+						pc_offset = blk.length[i];
+						if ((new_offset = P::inst_exec(dec, pc_offset)) != typename P::ux(-1) ||
+							(new_offset = inst_fence_i(dec, pc_offset)) != typename P::ux(-1) ||
+							(new_offset = inst_priv(dec, pc_offset)) != typename P::ux(-1))
+						{
+							if (P::log & ~proc_log_jit_trap) P::print_log(dec, blk.inst[i]);
+							P::pc += new_offset;
+							P::instret++;
+						} else {
+							P::raise(rv_cause_illegal_instruction, P::pc);
+						}
+						if (new_offset != pc_offset || P::instret == inststop ||
+							(P::pc == P::breakpoint && P::breakpoint != 0)) break;
+					}
+					blocks.sync(*this, dec);
+					continue;
+				}
+
 				inst = P::mmu.inst_fetch(*this, P::pc, pc_offset);
 				inst_cache_key = inst % inst_cache_size;
 				if (inst_cache[inst_cache_key].inst == inst) {
@@ -529,7 +1575,7 @@ namespace riscv {
 				}
 				else if ((new_offset = P::inst_exec(dec, pc_offset)) != typename P::ux(-1) ||
 						 (new_offset = inst_fence_i(dec, pc_offset)) != typename P::ux(-1) ||
-						 (new_offset = P::inst_priv(dec, pc_offset)) != typename P::ux(-1))
+						 (new_offset = inst_priv(dec, pc_offset)) != typename P::ux(-1))
 				{
 					if (P::log & ~(proc_log_hist_pc | proc_log_jit_trap)) P::print_log(dec, inst);
 					P::pc += new_offset;
@@ -537,6 +1583,7 @@ namespace riscv {
 				} else {
 					P::raise(rv_cause_illegal_instruction, P::pc);
 				}
+				blocks.sync(*this, dec);
 			}
 			return exit_cause_continue;
 		}
@@ -1,93 +1,93 @@
 unsigned char build_riscv64_unknown_elf_bin_boot_rom_bin[] = {
   0x6f, 0x00, 0x00, 0x01, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x01, 0x40, 0x97, 0x02, 0x00, 0x00, 0x93, 0x82, 0x42, 0x06,
+  0x00, 0x00, 0x01, 0x40, 0x97, 0x02, 0x00, 0x00, 0x93, 0x82, 0x42, 0x07,
   0x73, 0x90, 0x52, 0x30, 0xb7, 0xf1, 0x00, 0x40, 0x83, 0xb2, 0x81, 0x02,
-  0x03, 0xb3, 0x01, 0x03, 0x33, 0x81, 0x62, 0x00, 0x13, 0x01, 0x01, 0xf0,
+  0x03, 0xb3, 0x01, 0x03, 0x33, 0x81, 0x62, 0x00, 0xf3, 0x22, 0x40, 0xf1,
+  0x93, 0x82, 0x12, 0x00, 0x93, 0x92, 0x82, 0x00, 0x33, 0x01, 0x51, 0x40,
   0x73, 0x23, 0x00, 0x30, 0x93, 0x02, 0x30, 0x00, 0x93, 0x92, 0xb2, 0x00,
   0x33, 0x63, 0x53, 0x00, 0x73, 0x20, 0x03, 0x30, 0xb7, 0x32, 0x00, 0x40,
   0x13, 0x03, 0x10, 0x00, 0xa3, 0x80, 0x62, 0x00, 0xb7, 0x12, 0x00, 0x00,
   0x9b, 0x82, 0x02, 0x80, 0x73, 0xa0, 0x42, 0x30, 0x93, 0x02, 0x00, 0x08,
-  0x73, 0xa0, 0x02, 0x30, 0x83, 0xb0, 0x01, 0x02, 0x73, 0x11, 0x01, 0x34,
-  0x73, 0x90, 0x10, 0x34, 0x73, 0x00, 0x20, 0x30, 0x73, 0x11, 0x01, 0x34,
-  0x23, 0x30, 0x51, 0x00, 0x23, 0x34, 0x61, 0x00, 0x73, 0x23, 0x20, 0x34,
-  0x63, 0x5e, 0x03, 0x04, 0x13, 0x13, 0x13, 0x00, 0x13, 0x53, 0x13, 0x00,
-  0x93, 0x02, 0xb0, 0x00, 0x63, 0x88, 0x62, 0x00, 0x93, 0x02, 0x70, 0x00,
-  0x63, 0x80, 0x62, 0x02, 0x73, 0x00, 0x10, 0x00, 0xb7, 0x12, 0x00, 0x00,
-  0x9b, 0x82, 0x02, 0x80, 0x73, 0xb0, 0x42, 0x34, 0x93, 0x02, 0x00, 0x20,
-  0x73, 0xa0, 0x42, 0x34, 0x6f, 0x00, 0x80, 0x01, 0x93, 0x02, 0x00, 0x08,
-  0x73, 0xb0, 0x42, 0x34, 0x93, 0x02, 0x00, 0x02, 0x73, 0xa0, 0x42, 0x34,
-  0x6f, 0x00, 0x40, 0x00, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
-  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0x93, 0x22, 0xc3, 0x00,
-  0x63, 0x84, 0x02, 0x04, 0x97, 0x02, 0x00, 0x00, 0x93, 0x82, 0x42, 0x1b,
-  0x13, 0x13, 0x23, 0x00, 0xb3, 0x82, 0x62, 0x00, 0x83, 0xa2, 0x02, 0x00,
-  0x67, 0x80, 0x02, 0x00, 0x93, 0xa2, 0x08, 0x01, 0x63, 0x84, 0x02, 0x02,
-  0x97, 0x02, 0x00, 0x00, 0x93, 0x82, 0x42, 0x1c, 0x93, 0x98, 0x28, 0x00,
-  0xb3, 0x82, 0x12, 0x01, 0x83, 0xa2, 0x02, 0x00, 0x73, 0x23, 0x10, 0x34,
-  0x13, 0x03, 0x43, 0x00, 0x73, 0x10, 0x13, 0x34, 0x67, 0x80, 0x02, 0x00,
-  0x73, 0x00, 0x10, 0x00, 0x73, 0x00, 0x50, 0x10, 0x6f, 0xf0, 0xdf, 0xff,
-  0x73, 0x25, 0x40, 0xf1, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
-  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0x37, 0x33, 0x00, 0x40,
-  0x23, 0x00, 0xa3, 0x00, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
-  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0x37, 0x33, 0x00, 0x40,
-  0x83, 0x02, 0x23, 0x00, 0x93, 0xf2, 0x42, 0x00, 0x63, 0x8c, 0x02, 0x10,
-  0x03, 0x85, 0x05, 0x00, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
-  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0x73, 0x00, 0x10, 0x00,
-  0x73, 0x00, 0x10, 0x00, 0x73, 0x00, 0x10, 0x00, 0x37, 0x53, 0x00, 0x40,
-  0x93, 0x02, 0x10, 0x00, 0x23, 0x26, 0x53, 0x00, 0x6f, 0xf0, 0x1f, 0xf9,
+  0x73, 0xa0, 0x02, 0x30, 0x73, 0x25, 0x40, 0xf1, 0x83, 0xb0, 0x01, 0x02,
+  0x73, 0x11, 0x01, 0x34, 0x73, 0x90, 0x10, 0x34, 0x73, 0x00, 0x20, 0x30,
+  0x73, 0x11, 0x01, 0x34, 0x23, 0x30, 0x51, 0x00, 0x23, 0x34, 0x61, 0x00,
+  0x73, 0x23, 0x20, 0x34, 0x63, 0x5e, 0x03, 0x04, 0x13, 0x13, 0x13, 0x00,
+  0x13, 0x53, 0x13, 0x00, 0x93, 0x02, 0xb0, 0x00, 0x63, 0x88, 0x62, 0x00,
+  0x93, 0x02, 0x70, 0x00, 0x63, 0x80, 0x62, 0x02, 0x73, 0x00, 0x10, 0x00,
+  0xb7, 0x12, 0x00, 0x00, 0x9b, 0x82, 0x02, 0x80, 0x73, 0xb0, 0x42, 0x34,
+  0x93, 0x02, 0x00, 0x20, 0x73, 0xa0, 0x42, 0x34, 0x6f, 0x00, 0x80, 0x01,
+  0x93, 0x02, 0x00, 0x08, 0x73, 0xb0, 0x42, 0x34, 0x93, 0x02, 0x00, 0x02,
+  0x73, 0xa0, 0x42, 0x34, 0x6f, 0x00, 0x40, 0x00, 0x83, 0x32, 0x01, 0x00,
+  0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30,
+  0x93, 0x22, 0xc3, 0x00, 0x63, 0x84, 0x02, 0x04, 0x97, 0x02, 0x00, 0x00,
+  0x93, 0x82, 0xc2, 0x2b, 0x13, 0x13, 0x23, 0x00, 0xb3, 0x82, 0x62, 0x00,
+  0x83, 0xa2, 0x02, 0x00, 0x67, 0x80, 0x02, 0x00, 0x93, 0xa2, 0x08, 0x01,
+  0x63, 0x84, 0x02, 0x02, 0x97, 0x02, 0x00, 0x00, 0x93, 0x82, 0xc2, 0x2c,
+  0x93, 0x98, 0x28, 0x00, 0xb3, 0x82, 0x12, 0x01, 0x83, 0xa2, 0x02, 0x00,
+  0x73, 0x23, 0x10, 0x34, 0x13, 0x03, 0x43, 0x00, 0x73, 0x10, 0x13, 0x34,
+  0x67, 0x80, 0x02, 0x00, 0x73, 0x00, 0x10, 0x00, 0x73, 0x00, 0x50, 0x10,
+  0x6f, 0xf0, 0xdf, 0xff, 0x73, 0x25, 0x40, 0xf1, 0x83, 0x32, 0x01, 0x00,
+  0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30,
+  0x37, 0x33, 0x00, 0x40, 0x23, 0x00, 0xa3, 0x00, 0x83, 0x32, 0x01, 0x00,
+  0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30,
+  0x37, 0x33, 0x00, 0x40, 0x83, 0x02, 0x23, 0x00, 0x93, 0xf2, 0x42, 0x00,
+  0x63, 0x80, 0x02, 0x22, 0x03, 0x85, 0x05, 0x00, 0x83, 0x32, 0x01, 0x00,
+  0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30,
+  0x73, 0x00, 0x10, 0x00, 0xb7, 0xf2, 0x00, 0x40, 0x03, 0xb3, 0x02, 0x00,
+  0x63, 0x7e, 0x65, 0x1e, 0x13, 0x13, 0x25, 0x00, 0xb7, 0x12, 0x00, 0x40,
+  0xb3, 0x82, 0x62, 0x00, 0x13, 0x03, 0x10, 0x00, 0x23, 0xa0, 0x62, 0x00,
+  0x13, 0x05, 0x00, 0x00, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
+  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0x73, 0x23, 0x40, 0xf1,
+  0x13, 0x13, 0x23, 0x00, 0xb7, 0x12, 0x00, 0x40, 0xb3, 0x82, 0x62, 0x00,
+  0x2f, 0xa5, 0x02, 0x08, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
+  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0x37, 0x53, 0x00, 0x40,
+  0x93, 0x02, 0x10, 0x00, 0x23, 0x26, 0x53, 0x00, 0x6f, 0xf0, 0x1f, 0xf4,
   0xb7, 0x02, 0x00, 0x40, 0x03, 0xb3, 0x02, 0x00, 0xb3, 0x03, 0xa3, 0x00,
-  0xb7, 0x42, 0x00, 0x40, 0x23, 0xb0, 0x72, 0x00, 0x83, 0x32, 0x01, 0x00,
+  0x73, 0x23, 0x40, 0xf1, 0x13, 0x13, 0x33, 0x00, 0xb7, 0x42, 0x00, 0x40,
+  0xb3, 0x82, 0x62, 0x00, 0x23, 0xb0, 0x72, 0x00, 0x83, 0x32, 0x01, 0x00,
   0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30,
-  0x73, 0x00, 0x10, 0x00, 0x73, 0x00, 0x10, 0x00, 0xb7, 0xf5, 0x00, 0x40,
-  0x03, 0xb5, 0x05, 0x00, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
-  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0x63, 0x10, 0x05, 0x0a,
-  0xb7, 0xf2, 0x00, 0x40, 0x03, 0xb3, 0x82, 0x02, 0x83, 0xb3, 0x02, 0x03,
-  0x37, 0x0e, 0x20, 0x00, 0xb3, 0x83, 0xc3, 0x41, 0x13, 0x05, 0x00, 0x00,
-  0x23, 0xb0, 0x65, 0x00, 0x23, 0xb4, 0x75, 0x00, 0x23, 0xb8, 0xa5, 0x00,
+  0x13, 0x03, 0x20, 0x00, 0x6f, 0x00, 0x80, 0x00, 0x13, 0x03, 0x10, 0x00,
+  0x93, 0x03, 0xf0, 0xff, 0x63, 0x0a, 0x05, 0x00, 0x37, 0x0e, 0x02, 0x00,
+  0x73, 0x20, 0x0e, 0x30, 0x83, 0x33, 0x05, 0x00, 0x73, 0x30, 0x0e, 0x30,
+  0x13, 0x0e, 0x20, 0x00, 0xf3, 0x35, 0x0e, 0x30, 0xb7, 0xf2, 0x00, 0x40,
+  0x83, 0xbe, 0x02, 0x00, 0xb7, 0x12, 0x00, 0x40, 0x9b, 0x82, 0x02, 0x01,
+  0x13, 0x0f, 0x00, 0x00, 0x93, 0x8f, 0x03, 0x00, 0x63, 0x72, 0xdf, 0x03,
+  0x13, 0xfe, 0x1f, 0x00, 0x63, 0x08, 0x0e, 0x00, 0x13, 0x1e, 0x2f, 0x00,
+  0x33, 0x8e, 0xc2, 0x01, 0x23, 0x20, 0x6e, 0x00, 0x93, 0xdf, 0x1f, 0x00,
+  0x13, 0x0f, 0x1f, 0x00, 0x6f, 0xf0, 0x1f, 0xfe, 0x13, 0x0f, 0x00, 0x00,
+  0x93, 0x8f, 0x03, 0x00, 0x63, 0x74, 0xdf, 0x03, 0x13, 0xfe, 0x1f, 0x00,
+  0x63, 0x0a, 0x0e, 0x00, 0x13, 0x1e, 0x2f, 0x00, 0x33, 0x8e, 0xc2, 0x01,
+  0x03, 0x2e, 0x0e, 0x00, 0xe3, 0x14, 0x0e, 0xfe, 0x93, 0xdf, 0x1f, 0x00,
+  0x13, 0x0f, 0x1f, 0x00, 0x6f, 0xf0, 0xdf, 0xfd, 0x93, 0xf5, 0x25, 0x00,
+  0x73, 0xa0, 0x05, 0x30, 0x13, 0x05, 0x00, 0x00, 0x83, 0x32, 0x01, 0x00,
+  0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30,
+  0xb7, 0xf5, 0x00, 0x40, 0x03, 0xb5, 0x05, 0x00, 0x83, 0x32, 0x01, 0x00,
+  0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30,
+  0x63, 0x10, 0x05, 0x0a, 0xb7, 0xf2, 0x00, 0x40, 0x03, 0xb3, 0x82, 0x02,
+  0x83, 0xb3, 0x02, 0x03, 0x37, 0x0e, 0x20, 0x00, 0xb3, 0x83, 0xc3, 0x41,
+  0x13, 0x05, 0x00, 0x00, 0x23, 0xb0, 0x65, 0x00, 0x23, 0xb4, 0x75, 0x00,
+  0x23, 0xb8, 0xa5, 0x00, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
+  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0xb7, 0xf2, 0x00, 0x40,
+  0x03, 0xb5, 0x82, 0x00, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
+  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0x13, 0x23, 0x05, 0x02,
+  0x63, 0x06, 0x03, 0x04, 0x13, 0x03, 0x10, 0x00, 0x33, 0x1f, 0xa3, 0x00,
+  0x93, 0x0e, 0xf0, 0xff, 0x33, 0x4f, 0xdf, 0x01, 0x13, 0x05, 0x00, 0x00,
   0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34,
-  0x73, 0x00, 0x20, 0x30, 0xb7, 0xf2, 0x00, 0x40, 0x03, 0xb5, 0x82, 0x00,
+  0x73, 0x00, 0x20, 0x30, 0x13, 0x23, 0x05, 0x02, 0x63, 0x00, 0x03, 0x02,
+  0x13, 0x03, 0x10, 0x00, 0x33, 0x1f, 0xa3, 0x00, 0x13, 0x05, 0x00, 0x00,
   0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34,
-  0x73, 0x00, 0x20, 0x30, 0x13, 0x23, 0x05, 0x02, 0x63, 0x06, 0x03, 0x04,
-  0x13, 0x03, 0x10, 0x00, 0x33, 0x1f, 0xa3, 0x00, 0x93, 0x0e, 0xf0, 0xff,
-  0x33, 0x4f, 0xdf, 0x01, 0x13, 0x05, 0x00, 0x00, 0x83, 0x32, 0x01, 0x00,
+  0x73, 0x00, 0x20, 0x30, 0x13, 0x05, 0xf0, 0xff, 0x83, 0x32, 0x01, 0x00,
   0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30,
-  0x13, 0x23, 0x05, 0x02, 0x63, 0x00, 0x03, 0x02, 0x13, 0x03, 0x10, 0x00,
-  0x33, 0x1f, 0xa3, 0x00, 0x13, 0x05, 0x00, 0x00, 0x83, 0x32, 0x01, 0x00,
-  0x03, 0x33, 0x81, 0x00, 0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30,
-  0x13, 0x05, 0xf0, 0xff, 0x83, 0x32, 0x01, 0x00, 0x03, 0x33, 0x81, 0x00,
-  0x73, 0x11, 0x01, 0x34, 0x73, 0x00, 0x20, 0x30, 0x2c, 0x11, 0x00, 0x00,
-  0x2c, 0x11, 0x00, 0x00, 0x2c, 0x11, 0x00, 0x00, 0x2c, 0x11, 0x00, 0x00,
-  0x2c, 0x11, 0x00, 0x00, 0x2c, 0x11, 0x00, 0x00, 0x2c, 0x11, 0x00, 0x00,
-  0x2c, 0x11, 0x00, 0x00, 0x2c, 0x11, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00,
-  0x00, 0x11, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x38, 0x11, 0x00, 0x00,
-  0x4c, 0x11, 0x00, 0x00, 0x64, 0x11, 0x00, 0x00, 0x88, 0x11, 0x00, 0x00,
-  0x8c, 0x11, 0x00, 0x00, 0x90, 0x11, 0x00, 0x00, 0x94, 0x11, 0x00, 0x00,
-  0xa4, 0x11, 0x00, 0x00, 0xc8, 0x11, 0x00, 0x00, 0xcc, 0x11, 0x00, 0x00,
-  0xd0, 0x11, 0x00, 0x00, 0xe8, 0x11, 0x00, 0x00, 0x20, 0x12, 0x00, 0x00,
-  0x38, 0x12, 0x00, 0x00, 0x64, 0x12, 0x00, 0x00, 0xc8, 0x11, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
-  0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
+  0x3c, 0x11, 0x00, 0x00, 0x3c, 0x11, 0x00, 0x00, 0x3c, 0x11, 0x00, 0x00,
+  0x3c, 0x11, 0x00, 0x00, 0x3c, 0x11, 0x00, 0x00, 0x3c, 0x11, 0x00, 0x00,
+  0x3c, 0x11, 0x00, 0x00, 0x3c, 0x11, 0x00, 0x00, 0x3c, 0x11, 0x00, 0x00,
+  0x10, 0x11, 0x00, 0x00, 0x10, 0x11, 0x00, 0x00, 0x10, 0x11, 0x00, 0x00,
+  0x48, 0x11, 0x00, 0x00, 0x5c, 0x11, 0x00, 0x00, 0x74, 0x11, 0x00, 0x00,
+  0x98, 0x11, 0x00, 0x00, 0x9c, 0x11, 0x00, 0x00, 0xd0, 0x11, 0x00, 0x00,
+  0xf4, 0x11, 0x00, 0x00, 0x04, 0x12, 0x00, 0x00, 0x34, 0x12, 0x00, 0x00,
+  0x3c, 0x12, 0x00, 0x00, 0xe8, 0x12, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00,
+  0x38, 0x13, 0x00, 0x00, 0x50, 0x13, 0x00, 0x00, 0x7c, 0x13, 0x00, 0x00,
+  0x34, 0x12, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
   0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
   0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,
   0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,